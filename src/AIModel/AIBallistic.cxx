@@ -656,6 +656,9 @@ void FGAIBallistic::slaveToAC(double dt) {
 
 void FGAIBallistic::Run(double dt) {
     _life_timer += dt;
+
+    // collisions are checked along the whole path flown in this step
+    const SGVec3d startCartPos = SGVec3d::fromGeod(pos);
     
     //_pass += 1;
     //cout<<"AIBallistic run: name " << _name.c_str() 
@@ -930,7 +933,7 @@ void FGAIBallistic::Run(double dt) {
         handle_impact();
 
     if (_report_collision && !_collision_reported)
-        handle_collision();
+        handle_collision(startCartPos, dt);
 
     // Set destruction flag if altitude less than sea level -1000
     if (altitude_ft < -1000.0 && life != -1)
@@ -977,12 +980,16 @@ void FGAIBallistic::handle_expiry() {
     handleEndOfLife(pos.getElevationM());
 }
 
-void FGAIBallistic::handle_collision()
+void FGAIBallistic::handle_collision(const SGVec3d& startCartPos, double dt)
 {
-    const FGAIBase *object = manager->calcCollision(pos.getElevationFt(),
-        pos.getLatitudeDeg(),pos.getLongitudeDeg(), _fuse_range);
+    const SGVec3d endCartPos = SGVec3d::fromGeod(pos);
+    double hitFraction = 1.0;
+    const FGAIBase *object = manager->calcCollision(startCartPos, endCartPos,
+        dt, _fuse_range, &hitFraction);
 
     if (object) {
+        // report the impact where the path met the target, not at the end of the step
+        pos = SGGeod::fromCart(startCartPos + hitFraction * (endCartPos - startCartPos));
         report_impact(pos.getElevationM(), object);
         _collision_reported = true;
     }
@@ -210,7 +210,7 @@ private:
     std::string _contents_path;
 
     void handleEndOfLife(double);
-    void handle_collision();
+    void handle_collision(const SGVec3d& startCartPos, double dt);
     void handle_expiry();
     void handle_impact();
     void report_impact(double elevation, const FGAIBase *target = 0);
@@ -196,6 +196,7 @@ FGAIManager::shutdown()
     }
     
     ai_list.clear();
+    _trafficIndex.clear();
     _environmentVisiblity.clear();
     _userAircraft.clear();
     
@@ -252,6 +253,10 @@ FGAIManager::update(double dt)
     }
   
     ai_list.erase(ai_list.begin(), firstAlive);
+
+    // snapshot the survivors before anything runs, the index must not
+    // hold on to the objects just removed
+    _trafficIndex.rebuild(ai_list);
   
     // every remaining item is alive. update them in turn, but guard for
     // exceptions, so a single misbehaving AI object doesn't bring down the
@@ -534,59 +539,82 @@ FGAIManager::loadScenarioFile(const std::string& filename)
 
 const FGAIBase *
 FGAIManager::calcCollision(double alt, double lat, double lon, double fuse_range)
+{
+    SGVec3d cartPos(SGVec3d::fromGeod(SGGeod::fromDegFt(lon, lat, alt)));
+    return calcCollision(cartPos, cartPos, 0.0, fuse_range);
+}
+
+const FGAIBase *
+FGAIManager::calcCollision(const SGVec3d& from, const SGVec3d& to, double dt,
+                           double fuse_range, double* hitFraction)
 {
     // we specify tgt extent (ft) according to the AIObject type
-    double tgt_ht[]     = {0,  50, 100, 250, 0, 100, 0, 0,  50,  50, 20, 100,  50};
-    double tgt_length[] = {0, 100, 200, 750, 0,  50, 0, 0, 200, 100, 40, 200, 100};
-    ai_list_iterator ai_list_itr = ai_list.begin();
-    ai_list_iterator end = ai_list.end();
+    static const double tgt_ht[]     = {0,  50, 100, 250, 0, 100, 0, 0,  50,  50, 20, 100,  50};
+    static const double tgt_length[] = {0, 100, 200, 750, 0,  50, 0, 0, 200, 100, 40, 200, 100};
+    const double max_length = *std::max_element(tgt_length, tgt_length + FGAIBase::MAX_OBJECTS);
+
+    // broad phase: a sphere around the swept segment, grown by the largest
+    // target extent and by how far the fastest target moves in this step.
+    // The index was built at the start of this update(), after the dead
+    // objects were removed, so its positions are those at the start of the step.
+    const SGVec3d step = to - from;
+    const double radiusM = 0.5 * norm(step)
+        + (max_length + fuse_range) * SG_FEET_TO_METER
+        + _trafficIndex.maxSpeedMps() * dt;
+    _trafficIndex.query(0.5 * (from + to), radiusM, _collisionCandidates);
+
+    const FGAIBase* hit = 0;
+    double hitT = 1.0;
+
+    for (int i : _collisionCandidates) {
+        int type = _trafficIndex.type(i);
+        if (type == FGAIBase::otBallistic || type == FGAIBase::otStorm
+            || type == FGAIBase::otThermal) {
+            continue;
+        }
 
-    SGGeod pos(SGGeod::fromDegFt(lon, lat, alt));
-    SGVec3d cartPos(SGVec3d::fromGeod(pos));
-    
-    while (ai_list_itr != end) {
-        double tgt_alt = (*ai_list_itr)->_getAltitude();
-        int type       = (*ai_list_itr)->getType();
-        tgt_ht[type] += fuse_range;
-
-        if (fabs(tgt_alt - alt) > tgt_ht[type] || type == FGAIBase::otBallistic
-            || type == FGAIBase::otStorm || type == FGAIBase::otThermal ) {
-                //SG_LOG(SG_AI, SG_DEBUG, "AIManager: skipping "
-                //    << fabs(tgt_alt - alt)
-                //    << " "
-                //    << type
-                //    );
-                ++ai_list_itr;
-                continue;
+        // killed earlier in this update, e.g. by another projectile
+        if (_trafficIndex.object(i)->getDie()) {
+            continue;
         }
 
-        int id         = (*ai_list_itr)->getID();
-
-        double range = calcRangeFt(cartPos, (*ai_list_itr));
-
-        //SG_LOG(SG_AI, SG_DEBUG, "AIManager:  AI list size "
-        //    << ai_list.size()
-        //    << " type " << type
-        //    << " ID " << id
-        //    << " range " << range
-        //    //<< " bearing " << bearing
-        //    << " alt " << tgt_alt
-        //    );
-
-        tgt_length[type] += fuse_range;
-
-        if (range < tgt_length[type]){
-            SG_LOG(SG_AI, SG_DEBUG, "AIManager: HIT! "
-                << " type " << type
-                << " ID " << id
-                << " range " << range
-                << " alt " << tgt_alt
-                );
-            return (*ai_list_itr).get();
+        // closest approach of the projectile relative to the target, which
+        // moves with its snapshot velocity during the step
+        const SGVec3d& tgt_pos = _trafficIndex.cartPos(i);
+        const SGVec3d start = from - tgt_pos;
+        const SGVec3d delta = step - _trafficIndex.cartVelocity(i) * dt;
+        const double deltaSqr = dot(delta, delta);
+        double t = 0.0;
+        if (deltaSqr > 0.0) {
+            t = SGMiscd::clip(-dot(start, delta) / deltaSqr, 0.0, 1.0);
         }
-        ++ai_list_itr;
+
+        if ((hit != 0) && (t >= hitT)) {
+            continue; // can't be earlier than what we have
+        }
+
+        const SGVec3d rel = start + t * delta;
+        double range = norm(rel) * SG_METER_TO_FEET;
+        double ht_diff = fabs(dot(rel, normalize(tgt_pos))) * SG_METER_TO_FEET;
+
+        if (ht_diff > tgt_ht[type] + fuse_range || range >= tgt_length[type] + fuse_range) {
+            continue;
+        }
+
+        SG_LOG(SG_AI, SG_DEBUG, "AIManager: HIT! "
+            << " type " << type
+            << " ID " << _trafficIndex.object(i)->getID()
+            << " range " << range
+            << " alt " << _trafficIndex.altitudeFt(i)
+            );
+        hit = _trafficIndex.object(i);
+        hitT = t;
     }
-    return 0;
+
+    if (hit && hitFraction) {
+        *hitFraction = hitT;
+    }
+    return hit;
 }
 
 double
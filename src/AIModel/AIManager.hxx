@@ -29,6 +29,8 @@
 #include <simgear/structure/subsystem_mgr.hxx>
 #include <simgear/structure/SGSharedPtr.hxx>
 
+#include "AITrafficIndex.hxx"
+
 class FGAIBase;
 class FGAIThermal;
 class FGAIAircraft;
@@ -54,6 +56,17 @@ public:
 
     const FGAIBase *calcCollision(double alt, double lat, double lon, double fuse_range);
 
+    /**
+     * @brief find the first object hit by a projectile moving from
+     * @a from to @a to (cartesian, metres) during a step of @a dt seconds.
+     * Target motion during the step is taken into account, so fast
+     * projectiles can't pass through a target between two frames.
+     * @param hitFraction if non-null, receives the fraction of the step
+     * at which the hit happened
+     */
+    const FGAIBase *calcCollision(const SGVec3d& from, const SGVec3d& to, double dt,
+                                  double fuse_range, double* hitFraction = 0);
+
     inline double get_user_heading() const { return user_heading; }
     inline double get_user_pitch() const { return user_pitch; }
     inline double get_user_speed() const {return user_speed; }
@@ -82,6 +95,13 @@ public:
 
     double calcRangeFt(const SGVec3d& aCartPos, const FGAIBase* aObject) const;
 
+    /**
+     * @brief snapshot of the live AI and multiplayer traffic, rebuilt at the
+     * end of every update(). Use this for range queries instead of scanning
+     * ai_list or the /ai/models property tree.
+     */
+    const FGAITrafficIndex& getTrafficIndex() const { return _trafficIndex; }
+
     static const char* subsystemName() { return "ai-model"; }
     
     /**
@@ -146,6 +166,9 @@ private:
     ScenarioDict _scenarios;
     
     SGSharedPtr<FGAIAircraft> _userAircraft;
+
+    FGAITrafficIndex _trafficIndex;
+    std::vector<int> _collisionCandidates;
 };
 
 #endif  // _FG_AIMANAGER_HXX
@@ -0,0 +1,181 @@
+// AITrafficIndex.cxx - per-frame snapshot and spatial index of AI traffic
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation; either version 2 of the
+// License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include "AITrafficIndex.hxx"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include <simgear/constants.h>
+#include <simgear/props/props.hxx>
+
+#include "AIBase.hxx"
+
+// 10nm cells: most queries (TCAS, collisions) touch a handful of cells,
+// while display-range queries fall back to a linear scan of the arrays
+static const double DEFAULT_CELL_SIZE_M = 10 * SG_NM_TO_METER;
+static const int CELL_COORD_LIMIT = (1 << 20) - 1;
+
+FGAITrafficIndex::FGAITrafficIndex() :
+    _cellSizeM(DEFAULT_CELL_SIZE_M),
+    _maxSpeedMps(0.0)
+{
+}
+
+int FGAITrafficIndex::cellCoord(double v) const
+{
+    double c = floor(v / _cellSizeM);
+    return static_cast<int>(SGMiscd::clip(c, -CELL_COORD_LIMIT, CELL_COORD_LIMIT));
+}
+
+uint64_t FGAITrafficIndex::cellKey(int x, int y, int z) const
+{
+    // 21 bits per axis, offset to make them positive
+    return (static_cast<uint64_t>(x + CELL_COORD_LIMIT + 1) << 42) |
+           (static_cast<uint64_t>(y + CELL_COORD_LIMIT + 1) << 21) |
+            static_cast<uint64_t>(z + CELL_COORD_LIMIT + 1);
+}
+
+void FGAITrafficIndex::clear()
+{
+    _objects.clear();
+    _props.clear();
+    _types.clear();
+    _cartPos.clear();
+    _cartVelocity.clear();
+    _geod.clear();
+    _altitudeFt.clear();
+    _headingDeg.clear();
+    _speedKt.clear();
+    _verticalFps.clear();
+    _transponder.clear();
+    _maxSpeedMps = 0.0;
+    _cells.clear();
+    _cellEntries.clear();
+}
+
+void FGAITrafficIndex::rebuild(const std::vector<SGSharedPtr<FGAIBase> >& aiList)
+{
+    clear();
+
+    for (FGAIBase* ai : aiList) {
+        if (ai->getDie()) {
+            continue;
+        }
+
+        const SGGeod geod = ai->getGeodPos();
+        const double headingDeg = ai->_getHeading();
+        const double speedKt = ai->_getSpeed();
+        const double verticalFps = ai->_getVS_fps();
+
+        // north-east-down velocity, rotated into the earth-centered frame
+        const double hdgRad = headingDeg * SG_DEGREES_TO_RADIANS;
+        const double speedMps = speedKt * SG_KT_TO_MPS;
+        SGVec3d nedVelocity(cos(hdgRad) * speedMps, sin(hdgRad) * speedMps,
+                            -verticalFps * SG_FEET_TO_METER);
+
+        // matches TCAS::ThreatDetector::checkTransponder
+        const char* typeString = ai->getTypeString();
+        bool transponder = !strcmp(typeString, "aircraft");
+        if (!strcmp(typeString, "multiplayer")) {
+            transponder = !ai->_getProps()->getBoolValue("controls/invisible");
+        }
+
+        _objects.push_back(ai);
+        _props.push_back(ai->_getProps());
+        _types.push_back(ai->getType());
+        _geod.push_back(geod);
+        _cartPos.push_back(SGVec3d::fromGeod(geod));
+        _cartVelocity.push_back(SGQuatd::fromLonLat(geod).backTransform(nedVelocity));
+        _altitudeFt.push_back(ai->_getAltitude());
+        _headingDeg.push_back(headingDeg);
+        _speedKt.push_back(speedKt);
+        _verticalFps.push_back(verticalFps);
+        _transponder.push_back(transponder);
+        _maxSpeedMps = std::max(_maxSpeedMps, norm(_cartVelocity.back()));
+    }
+
+    // bucket the objects by grid cell
+    const int count = size();
+    _sortScratch.resize(count);
+    for (int i = 0; i < count; ++i) {
+        const SGVec3d& p = _cartPos[i];
+        _sortScratch[i] = std::make_pair(cellKey(cellCoord(p.x()), cellCoord(p.y()), cellCoord(p.z())), i);
+    }
+    std::sort(_sortScratch.begin(), _sortScratch.end());
+
+    _cells.clear();
+    _cellEntries.resize(count);
+    for (int i = 0; i < count; ++i) {
+        _cellEntries[i] = _sortScratch[i].second;
+        if ((i == 0) || (_sortScratch[i].first != _sortScratch[i - 1].first)) {
+            _cells[_sortScratch[i].first] = CellRange(i, i + 1);
+        } else {
+            _cells[_sortScratch[i].first].second = i + 1;
+        }
+    }
+}
+
+void FGAITrafficIndex::query(const SGVec3d& cartPos, double rangeM, std::vector<int>& result) const
+{
+    result.clear();
+    if (_objects.empty() || !(rangeM >= 0.0)) {
+        return;
+    }
+
+    const double rangeSqr = rangeM * rangeM;
+    const int x0 = cellCoord(cartPos.x() - rangeM), x1 = cellCoord(cartPos.x() + rangeM);
+    const int y0 = cellCoord(cartPos.y() - rangeM), y1 = cellCoord(cartPos.y() + rangeM);
+    const int z0 = cellCoord(cartPos.z() - rangeM), z1 = cellCoord(cartPos.z() + rangeM);
+
+    const double cellCount = double(x1 - x0 + 1) * (y1 - y0 + 1) * (z1 - z0 + 1);
+    if (cellCount >= _cells.size()) {
+        // the query box covers more cells than are occupied, scanning
+        // the position array is cheaper than probing the grid
+        const int count = size();
+        for (int i = 0; i < count; ++i) {
+            if (distSqr(_cartPos[i], cartPos) <= rangeSqr) {
+                result.push_back(i);
+            }
+        }
+        return;
+    }
+
+    for (int x = x0; x <= x1; ++x) {
+        for (int y = y0; y <= y1; ++y) {
+            for (int z = z0; z <= z1; ++z) {
+                auto it = _cells.find(cellKey(x, y, z));
+                if (it == _cells.end()) {
+                    continue;
+                }
+
+                for (int e = it->second.first; e < it->second.second; ++e) {
+                    const int i = _cellEntries[e];
+                    if (distSqr(_cartPos[i], cartPos) <= rangeSqr) {
+                        result.push_back(i);
+                    }
+                }
+            }
+        }
+    }
+
+    std::sort(result.begin(), result.end());
+}
@@ -0,0 +1,110 @@
+// AITrafficIndex.hxx - per-frame snapshot and spatial index of AI traffic
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation; either version 2 of the
+// License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+#ifndef _FG_AITRAFFICINDEX_HXX
+#define _FG_AITRAFFICINDEX_HXX
+
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+
+#include <simgear/math/SGMath.hxx>
+#include <simgear/structure/SGSharedPtr.hxx>
+
+class FGAIBase;
+class SGPropertyNode;
+
+/**
+ * @brief Snapshot of the live AI and multiplayer objects, taken once per
+ * frame by FGAIManager, so instruments don't have to walk /ai/models.
+ * The manager rebuilds it right after removing the dead objects, before
+ * updating the others, so it never refers to an object already deleted.
+ *
+ * The per-object data is stored as parallel arrays; live objects keep the
+ * order of the AI list at the time of the snapshot. A uniform grid
+ * over the cartesian positions answers range queries. Indices and pointers
+ * are only valid until the next rebuild().
+ */
+class FGAITrafficIndex
+{
+public:
+    FGAITrafficIndex();
+
+    void rebuild(const std::vector<SGSharedPtr<FGAIBase> >& aiList);
+
+    /// drop the snapshot, when the objects it refers to go away
+    void clear();
+
+    /**
+     * @brief find all objects within rangeM of cartPos.
+     * @param result receives the matching indices in ascending order, so
+     * callers see objects in the same order as in the AI list
+     */
+    void query(const SGVec3d& cartPos, double rangeM, std::vector<int>& result) const;
+
+    int size() const { return static_cast<int>(_objects.size()); }
+
+    /// fastest object in the snapshot, to bound how far anything moves in a step
+    double maxSpeedMps() const { return _maxSpeedMps; }
+
+    FGAIBase* object(int i) const { return _objects[i]; }
+    SGPropertyNode* props(int i) const { return _props[i]; }
+    int type(int i) const { return _types[i]; }
+
+    const SGVec3d& cartPos(int i) const { return _cartPos[i]; }
+    /// velocity in the earth-centered frame, metres per second
+    const SGVec3d& cartVelocity(int i) const { return _cartVelocity[i]; }
+    const SGGeod& geod(int i) const { return _geod[i]; }
+
+    double altitudeFt(int i) const { return _altitudeFt[i]; }
+    double headingDeg(int i) const { return _headingDeg[i]; }
+    double speedKt(int i) const { return _speedKt[i]; }
+    double verticalFps(int i) const { return _verticalFps[i]; }
+
+    /**
+     * @brief AI aircraft and visible multiplayer aircraft are assumed to
+     * carry a transponder; ships, ground vehicles etc. don't.
+     */
+    bool hasTransponder(int i) const { return _transponder[i]; }
+
+private:
+    uint64_t cellKey(int x, int y, int z) const;
+    int cellCoord(double v) const;
+
+    std::vector<FGAIBase*> _objects;
+    std::vector<SGPropertyNode*> _props;
+    std::vector<int> _types;
+    std::vector<SGVec3d> _cartPos;
+    std::vector<SGVec3d> _cartVelocity;
+    std::vector<SGGeod> _geod;
+    std::vector<double> _altitudeFt;
+    std::vector<double> _headingDeg;
+    std::vector<double> _speedKt;
+    std::vector<double> _verticalFps;
+    std::vector<char> _transponder;
+
+    double _cellSizeM;
+    double _maxSpeedMps;
+
+    // object indices sorted by cell, and the [begin, end) range in
+    // _cellEntries of every occupied cell
+    typedef std::pair<int, int> CellRange;
+    std::vector<int> _cellEntries;
+    std::unordered_map<uint64_t, CellRange> _cells;
+    std::vector<std::pair<uint64_t, int> > _sortScratch;
+};
+
+#endif // _FG_AITRAFFICINDEX_HXX
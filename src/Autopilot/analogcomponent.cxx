@@ -49,6 +49,28 @@ double AnalogComponent::clamp( double value ) const
     return value;
 }
 
+bool AnalogComponent::collectDependencies( PropertyNodeSet& reads,
+                                           PropertyNodeSet& writes ) const
+{
+  bool complete = Component::collectDependencies(reads, writes);
+
+  const InputValueList* inputs[] = { &_valueInput, &_referenceInput,
+                                     &_minInput, &_maxInput };
+  for( size_t i = 0; i < sizeof(inputs)/sizeof(inputs[0]); ++i )
+    if( !inputs[i]->collectDependencies(reads) )
+      complete = false;
+  if( _periodical && !_periodical->collectDependencies(reads) )
+    complete = false;
+  if( _honor_passive )
+    reads.insert( _passive_mode.ptr() );
+
+  for( simgear::PropertyList::const_iterator it = _output_list.begin();
+       it != _output_list.end(); ++it)
+    writes.insert( it->ptr() );
+
+  return complete;
+}
+
 bool AnalogComponent::configure( SGPropertyNode& cfg_node,
                                  const std::string& cfg_name,
                                  SGPropertyNode& prop_root )
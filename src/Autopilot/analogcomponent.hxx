@@ -139,6 +139,9 @@ protected:
 
 public:
     const PeriodicalValue * getPeriodicalValue() const { return _periodical; }
+
+    virtual bool collectDependencies( PropertyNodeSet& reads,
+                                      PropertyNodeSet& writes ) const;
 };
 
 inline void AnalogComponent::disabled( double dt )
@@ -31,6 +31,7 @@
 #include <simgear/sg_inlines.h>
 
 #include "component.hxx"
+#include "componentgraph.hxx"
 #include "functor.hxx"
 #include "predictor.hxx"
 #include "digitalfilter.hxx"
@@ -120,7 +121,9 @@ static ComponentForge componentForge;
 Autopilot::Autopilot( SGPropertyNode_ptr rootNode, SGPropertyNode_ptr configNode ) :
   _name("unnamed autopilot"),
   _serviceable(true),
-  _rootNode(rootNode)
+  _rootNode(rootNode),
+  _graphBuilt(false),
+  _graphTiming(false)
 {
   if (componentForge.empty())
   {
@@ -136,6 +139,11 @@ Autopilot::Autopilot( SGPropertyNode_ptr rootNode, SGPropertyNode_ptr configNode
   if( !configNode )
     configNode = rootNode;
 
+  _dataflowNode = rootNode->getNode("dataflow", true);
+  _timingNode = _dataflowNode->getNode("timing", true);
+  if( _dataflowNode->getBoolValue("enabled", false) )
+    _graph.reset(new ComponentGraph);
+
   // property-root can be set in config file and overridden in the local system
   // node. This allows using the same autopilot multiple times but with
   // different paths (with all relative property paths being relative to the
@@ -214,11 +222,27 @@ void Autopilot::add_component( Component * component, double updateInterval )
     SG_LOG( SG_AUTOPILOT, SG_WARN, "Duplicate autopilot component " << component->get_name() << ", renamed to " << name );
 
   set_subsystem( name.c_str(), component, updateInterval );
+  if( _graph )
+    _graph->add( name, component, updateInterval );
 }
 
 void Autopilot::update( double dt ) 
 {
   if( !_serviceable || dt <= SGLimitsd::min() )
     return;
-  SGSubsystemGroup::update( dt );
+
+  if( !_graph ) {
+    SGSubsystemGroup::update( dt );
+    return;
+  }
+
+  if( !_graphBuilt ) {
+    _graph->build();
+    _graphBuilt = true;
+  }
+  if( _graphTiming != _timingNode->getBoolValue() ) {
+    _graphTiming = !_graphTiming;
+    _graph->setTimingNode( _graphTiming ? _dataflowNode.get() : NULL );
+  }
+  _graph->update( dt );
 }
@@ -23,16 +23,25 @@
 #ifndef __AUTOPILOT_HXX
 #define __AUTOPILOT_HXX 1
 
+#include <memory>
+
 #include <simgear/props/props.hxx>
 #include <simgear/structure/subsystem_mgr.hxx>
 
 namespace FGXMLAutopilot {
 
 class Component;
+class ComponentGraph;
   
 /**
  * @brief A SGSubsystemGroup implementation to serve as a collection
  * of Components
+ *
+ * The components are updated in order of declaration, or if dataflow/enabled
+ * is set in the root node, in the order of their dependencies by a
+ * ComponentGraph, which also skips unchanged stateless ones. Setting
+ * dataflow/timing then publishes the time spent in each component under
+ * dataflow.
  */
 class Autopilot : public SGSubsystemGroup
 {
@@ -58,6 +67,12 @@ private:
     std::string _name;
     bool _serviceable;
     SGPropertyNode_ptr _rootNode;
+
+    std::unique_ptr<ComponentGraph> _graph;
+    bool _graphBuilt;
+    bool _graphTiming;
+    SGPropertyNode_ptr _dataflowNode;
+    SGPropertyNode_ptr _timingNode;
 };
 
 }
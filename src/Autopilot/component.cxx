@@ -131,6 +131,15 @@ bool Component::isPropertyEnabled()
     return true;
 }
 
+//------------------------------------------------------------------------------
+bool Component::collectDependencies( PropertyNodeSet& reads,
+                                     PropertyNodeSet& writes ) const
+{
+  if( _enable_prop )
+    reads.insert( _enable_prop.ptr() );
+  return !_condition;
+}
+
 void Component::update( double dt )
 {
   bool firstTime = false;
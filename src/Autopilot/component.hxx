@@ -30,6 +30,8 @@
 #include <simgear/structure/subsystem_mgr.hxx>
 #include <simgear/props/propsfwd.hxx>
 
+#include "inputvalue.hxx"
+
 namespace FGXMLAutopilot {
 
 /**
@@ -138,6 +140,22 @@ public:
      * Returns true, if neither &lt;condition&gt; nor &lt;prop&gt; exists
      */
     bool isPropertyEnabled();
+
+    /**
+     * @brief add the properties this component reads to reads and the ones
+     *        it writes to writes. Used to order the components of an
+     *        autopilot by their dependencies.
+     * @return true if all the properties read were added, false if some are
+     *         hidden in conditions or expressions
+     */
+    virtual bool collectDependencies( PropertyNodeSet& reads,
+                                      PropertyNodeSet& writes ) const;
+
+    /**
+     * @brief true if the outputs only depend on the current inputs, so that
+     *        the component need not run again until one of them changes
+     */
+    virtual bool isStateless() const { return false; }
 };
 
 
@@ -0,0 +1,260 @@
+// componentgraph.cxx - evaluate autopilot components in dependency order
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation; either version 2 of the
+// License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//
+
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include "componentgraph.hxx"
+
+#include <functional>
+#include <map>
+#include <queue>
+
+#include <simgear/debug/logstream.hxx>
+#include <simgear/timing/timestamp.hxx>
+
+#include "component.hxx"
+
+using namespace FGXMLAutopilot;
+
+static bool isText( const SGPropertyNode* node )
+{
+  simgear::props::Type type = node->getType();
+  return type == simgear::props::STRING || type == simgear::props::UNSPECIFIED;
+}
+
+ComponentGraph::ComponentGraph() :
+  _timingElapsed(0.0),
+  _timingFrames(0)
+{
+}
+
+void ComponentGraph::add( const std::string& name, Component* component,
+                          double updateInterval )
+{
+  Entry entry;
+  entry.name = name;
+  entry.component = component;
+  entry.updateInterval = updateInterval;
+  entry.elapsed = 0.0;
+  entry.skippable = false;
+  entry.valid = false;
+  entry.watchBegin = entry.watchEnd = 0;
+  entry.runs = entry.skips = 0;
+  entry.runTime = 0.0;
+  _components.push_back(entry);
+}
+
+void ComponentGraph::build()
+{
+  size_t count = _components.size();
+  std::vector<PropertyNodeSet> reads(count), writes(count);
+  std::vector<bool> complete(count);
+  std::map<SGPropertyNode*, std::vector<size_t> > writers;
+
+  for( size_t i = 0; i < count; ++i ) {
+    complete[i] = _components[i].component->collectDependencies(reads[i], writes[i]);
+    for( PropertyNodeSet::iterator it = writes[i].begin(); it != writes[i].end(); ++it )
+      writers[*it].push_back(i);
+  }
+
+  // an edge from each writer of a property to each of its readers
+  std::vector<std::vector<size_t> > successors(count);
+  std::vector<size_t> predecessors(count, 0);
+  for( size_t i = 0; i < count; ++i ) {
+    std::vector<bool> linked(count, false);
+    for( PropertyNodeSet::iterator it = reads[i].begin(); it != reads[i].end(); ++it ) {
+      std::map<SGPropertyNode*, std::vector<size_t> >::iterator w = writers.find(*it);
+      if( w == writers.end() )
+        continue;
+      for( size_t j = 0; j < w->second.size(); ++j ) {
+        size_t writer = w->second[j];
+        if( writer == i || linked[writer] )
+          continue;
+        linked[writer] = true;
+        successors[writer].push_back(i);
+        ++predecessors[i];
+      }
+    }
+  }
+
+  // topological order, the first declared first among the ready ones
+  std::priority_queue<size_t, std::vector<size_t>, std::greater<size_t> > ready;
+  for( size_t i = 0; i < count; ++i )
+    if( predecessors[i] == 0 )
+      ready.push(i);
+
+  std::vector<bool> placed(count, false);
+  size_t loops = 0;
+  _order.clear();
+  while( _order.size() < count ) {
+    if( ready.empty() ) {
+      // a loop: break it at the first declared component left
+      size_t first = 0;
+      while( placed[first] || predecessors[first] == 0 )
+        ++first;
+      predecessors[first] = 0;
+      ready.push(first);
+      ++loops;
+    }
+
+    size_t i = ready.top();
+    ready.pop();
+    placed[i] = true;
+    _order.push_back(i);
+    for( size_t j = 0; j < successors[i].size(); ++j ) {
+      size_t next = successors[i][j];
+      if( !placed[next] && predecessors[next] > 0 && --predecessors[next] == 0 )
+        ready.push(next);
+    }
+  }
+
+  // the properties to compare for the skippable components
+  _watched.clear();
+  size_t skippable = 0;
+  for( size_t i = 0; i < count; ++i ) {
+    Entry& entry = _components[i];
+    entry.skippable = complete[i] && entry.component->isStateless()
+                   && entry.updateInterval <= 0.0;
+    entry.valid = false;
+    entry.watchBegin = _watched.size();
+    if( entry.skippable ) {
+      ++skippable;
+      _watched.insert(_watched.end(), reads[i].begin(), reads[i].end());
+      for( PropertyNodeSet::iterator it = writes[i].begin(); it != writes[i].end(); ++it )
+        if( !reads[i].count(*it) )
+          _watched.push_back(*it);
+    }
+    entry.watchEnd = _watched.size();
+  }
+  _numbers.assign(_watched.size(), 0.0);
+  _texts.assign(_watched.size(), std::string());
+
+  SG_LOG( SG_AUTOPILOT, SG_INFO, "ordered " << count << " autopilot components, "
+          << skippable << " skippable, " << loops << " loop(s) broken" );
+}
+
+bool ComponentGraph::unchanged( const Entry& entry ) const
+{
+  if( !entry.valid )
+    return false;
+
+  for( size_t i = entry.watchBegin; i < entry.watchEnd; ++i ) {
+    const SGPropertyNode* node = _watched[i];
+    if( isText(node) ) {
+      if( _texts[i] != node->getStringValue() )
+        return false;
+    } else if( _numbers[i] != node->getDoubleValue() ) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void ComponentGraph::record( const Entry& entry )
+{
+  for( size_t i = entry.watchBegin; i < entry.watchEnd; ++i ) {
+    const SGPropertyNode* node = _watched[i];
+    if( isText(node) )
+      _texts[i] = node->getStringValue();
+    else
+      _numbers[i] = node->getDoubleValue();
+  }
+}
+
+void ComponentGraph::update( double dt )
+{
+  bool timing = _timingNode.valid();
+
+  for( size_t n = 0; n < _order.size(); ++n ) {
+    Entry& entry = _components[_order[n]];
+
+    // like SGSubsystemGroup does for its members
+    entry.elapsed += dt;
+    if( entry.elapsed < entry.updateInterval )
+      continue;
+    if( entry.component->is_suspended() )
+      continue;
+    double elapsed = entry.elapsed;
+    entry.elapsed = 0.0;
+
+    if( entry.skippable && unchanged(entry) ) {
+      ++entry.skips;
+      continue;
+    }
+
+    SGSubsystem* subsystem = entry.component;
+    if( timing ) {
+      SGTimeStamp start = SGTimeStamp::now();
+      subsystem->update(elapsed);
+      entry.runTime += (SGTimeStamp::now() - start).toSecs();
+    } else {
+      subsystem->update(elapsed);
+    }
+    ++entry.runs;
+
+    if( entry.skippable ) {
+      record(entry);
+      entry.valid = true;
+    }
+  }
+
+  if( timing ) {
+    _timingElapsed += dt;
+    ++_timingFrames;
+    if( _timingElapsed >= 1.0 )
+      publishTiming();
+  }
+}
+
+void ComponentGraph::setTimingNode( SGPropertyNode* node )
+{
+  _timingNode = node;
+  _timingElapsed = 0.0;
+  _timingFrames = 0;
+  for( size_t i = 0; i < _components.size(); ++i ) {
+    _components[i].runs = _components[i].skips = 0;
+    _components[i].runTime = 0.0;
+  }
+}
+
+void ComponentGraph::publishTiming()
+{
+  unsigned runs = 0, skips = 0;
+  double runTime = 0.0;
+  for( size_t n = 0; n < _order.size(); ++n ) {
+    Entry& entry = _components[_order[n]];
+    SGPropertyNode* node = _timingNode->getChild("component", n, true);
+    node->setStringValue("name", entry.name);
+    node->setIntValue("runs", entry.runs);
+    node->setIntValue("skips", entry.skips);
+    node->setDoubleValue("mean-time-us",
+                         entry.runs ? 1e6 * entry.runTime / entry.runs : 0.0);
+
+    runs += entry.runs;
+    skips += entry.skips;
+    runTime += entry.runTime;
+    entry.runs = entry.skips = 0;
+    entry.runTime = 0.0;
+  }
+  _timingNode->setIntValue("runs", runs);
+  _timingNode->setIntValue("skips", skips);
+  _timingNode->setDoubleValue("mean-frame-time-us", 1e6 * runTime / _timingFrames);
+  _timingElapsed = 0.0;
+  _timingFrames = 0;
+}
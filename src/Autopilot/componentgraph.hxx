@@ -0,0 +1,108 @@
+// componentgraph.hxx - evaluate autopilot components in dependency order
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation; either version 2 of the
+// License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//
+#ifndef __COMPONENTGRAPH_HXX
+#define __COMPONENTGRAPH_HXX 1
+
+#include <string>
+#include <vector>
+
+#include <simgear/props/props.hxx>
+
+namespace FGXMLAutopilot {
+
+class Component;
+
+/**
+ * @brief The components of an autopilot, ordered by the properties they
+ * read and write.
+ *
+ * A component runs after the components writing the properties it reads,
+ * so that a value computed in a frame is used in the same frame whatever
+ * the order of declaration. Components not depending on each other, and
+ * the ones in a loop, keep their order of declaration.
+ *
+ * Stateless components whose inputs are all known are skipped as long as
+ * their inputs, and their outputs, keep the values they had after their
+ * last run. Skipping one leaves its outputs unchanged, so a whole chain
+ * of them is skipped when the value at its head does not change.
+ *
+ * The time spent in each component can be published under a property
+ * node, see setTimingNode().
+ */
+class ComponentGraph {
+public:
+    ComponentGraph();
+
+    /**
+     * @brief add a component, in order of declaration
+     * @param updateInterval minimum time between two runs, 0 for every frame
+     */
+    void add( const std::string& name, Component* component,
+              double updateInterval );
+
+    /**
+     * @brief order the components added so far
+     */
+    void build();
+
+    void update( double dt );
+
+    /**
+     * @brief publish the timing of the components under node every
+     * second: the number of runs and skips and the mean run time of each
+     * component, and the mean time per frame of all of them. NULL stops.
+     */
+    void setTimingNode( SGPropertyNode* node );
+
+    size_t size() const { return _components.size(); }
+
+private:
+    struct Entry {
+        std::string name;
+        Component* component;
+        double updateInterval;
+        double elapsed;
+
+        // the properties compared to decide whether it can be skipped,
+        // in [watchBegin, watchEnd) of the dense arrays below
+        bool skippable;
+        bool valid;
+        size_t watchBegin, watchEnd;
+
+        unsigned runs, skips;
+        double runTime;
+    };
+
+    bool unchanged( const Entry& entry ) const;
+    void record( const Entry& entry );
+    void publishTiming();
+
+    std::vector<Entry> _components;
+    std::vector<size_t> _order;
+
+    std::vector<SGPropertyNode*> _watched;
+    std::vector<double> _numbers;
+    std::vector<std::string> _texts;
+
+    SGPropertyNode_ptr _timingNode;
+    double _timingElapsed;
+    unsigned _timingFrames;
+};
+
+}
+
+#endif // __COMPONENTGRAPH_HXX
@@ -107,3 +107,15 @@ bool DigitalComponent::configure( SGPropertyNode& cfg_node,
   
   return Component::configure(cfg_node, cfg_name, prop_root);
 }
+
+bool DigitalComponent::collectDependencies( PropertyNodeSet& reads,
+                                            PropertyNodeSet& writes ) const
+{
+  bool complete = Component::collectDependencies(reads, writes) && _input.empty();
+
+  for( OutputMap::const_iterator it = _output.begin(); it != _output.end(); ++it )
+    if( it->second->getProperty() )
+      writes.insert( it->second->getProperty() );
+
+  return complete;
+}
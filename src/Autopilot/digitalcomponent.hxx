@@ -52,6 +52,8 @@ public:
   inline void setInverted( bool value ) { _inverted = value; }
   inline bool isInverted() const { return _inverted; }
 
+  SGPropertyNode* getProperty() const { return _node; }
+
   bool getValue() const;
   void setValue( bool value );
 };
@@ -130,6 +132,13 @@ protected:
     virtual bool configure( SGPropertyNode& cfg_node,
                             const std::string& cfg_name,
                             SGPropertyNode& prop_root );
+
+public:
+    /**
+     * @brief the outputs are known, the inputs are conditions and are not
+     */
+    virtual bool collectDependencies( PropertyNodeSet& reads,
+                                      PropertyNodeSet& writes ) const;
 };
 
 }
@@ -46,6 +46,8 @@ class DigitalFilterImplementation:
     virtual bool configure( SGPropertyNode& cfg_node,
                             const std::string& cfg_name,
                             SGPropertyNode& prop_root ) = 0;
+    // add the properties read by the inputs specific to the filter
+    virtual bool collectDependencies( PropertyNodeSet& reads ) const { return false; }
 
     void setDigitalFilter( DigitalFilter * digitalFilter ) { _digitalFilter = digitalFilter; }
 
@@ -64,6 +66,10 @@ protected:
 public:
   GainFilterImplementation() : _gainInput(1.0) {}
   double compute(  double dt, double input );
+  // only the gain, the derived filters keep state and their other inputs
+  // are not needed for ordering
+  bool collectDependencies( PropertyNodeSet& reads ) const
+  { return _gainInput.collectDependencies(reads); }
 };
 
 class ReciprocalFilterImplementation : public GainFilterImplementation {
@@ -707,7 +713,8 @@ bool LeadLagFilterImplementation::configure( SGPropertyNode& cfg_node,
 
 DigitalFilter::DigitalFilter() :
     AnalogComponent(),
-    _initializeTo(INITIALIZE_INPUT)
+    _initializeTo(INITIALIZE_INPUT),
+    _stateless(false)
 {
 }
 
@@ -756,6 +763,7 @@ bool DigitalFilter::configure( SGPropertyNode& prop_root,
 
   _implementation = (*component_factory->second)();
   _implementation->setDigitalFilter( this );
+  _stateless = type == "gain" || type == "reciprocal";
 
   for( int i = 0; i < cfg.nChildren(); ++i )
   {
@@ -805,6 +813,16 @@ bool DigitalFilter::configure( SGPropertyNode& cfg_node,
   return AnalogComponent::configure(cfg_node, cfg_name, prop_root);
 }
 
+//------------------------------------------------------------------------------
+bool DigitalFilter::collectDependencies( PropertyNodeSet& reads,
+                                         PropertyNodeSet& writes ) const
+{
+  bool complete = AnalogComponent::collectDependencies(reads, writes);
+  if( !_implementation || !_implementation->collectDependencies(reads) )
+    complete = false;
+  return complete;
+}
+
 //------------------------------------------------------------------------------
 void DigitalFilter::update( bool firstTime, double dt)
 {
@@ -58,6 +58,9 @@ class DigitalFilter : public AnalogComponent
     InputValueList _gain;
     InitializeTo _initializeTo;
 
+    // gain and reciprocal filters, whose output is a function of the input
+    bool _stateless;
+
 public:
     DigitalFilter();
     ~DigitalFilter();
@@ -65,6 +68,10 @@ public:
     virtual bool configure( SGPropertyNode& prop_root,
                             SGPropertyNode& cfg );
 
+    virtual bool collectDependencies( PropertyNodeSet& reads,
+                                      PropertyNodeSet& writes ) const;
+    virtual bool isStateless() const { return _stateless; }
+
 };
 
 } // namespace FGXMLAutopilot
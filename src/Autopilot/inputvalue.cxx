@@ -65,6 +65,17 @@ double PeriodicalValue::normalizeSymmetric( double value ) const
   return value > width_2 ? width_2 - value : value;
 }
 
+//------------------------------------------------------------------------------
+bool PeriodicalValue::collectDependencies( PropertyNodeSet& reads ) const
+{
+  bool complete = true;
+  if( minPeriod && !minPeriod->collectDependencies(reads) )
+    complete = false;
+  if( maxPeriod && !maxPeriod->collectDependencies(reads) )
+    complete = false;
+  return complete;
+}
+
 //------------------------------------------------------------------------------
 InputValue::InputValue( SGPropertyNode& prop_root,
                         SGPropertyNode& cfg,
@@ -173,6 +184,24 @@ void InputValue::set_value( double aValue )
         _property->setDoubleValue( 0 ); // if scale is zero, value*scale is zero
 }
 
+bool InputValue::collectDependencies( PropertyNodeSet& reads ) const
+{
+    // the properties behind conditions and expressions are not known
+    bool complete = !_condition && !_expression;
+
+    if( _property )
+        reads.insert( _property.ptr() );
+
+    InputValue_ptr parts[] = { _scale, _offset, _min, _max };
+    for( size_t i = 0; i < sizeof(parts)/sizeof(parts[0]); ++i ) {
+        if( parts[i] && !parts[i]->collectDependencies(reads) )
+            complete = false;
+    }
+    if( _periodical && !_periodical->collectDependencies(reads) )
+        complete = false;
+    return complete;
+}
+
 double InputValue::get_value() const
 {
     double value = _value;
@@ -26,11 +26,14 @@
 #endif
 
 
+#include <set>
+
 #include <simgear/structure/SGExpression.hxx>
 
 namespace FGXMLAutopilot {
 
 typedef SGSharedPtr<class InputValue> InputValue_ptr;
+typedef std::set<SGPropertyNode*> PropertyNodeSet;
 typedef SGSharedPtr<class PeriodicalValue> PeriodicalValue_ptr;
 
 /**
@@ -48,6 +51,7 @@ public:
                       SGPropertyNode& cfg );
      double normalize( double value ) const;
      double normalizeSymmetric( double value ) const;
+     bool collectDependencies( PropertyNodeSet& reads ) const;
 };
 
 /**
@@ -109,6 +113,13 @@ public:
       return _condition == NULL ? true : _condition->test();
     }
 
+    /**
+     * @brief add the properties this value is computed from to reads
+     * @return false if some could not be added, as for conditions and
+     *         expressions
+     */
+    bool collectDependencies( PropertyNodeSet& reads ) const;
+
 };
 
 /**
@@ -134,6 +145,15 @@ class InputValueList : public std::vector<InputValue_ptr> {
       InputValue_ptr input = get_active();
       return input == NULL ? _def : input->get_value();
     }
+
+    bool collectDependencies( PropertyNodeSet& reads ) const {
+      bool complete = true;
+      for (const_iterator it = begin(); it != end(); ++it) {
+        if( !(*it)->collectDependencies(reads) )
+          complete = false;
+      }
+      return complete;
+    }
   private:
 
     double _def;
@@ -72,6 +72,7 @@ using std::string;
 #include <Navaids/fix.hxx>
 #include <Airports/airport.hxx>
 #include <Airports/runways.hxx>
+#include <AIModel/AIManager.hxx>
 #include "od_gauge.hxx"
 
 static const char *DEFAULT_FONT = "typewriter.txf";
@@ -1312,13 +1313,20 @@ static string mapAINodeToType(SGPropertyNode* model)
 
 void NavDisplay::processAI()
 {
-    SGPropertyNode *ai = fgGetNode("/ai/models", true);
-    for (int i = ai->nChildren() - 1; i >= 0; i--) {
-        SGPropertyNode *model = ai->getChild(i);
-        if (!model->nChildren()) {
-            continue;
-        }
-        
+    FGAIManager* aiManager = globals->get_subsystem<FGAIManager>();
+    if (!aiManager) {
+        return;
+    }
+
+    // generous enough for off-centre display modes and high-flying traffic,
+    // symbols outside the display are clipped below anyway
+    const FGAITrafficIndex& traffic = aiManager->getTrafficIndex();
+    const double queryRangeM = 2 * _rangeNm * SG_NM_TO_METER + 100000 * SG_FEET_TO_METER;
+    traffic.query(SGVec3d::fromGeod(_pos), queryRangeM, _aiInRange);
+
+    for (std::vector<int>::const_reverse_iterator it = _aiInRange.rbegin(); it != _aiInRange.rend(); ++it) {
+        SGPropertyNode *model = traffic.props(*it);
+
     // prefix types with 'ai-', to avoid any chance of namespace collisions
     // with fg-positioned.
         string_set ss;
@@ -1326,13 +1334,11 @@ void NavDisplay::processAI()
         SymbolRuleVector rules;
         findRules(mapAINodeToType(model), ss, rules);
         if (rules.empty()) {
-            return; // no rules matched, we can skip this item
+            continue; // no rules matched, we can skip this item
         }
 
-        double heading = model->getDoubleValue("orientation/true-heading-deg");
-        SGGeod aiModelPos = SGGeod::fromDegFt(model->getDoubleValue("position/longitude-deg"), 
-                                            model->getDoubleValue("position/latitude-deg"), 
-                                            model->getDoubleValue("position/altitude-ft"));
+        double heading = traffic.headingDeg(*it);
+        SGGeod aiModelPos = SGGeod::fromGeodFt(traffic.geod(*it), traffic.altitudeFt(*it));
     // compute some additional props
         int fl = (aiModelPos.getElevationFt() / 1000);
         model->setIntValue("flight-level", fl * 10);
@@ -193,6 +193,7 @@ private:
     bool _cachedItemsValid;
     SGVec3d _cachedPos;
     FGPositionedList _itemsInRange;
+    std::vector<int> _aiInRange;
     SGPropertyNode_ptr _excessDataNode;
     int _maxSymbols;
     SGPropertyNode_ptr _customSymbols;
@@ -56,6 +56,8 @@ using std::string;
 
 #include <Main/fg_props.hxx>
 #include <Main/globals.hxx>
+#include <AIModel/AIManager.hxx>
+#include <AIModel/AIBase.hxx>
 
 #include "panel.hxx" // for FGTextureManager
 #include "od_gauge.hxx"
@@ -705,27 +707,37 @@ wxRadarBg::update_aircraft()
 
     int selected_id = fgGetInt("/instrumentation/radar/selected-id", -1);
 
-    const SGPropertyNode *selected_ac = 0;
-    const SGPropertyNode *ai = fgGetNode("/ai/models", true);
+    FGAIManager* aiManager = globals->get_subsystem<FGAIManager>();
+    if (!aiManager)
+        return;
+
+    // no target is detectable beyond the range for the largest cross
+    // section (see inRadarRange), allow for the altitude difference too
+    const FGAITrafficIndex& traffic = aiManager->getTrafficIndex();
+    double ref_rng = (_radar_ref_rng > 0) ? _radar_ref_rng : 35;
+    double max_range_m = ref_rng * pow(100.0, 0.25) * SG_NM_TO_METER + 100000 * SG_FEET_TO_METER;
+    traffic.query(SGVec3d::fromGeod(SGGeod::fromDegFt(user_lon, user_lat, user_alt)),
+                  max_range_m, _ai_in_range);
 
-    for (int i = ai->nChildren() - 1; i >= -1; i--) {
-        const SGPropertyNode *model;
+    int selected_ac = -1;
 
-        if (i < 0) { // last iteration: selected model
-            model = selected_ac;
+    for (int n = _ai_in_range.size() - 1; n >= -1; n--) {
+        int i;
+
+        if (n < 0) { // last iteration: selected model
+            i = selected_ac;
         } else {
-            model = ai->getChild(i);
-            if (!model->nChildren())
-                continue;
-            if ((model->getIntValue("id") == selected_id)&&
+            i = _ai_in_range[n];
+            if ((traffic.object(i)->getID() == selected_id)&&
                 (!draw_tcas)) {
-                selected_ac = model;  // save selected model for last iteration
+                selected_ac = i;  // save selected model for last iteration
                 continue;
             }
         }
-        if (!model)
+        if (i < 0)
             continue;
 
+        const SGPropertyNode *model = traffic.props(i);
         double echo_radius, sigma;
         const string name = model->getName();
 
@@ -745,10 +757,10 @@ wxRadarBg::update_aircraft()
         else
             continue;
 
-        double lat = model->getDoubleValue("position/latitude-deg");
-        double lon = model->getDoubleValue("position/longitude-deg");
-        double alt = model->getDoubleValue("position/altitude-ft");
-        double heading = model->getDoubleValue("orientation/true-heading-deg");
+        double lat = traffic.geod(i).getLatitudeDeg();
+        double lon = traffic.geod(i).getLongitudeDeg();
+        double alt = traffic.altitudeFt(i);
+        double heading = traffic.headingDeg(i);
 
         double range, bearing;
         calcRangeBearing(user_lat, user_lon, lat, lon, range, bearing);
@@ -801,9 +813,9 @@ wxRadarBg::update_aircraft()
             addQuad(_vertices, _texCoords, m, texBase);
         }
 
-        if ((draw_data || i < 0)&&  // selected one (i == -1) is always drawn
+        if ((draw_data || n < 0)&&  // selected one (n == -1) is always drawn
             ((!draw_tcas)||(is_tcas_contact)||(draw_echoes)))
-            update_data(model, alt, heading, radius, bearing, i < 0);
+            update_data(model, alt, heading, radius, bearing, n < 0);
     }
 }
 
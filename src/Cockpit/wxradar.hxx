@@ -95,6 +95,7 @@ private:
     DisplayMode _display_mode;
 
     float _range_nm;
+    std::vector<int> _ai_in_range;
     float _scale;   // factor to convert nm to display units
     float _angle_offset;
     float _view_heading;
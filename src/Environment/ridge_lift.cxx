@@ -139,14 +139,22 @@ void FGRidgeLift::update(double dt) {
 		SGGeoc myGeocPos = SGGeoc::fromGeod( myGeodPos );
 		double ground_wind_from_rad = _surface_wind_from_deg_node->getDoubleValue() * SG_DEGREES_TO_RADIANS;
 
-		// compute the remaining probes
-		for (unsigned i = 1; i < sizeof(probe_elev_m)/sizeof(probe_elev_m[0]); i++) {
+		// compute the remaining probes, in one query of the scenery
+		const unsigned num_probes = sizeof(probe_elev_m)/sizeof(probe_elev_m[0]);
+		SGGeod probeGeod[num_probes];
+		FGElevationResult probeElev[num_probes];
+		for (unsigned i = 1; i < num_probes; i++) {
 			SGGeoc probe = myGeocPos.advanceRadM( ground_wind_from_rad, dist_probe_m[i] );
 			// convert to geodetic position for ground level computation
-			SGGeod probeGeod = SGGeod::fromGeoc( probe );
-			probe_lat_deg[i] = probeGeod.getLatitudeDeg();
-			probe_lon_deg[i] = probeGeod.getLongitudeDeg();
-			if (!globals->get_scenery()->get_elevation_m( probeGeod, probe_elev_m[i], NULL )) {
+			probeGeod[i] = SGGeod::fromGeoc( probe );
+			probe_lat_deg[i] = probeGeod[i].getLatitudeDeg();
+			probe_lon_deg[i] = probeGeod[i].getLongitudeDeg();
+		}
+		globals->get_scenery()->get_elevation_m_batch( probeGeod + 1, num_probes - 1, probeElev + 1 );
+		for (unsigned i = 1; i < num_probes; i++) {
+			if (probeElev[i].valid) {
+				probe_elev_m[i] = probeElev[i].elevation_m;
+			} else {
 				// no ground found? use elevation of previous probe :-(
 				probe_elev_m[i] = probe_elev_m[i-1];
 			}
@@ -222,19 +222,31 @@ void AreaSampler::update( double dt )
 
     FGScenery * scenery = globals->get_scenery();
 
+    // the probes are sent to the scenery in batches, which share the
+    // traversal of the scene graph
+    const unsigned batchSize = 32;
+    SGGeod probes[batchSize];
+    FGElevationResult elevations[batchSize];
+
     SGTimeStamp start = SGTimeStamp::now();
     while( (SGTimeStamp::now() - start).toSecs() < dt * _max_computation_time_norm ) {
         // sample until we used up all our configured time
-        double distance = sg_random();
-        distance = _radius * (1-distance*distance);
-        double course = sg_random() * 2.0 * SG_PI;
-        SGGeod probe = SGGeod::fromGeoc(center.advanceRadM( course, distance ));
-        double elevation_m = 0.0;
-
-        if (scenery->get_elevation_m( probe, elevation_m, NULL )) 
-            _elevations.push_front(elevation_m *= SG_METER_TO_FEET);
-        
-        if( _elevations.size() >= (deque<unsigned>::size_type)_max_samples ) {
+        for( unsigned i = 0; i < batchSize; i++ ) {
+            double distance = sg_random();
+            distance = _radius * (1-distance*distance);
+            double course = sg_random() * 2.0 * SG_PI;
+            probes[i] = SGGeod::fromGeoc(center.advanceRadM( course, distance ));
+        }
+        scenery->get_elevation_m_batch( probes, batchSize, elevations );
+
+        bool complete = false;
+        for( unsigned i = 0; i < batchSize && !complete; i++ ) {
+            if( elevations[i].valid )
+                _elevations.push_front(elevations[i].elevation_m * SG_METER_TO_FEET);
+            complete = _elevations.size() >= (deque<unsigned>::size_type)_max_samples;
+        }
+
+        if( complete ) {
             // sampling complete? 
             analyse();
             _outputPosition = _inputPosition;
@@ -46,6 +46,8 @@ INCLUDES
 #include <iterator>
 #include <cstdlib>
 #include <iomanip>
+#include <chrono>
+#include <atomic>
 
 #include "FGFDMExec.h"
 #include "models/atmosphere/FGStandardAtmosphere.h"
@@ -67,6 +69,7 @@ INCLUDES
 #include "initialization/FGTrim.h"
 #include "input_output/FGScript.h"
 #include "input_output/FGXMLFileRead.h"
+#include "input_output/FGXMLCache.h"
 
 using namespace std;
 
@@ -75,6 +78,12 @@ namespace JSBSim {
 IDENT(IdSrc,"$Id: FGFDMExec.cpp,v 1.194 2017/03/03 23:00:39 bcoconni Exp $");
 IDENT(IdHdr,ID_FDMEXEC);
 
+// The ground callback is shared by all the executives of the process: the
+// first one to be built installs the default callback and the last one to be
+// deleted removes it, so that executives can be built and deleted while
+// others are running.
+static std::atomic<unsigned int> num_executives(0);
+
 /*%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
 CLASS IMPLEMENTATION
 %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%*/
@@ -106,6 +115,7 @@ FGFDMExec::FGFDMExec(FGPropertyManager* root, unsigned int* fdmctr) : Root(root)
   TimeStepsUntilHold = -1;
 
   sim_time = 0.0;
+  LoadTimeParse = LoadTimeModel = LoadTimeRunIC = 0.0;
   dT = 1.0/120.0; // a default timestep size. This is needed for when JSBSim is
                   // run in standalone mode with no initialization file.
 
@@ -150,6 +160,7 @@ FGFDMExec::FGFDMExec(FGPropertyManager* root, unsigned int* fdmctr) : Root(root)
   }
 
   Debug(0);
+  num_executives++;
   // this is to catch errors in binding member functions to the property tree.
   try {
     Allocate();
@@ -174,6 +185,9 @@ FGFDMExec::FGFDMExec(FGPropertyManager* root, unsigned int* fdmctr) : Root(root)
   instance->Tie("simulation/jsbsim-debug", this, &FGFDMExec::GetDebugLevel, &FGFDMExec::SetDebugLevel);
   instance->Tie("simulation/frame", (int *)&Frame, false);
   instance->Tie("simulation/trim-completed", (int *)&trim_completed, false);
+  instance->Tie("simulation/load-time/parse-sec", this, &FGFDMExec::GetLoadTimeParse);
+  instance->Tie("simulation/load-time/model-sec", this, &FGFDMExec::GetLoadTimeModel);
+  instance->Tie("simulation/load-time/run-ic-sec", this, &FGFDMExec::GetLoadTimeRunIC);
   instance->Tie("forces/hold-down", this, &FGFDMExec::GetHoldDown, &FGFDMExec::SetHoldDown);
 
   Constructing = false;
@@ -209,7 +223,7 @@ FGFDMExec::~FGFDMExec()
 
   PropertyCatalog.clear();
   
-  SetGroundCallback(0);
+  if (--num_executives == 0) SetGroundCallback(0);
 
   if (FDMctr != 0) (*FDMctr)--;
 
@@ -229,7 +243,8 @@ bool FGFDMExec::Allocate(void)
   // Note that this does not affect the order in which the models will be
   // executed later.
   Models[eInertial]          = new FGInertial(this);
-  SetGroundCallback(new FGDefaultGroundCallback(static_cast<FGInertial*>(Models[eInertial])->GetRefRadius()));
+  if (!GetGroundCallback())
+    SetGroundCallback(new FGDefaultGroundCallback(static_cast<FGInertial*>(Models[eInertial])->GetRefRadius()));
 
   // See the eModels enum specification in the header file. The order of the
   // enums specifies the order of execution. The Models[] vector is the primary
@@ -552,6 +567,7 @@ void FGFDMExec::LoadModelConstants(void)
 bool FGFDMExec::RunIC(void)
 {
   FGPropulsion* propulsion = (FGPropulsion*)Models[ePropulsion];
+  chrono::steady_clock::time_point start = chrono::steady_clock::now();
 
   SuspendIntegration(); // saves the integration rate, dt, then sets it to 0.0.
   Initialize(IC);
@@ -563,6 +579,8 @@ bool FGFDMExec::RunIC(void)
   Propagate->InitializeDerivatives();
   ResumeIntegration(); // Restores the integration rate to what it was.
 
+  LoadTimeRunIC = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
   if (debug_lvl > 0) {
     MassBalance->GetMassPropertiesReport(0);
 
@@ -677,6 +695,32 @@ bool FGFDMExec::LoadModel(const SGPath& AircraftPath, const SGPath& EnginePath,
 //%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
 
 bool FGFDMExec::LoadModel(const string& model, bool addModelToPath)
+{
+  chrono::steady_clock::time_point start = chrono::steady_clock::now();
+  double parse_start = FGXMLCache::GetLoadTime();
+
+  bool result = ReadModel(model, addModelToPath);
+
+  double total = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+  LoadTimeParse = FGXMLCache::GetLoadTime() - parse_start;
+  LoadTimeModel = total - LoadTimeParse;
+
+  if (result && debug_lvl > 0 && !IsChild) {
+    FGXMLCache::Statistics stats = FGXMLCache::GetStatistics();
+    cout << endl << "  Model loaded in " << setprecision(3) << total << " s ("
+         << LoadTimeParse << " s reading XML, " << LoadTimeModel
+         << " s building the models)" << endl
+         << "  XML documents: " << stats.parsed << " parsed, " << stats.disk_hits
+         << " from the disk cache, " << stats.memory_hits << " from memory"
+         << setprecision(6) << endl;
+  }
+
+  return result;
+}
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+
+bool FGFDMExec::ReadModel(const string& model, bool addModelToPath)
 {
   SGPath aircraftCfgFileName;
   bool result = false; // initialize result to false, indicating input file not yet read
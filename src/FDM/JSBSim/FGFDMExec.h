@@ -599,6 +599,15 @@ public:
   */
   bool GetHoldDown(void) const {return HoldDown;}
 
+  /** Time spent reading XML documents by the last call to LoadModel(), in
+      seconds. This includes the files of engines, systems and child FDMs. */
+  double GetLoadTimeParse(void) const {return LoadTimeParse;}
+  /** Time spent building the models by the last call to LoadModel(), in
+      seconds, not counting the time spent reading XML documents. */
+  double GetLoadTimeModel(void) const {return LoadTimeModel;}
+  /// Duration of the last call to RunIC(), in seconds.
+  double GetLoadTimeRunIC(void) const {return LoadTimeRunIC;}
+
 private:
   int Error;
   unsigned int Frame;
@@ -623,6 +632,9 @@ private:
   std::string CFGVersion;
   std::string Release;
   SGPath RootDir;
+  double LoadTimeParse;
+  double LoadTimeModel;
+  double LoadTimeRunIC;
 
   // Standard Model pointers - shortcuts for internal executive use only.
   FGPropagate* Propagate;
@@ -663,6 +675,7 @@ private:
   std::vector <childData*> ChildFDMList;
   std::vector <FGModel*> Models;
 
+  bool ReadModel(const std::string& model, bool addModelToPath);
   bool ReadFileHeader(Element*);
   bool ReadChild(Element*);
   bool ReadPrologue(Element*);
@@ -113,8 +113,9 @@ const string FGJSBBase::JSBSim_version = "1.0 " __DATE__ " " __TIME__ ;
 queue <FGJSBBase::Message> FGJSBBase::Messages;
 FGJSBBase::Message FGJSBBase::localMsg;
 unsigned int FGJSBBase::messageId = 0;
+std::mutex FGJSBBase::MessagesMutex;
 
-int FGJSBBase::gaussian_random_number_phase = 0;
+thread_local int FGJSBBase::gaussian_random_number_phase = 0;
 
 short FGJSBBase::debug_lvl  = 1;
 
@@ -122,6 +123,7 @@ short FGJSBBase::debug_lvl  = 1;
 
 void FGJSBBase::PutMessage(const Message& msg)
 {
+  std::lock_guard<std::mutex> lock(MessagesMutex);
   Messages.push(msg);
 }
 
@@ -131,6 +133,7 @@ void FGJSBBase::PutMessage(const string& text)
 {
   Message msg;
   msg.text = text;
+  std::lock_guard<std::mutex> lock(MessagesMutex);
   msg.messageId = messageId++;
   msg.subsystem = "FDM";
   msg.type = Message::eText;
@@ -143,6 +146,7 @@ void FGJSBBase::PutMessage(const string& text, bool bVal)
 {
   Message msg;
   msg.text = text;
+  std::lock_guard<std::mutex> lock(MessagesMutex);
   msg.messageId = messageId++;
   msg.subsystem = "FDM";
   msg.type = Message::eBool;
@@ -156,6 +160,7 @@ void FGJSBBase::PutMessage(const string& text, int iVal)
 {
   Message msg;
   msg.text = text;
+  std::lock_guard<std::mutex> lock(MessagesMutex);
   msg.messageId = messageId++;
   msg.subsystem = "FDM";
   msg.type = Message::eInteger;
@@ -169,6 +174,7 @@ void FGJSBBase::PutMessage(const string& text, double dVal)
 {
   Message msg;
   msg.text = text;
+  std::lock_guard<std::mutex> lock(MessagesMutex);
   msg.messageId = messageId++;
   msg.subsystem = "FDM";
   msg.type = Message::eDouble;
@@ -180,6 +186,7 @@ void FGJSBBase::PutMessage(const string& text, double dVal)
 
 void FGJSBBase::ProcessMessage(void)
 {
+  std::lock_guard<std::mutex> lock(MessagesMutex);
   if (Messages.empty()) return;
   localMsg = Messages.front();
 
@@ -212,6 +219,7 @@ void FGJSBBase::ProcessMessage(void)
 
 FGJSBBase::Message* FGJSBBase::ProcessNextMessage(void)
 {
+  std::lock_guard<std::mutex> lock(MessagesMutex);
   if (Messages.empty()) return NULL;
   localMsg = Messages.front();
 
@@ -249,7 +257,7 @@ string FGJSBBase::CreateIndexedPropertyName(const string& Property, int index)
 
 double FGJSBBase::GaussianRandomNumber(void)
 {
-  static double V1, V2, S;
+  static thread_local double V1, V2, S;
   double X;
 
   if (gaussian_random_number_phase == 0) {
@@ -40,6 +40,7 @@ INCLUDES
 
 #include <float.h>
 #include <queue>
+#include <mutex>
 #include <string>
 #include <cmath>
 
@@ -341,6 +342,8 @@ protected:
   static Message localMsg;
 
   static std::queue <Message> Messages;
+  /// Guards Messages and messageId; executives may run on several threads.
+  static std::mutex MessagesMutex;
 
   void Debug(int) {};
 
@@ -371,7 +374,7 @@ protected:
 
   static std::string CreateIndexedPropertyName(const std::string& Property, int index);
 
-  static int gaussian_random_number_phase;
+  static thread_local int gaussian_random_number_phase;
 
 public:
 /// Moments L, M, N
@@ -40,8 +40,13 @@ INCLUDES
 %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%*/
 
 #include "initialization/FGTrim.h"
+#include "initialization/FGTrimSweep.h"
 #include "FGFDMExec.h"
+#include "models/FGOutput.h"
+#include "models/FGInertial.h"
 #include "input_output/FGXMLFileRead.h"
+#include "input_output/FGXMLCache.h"
+#include "simgear/io/iostreams/sgstream.hxx"
 
 #if !defined(__GNUC__) && !defined(sgi) && !defined(_MSC_VER)
 #  include <time>
@@ -64,10 +69,16 @@ INCLUDES
 #  include <sys/timeb.h>
 #else
 #  include <sys/time.h>
+#  include <sys/resource.h>
 #endif
 
 #include <iostream>
+#include <iomanip>
+#include <fstream>
 #include <cstdlib>
+#include <thread>
+#include <atomic>
+#include <mutex>
 
 using namespace std;
 using JSBSim::FGXMLFileRead;
@@ -105,12 +116,40 @@ double simulation_rate = 1./120.;
 bool override_sim_rate = false;
 double sleep_period=0.01;
 
+/** One run of a batch: the values of the batch properties and the outcome. */
+struct BatchRun {
+  unsigned int id;
+  vector <double> values;
+  bool succeeded;
+  double sim_time;
+  double wall_time;
+  double load_time;
+};
+
+SGPath BatchFileName;
+vector <string> SweepProperties;
+vector < vector <double> > SweepValues;
+vector <string> BatchProperties;
+vector <BatchRun> BatchRuns;
+unsigned int batch_threads = 0; // 0 means one thread per hardware thread
+std::atomic<unsigned int> next_batch_run;
+std::mutex batch_output_mutex;
+std::mutex batch_load_mutex;
+double batch_sim_rate = 0.0;
+
+SGPath TrimEnvelopeName;
+int trim_envelope_mode = JSBSim::tFull;
+bool trim_envelope_linearize = false;
+
 /*%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
 FORWARD DECLARATIONS
 %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%*/
 
 bool options(int, char**);
 int real_main(int argc, char* argv[]);
+int batch_main(void);
+int envelope_main(void);
+bool LoadExecutive(JSBSim::FGFDMExec*, double&);
 void PrintHelp(void);
 
 #if defined(__BORLANDC__) || defined(_MSC_VER) || defined(__MINGW32__)
@@ -147,6 +186,25 @@ void PrintHelp(void);
   }
 #endif
 
+#if defined(__BORLANDC__) || defined(_MSC_VER) || defined(__MINGW32__)
+  double getpeakmemory(void)
+  {
+    return -1.0; // not available
+  }
+#else
+  double getpeakmemory(void) // Peak resident set size in megabytes
+  {
+    struct rusage usage;
+
+    if (getrusage(RUSAGE_SELF, &usage) != 0) return -1.0;
+#  if defined(__APPLE__)
+    return usage.ru_maxrss / (1024.0*1024.0); // bytes
+#  else
+    return usage.ru_maxrss / 1024.0;          // kilobytes
+#  endif
+  }
+#endif
+
 /** This class is solely for the purpose of determining what type
     of file is given on the command line */
 class XMLFile : public FGXMLFileRead {
@@ -292,7 +350,7 @@ int main(int argc, char* argv[])
 #endif
 
   try {
-    real_main(argc, argv);
+    return real_main(argc, argv);
   } catch (string& msg) {
     std::cerr << "FATAL ERROR: JSBSim terminated with an exception."
               << std::endl << "The message was: " << msg << std::endl;
@@ -342,103 +400,23 @@ int real_main(int argc, char* argv[])
     exit(-1);
   }
 
+  if (!TrimEnvelopeName.isNull()) return envelope_main();
+  if (!BatchFileName.isNull() || !SweepProperties.empty()) return batch_main();
+
   // *** SET UP JSBSIM *** //
   FDMExec = new JSBSim::FGFDMExec();
-  FDMExec->SetRootDir(RootDir);
-  FDMExec->SetAircraftPath(SGPath("aircraft"));
-  FDMExec->SetEnginePath(SGPath("engine"));
-  FDMExec->SetSystemsPath(SGPath("systems"));
   FDMExec->GetPropertyManager()->Tie("simulation/frame_start_time", &actual_elapsed_time);
   FDMExec->GetPropertyManager()->Tie("simulation/cycle_duration", &cycle_duration);
 
-  if (nohighlight) FDMExec->disableHighLighting();
-
-  if (simulation_rate < 1.0 )
-    FDMExec->Setdt(simulation_rate);
-  else
-    FDMExec->Setdt(1.0/simulation_rate);
-
-  if (override_sim_rate) override_sim_rate_value = FDMExec->GetDeltaT();
-
-  // SET PROPERTY VALUES THAT ARE GIVEN ON THE COMMAND LINE and which are for the simulation only.
-
-  for (unsigned int i=0; i<CommandLineProperties.size(); i++) {
-
-    if (CommandLineProperties[i].find("simulation") != std::string::npos) {
-      if (FDMExec->GetPropertyManager()->GetNode(CommandLineProperties[i])) {
-        FDMExec->SetPropertyValue(CommandLineProperties[i], CommandLinePropertyValues[i]);
-      }
-    }
-  }
-
-  // *** OPTION A: LOAD A SCRIPT, WHICH LOADS EVERYTHING ELSE *** //
-  if (!ScriptName.isNull()) {
-
-    result = FDMExec->LoadScript(ScriptName, override_sim_rate_value, ResetName);
-
-    if (!result) {
-      cerr << "Script file " << ScriptName << " was not successfully loaded" << endl;
-      delete FDMExec;
-      exit(-1);
-    }
-
-  // *** OPTION B: LOAD AN AIRCRAFT AND A SET OF INITIAL CONDITIONS *** //
-  } else if (!AircraftName.empty() || !ResetName.isNull()) {
-
-    if (catalog) FDMExec->SetDebugLevel(0);
-
-    if ( ! FDMExec->LoadModel(SGPath("aircraft"),
-                              SGPath("engine"),
-                              SGPath("systems"),
-                              AircraftName)) {
-      cerr << "  JSBSim could not be started" << endl << endl;
-      delete FDMExec;
-      exit(-1);
-    }
-
-    if (catalog) {
-      FDMExec->PrintPropertyCatalog();
-      delete FDMExec;
-      return 0;
-    }
-
-    JSBSim::FGInitialCondition *IC = FDMExec->GetIC();
-    if ( ! IC->Load(ResetName)) {
-      delete FDMExec;
-      cerr << "Initialization unsuccessful" << endl;
-      exit(-1);
-    }
-
-  } else {
-    cout << "  No Aircraft, Script, or Reset information given" << endl << endl;
+  if (!LoadExecutive(FDMExec, override_sim_rate_value)) {
     delete FDMExec;
     exit(-1);
   }
 
-  // Load output directives file[s], if given
-  for (unsigned int i=0; i<LogDirectiveName.size(); i++) {
-    if (!LogDirectiveName[i].isNull()) {
-      if (!FDMExec->SetOutputDirectives(LogDirectiveName[i])) {
-        cout << "Output directives not properly set in file " << LogDirectiveName[i] << endl;
-        delete FDMExec;
-        exit(-1);
-      }
-    }
-  }
-
-  // OVERRIDE OUTPUT FILE NAME. THIS IS USEFUL FOR CASES WHERE MULTIPLE
-  // RUNS ARE BEING MADE (SUCH AS IN A MONTE CARLO STUDY) AND THE OUTPUT FILE
-  // NAME MUST BE SET EACH TIME TO AVOID THE PREVIOUS RUN DATA FROM BEING OVER-
-  // WRITTEN.
-  for (unsigned int i=0; i<LogOutputName.size(); i++) {
-    string old_filename = FDMExec->GetOutputFileName(i);
-    if (!FDMExec->SetOutputFileName(i, LogOutputName[i])) {
-      cout << "Output filename could not be set" << endl;
-    } else {
-      cout << "Output filename change from " << old_filename << " from aircraft"
-              " configuration file to " << LogOutputName[i] << " specified on"
-              " command line" << endl;
-    }
+  if (catalog) {
+    FDMExec->PrintPropertyCatalog();
+    delete FDMExec;
+    return 0;
   }
 
   // SET PROPERTY VALUES THAT ARE GIVEN ON THE COMMAND LINE
@@ -562,6 +540,506 @@ quit:
   return 0;
 }
 
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// Sets up an executive from the command line options: loads the script, or the
+// aircraft and its initial conditions, and the output directives. When a
+// catalog is requested, only the aircraft is loaded.
+
+bool LoadExecutive(JSBSim::FGFDMExec* exec, double& override_sim_rate_value)
+{
+  exec->SetRootDir(RootDir);
+  exec->SetAircraftPath(SGPath("aircraft"));
+  exec->SetEnginePath(SGPath("engine"));
+  exec->SetSystemsPath(SGPath("systems"));
+
+  if (nohighlight) exec->disableHighLighting();
+
+  if (simulation_rate < 1.0 )
+    exec->Setdt(simulation_rate);
+  else
+    exec->Setdt(1.0/simulation_rate);
+
+  if (override_sim_rate) override_sim_rate_value = exec->GetDeltaT();
+
+  // SET PROPERTY VALUES THAT ARE GIVEN ON THE COMMAND LINE and which are for the simulation only.
+
+  for (unsigned int i=0; i<CommandLineProperties.size(); i++) {
+
+    if (CommandLineProperties[i].find("simulation") != std::string::npos) {
+      if (exec->GetPropertyManager()->GetNode(CommandLineProperties[i])) {
+        exec->SetPropertyValue(CommandLineProperties[i], CommandLinePropertyValues[i]);
+      }
+    }
+  }
+
+  // *** OPTION A: LOAD A SCRIPT, WHICH LOADS EVERYTHING ELSE *** //
+  if (!ScriptName.isNull()) {
+
+    if (!exec->LoadScript(ScriptName, override_sim_rate_value, ResetName)) {
+      cerr << "Script file " << ScriptName << " was not successfully loaded" << endl;
+      return false;
+    }
+
+  // *** OPTION B: LOAD AN AIRCRAFT AND A SET OF INITIAL CONDITIONS *** //
+  } else if (!AircraftName.empty() || !ResetName.isNull()) {
+
+    if (catalog) exec->SetDebugLevel(0);
+
+    if ( ! exec->LoadModel(SGPath("aircraft"),
+                           SGPath("engine"),
+                           SGPath("systems"),
+                           AircraftName)) {
+      cerr << "  JSBSim could not be started" << endl << endl;
+      return false;
+    }
+
+    if (catalog) return true;
+
+    JSBSim::FGInitialCondition *IC = exec->GetIC();
+    if ( ! IC->Load(ResetName)) {
+      cerr << "Initialization unsuccessful" << endl;
+      return false;
+    }
+
+  } else {
+    cout << "  No Aircraft, Script, or Reset information given" << endl << endl;
+    return false;
+  }
+
+  // Load output directives file[s], if given
+  for (unsigned int i=0; i<LogDirectiveName.size(); i++) {
+    if (!LogDirectiveName[i].isNull()) {
+      if (!exec->SetOutputDirectives(LogDirectiveName[i])) {
+        cout << "Output directives not properly set in file " << LogDirectiveName[i] << endl;
+        return false;
+      }
+    }
+  }
+
+  // OVERRIDE OUTPUT FILE NAME. THIS IS USEFUL FOR CASES WHERE MULTIPLE
+  // RUNS ARE BEING MADE (SUCH AS IN A MONTE CARLO STUDY) AND THE OUTPUT FILE
+  // NAME MUST BE SET EACH TIME TO AVOID THE PREVIOUS RUN DATA FROM BEING OVER-
+  // WRITTEN.
+  for (unsigned int i=0; i<LogOutputName.size(); i++) {
+    string old_filename = exec->GetOutputFileName(i);
+    if (!exec->SetOutputFileName(i, LogOutputName[i])) {
+      cout << "Output filename could not be set" << endl;
+    } else {
+      cout << "Output filename change from " << old_filename << " from aircraft"
+              " configuration file to " << LogOutputName[i] << " specified on"
+              " command line" << endl;
+    }
+  }
+
+  return true;
+}
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// Reads the runs of a batch from a CSV file. The first line holds the names of
+// the properties, each of the following lines the values for one run. Empty
+// lines and lines starting with # are ignored.
+
+bool ReadBatchFile(const SGPath& fname)
+{
+  sg_ifstream batch_file(fname);
+  if (!batch_file.is_open()) {
+    cerr << "  Could not open the batch file " << fname << endl;
+    return false;
+  }
+
+  string line;
+  unsigned int line_number = 0;
+  vector <string> header;
+  vector < vector <double> > rows;
+
+  while (getline(batch_file, line)) {
+    line_number++;
+    trim(line);
+    if (line.empty() || line[0] == '#') continue;
+
+    vector <string> fields = split(line, ',');
+    if (header.empty()) {
+      header = fields;
+      continue;
+    }
+
+    if (fields.size() != header.size()) {
+      cerr << "  " << fname << ", line " << line_number << ": expected "
+           << header.size() << " values, got " << fields.size() << endl;
+      return false;
+    }
+
+    vector <double> values;
+    for (unsigned int i=0; i<fields.size(); i++) {
+      if (!is_number(fields[i])) {
+        cerr << "  " << fname << ", line " << line_number << ": \""
+             << fields[i] << "\" is not a number" << endl;
+        return false;
+      }
+      values.push_back(atof(fields[i].c_str()));
+    }
+    rows.push_back(values);
+  }
+
+  BatchProperties = header;
+  for (unsigned int r=0; r<rows.size(); r++) {
+    BatchRun run;
+    run.values = rows[r];
+    BatchRuns.push_back(run);
+  }
+
+  return true;
+}
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// Combines the runs read from the batch file with every combination of the
+// --sweep values (full factorial), then numbers the runs.
+
+void ExpandSweeps(void)
+{
+  if (BatchRuns.empty()) BatchRuns.push_back(BatchRun());
+
+  for (unsigned int p=0; p<SweepProperties.size(); p++) {
+    vector <BatchRun> expanded;
+    for (unsigned int r=0; r<BatchRuns.size(); r++) {
+      for (unsigned int v=0; v<SweepValues[p].size(); v++) {
+        BatchRun run = BatchRuns[r];
+        run.values.push_back(SweepValues[p][v]);
+        expanded.push_back(run);
+      }
+    }
+    BatchRuns.swap(expanded);
+    BatchProperties.push_back(SweepProperties[p]);
+  }
+
+  for (unsigned int r=0; r<BatchRuns.size(); r++) {
+    BatchRuns[r].id = r;
+    BatchRuns[r].succeeded = false;
+    BatchRuns[r].sim_time = 0.0;
+    BatchRuns[r].wall_time = 0.0;
+    BatchRuns[r].load_time = 0.0;
+  }
+}
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// Appends the run number to an output file name, before the extension if any,
+// in the same way FGOutputFile::SetStartNewOutput() numbers successive runs.
+
+string BatchOutputFileName(const string& name, unsigned int id)
+{
+  ostringstream buf;
+  string::size_type dot = name.find_last_of('.');
+  string::size_type slash = name.find_last_of("/\\");
+
+  if (dot != string::npos && (slash == string::npos || dot > slash)) {
+    buf << name.substr(0, dot) << '_' << setw(4) << setfill('0') << id
+        << name.substr(dot);
+  } else {
+    buf << name << '_' << setw(4) << setfill('0') << id;
+  }
+
+  return buf.str();
+}
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// Executes one run of the batch on an executive loaded for this run only, so
+// that nothing a previous run left in the property tree (script events,
+// latched FCS components, properties set by the run itself) can change its
+// outcome. The XML documents come from the cache after the first load.
+
+bool ExecuteBatchRun(JSBSim::FGFDMExec* exec, const vector <string>& outputNames,
+                     BatchRun& run)
+{
+  for (unsigned int i=0; i<outputNames.size(); i++) {
+    if (!outputNames[i].empty())
+      exec->SetOutputFileName(i, BatchOutputFileName(outputNames[i], run.id));
+  }
+
+  for (unsigned int i=0; i<CommandLineProperties.size(); i++)
+    exec->SetPropertyValue(CommandLineProperties[i], CommandLinePropertyValues[i]);
+  for (unsigned int i=0; i<BatchProperties.size(); i++)
+    exec->SetPropertyValue(BatchProperties[i], run.values[i]);
+
+  if (!exec->RunIC()) return false;
+
+  if (exec->GetIC()->NeedTrim()) {
+    JSBSim::FGTrim trim(exec);
+    trim.DoTrim();
+  }
+
+  bool result = exec->Run();
+  while (result && exec->GetSimTime() <= end_time) {
+    exec->ProcessMessage();
+    result = exec->Run();
+  }
+
+  run.sim_time = exec->GetSimTime();
+  return true;
+}
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// Takes runs off the batch until there are none left, loading a new
+// executive for each of them. The loads are made one at a time because the
+// XML parser is not thread safe. When the batch runs on a single thread, each
+// run also gets a ground callback of its own, so that a terrain elevation set
+// by a run does not carry over to the next one.
+
+void BatchWorker(const vector <string>* outputNames, bool own_ground)
+{
+  unsigned int r;
+
+  while ((r = next_batch_run++) < BatchRuns.size()) {
+    BatchRun& run = BatchRuns[r];
+    string error;
+    double start = getcurrentseconds();
+    JSBSim::FGFDMExec* exec = 0;
+
+    try {
+      bool loaded;
+      {
+        std::lock_guard<std::mutex> lock(batch_load_mutex);
+        double override_sim_rate_value = batch_sim_rate;
+        exec = new JSBSim::FGFDMExec();
+        if (own_ground) {
+          double radius = exec->GetInertial()->GetRefRadius();
+          exec->SetGroundCallback(new JSBSim::FGDefaultGroundCallback(radius));
+        }
+        loaded = LoadExecutive(exec, override_sim_rate_value);
+      }
+      run.load_time = getcurrentseconds() - start;
+
+      if (!loaded) error = "loading failed";
+      else {
+        run.succeeded = ExecuteBatchRun(exec, *outputNames, run);
+        if (!run.succeeded) error = "initialization failed";
+      }
+    } catch (string& msg) {
+      error = msg;
+    } catch (const char* msg) {
+      error = msg;
+    } catch (...) {
+      error = "unknown exception";
+    }
+
+    {
+      std::lock_guard<std::mutex> lock(batch_load_mutex);
+      delete exec;
+    }
+    run.wall_time = getcurrentseconds() - start;
+
+    std::lock_guard<std::mutex> lock(batch_output_mutex);
+    cout << "Run " << setw(4) << setfill('0') << run.id << setfill(' ');
+    if (run.succeeded) {
+      cout << ": " << setprecision(2) << run.sim_time << " s simulated in "
+           << setprecision(3) << run.wall_time << " s" << endl;
+    } else {
+      cout << " failed: " << error << endl;
+    }
+  }
+}
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// Runs the script or aircraft once for each row of the batch file and each
+// combination of --sweep values, spreading the runs over several threads.
+//
+// Every run gets an executive of its own, see BatchWorker(). The one loaded
+// here checks the command line, echoes the configuration and is kept until
+// the end: it holds the ground callback, which is shared by the whole process,
+// for the executives of the runs. This is also why terrain elevation and sea
+// level radius cannot vary between runs executed in parallel.
+
+int batch_main(void)
+{
+  if (!BatchFileName.isNull()) {
+    if (!ReadBatchFile(BatchFileName)) return -1;
+    if (BatchRuns.empty()) {
+      cerr << "  The batch file " << BatchFileName << " contains no runs" << endl;
+      return -1;
+    }
+  }
+  ExpandSweeps();
+
+  unsigned int num_threads = batch_threads;
+  if (num_threads == 0) num_threads = std::thread::hardware_concurrency();
+  if (num_threads == 0) num_threads = 1;
+  if (num_threads > BatchRuns.size()) num_threads = BatchRuns.size();
+
+  for (unsigned int i=0; i<BatchProperties.size() && num_threads > 1; i++) {
+    if (BatchProperties[i].find("terrain-elevation") != string::npos ||
+        BatchProperties[i].find("sea-level-radius") != string::npos) {
+      cerr << "  " << BatchProperties[i] << " is shared by all the runs in"
+              " progress: the batch will be run on a single thread." << endl;
+      num_threads = 1;
+    }
+  }
+
+  double start = getcurrentseconds();
+  vector <string> outputNames;
+
+  JSBSim::FGFDMExec* exec = new JSBSim::FGFDMExec();
+  bool loaded = LoadExecutive(exec, batch_sim_rate);
+
+  if (loaded) {
+    for (unsigned int i=0; i<BatchProperties.size(); i++) {
+      if (!exec->GetPropertyManager()->GetNode(BatchProperties[i])) {
+        cerr << endl << "  No property by the name " << BatchProperties[i] << endl;
+        loaded = false;
+      }
+    }
+    for (unsigned int i=0; i<CommandLineProperties.size(); i++) {
+      if (!exec->GetPropertyManager()->GetNode(CommandLineProperties[i])) {
+        cerr << endl << "  No property by the name " << CommandLineProperties[i] << endl;
+        loaded = false;
+      }
+    }
+
+    // File outputs get one file per run. The names are given back to
+    // SetOutputFileName() which prefixes them with the root directory again.
+    JSBSim::FGOutput* output = exec->GetOutput();
+    string root = RootDir.utf8Str();
+    for (unsigned int i=0; i<output->GetNumOutputs(); i++) {
+      string name;
+      if (output->IsFileOutput(i)) {
+        name = output->GetOutputName(i);
+        if (!root.empty() && name.compare(0, root.size(), root) == 0) {
+          name.erase(0, root.size());
+          if (!name.empty() && (name[0] == '/' || name[0] == '\\')) name.erase(0, 1);
+        }
+      }
+      outputNames.push_back(name);
+    }
+
+    // This executive has echoed the configuration; those of the runs stay
+    // quiet.
+    exec->SetDebugLevel(0);
+  }
+
+  int ret = 0;
+
+  if (loaded) {
+    double load_time = getcurrentseconds() - start;
+
+    cout << endl << JSBSim::FGFDMExec::fggreen << JSBSim::FGFDMExec::highint
+         << "---- JSBSim batch of " << BatchRuns.size() << " runs on "
+         << num_threads << " threads -------------------------------------"
+         << JSBSim::FGFDMExec::reset << endl << endl;
+
+    start = getcurrentseconds();
+    next_batch_run = 0;
+
+    vector <std::thread> workers;
+    for (unsigned int t=0; t<num_threads; t++)
+      workers.push_back(std::thread(BatchWorker, &outputNames, num_threads == 1));
+    for (unsigned int t=0; t<num_threads; t++)
+      workers[t].join();
+
+    double run_time = getcurrentseconds() - start;
+    double sim_time = 0.0, run_load_time = 0.0;
+    unsigned int failed = 0;
+    for (unsigned int r=0; r<BatchRuns.size(); r++) {
+      run_load_time += BatchRuns[r].load_time;
+      if (BatchRuns[r].succeeded) sim_time += BatchRuns[r].sim_time;
+      else failed++;
+    }
+
+    cout << endl << "  Runs: " << BatchRuns.size() << " (" << failed << " failed)"
+         << endl;
+    cout << setprecision(3);
+    cout << "  Load time: " << load_time << " s for the first executive ("
+         << exec->GetLoadTimeParse() << " s reading XML, "
+         << exec->GetLoadTimeModel() << " s building the models), "
+         << run_load_time / BatchRuns.size() << " s per run" << endl;
+    cout << "  Run time: " << run_time << " s, "
+         << BatchRuns.size() / run_time << " runs/s, "
+         << sim_time / run_time << " simulated s per s" << endl;
+    double peak_memory = getpeakmemory();
+    if (peak_memory >= 0.0)
+      cout << "  Peak memory: " << setprecision(1) << peak_memory << " MB" << endl;
+
+    if (failed > 0) ret = 1;
+  } else {
+    ret = -1;
+  }
+
+  delete exec;
+
+  return ret;
+}
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// Trims the aircraft at each combination of --sweep values and writes the trim
+// controls, and the linear models with --linearize, to the envelope file. The
+// executives are loaded as for a batch, see batch_main().
+
+int envelope_main(void)
+{
+  JSBSim::FGTrimSweep sweep((JSBSim::TrimMode)trim_envelope_mode);
+  sweep.SetLinearize(trim_envelope_linearize);
+  for (unsigned int p=0; p<SweepProperties.size(); p++)
+    sweep.AddAxis(SweepProperties[p], SweepValues[p]);
+  // Properties given on the command line are applied at every point.
+  for (unsigned int i=0; i<CommandLineProperties.size(); i++)
+    sweep.AddAxis(CommandLineProperties[i], vector<double>(1, CommandLinePropertyValues[i]));
+
+  unsigned int num_threads = batch_threads;
+  if (num_threads == 0) num_threads = std::thread::hardware_concurrency();
+  if (num_threads == 0) num_threads = 1;
+  // Each thread takes whole lines along the first swept property.
+  unsigned int num_lines = sweep.GetNumPoints() / SweepValues[0].size();
+  if (num_threads > num_lines) num_threads = num_lines;
+
+  for (unsigned int i=0; i<SweepProperties.size() && num_threads > 1; i++) {
+    if (SweepProperties[i].find("terrain-elevation") != string::npos ||
+        SweepProperties[i].find("sea-level-radius") != string::npos) {
+      cerr << "  " << SweepProperties[i] << " is shared by all the trims in"
+              " progress: the envelope will be run on a single thread." << endl;
+      num_threads = 1;
+    }
+  }
+
+  double override_sim_rate_value = 0.0;
+  vector <JSBSim::FGFDMExec*> executives;
+  bool loaded = true;
+
+  for (unsigned int t=0; t<num_threads && loaded; t++) {
+    JSBSim::FGFDMExec* exec = new JSBSim::FGFDMExec();
+    executives.push_back(exec);
+    loaded = LoadExecutive(exec, override_sim_rate_value);
+    exec->SetDebugLevel(0);
+  }
+
+  int ret = -1;
+
+  if (loaded) {
+    cout << endl << JSBSim::FGFDMExec::fggreen << JSBSim::FGFDMExec::highint
+         << "---- JSBSim trim envelope of " << sweep.GetNumPoints() << " points on "
+         << num_threads << " threads -------------------------------------"
+         << JSBSim::FGFDMExec::reset << endl << endl;
+
+    double start = getcurrentseconds();
+    if (sweep.Run(executives)) {
+      double run_time = getcurrentseconds() - start;
+      bool written;
+      if (TrimEnvelopeName.lower_extension() == "csv")
+        written = sweep.WriteCSV(TrimEnvelopeName);
+      else
+        written = sweep.WriteBinary(TrimEnvelopeName);
+
+      sweep.PrintStatistics(cout);
+      cout << "  Run time: " << setprecision(3) << run_time << " s, "
+           << sweep.GetNumPoints() / run_time << " points/s" << endl;
+
+      JSBSim::FGTrimSweep::Statistics stats = sweep.GetStatistics();
+      if (!written) ret = -1;
+      else ret = stats.converged < stats.points ? 1 : 0;
+    }
+  }
+
+  for (unsigned int t=0; t<executives.size(); t++) delete executives[t];
+
+  return ret;
+}
+
 //%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
 
 #define gripe cerr << "Option '" << keyword     \
@@ -694,6 +1172,78 @@ bool options(int count, char **arg)
         exit(1);
       }
 
+    } else if (keyword == "--batch") {
+      if (n != string::npos) {
+        BatchFileName = SGPath::fromLocal8Bit(value.c_str());
+      } else {
+        gripe;
+        exit(1);
+      }
+
+    } else if (keyword == "--sweep") {
+      if (n != string::npos && value.find("=") != string::npos) {
+        string propName = value.substr(0,value.find("="));
+        vector <string> items = split(value.substr(value.find("=")+1), ',');
+        vector <double> values;
+        for (unsigned int j=0; j<items.size(); j++) {
+          vector <string> range = split(items[j], ':');
+          if (range.size() == 3 && atof(range[2].c_str()) > 0.0) {
+            // first:last:step
+            double first = atof(range[0].c_str());
+            double last = atof(range[1].c_str());
+            double step = atof(range[2].c_str());
+            for (int k=0; first + k*step <= last + 0.5e-9*step; k++)
+              values.push_back(first + k*step);
+          } else {
+            values.push_back(atof(items[j].c_str()));
+          }
+        }
+        if (values.empty()) {
+          cerr << endl << "  No values given to sweep " << propName << endl << endl;
+          result = false;
+        }
+        SweepProperties.push_back(propName);
+        SweepValues.push_back(values);
+      } else {
+        gripe;
+        exit(1);
+      }
+
+    } else if (keyword == "--trim-envelope") {
+      if (n != string::npos) {
+        TrimEnvelopeName = SGPath::fromLocal8Bit(value.c_str());
+      } else {
+        gripe;
+        exit(1);
+      }
+
+    } else if (keyword == "--trim-mode") {
+      if (n != string::npos) {
+        trim_envelope_mode = atoi( value.c_str() );
+      } else {
+        gripe;
+        exit(1);
+      }
+
+    } else if (keyword == "--linearize") {
+      trim_envelope_linearize = true;
+
+    } else if (keyword == "--threads") {
+      if (n != string::npos) {
+        batch_threads = atoi( value.c_str() );
+      } else {
+        gripe;
+        exit(1);
+      }
+
+    } else if (keyword == "--xmlcache") {
+      if (n != string::npos) {
+        JSBSim::FGXMLCache::SetDirectory(SGPath::fromLocal8Bit(value.c_str()));
+      } else {
+        gripe;
+        exit(1);
+      }
+
     } else if (keyword == "--catalog") {
         catalog = true;
         if (value.size() > 0) AircraftName=value;
@@ -737,6 +1287,26 @@ bool options(int count, char **arg)
     cerr << "You cannot specify an aircraft file with a script." << endl;
     result = false;
   }
+  if (!TrimEnvelopeName.isNull()) {
+    if (SweepProperties.empty()) {
+      cerr << "A trim envelope needs at least one --sweep" << endl << endl;
+      result = false;
+    }
+    if (!BatchFileName.isNull() || catalog || realtime || suspend) {
+      cerr << "A trim envelope cannot be run with a batch file, in real time,"
+              " suspended or with catalog" << endl << endl;
+      result = false;
+    }
+  } else if (!BatchFileName.isNull() || !SweepProperties.empty()) {
+    if (catalog || realtime || suspend) {
+      cerr << "A batch cannot be run in real time, suspended or with catalog" << endl << endl;
+      result = false;
+    }
+    if (ScriptName.isNull() && end_time == 1e99) {
+      cerr << "A batch run without a script needs an end time (--end)" << endl << endl;
+      result = false;
+    }
+  }
 
   return result;
 
@@ -768,7 +1338,22 @@ void PrintHelp(void)
     cout << "    --simulation-rate=<rate (double)> specifies the sim dT time or frequency" << endl;
     cout << "                      If rate specified is less than 1, it is interpreted as" << endl;
     cout << "                      a time step size, otherwise it is assumed to be a rate in Hertz." << endl;
-    cout << "    --end=<time (double)> specifies the sim end time" << endl << endl;
+    cout << "    --end=<time (double)> specifies the sim end time" << endl;
+    cout << "    --batch=<filename>  runs the simulation once per line of a CSV file. The first line" << endl;
+    cout << "                        gives the property names, the others their values for each run." << endl;
+    cout << "                        Output files get the run number appended to their name." << endl;
+    cout << "    --sweep=<name=values>  runs the simulation for each value of a property, in combination" << endl;
+    cout << "                           with the other sweeps and the batch file, e.g." << endl;
+    cout << "                           --sweep=ic/vc-kts=80,90,100 or --sweep=ic/alpha-deg=0:10:0.5" << endl;
+    cout << "                           (can appear multiple times)" << endl;
+    cout << "    --trim-envelope=<filename>  trims the aircraft at each combination of --sweep values" << endl;
+    cout << "                                instead of running it. The controls are written as CSV if" << endl;
+    cout << "                                the file name ends in .csv, as a binary table otherwise." << endl;
+    cout << "    --trim-mode=<n>  trim mode of the envelope (0: longitudinal, 1: full (default), 2: ground)" << endl;
+    cout << "    --linearize  also writes the linear model of the aircraft at each trimmed point" << endl;
+    cout << "    --xmlcache=<path>  keeps the parsed XML files in this directory to speed up later loads" << endl;
+    cout << "    --threads=<n>  number of runs of a batch or points of a trim envelope executed in" << endl;
+    cout << "                   parallel (default: one per CPU)" << endl << endl;
 
     cout << "  NOTE: There can be no spaces around the = sign when" << endl;
     cout << "        an option is followed by a filename" << endl << endl;
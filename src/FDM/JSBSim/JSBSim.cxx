@@ -74,6 +74,7 @@
 #include <FDM/JSBSim/models/propulsion/FGRotor.h>
 #include <FDM/JSBSim/models/propulsion/FGTank.h>
 #include <FDM/JSBSim/input_output/FGPropertyManager.h>
+#include <FDM/JSBSim/input_output/FGXMLCache.h>
 #include <FDM/JSBSim/input_output/FGGroundCallback.h>
 
 using namespace JSBSim;
@@ -155,7 +156,9 @@ std::map<std::string,int> FGJSBsim::TURBULENCE_TYPE_NAMES;
 static FGTurbulenceSeverityTable TurbulenceSeverityTable;
 
 FGJSBsim::FGJSBsim( double dt )
-  : FGInterface(dt), got_wire(false)
+  : FGInterface(dt), got_wire(false), ai_wake_enabled(false),
+    terrain_override_level(-1), terrain_active(true), terrain_valid(false),
+    unthreaded_dt(dt), input_serial(0), applied_serial(0)
 {
     bool result;
     if( TURBULENCE_TYPE_NAMES.empty() ) {
@@ -197,7 +200,14 @@ FGJSBsim::FGJSBsim( double dt )
             FGJSBBase::debug_lvl = 0x00;
     }
 
-    PropertyManager = new FGPropertyManager( (FGPropertyNode*)globals->get_props() );
+    // JSBSim can only run in the FDM thread with a property tree of its own,
+    // so that has to be decided before it is loaded.
+    private_props = fgGetBool("/sim/fdm/thread/enabled");
+    if (private_props)
+      PropertyManager = new FGPropertyManager;
+    else
+      PropertyManager = new FGPropertyManager( (FGPropertyNode*)globals->get_props() );
+    fdm_props = PropertyManager->GetNode();
     fdmex = new FGFDMExec( PropertyManager );
 
     // Register ground callback.
@@ -227,18 +237,18 @@ FGJSBsim::FGJSBsim( double dt )
     SGPath systems_path( fgGetString("/sim/fg-root") );
     systems_path.append( "Aircraft/Generic/JSBSim/Systems" );
 
-// deprecate sim-time-sec for simulation/sim-time-sec
-// remove alias with increased configuration file version number (2.1 or later)
-    SGPropertyNode * node = fgGetNode("/fdm/jsbsim/simulation/sim-time-sec");
-    fgGetNode("/fdm/jsbsim/sim-time-sec", true)->alias( node );
-// end of sim-time-sec deprecation patch
-
     _ai_wake_enabled = fgGetNode("fdm/ai-wake/enabled", true);
 
     terrain = fgGetNode("/sim/fdm/surface", true);
 
     fdmex->Setdt( dt );
 
+    // Parsed aircraft files are kept in memory for resets; optionally also on
+    // disk, which speeds up the first load of the next session.
+    if (fgGetBool("/sim/fdm/jsbsim/xml-disk-cache", false)) {
+        JSBSim::FGXMLCache::SetDirectory(globals->get_fg_home() / "JSBSimCache");
+    }
+
     result = fdmex->LoadModel( aircraft_path, engine_path, systems_path,
                                fgGetString("/sim/aero"), false );
 
@@ -250,6 +260,29 @@ FGJSBsim::FGJSBsim( double dt )
       throw(-1);
     }
 
+    SG_LOG( SG_FLIGHT, SG_INFO, "  load time: " << fdmex->GetLoadTimeParse()
+            << " s reading XML, " << fdmex->GetLoadTimeModel() << " s building models");
+
+    // written by update_external_forces(), they must exist to be mirrored
+    const char* hook_props[] = {
+      "/fdm/jsbsim/systems/hook/tailhook-pos-deg",
+      "/fdm/jsbsim/external_reactions/hook/x",
+      "/fdm/jsbsim/external_reactions/hook/y",
+      "/fdm/jsbsim/external_reactions/hook/z",
+      "/fdm/jsbsim/external_reactions/hook/magnitude"
+    };
+    for (const char* path : hook_props) {
+      if (private_props && !fdm_props->hasValue(path))
+        fdm_props->setDoubleValue(path, 0.0);
+    }
+    build_mirror();
+
+// deprecate sim-time-sec for simulation/sim-time-sec
+// remove alias with increased configuration file version number (2.1 or later)
+    SGPropertyNode * node = fgGetNode("/fdm/jsbsim/simulation/sim-time-sec");
+    fgGetNode("/fdm/jsbsim/sim-time-sec", true)->alias( node );
+// end of sim-time-sec deprecation patch
+
     SG_LOG( SG_FLIGHT, SG_INFO, "" );
     SG_LOG( SG_FLIGHT, SG_INFO, "" );
     SG_LOG( SG_FLIGHT, SG_INFO, "After loading aero definition file ..." );
@@ -268,6 +301,16 @@ FGJSBsim::FGJSBsim( double dt )
 
     init_gear();
 
+    for (int i = 0; i < Neng; i++) {
+      engine_nodes.push_back(fgGetNode("engines/engine", i, true));
+      thruster_nodes.push_back(engine_nodes[i]->getChild("thruster", 0, true));
+    }
+    for (unsigned int i = 0; i < Propulsion->GetNumTanks(); i++)
+      tank_nodes.push_back(fgGetNode("/consumables/fuel/tank", i, true));
+    for (int i = 0; i < GroundReactions->GetNumGearUnits(); i++)
+      gear_nodes.push_back(fgGetNode("gear/gear", i, true));
+    fuel_freeze = fgGetNode("/sim/freeze/fuel", true);
+
     // Set initial fuel levels if provided.
     for (unsigned int i = 0; i < Propulsion->GetNumTanks(); i++) {
       double d;
@@ -358,16 +401,16 @@ FGJSBsim::FGJSBsim( double dt )
     }
 
     hook_root_struct = FGColumnVector3(
-        fgGetDouble("/fdm/jsbsim/systems/hook/tailhook-offset-x-in", 196),
-        fgGetDouble("/fdm/jsbsim/systems/hook/tailhook-offset-y-in", 0),
-        fgGetDouble("/fdm/jsbsim/systems/hook/tailhook-offset-z-in", -16));
+        fdm_props->getDoubleValue("/fdm/jsbsim/systems/hook/tailhook-offset-x-in", 196),
+        fdm_props->getDoubleValue("/fdm/jsbsim/systems/hook/tailhook-offset-y-in", 0),
+        fdm_props->getDoubleValue("/fdm/jsbsim/systems/hook/tailhook-offset-z-in", -16));
     last_hook_tip[0] = 0; last_hook_tip[1] = 0; last_hook_tip[2] = 0;
     last_hook_root[0] = 0; last_hook_root[1] = 0; last_hook_root[2] = 0;
 
     crashed = false;
 
-    mesh = new AircraftMesh(fgGetDouble("/fdm/jsbsim/metrics/bw-ft"),
-                            fgGetDouble("/fdm/jsbsim/metrics/cbarw-ft"));
+    mesh = new AircraftMesh(fdm_props->getDoubleValue("/fdm/jsbsim/metrics/bw-ft"),
+                            fdm_props->getDoubleValue("/fdm/jsbsim/metrics/cbarw-ft"));
 }
 
 /******************************************************************************/
@@ -448,14 +491,14 @@ void FGJSBsim::init()
 
     copy_from_JSBsim(); //update the bus
 
-    _fmag = fgGetNode("/fdm/jsbsim/external_reactions/ai-wake/magnitude", false);
-    _fbx = fgGetNode("/fdm/jsbsim/external_reactions/ai-wake/x", false);
-    _fby = fgGetNode("/fdm/jsbsim/external_reactions/ai-wake/y", false);
-    _fbz = fgGetNode("/fdm/jsbsim/external_reactions/ai-wake/z", false);
-    _mmag = fgGetNode("/fdm/jsbsim/external_reactions/ai-wake/magnitude-lbsft", false);
-    _mbx = fgGetNode("/fdm/jsbsim/external_reactions/ai-wake/l", false);
-    _mby = fgGetNode("/fdm/jsbsim/external_reactions/ai-wake/m", false);
-    _mbz = fgGetNode("/fdm/jsbsim/external_reactions/ai-wake/n", false);
+    _fmag = fdm_props->getNode("/fdm/jsbsim/external_reactions/ai-wake/magnitude");
+    _fbx = fdm_props->getNode("/fdm/jsbsim/external_reactions/ai-wake/x");
+    _fby = fdm_props->getNode("/fdm/jsbsim/external_reactions/ai-wake/y");
+    _fbz = fdm_props->getNode("/fdm/jsbsim/external_reactions/ai-wake/z");
+    _mmag = fdm_props->getNode("/fdm/jsbsim/external_reactions/ai-wake/magnitude-lbsft");
+    _mbx = fdm_props->getNode("/fdm/jsbsim/external_reactions/ai-wake/l");
+    _mby = fdm_props->getNode("/fdm/jsbsim/external_reactions/ai-wake/m");
+    _mbz = fdm_props->getNode("/fdm/jsbsim/external_reactions/ai-wake/n");
 
     SG_LOG( SG_FLIGHT, SG_INFO, "  Initialized JSBSim with:" );
 
@@ -548,29 +591,8 @@ void FGJSBsim::update( double dt )
       update_external_forces(fdmex->GetSimTime() + i * fdmex->GetDeltaT());
     }
 
-    FGJSBBase::Message* msg;
-    while ((msg = fdmex->ProcessNextMessage()) != NULL) {
-//      msg = fdmex->ProcessNextMessage();
-      switch (msg->type) {
-      case FGJSBBase::Message::eText:
-        if (msg->text == "Crash Detected: Simulation FREEZE.")
-          crashed = true;
-        SG_LOG( SG_FLIGHT, SG_INFO, msg->messageId << ": " << msg->text );
-        break;
-      case FGJSBBase::Message::eBool:
-        SG_LOG( SG_FLIGHT, SG_INFO, msg->messageId << ": " << msg->text << " " << msg->bVal );
-        break;
-      case FGJSBBase::Message::eInteger:
-        SG_LOG( SG_FLIGHT, SG_INFO, msg->messageId << ": " << msg->text << " " << msg->iVal );
-        break;
-      case FGJSBBase::Message::eDouble:
-        SG_LOG( SG_FLIGHT, SG_INFO, msg->messageId << ": " << msg->text << " " << msg->dVal );
-        break;
-      default:
-        SG_LOG( SG_FLIGHT, SG_INFO, "Unrecognized message type." );
-        break;
-      }
-    }
+    if (process_messages())
+      crashed = true;
 
     reset_wake_group();
 
@@ -583,6 +605,7 @@ void FGJSBsim::update( double dt )
 
 void FGJSBsim::suspend()
 {
+  std::lock_guard<std::mutex> lock(thread_mutex());
   fdmex->Hold();
   SGSubsystem::suspend();
 }
@@ -591,6 +614,7 @@ void FGJSBsim::suspend()
 
 void FGJSBsim::resume()
 {
+  std::lock_guard<std::mutex> lock(thread_mutex());
   fdmex->Resume();
   SGSubsystem::resume();
 }
@@ -601,63 +625,157 @@ void FGJSBsim::resume()
 
 bool FGJSBsim::copy_to_JSBsim()
 {
-    unsigned int i;
+    read_inputs(inputs);
+    apply_inputs(inputs);
+    return true;
+}
 
-    // copy control positions into the JSBsim structure
+/******************************************************************************/
 
-    FCS->SetDaCmd( globals->get_controls()->get_aileron());
-    FCS->SetRollTrimCmd( globals->get_controls()->get_aileron_trim() );
-    FCS->SetDeCmd( globals->get_controls()->get_elevator());
-    FCS->SetPitchTrimCmd( globals->get_controls()->get_elevator_trim() );
-    FCS->SetDrCmd( -globals->get_controls()->get_rudder() );
-    FCS->SetDsCmd( globals->get_controls()->get_rudder() );
-    FCS->SetYawTrimCmd( -globals->get_controls()->get_rudder_trim() );
-    FCS->SetDfCmd( globals->get_controls()->get_flaps() );
-    FCS->SetDsbCmd( globals->get_controls()->get_speedbrake() );
-    FCS->SetDspCmd( globals->get_controls()->get_spoilers() );
+// Read what JSBSim needs from FlightGear. Main loop only.
+
+void FGJSBsim::read_inputs(Inputs& in)
+{
+    FGControls* controls = globals->get_controls();
+
+    in.aileron = controls->get_aileron();
+    in.aileron_trim = controls->get_aileron_trim();
+    in.elevator = controls->get_elevator();
+    in.elevator_trim = controls->get_elevator_trim();
+    in.rudder = controls->get_rudder();
+    in.rudder_trim = controls->get_rudder_trim();
+    in.flaps = controls->get_flaps();
+    in.speedbrake = controls->get_speedbrake();
+    in.spoilers = controls->get_spoilers();
 
         // Parking brake sets minimum braking
         // level for mains.
-    double parking_brake = globals->get_controls()->get_brake_parking();
-    double left_brake = globals->get_controls()->get_brake_left();
-    double right_brake = globals->get_controls()->get_brake_right();
-    
+    double parking_brake = controls->get_brake_parking();
+    double left_brake = controls->get_brake_left();
+    double right_brake = controls->get_brake_right();
+
     if (ab_brake_engaged->getBoolValue()) {
       left_brake = ab_brake_left_pct->getDoubleValue();
-      right_brake = ab_brake_right_pct->getDoubleValue(); 
+      right_brake = ab_brake_right_pct->getDoubleValue();
     }
-    
-    FCS->SetLBrake(FMAX(left_brake, parking_brake));
-    FCS->SetRBrake(FMAX(right_brake, parking_brake));
-    
-    
+
+    in.left_brake = FMAX(left_brake, parking_brake);
+    in.right_brake = FMAX(right_brake, parking_brake);
+    in.gear_down = controls->get_gear_down();
+
+    in.engines.resize(engine_nodes.size());
+    for (unsigned int i = 0; i < in.engines.size(); i++) {
+      EngineInputs& eng = in.engines[i];
+      eng.throttle = controls->get_throttle(i);
+      eng.mixture = controls->get_mixture(i);
+      eng.prop_advance = controls->get_prop_advance(i);
+      eng.feather = controls->get_feather(i);
+      eng.magnetos = controls->get_magnetos(i);
+      eng.augmentation = controls->get_augmentation(i);
+      eng.reverser = controls->get_reverser(i);
+      eng.cutoff = controls->get_cutoff(i);
+      eng.ignition = controls->get_ignition(i);
+      eng.generator_breaker = controls->get_generator_breaker(i);
+      eng.condition = controls->get_condition(i);
+      eng.starter = controls->get_starter(i);
+      eng.running = engine_nodes[i]->getBoolValue("running");
+    }
+
+    in.temperature_degc = temperature->getDoubleValue();
+    in.altitude_ft = get_Altitude();
+    in.pressure_sl_inhg = pressureSL->getDoubleValue();
+
+    in.turbulence_type = TURBULENCE_TYPE_NAMES[turbulence_model->getStringValue()];
+    in.turbulence_gain = turbulence_gain->getDoubleValue();
+    in.turbulence_rate = turbulence_rate->getDoubleValue();
+    in.ground_wind = ground_wind->getDoubleValue();
+
+    in.wind_from_north = wind_from_north->getDoubleValue();
+    in.wind_from_east = wind_from_east->getDoubleValue();
+    in.wind_from_down = wind_from_down->getDoubleValue();
+
+    in.tanks.resize(tank_nodes.size());
+    for (unsigned int i = 0; i < in.tanks.size(); i++) {
+      double fuelDensity = tank_nodes[i]->getDoubleValue("density-ppg");
+
+      if (fuelDensity < 0.1)
+        fuelDensity = 6.0; // Use average fuel value
+
+      in.tanks[i].density = fuelDensity;
+      in.tanks[i].level = tank_nodes[i]->getDoubleValue("level-lbs");
+    }
+
+    in.fuel_freeze = fuel_freeze->getBoolValue();
+    in.slaved = slaved->getBoolValue();
+    in.ai_wake_enabled = _ai_wake_enabled->getBoolValue();
+    in.terrain_override_level = terrain->getIntValue("override-level", -1);
+
+    // what FlightGear changed since the last exchange goes to JSBSim
+    in.serial = ++input_serial;
+    in.props.resize(mirror_fg.size());
+    in.props_serial.resize(mirror_fg.size());
+    for (unsigned int i = 0; i < mirror_fg.size(); i++) {
+      double value = mirror_fg[i]->getDoubleValue();
+      if (value != mirror_last[i]) {
+        mirror_last[i] = value;
+        mirror_written[i] = input_serial;
+      }
+      in.props[i] = value;
+      in.props_serial[i] = mirror_written[i];
+    }
+}
+
+/******************************************************************************/
+
+// Pass the inputs on to JSBSim. Runs in the thread stepping the FDM.
+
+void FGJSBsim::apply_inputs(const Inputs& in)
+{
+    unsigned int i;
+
+    // copy control positions into the JSBsim structure
+
+    FCS->SetDaCmd( in.aileron );
+    FCS->SetRollTrimCmd( in.aileron_trim );
+    FCS->SetDeCmd( in.elevator );
+    FCS->SetPitchTrimCmd( in.elevator_trim );
+    FCS->SetDrCmd( -in.rudder );
+    FCS->SetDsCmd( in.rudder );
+    FCS->SetYawTrimCmd( -in.rudder_trim );
+    FCS->SetDfCmd( in.flaps );
+    FCS->SetDsbCmd( in.speedbrake );
+    FCS->SetDspCmd( in.spoilers );
+
+    FCS->SetLBrake( in.left_brake );
+    FCS->SetRBrake( in.right_brake );
+
     FCS->SetCBrake( 0.0 );
     // FCS->SetCBrake( globals->get_controls()->get_brake(2) );
 
-    FCS->SetGearCmd( globals->get_controls()->get_gear_down());
-    for (i = 0; i < Propulsion->GetNumEngines(); i++) {
-      SGPropertyNode * node = fgGetNode("engines/engine", i, true);
+    FCS->SetGearCmd( in.gear_down );
+    for (i = 0; i < in.engines.size(); i++) {
+      const EngineInputs& controls = in.engines[i];
 
-      FCS->SetThrottleCmd(i, globals->get_controls()->get_throttle(i));
-      FCS->SetMixtureCmd(i, globals->get_controls()->get_mixture(i));
-      FCS->SetPropAdvanceCmd(i, globals->get_controls()->get_prop_advance(i));
-      FCS->SetFeatherCmd(i, globals->get_controls()->get_feather(i));
+      FCS->SetThrottleCmd(i, controls.throttle);
+      FCS->SetMixtureCmd(i, controls.mixture);
+      FCS->SetPropAdvanceCmd(i, controls.prop_advance);
+      FCS->SetFeatherCmd(i, controls.feather);
 
       switch (Propulsion->GetEngine(i)->GetType()) {
       case FGEngine::etPiston:
         { // FGPiston code block
         FGPiston* eng = (FGPiston*)Propulsion->GetEngine(i);
-        eng->SetMagnetos( globals->get_controls()->get_magnetos(i) );
+        eng->SetMagnetos( controls.magnetos );
         break;
         } // end FGPiston code block
       case FGEngine::etTurbine:
         { // FGTurbine code block
         FGTurbine* eng = (FGTurbine*)Propulsion->GetEngine(i);
-        eng->SetAugmentation( globals->get_controls()->get_augmentation(i) );
-        eng->SetReverse( globals->get_controls()->get_reverser(i) );
+        eng->SetAugmentation( controls.augmentation );
+        eng->SetReverse( controls.reverser );
         //eng->SetInjection( globals->get_controls()->get_water_injection(i) );
-        eng->SetCutoff( globals->get_controls()->get_cutoff(i) );
-        eng->SetIgnition( globals->get_controls()->get_ignition(i) );
+        eng->SetCutoff( controls.cutoff );
+        eng->SetIgnition( controls.ignition );
         break;
         } // end FGTurbine code block
       case FGEngine::etRocket:
@@ -668,12 +786,12 @@ bool FGJSBsim::copy_to_JSBsim()
       case FGEngine::etTurboprop:
         { // FGTurboProp code block
         FGTurboProp* eng = (FGTurboProp*)Propulsion->GetEngine(i);
-        eng->SetReverse( globals->get_controls()->get_reverser(i) );
-        eng->SetCutoff( globals->get_controls()->get_cutoff(i) );
+        eng->SetReverse( controls.reverser );
+        eng->SetCutoff( controls.cutoff );
         // eng->SetIgnition( globals->get_controls()->get_ignition(i) );
 
-        eng->SetGeneratorPower( globals->get_controls()->get_generator_breaker(i) );
-        eng->SetCondition( globals->get_controls()->get_condition(i) );
+        eng->SetGeneratorPower( controls.generator_breaker );
+        eng->SetCondition( controls.condition );
         break;
         } // end FGTurboProp code block
       default:
@@ -683,32 +801,32 @@ bool FGJSBsim::copy_to_JSBsim()
       { // FGEngine code block
       FGEngine* eng = Propulsion->GetEngine(i);
 
-      eng->SetStarter( globals->get_controls()->get_starter(i) );
-      eng->SetRunning( node->getBoolValue("running") );
+      eng->SetStarter( controls.starter );
+      eng->SetRunning( controls.running );
       } // end FGEngine code block
     }
 
-    Atmosphere->SetTemperature(temperature->getDoubleValue(), get_Altitude(), FGAtmosphere::eCelsius);
-    Atmosphere->SetPressureSL(FGAtmosphere::eInchesHg, pressureSL->getDoubleValue());
+    Atmosphere->SetTemperature(in.temperature_degc, in.altitude_ft, FGAtmosphere::eCelsius);
+    Atmosphere->SetPressureSL(FGAtmosphere::eInchesHg, in.pressure_sl_inhg);
 
-    Winds->SetTurbType((FGWinds::tType)TURBULENCE_TYPE_NAMES[turbulence_model->getStringValue()]);
+    Winds->SetTurbType((FGWinds::tType)in.turbulence_type);
     switch( Winds->GetTurbType() ) {
         case FGWinds::ttStandard:
         case FGWinds::ttCulp: {
-            double tmp = turbulence_gain->getDoubleValue();
+            double tmp = in.turbulence_gain;
             Winds->SetTurbGain(tmp * tmp * 100.0);
-            Winds->SetTurbRate(turbulence_rate->getDoubleValue());
+            Winds->SetTurbRate(in.turbulence_rate);
             break;
         }
         case FGWinds::ttMilspec:
         case FGWinds::ttTustin: {
             // milspec turbulence: 3=light, 4=moderate, 6=severe turbulence
             // turbulence_gain normalized: 0: none, 1/3: light, 2/3: moderate, 3/3: severe
-            double tmp = turbulence_gain->getDoubleValue();
+            double tmp = in.turbulence_gain;
             Winds->SetProbabilityOfExceedence(
               SGMiscd::roundToInt(TurbulenceSeverityTable.GetValue( tmp ) )
             );
-            Winds->SetWindspeed20ft(ground_wind->getDoubleValue());
+            Winds->SetWindspeed20ft(in.ground_wind);
             break;
         }
 
@@ -716,37 +834,248 @@ bool FGJSBsim::copy_to_JSBsim()
             break;
     }
 
-    Winds->SetWindNED( -wind_from_north->getDoubleValue(),
-                       -wind_from_east->getDoubleValue(),
-                       -wind_from_down->getDoubleValue() );
+    Winds->SetWindNED( -in.wind_from_north,
+                       -in.wind_from_east,
+                       -in.wind_from_down );
 //    SG_LOG(SG_FLIGHT,SG_INFO, "Wind NED: "
 //                  << get_V_north_airmass() << ", "
 //                  << get_V_east_airmass()  << ", "
 //                  << get_V_down_airmass() );
 
-    for (i = 0; i < Propulsion->GetNumTanks(); i++) {
-      SGPropertyNode * node = fgGetNode("/consumables/fuel/tank", i, true);
+    for (i = 0; i < in.tanks.size(); i++) {
       FGTank * tank = Propulsion->GetTank(i);
-      double fuelDensity = node->getDoubleValue("density-ppg");
+      tank->SetDensity(in.tanks[i].density);
+      tank->SetContents(in.tanks[i].level);
+    }
 
-      if (fuelDensity < 0.1)
-        fuelDensity = 6.0; // Use average fuel value
+    Propulsion->SetFuelFreeze(in.fuel_freeze);
+    fdmex->SetChild(in.slaved);
 
-      tank->SetDensity(fuelDensity);
-      tank->SetContents(node->getDoubleValue("level-lbs"));
+    ai_wake_enabled = in.ai_wake_enabled;
+    terrain_override_level = in.terrain_override_level;
+
+    for (i = 0; i < in.props.size() && i < mirror_fdm.size(); i++) {
+      if (in.props_serial[i] > applied_serial)
+        mirror_fdm[i]->setDoubleValue(in.props[i]);
     }
+    applied_serial = in.serial;
+}
 
-    Propulsion->SetFuelFreeze((fgGetNode("/sim/freeze/fuel",true))->getBoolValue());
-    fdmex->SetChild(slaved->getBoolValue());
+/******************************************************************************/
 
+// Convert from the JSBsim generic_ struct to the FGInterface struct
+
+bool FGJSBsim::copy_from_JSBsim()
+{
+    read_outputs(outputs);
+    publish_outputs(outputs);
     return true;
 }
 
 /******************************************************************************/
 
-// Convert from the JSBsim generic_ struct to the FGInterface struct
+// Read the state of JSBSim. Runs in the thread stepping the FDM.
 
-bool FGJSBsim::copy_from_JSBsim()
+void FGJSBsim::read_outputs(Outputs& out)
+{
+    unsigned int i, j;
+
+    out.sim_time = fdmex->GetSimTime();
+
+    for ( i = 0; i < 3; i++ ) {
+      out.cg[i] = MassBalance->GetXYZcg(i+1);
+      out.accel_body[i] = Accelerations->GetBodyAccel(i+1);
+      out.accel_cg_n[i] = Auxiliary->GetNcg(i+1);
+      out.accel_pilot[i] = Auxiliary->GetPilotAccel(i+1);
+      out.vel_local[i] = Propagate->GetVel(i+1);
+      out.uvw[i] = Propagate->GetUVW(i+1);
+      out.pqr[i] = Propagate->GetPQR(i+1);
+      out.euler_rates[i] = Auxiliary->GetEulerRates(i+1);
+      out.euler[i] = Propagate->GetEuler(i+1);
+    }
+
+    out.nlf = Auxiliary->GetNlf();
+    out.vt = Auxiliary->GetVt();
+    out.veas_kts = Auxiliary->GetVequivalentKTS();
+    out.vcas_kts = Auxiliary->GetVcalibratedKTS();
+    out.vground = Auxiliary->GetVground();
+    out.mach = Auxiliary->GetMach();
+
+    // Positions of Visual Reference Point
+    FGLocation l = Auxiliary->GetLocationVRP();
+    out.vrp[0] = l(1);
+    out.vrp[1] = l(2);
+    out.vrp[2] = l(3);
+    out.lon = l.GetLongitude();
+    out.lat = l.GetLatitude();
+    out.radius = l.GetRadius();
+
+    out.agl = Propagate->GetDistanceAGL();
+    {
+      double contact[3], d[3], sd, t;
+      is_valid_m(&t, d, &sd);
+      get_agl_ft(t, l, SG_METER_TO_FEET*2, contact, d, d, d);
+      out.runway_radius
+        = FGColumnVector3( contact[0], contact[1], contact[2] ).Magnitude();
+    }
+
+    out.alpha = Auxiliary->Getalpha();
+    out.beta = Auxiliary->Getbeta();
+    out.gamma = Auxiliary->GetGamma();
+    out.earth_position_angle = Propagate->GetEarthPositionAngle();
+    out.hdot = Propagate->Gethdot();
+
+    const FGMatrix33& Tl2b = Propagate->GetTl2b();
+    for ( i = 0; i < 3; i++ ) {
+        for ( j = 0; j < 3; j++ ) {
+            out.tl2b[i][j] = Tl2b(i+1,j+1);
+        }
+    }
+
+    // Copy the engine values from JSBSim.
+    out.engines.resize(Propulsion->GetNumEngines());
+    for ( i=0; i < out.engines.size(); i++ ) {
+      EngineOutputs& e = out.engines[i];
+      FGEngine* engine = Propulsion->GetEngine(i);
+      FGThruster * thruster = engine->GetThruster();
+
+      e.type = engine->GetType();
+      e.thruster_type = thruster->GetType();
+
+      switch (e.type) {
+      case FGEngine::etPiston:
+        { // FGPiston code block
+        FGPiston* eng = (FGPiston*)engine;
+        e.egt_degf = eng->getExhaustGasTemp_degF();
+        e.oil_temperature_degf = eng->getOilTemp_degF();
+        e.oil_pressure_psi = eng->getOilPressure_psi();
+        e.mp_inhg = eng->getManifoldPressure_inHg();
+        e.cht_degf = eng->getCylinderHeadTemp_degF();
+        e.rpm = eng->getRPM();
+        } // end FGPiston code block
+        break;
+      case FGEngine::etTurbine:
+        { // FGTurbine code block
+        FGTurbine* eng = (FGTurbine*)engine;
+        e.n1 = eng->GetN1();
+        e.n2 = eng->GetN2();
+        e.egt_degf = 32 + eng->GetEGT()*9/5;
+        e.augmentation = eng->GetAugmentation();
+        e.water_injection = eng->GetInjection();
+        e.ignition = eng->GetIgnition() != 0;
+        e.nozzle_pos = eng->GetNozzle();
+        e.inlet_pos = eng->GetInlet();
+        e.oil_pressure_psi = eng->getOilPressure_psi();
+        e.reversed = eng->GetReversed();
+        e.cutoff = eng->GetCutoff();
+        e.epr = eng->GetEPR();
+        } // end FGTurbine code block
+        break;
+      case FGEngine::etTurboprop:
+        { // FGTurboProp code block
+        FGTurboProp* eng = (FGTurboProp*)engine;
+        e.n1 = eng->GetN1();
+        e.itt_degf = 32 + eng->GetITT()*9/5;
+        e.oil_pressure_psi = eng->getOilPressure_psi();
+        e.reversed = eng->GetReversed();
+        e.cutoff = eng->GetCutoff();
+        e.starting = eng->GetEngStarting();
+        e.generator_power = eng->GetGeneratorPower();
+        e.damaged = eng->GetCondition() != 0;
+        e.ielu_intervent = eng->GetIeluIntervent();
+        e.oil_temperature_degf = eng->getOilTemp_degF();
+        } // end FGTurboProp code block
+        break;
+      case FGEngine::etElectric:
+        { // FGElectric code block
+        FGElectric* eng = (FGElectric*)engine;
+        e.rpm = eng->getRPM();
+        } // end FGElectric code block
+        break;
+      default:
+        break;
+      }
+
+      e.fuel_flow_gph = engine->getFuelFlow_gph();
+      e.thrust_lb = thruster->GetThrust();
+      e.fuel_flow_pph = engine->getFuelFlow_pph();
+      e.running = engine->GetRunning();
+      e.starter = engine->GetStarter();
+      e.cranking = engine->GetCranking();
+
+      if (e.thruster_type == FGThruster::ttPropeller) {
+        FGPropeller* prop = (FGPropeller*)thruster;
+        e.prop_rpm = thruster->GetRPM();
+        e.prop_pitch = prop->GetPitch();
+        e.prop_torque = prop->GetTorque();
+        e.prop_feathered = prop->GetFeather();
+      }
+    }
+
+    // Copy the fuel levels from JSBSim if fuel
+    // freeze not enabled.
+    out.fuel_freeze = Propulsion->GetFuelFreeze();
+    out.tanks.resize(Propulsion->GetNumTanks());
+    if ( ! out.fuel_freeze ) {
+      for (i = 0; i < out.tanks.size(); i++) {
+        FGTank* tank = Propulsion->GetTank(i);
+        double fuelDensity = tank->GetDensity();
+
+        if (fuelDensity < 0.1)
+          fuelDensity = 6.0; // Use average fuel value
+
+        out.tanks[i].density = fuelDensity;
+        out.tanks[i].level = tank->GetContents();
+        out.tanks[i].temperature_degc = tank->GetTemperature_degC();
+        out.tanks[i].arm_in = tank->GetXYZ(FGJSBBase::eX);
+      }
+    }
+
+    out.gear.resize(GroundReactions->GetNumGearUnits());
+    for (i = 0; i < out.gear.size(); i++) {
+      FGLGear *gear = GroundReactions->GetGearUnit(i);
+      out.gear[i].wow = gear->GetWOW();
+      out.gear[i].rollspeed_ms = gear->GetWheelRollVel()*0.3043;
+      out.gear[i].position_norm = gear->GetGearUnitPos();
+      out.gear[i].compression_ft = gear->GetCompLen();
+      out.gear[i].steerable = gear->GetSteerable();
+      out.gear[i].steering_norm = gear->GetSteerNorm();
+    }
+
+    out.stall_warning = Aerodynamics->GetStallWarn();
+
+    out.elevator_pos = FCS->GetDePos(ofNorm);
+    out.left_aileron_pos = FCS->GetDaLPos(ofNorm);
+    out.right_aileron_pos = FCS->GetDaRPos(ofNorm);
+    out.rudder_pos = -1*FCS->GetDrPos(ofNorm);
+    out.flap_pos = FCS->GetDfPos(ofNorm);
+    out.speedbrake_pos = FCS->GetDsbPos(ofNorm);
+    out.spoilers_pos = FCS->GetDspPos(ofNorm);
+    out.tailhook_pos = FCS->GetTailhookPos();
+    out.wing_fold_pos = FCS->GetWingFoldPos();
+
+    out.terrain_active = terrain_active;
+    out.terrain_valid = terrain_valid;
+
+    // force a sim crashed if crashed (altitude AGL < 0)
+    if (out.agl < -100.0) {
+         fdmex->SuspendIntegration();
+         crashed = true;
+    }
+    out.crashed = crashed;
+
+    out.props.resize(mirror_fdm.size());
+    for (i = 0; i < out.props.size(); i++) {
+      out.props[i] = mirror_fdm[i]->getDoubleValue();
+    }
+    out.serial = applied_serial;
+}
+
+/******************************************************************************/
+
+// Hand the state of JSBSim over to FlightGear. Main loop only.
+
+void FGJSBsim::publish_outputs(const Outputs& out)
 {
     unsigned int i, j;
 /*
@@ -756,256 +1085,390 @@ bool FGJSBsim::copy_from_JSBsim()
                    MassBalance->GetIzz(),
                    MassBalance->GetIxz() );
 */
-    _set_CG_Position( MassBalance->GetXYZcg(1),
-                      MassBalance->GetXYZcg(2),
-                      MassBalance->GetXYZcg(3) );
+    _set_CG_Position( out.cg[0], out.cg[1], out.cg[2] );
 
-    _set_Accels_Body( Accelerations->GetBodyAccel(1),
-                      Accelerations->GetBodyAccel(2),
-                      Accelerations->GetBodyAccel(3) );
+    _set_Accels_Body( out.accel_body[0], out.accel_body[1], out.accel_body[2] );
 
-    _set_Accels_CG_Body_N ( Auxiliary->GetNcg(1),
-                            Auxiliary->GetNcg(2),
-                            Auxiliary->GetNcg(3) );
+    _set_Accels_CG_Body_N ( out.accel_cg_n[0], out.accel_cg_n[1], out.accel_cg_n[2] );
 
-    _set_Accels_Pilot_Body( Auxiliary->GetPilotAccel(1),
-                            Auxiliary->GetPilotAccel(2),
-                            Auxiliary->GetPilotAccel(3) );
+    _set_Accels_Pilot_Body( out.accel_pilot[0], out.accel_pilot[1], out.accel_pilot[2] );
 
-    _set_Nlf( Auxiliary->GetNlf() );
+    _set_Nlf( out.nlf );
 
     // Velocities
 
-    _set_Velocities_Local( Propagate->GetVel(FGJSBBase::eNorth),
-                           Propagate->GetVel(FGJSBBase::eEast),
-                           Propagate->GetVel(FGJSBBase::eDown) );
+    _set_Velocities_Local( out.vel_local[0], out.vel_local[1], out.vel_local[2] );
 
-    _set_Velocities_Body( Propagate->GetUVW(1),
-                          Propagate->GetUVW(2),
-                          Propagate->GetUVW(3) );
+    _set_Velocities_Body( out.uvw[0], out.uvw[1], out.uvw[2] );
 
     // Make the HUD work ...
-    _set_Velocities_Ground( Propagate->GetVel(FGJSBBase::eNorth),
-                            Propagate->GetVel(FGJSBBase::eEast),
-                            -Propagate->GetVel(FGJSBBase::eDown) );
+    _set_Velocities_Ground( out.vel_local[0], out.vel_local[1], -out.vel_local[2] );
 
-    _set_V_rel_wind( Auxiliary->GetVt() );
+    _set_V_rel_wind( out.vt );
 
-    _set_V_equiv_kts( Auxiliary->GetVequivalentKTS() );
+    _set_V_equiv_kts( out.veas_kts );
 
-    _set_V_calibrated_kts( Auxiliary->GetVcalibratedKTS() );
+    _set_V_calibrated_kts( out.vcas_kts );
 
-    _set_V_ground_speed( Auxiliary->GetVground() );
+    _set_V_ground_speed( out.vground );
 
-    _set_Omega_Body( Propagate->GetPQR(FGJSBBase::eP),
-                     Propagate->GetPQR(FGJSBBase::eQ),
-                     Propagate->GetPQR(FGJSBBase::eR) );
+    _set_Omega_Body( out.pqr[0], out.pqr[1], out.pqr[2] );
 
-    _set_Euler_Rates( Auxiliary->GetEulerRates(FGJSBBase::ePhi),
-                      Auxiliary->GetEulerRates(FGJSBBase::eTht),
-                      Auxiliary->GetEulerRates(FGJSBBase::ePsi) );
+    _set_Euler_Rates( out.euler_rates[0], out.euler_rates[1], out.euler_rates[2] );
 
-    _set_Mach_number( Auxiliary->GetMach() );
+    _set_Mach_number( out.mach );
 
     // Positions of Visual Reference Point
-    FGLocation l = Auxiliary->GetLocationVRP();
-    _updatePosition(SGGeoc::fromRadFt( l.GetLongitude(), l.GetLatitude(),
-                                       l.GetRadius() ));
+    _updatePosition(SGGeoc::fromRadFt( out.lon, out.lat, out.radius ));
 
-    _set_Altitude_AGL( Propagate->GetDistanceAGL() );
-    {
-      double contact[3], d[3], sd, t;
-      is_valid_m(&t, d, &sd);
-      get_agl_ft(t, l, SG_METER_TO_FEET*2, contact, d, d, d);
-      double rwrad
-        = FGColumnVector3( contact[0], contact[1], contact[2] ).Magnitude();
-      _set_Runway_altitude( rwrad - get_Sea_level_radius() );
-    }
+    _set_Altitude_AGL( out.agl );
+    _set_Runway_altitude( out.runway_radius - get_Sea_level_radius() );
 
-    _set_Euler_Angles( Propagate->GetEuler(FGJSBBase::ePhi),
-                       Propagate->GetEuler(FGJSBBase::eTht),
-                       Propagate->GetEuler(FGJSBBase::ePsi) );
+    _set_Euler_Angles( out.euler[0], out.euler[1], out.euler[2] );
 
-    _set_Alpha( Auxiliary->Getalpha() );
-    _set_Beta( Auxiliary->Getbeta() );
+    _set_Alpha( out.alpha );
+    _set_Beta( out.beta );
 
 
-    _set_Gamma_vert_rad( Auxiliary->GetGamma() );
+    _set_Gamma_vert_rad( out.gamma );
 
-    _set_Earth_position_angle( Propagate->GetEarthPositionAngle() );
+    _set_Earth_position_angle( out.earth_position_angle );
 
-    _set_Climb_Rate( Propagate->Gethdot() );
+    _set_Climb_Rate( out.hdot );
 
-    const FGMatrix33& Tl2b = Propagate->GetTl2b();
     for ( i = 1; i <= 3; i++ ) {
         for ( j = 1; j <= 3; j++ ) {
-            _set_T_Local_to_Body( i, j, Tl2b(i,j) );
+            _set_T_Local_to_Body( i, j, out.tl2b[i-1][j-1] );
         }
     }
 
-    // Copy the engine values from JSBSim.
-    for ( i=0; i < Propulsion->GetNumEngines(); i++ ) {
-      SGPropertyNode * node = fgGetNode("engines/engine", i, true);
-      SGPropertyNode * tnode = node->getChild("thruster", 0, true);
-      FGThruster * thruster = Propulsion->GetEngine(i)->GetThruster();
+    FGControls* controls = globals->get_controls();
 
-      switch (Propulsion->GetEngine(i)->GetType()) {
+    for ( i=0; i < out.engines.size(); i++ ) {
+      const EngineOutputs& e = out.engines[i];
+      SGPropertyNode * node = engine_nodes[i];
+      SGPropertyNode * tnode = thruster_nodes[i];
+
+      switch (e.type) {
       case FGEngine::etPiston:
-        { // FGPiston code block
-        FGPiston* eng = (FGPiston*)Propulsion->GetEngine(i);
-        node->setDoubleValue("egt-degf", eng->getExhaustGasTemp_degF());
-        node->setDoubleValue("oil-temperature-degf", eng->getOilTemp_degF());
-        node->setDoubleValue("oil-pressure-psi", eng->getOilPressure_psi());
-        node->setDoubleValue("mp-osi", eng->getManifoldPressure_inHg());
+        node->setDoubleValue("egt-degf", e.egt_degf);
+        node->setDoubleValue("oil-temperature-degf", e.oil_temperature_degf);
+        node->setDoubleValue("oil-pressure-psi", e.oil_pressure_psi);
+        node->setDoubleValue("mp-osi", e.mp_inhg);
         // NOTE: mp-osi is not in ounces per square inch.
         // This error is left for reasons of backwards compatibility with
         // existing FlightGear sound and instrument configurations.
-        node->setDoubleValue("mp-inhg", eng->getManifoldPressure_inHg());
-        node->setDoubleValue("cht-degf", eng->getCylinderHeadTemp_degF());
-        node->setDoubleValue("rpm", eng->getRPM());
-        } // end FGPiston code block
-        break;
-      case FGEngine::etRocket:
-        { // FGRocket code block
-//        FGRocket* eng = (FGRocket*)Propulsion->GetEngine(i);
-        } // end FGRocket code block
+        node->setDoubleValue("mp-inhg", e.mp_inhg);
+        node->setDoubleValue("cht-degf", e.cht_degf);
+        node->setDoubleValue("rpm", e.rpm);
         break;
       case FGEngine::etTurbine:
-        { // FGTurbine code block
-        FGTurbine* eng = (FGTurbine*)Propulsion->GetEngine(i);
-        node->setDoubleValue("n1", eng->GetN1());
-        node->setDoubleValue("n2", eng->GetN2());
-        node->setDoubleValue("egt-degf", 32 + eng->GetEGT()*9/5);
-        node->setBoolValue("augmentation", eng->GetAugmentation());
-        node->setBoolValue("water-injection", eng->GetInjection());
-        node->setBoolValue("ignition", eng->GetIgnition() != 0);
-        node->setDoubleValue("nozzle-pos-norm", eng->GetNozzle());
-        node->setDoubleValue("inlet-pos-norm", eng->GetInlet());
-        node->setDoubleValue("oil-pressure-psi", eng->getOilPressure_psi());
-        node->setBoolValue("reversed", eng->GetReversed());
-        node->setBoolValue("cutoff", eng->GetCutoff());
-        node->setDoubleValue("epr", eng->GetEPR());
-        globals->get_controls()->set_reverser(i, eng->GetReversed() );
-        globals->get_controls()->set_cutoff(i, eng->GetCutoff() );
-        globals->get_controls()->set_water_injection(i, eng->GetInjection() );
-        globals->get_controls()->set_augmentation(i, eng->GetAugmentation() );
-        } // end FGTurbine code block
+        node->setDoubleValue("n1", e.n1);
+        node->setDoubleValue("n2", e.n2);
+        node->setDoubleValue("egt-degf", e.egt_degf);
+        node->setBoolValue("augmentation", e.augmentation);
+        node->setBoolValue("water-injection", e.water_injection);
+        node->setBoolValue("ignition", e.ignition);
+        node->setDoubleValue("nozzle-pos-norm", e.nozzle_pos);
+        node->setDoubleValue("inlet-pos-norm", e.inlet_pos);
+        node->setDoubleValue("oil-pressure-psi", e.oil_pressure_psi);
+        node->setBoolValue("reversed", e.reversed);
+        node->setBoolValue("cutoff", e.cutoff);
+        node->setDoubleValue("epr", e.epr);
+        controls->set_reverser(i, e.reversed );
+        controls->set_cutoff(i, e.cutoff );
+        controls->set_water_injection(i, e.water_injection );
+        controls->set_augmentation(i, e.augmentation );
         break;
       case FGEngine::etTurboprop:
-        { // FGTurboProp code block
-        FGTurboProp* eng = (FGTurboProp*)Propulsion->GetEngine(i);
-        node->setDoubleValue("n1", eng->GetN1());
-        //node->setDoubleValue("n2", eng->GetN2());
-        node->setDoubleValue("itt_degf", 32 + eng->GetITT()*9/5);
-        // node->setBoolValue("ignition", eng->GetIgnition() != 0);
-        // node->setDoubleValue("nozzle-pos-norm", eng->GetNozzle());
-        // node->setDoubleValue("inlet-pos-norm", eng->GetInlet());
-        node->setDoubleValue("oil-pressure-psi", eng->getOilPressure_psi());
-        node->setBoolValue("reversed", eng->GetReversed());
-        node->setBoolValue("cutoff", eng->GetCutoff());
-        node->setBoolValue("starting", eng->GetEngStarting());
-        node->setBoolValue("generator-power", eng->GetGeneratorPower());
-        node->setBoolValue("damaged", eng->GetCondition() != 0);
-        node->setBoolValue("ielu-intervent", eng->GetIeluIntervent());
-        node->setDoubleValue("oil-temperature-degf", eng->getOilTemp_degF());
+        node->setDoubleValue("n1", e.n1);
+        node->setDoubleValue("itt_degf", e.itt_degf);
+        node->setDoubleValue("oil-pressure-psi", e.oil_pressure_psi);
+        node->setBoolValue("reversed", e.reversed);
+        node->setBoolValue("cutoff", e.cutoff);
+        node->setBoolValue("starting", e.starting);
+        node->setBoolValue("generator-power", e.generator_power);
+        node->setBoolValue("damaged", e.damaged);
+        node->setBoolValue("ielu-intervent", e.ielu_intervent);
+        node->setDoubleValue("oil-temperature-degf", e.oil_temperature_degf);
 //        node->setBoolValue("onfire", eng->GetFire());
-        globals->get_controls()->set_reverser(i, eng->GetReversed() );
-        globals->get_controls()->set_cutoff(i, eng->GetCutoff() );
-        } // end FGTurboProp code block
+        controls->set_reverser(i, e.reversed );
+        controls->set_cutoff(i, e.cutoff );
         break;
       case FGEngine::etElectric:
-        { // FGElectric code block
-        FGElectric* eng = (FGElectric*)Propulsion->GetEngine(i);
-        node->setDoubleValue("rpm", eng->getRPM());
-        } // end FGElectric code block
+        node->setDoubleValue("rpm", e.rpm);
         break;
-      case FGEngine::etUnknown:
+      default:
         break;
       }
 
-      { // FGEngine code block
-      FGEngine* eng = Propulsion->GetEngine(i);
-      node->setDoubleValue("fuel-flow-gph", eng->getFuelFlow_gph());
-      node->setDoubleValue("thrust_lb", thruster->GetThrust());
-      node->setDoubleValue("fuel-flow_pph", eng->getFuelFlow_pph());
-      node->setBoolValue("running", eng->GetRunning());
-      node->setBoolValue("starter", eng->GetStarter());
-      node->setBoolValue("cranking", eng->GetCranking());
-      globals->get_controls()->set_starter(i, eng->GetStarter() );
-      } // end FGEngine code block
+      node->setDoubleValue("fuel-flow-gph", e.fuel_flow_gph);
+      node->setDoubleValue("thrust_lb", e.thrust_lb);
+      node->setDoubleValue("fuel-flow_pph", e.fuel_flow_pph);
+      node->setBoolValue("running", e.running);
+      node->setBoolValue("starter", e.starter);
+      node->setBoolValue("cranking", e.cranking);
+      controls->set_starter(i, e.starter );
+
+      if (e.thruster_type == FGThruster::ttPropeller) {
+        tnode->setDoubleValue("rpm", e.prop_rpm);
+        tnode->setDoubleValue("pitch", e.prop_pitch);
+        tnode->setDoubleValue("torque", e.prop_torque);
+        tnode->setBoolValue("feathered", e.prop_feathered);
+      }
+    }
+
+    if ( ! out.fuel_freeze ) {
+      for (i = 0; i < out.tanks.size(); i++) {
+        SGPropertyNode * node = tank_nodes[i];
+        const TankOutputs& tank = out.tanks[i];
+
+        node->setDoubleValue("density-ppg" , tank.density);
+        node->setDoubleValue("level-lbs", tank.level);
+        if (tank.temperature_degc != -9999.0)
+          node->setDoubleValue("temperature_degC", tank.temperature_degc);
+
+        node->setDoubleValue("arm-in", tank.arm_in );
+      }
+    }
+
+    for (i = 0; i < out.gear.size(); i++) {
+      SGPropertyNode * node = gear_nodes[i];
+      const GearOutputs& gear = out.gear[i];
+      node->setBoolValue("wow", gear.wow);
+      node->setDoubleValue("rollspeed-ms", gear.rollspeed_ms);
+      node->setDoubleValue("position-norm", gear.position_norm);
+      node->setDoubleValue("compression-norm", gear.compression_ft);
+      node->setDoubleValue("compression-ft", gear.compression_ft);
+      if ( gear.steerable )
+        node->setDoubleValue("steering-norm", gear.steering_norm);
+    }
+
+    stall_warning->setDoubleValue( out.stall_warning );
 
-      switch (thruster->GetType()) {
-      case FGThruster::ttNozzle:
-        { // FGNozzle code block
-//        FGNozzle* noz = (FGNozzle*)thruster;
-        } // end FGNozzle code block
+    elevator_pos_pct->setDoubleValue( out.elevator_pos );
+    left_aileron_pos_pct->setDoubleValue( out.left_aileron_pos );
+    right_aileron_pos_pct->setDoubleValue( out.right_aileron_pos );
+    rudder_pos_pct->setDoubleValue( out.rudder_pos );
+    flap_pos_pct->setDoubleValue( out.flap_pos );
+    speedbrake_pos_pct->setDoubleValue( out.speedbrake_pos );
+    spoilers_pos_pct->setDoubleValue( out.spoilers_pos );
+    tailhook_pos_pct->setDoubleValue( out.tailhook_pos );
+    wing_fold_pos_pct->setDoubleValue( out.wing_fold_pos );
+
+#ifdef JSBSIM_USE_GROUNDREACTIONS
+    terrain->setBoolValue("active", out.terrain_active);
+#endif
+    terrain->setBoolValue("valid", out.terrain_valid);
+
+    // A property FlightGear changed is only taken back once JSBSim has seen
+    // the change.
+    for (i = 0; i < out.props.size() && i < mirror_fg.size(); i++) {
+      if (mirror_written[i] > out.serial || out.props[i] == mirror_last[i])
+        continue;
+      mirror_fg[i]->setDoubleValue(out.props[i]);
+      mirror_last[i] = mirror_fg[i]->getDoubleValue();
+    }
+}
+
+/******************************************************************************/
+
+// Pair the leaves of JSBSim's own property tree with the nodes of the same
+// path in FlightGear's. Main loop only, while the FDM thread is not running.
+
+void FGJSBsim::build_mirror()
+{
+    mirror_fdm.clear();
+    mirror_fg.clear();
+    mirror_last.clear();
+    mirror_written.clear();
+    if (private_props)
+      add_mirror(fdm_props);
+
+    for (unsigned int i = 0; i < mirror_fdm.size(); i++) {
+      SGPropertyNode* from = mirror_fdm[i];
+      SGPropertyNode* to = mirror_fg[i];
+      // As with a single tree: JSBSim's tied values win, the values
+      // FlightGear already has win over the defaults of the other ones.
+      if (!from->isTied() && to->hasValue())
+        std::swap(from, to);
+
+      switch (from->getType()) {
+      case simgear::props::BOOL:
+        to->setBoolValue(from->getBoolValue());
         break;
-      case FGThruster::ttPropeller:
-        { // FGPropeller code block
-        FGPropeller* prop = (FGPropeller*)thruster;
-        tnode->setDoubleValue("rpm", thruster->GetRPM());
-        tnode->setDoubleValue("pitch", prop->GetPitch());
-        tnode->setDoubleValue("torque", prop->GetTorque());
-        tnode->setBoolValue("feathered", prop->GetFeather());
-        } // end FGPropeller code block
+      case simgear::props::INT:
+        to->setIntValue(from->getIntValue());
         break;
-      case FGThruster::ttRotor:
-        { // FGRotor code block
-//        FGRotor* rotor = (FGRotor*)thruster;
-        } // end FGRotor code block
+      case simgear::props::LONG:
+        to->setLongValue(from->getLongValue());
         break;
-      case FGThruster::ttDirect:
-        { // Direct code block
-        } // end Direct code block
+      default:
+        to->setDoubleValue(from->getDoubleValue());
         break;
       }
+      mirror_last.push_back(mirror_fg[i]->getDoubleValue());
+      mirror_written.push_back(0);
+    }
+}
+
+void FGJSBsim::add_mirror(SGPropertyNode* node)
+{
+    if (node->isAlias())
+      return;
 
+    if (node->nChildren() > 0) {
+      for (int i = 0; i < node->nChildren(); i++)
+        add_mirror(node->getChild(i));
+      return;
     }
 
-    // Copy the fuel levels from JSBSim if fuel
-    // freeze not enabled.
-    if ( ! Propulsion->GetFuelFreeze() ) {
-      for (i = 0; i < Propulsion->GetNumTanks(); i++) {
-        SGPropertyNode * node = fgGetNode("/consumables/fuel/tank", i, true);
-        FGTank* tank = Propulsion->GetTank(i);
-        double contents = tank->GetContents();
-        double temp = tank->GetTemperature_degC();
-        double fuelDensity = tank->GetDensity();
+    // strings are not passed on, JSBSim has no use for them
+    switch (node->getType()) {
+    case simgear::props::BOOL:
+    case simgear::props::INT:
+    case simgear::props::LONG:
+    case simgear::props::FLOAT:
+    case simgear::props::DOUBLE:
+      mirror_fdm.push_back(node);
+      mirror_fg.push_back(fgGetNode(node->getPath().c_str(), true));
+      break;
+    default:
+      break;
+    }
+}
 
-        if (fuelDensity < 0.1)
-          fuelDensity = 6.0; // Use average fuel value
+/******************************************************************************/
 
-        node->setDoubleValue("density-ppg" , fuelDensity);
-        node->setDoubleValue("level-lbs", contents);
-        if (temp != -9999.0) node->setDoubleValue("temperature_degC", temp);
+// Log the messages of JSBSim; returns true if one of them reports a crash.
 
-        node->setDoubleValue("arm-in", tank->GetXYZ(FGJSBBase::eX ) );
+bool FGJSBsim::process_messages(void)
+{
+    bool crash = false;
+    FGJSBBase::Message* msg;
+    while ((msg = fdmex->ProcessNextMessage()) != NULL) {
+//      msg = fdmex->ProcessNextMessage();
+      switch (msg->type) {
+      case FGJSBBase::Message::eText:
+        if (msg->text == "Crash Detected: Simulation FREEZE.")
+          crash = true;
+        SG_LOG( SG_FLIGHT, SG_INFO, msg->messageId << ": " << msg->text );
+        break;
+      case FGJSBBase::Message::eBool:
+        SG_LOG( SG_FLIGHT, SG_INFO, msg->messageId << ": " << msg->text << " " << msg->bVal );
+        break;
+      case FGJSBBase::Message::eInteger:
+        SG_LOG( SG_FLIGHT, SG_INFO, msg->messageId << ": " << msg->text << " " << msg->iVal );
+        break;
+      case FGJSBBase::Message::eDouble:
+        SG_LOG( SG_FLIGHT, SG_INFO, msg->messageId << ": " << msg->text << " " << msg->dVal );
+        break;
+      default:
+        SG_LOG( SG_FLIGHT, SG_INFO, "Unrecognized message type." );
+        break;
       }
     }
 
-    update_gear();
+    return crash;
+}
+
+/******************************************************************************/
 
-    stall_warning->setDoubleValue( Aerodynamics->GetStallWarn() );
+void FGJSBsim::thread_start(double step_dt)
+{
+    // pick up the properties JSBSim created since it was loaded
+    build_mirror();
 
-    elevator_pos_pct->setDoubleValue( FCS->GetDePos(ofNorm) );
-    left_aileron_pos_pct->setDoubleValue( FCS->GetDaLPos(ofNorm) );
-    right_aileron_pos_pct->setDoubleValue( FCS->GetDaRPos(ofNorm) );
-    rudder_pos_pct->setDoubleValue( -1*FCS->GetDrPos(ofNorm) );
-    flap_pos_pct->setDoubleValue( FCS->GetDfPos(ofNorm) );
-    speedbrake_pos_pct->setDoubleValue( FCS->GetDsbPos(ofNorm) );
-    spoilers_pos_pct->setDoubleValue( FCS->GetDspPos(ofNorm) );
-    tailhook_pos_pct->setDoubleValue( FCS->GetTailhookPos() );
-    wing_fold_pos_pct->setDoubleValue( FCS->GetWingFoldPos() );
+    unthreaded_dt = fdmex->GetDeltaT();
+    fdmex->Setdt(step_dt);
 
-    // force a sim crashed if crashed (altitude AGL < 0)
-    if (get_Altitude_AGL() < -100.0) {
-         fdmex->SuspendIntegration();
-         crashed = true;
+    read_inputs(inputs);
+    apply_inputs(inputs);
+    input_buffer.init(inputs);
+    thread_inputs = inputs;
+
+    read_outputs(outputs);
+    output_buffer.init(outputs);
+    thread_outputs = outputs;
+}
+
+/******************************************************************************/
+
+void FGJSBsim::thread_stop()
+{
+    fdmex->Setdt(unthreaded_dt);
+
+    if (output_buffer.read(outputs)) {
+      publish_outputs(outputs);
     }
+}
 
-    return true;
+/******************************************************************************/
+
+// Main loop, with the FDM thread kept out.
+
+void FGJSBsim::thread_prepare(double dt)
+{
+    // The cache must cover the steps run until the next frame.
+    double speed = FGColumnVector3(outputs.uvw[0], outputs.uvw[1],
+                                   outputs.uvw[2]).Magnitude();
+    update_ground_cache(outputs.vrp, outputs.sim_time, speed, dt);
+
+    // The tailhook reads and writes the properties of the hook system, so it
+    // is updated here once per frame rather than after each step.
+    if (!crashed)
+      update_external_forces(fdmex->GetSimTime());
+
+    read_inputs(inputs);
+    input_buffer.write(inputs);
 }
 
+/******************************************************************************/
+
+// Run by the FDM thread: no access to the FlightGear properties here, only
+// to JSBSim's own tree, which the main loop only touches with the thread
+// mutex held.
+
+bool FGJSBsim::thread_step()
+{
+    if (crashed)
+      return false;
+
+    if (input_buffer.read(thread_inputs))
+      apply_inputs(thread_inputs);
+
+    if (!fdmex->Run()) {
+      // The property fdm/jsbsim/simulation/terminate has been set to true
+      // by the user. The sim is considered crashed.
+      crashed = true;
+    }
+
+    read_outputs(thread_outputs);
+    output_buffer.write(thread_outputs);
+
+    return !crashed;
+}
+
+/******************************************************************************/
+
+// Main loop: the latest state of the FDM thread goes to FlightGear.
+
+void FGJSBsim::thread_publish()
+{
+    if (output_buffer.read(outputs)) {
+      trimmed->setBoolValue(false);
+      publish_outputs(outputs);
+    }
+
+    // The message queue of JSBSim is thread safe. A crash it reports is only
+    // passed on: the FDM has frozen itself already.
+    bool crash = process_messages() || outputs.crashed;
+
+    if (crash && !fgGetBool("/sim/crashed"))
+      fgSetBool("/sim/crashed", true);
+}
+
+/******************************************************************************/
 
 bool FGJSBsim::ToggleDataLogging(void)
 {
@@ -1252,24 +1715,6 @@ void FGJSBsim::init_gear(void )
     }
 }
 
-void FGJSBsim::update_gear(void)
-{
-    FGGroundReactions* gr=fdmex->GetGroundReactions();
-    int Ngear=GroundReactions->GetNumGearUnits();
-    for (int i=0;i<Ngear;i++) {
-      FGLGear *gear = gr->GetGearUnit(i);
-      SGPropertyNode * node = fgGetNode("gear/gear", i, true);
-      node->getChild("wow", 0, true)->setBoolValue( gear->GetWOW());
-      node->getChild("rollspeed-ms", 0, true)->setDoubleValue(gear->GetWheelRollVel()*0.3043);
-      node->getChild("position-norm", 0, true)->setDoubleValue(gear->GetGearUnitPos());
-//    gear->SetTirePressure(node->getDoubleValue("tire-pressure-norm"));
-      node->setDoubleValue("compression-norm", gear->GetCompLen());
-      node->setDoubleValue("compression-ft", gear->GetCompLen());
-      if ( gear->GetSteerable() )
-        node->setDoubleValue("steering-norm", gear->GetSteerNorm());
-    }
-}
-
 void FGJSBsim::do_trim(void)
 {
   FGTrim *fgtrim;
@@ -1306,6 +1751,14 @@ void FGJSBsim::do_trim(void)
 }
 
 bool FGJSBsim::update_ground_cache(const FGLocation& cart, double dt)
+{
+  double cart_pos[3] {cart(1), cart(2), cart(3)};
+  return update_ground_cache(cart_pos, fdmex->GetSimTime(),
+                             Propagate->GetUVW().Magnitude(), dt);
+}
+
+bool FGJSBsim::update_ground_cache(const double cart[3], double t0,
+                                   double speed, double dt)
 {
   // Compute the radius of the aircraft. That is the radius of a ball
   // where all gear units are in. At the moment it is at least 10ft ...
@@ -1320,10 +1773,9 @@ bool FGJSBsim::update_ground_cache(const FGLocation& cart, double dt)
 
   // Compute the potential movement of this aircraft and query for the
   // ground in this area.
-  double groundCacheRadius = acrad + 2*dt*Propagate->GetUVW().Magnitude();
+  double groundCacheRadius = acrad + 2*dt*speed;
 
-  double cart_pos[3] {cart(1), cart(2), cart(3)};
-  double t0 = fdmex->GetSimTime();
+  double cart_pos[3] {cart[0], cart[1], cart[2]};
   bool cache_ok = prepare_ground_cache_ft( t0, t0 + dt, cart_pos,
                                            groundCacheRadius );
   if (!cache_ok) {
@@ -1363,10 +1815,11 @@ FGJSBsim::get_agl_ft(double t, const FGColumnVector3& loc, double alt_off,
   SGGeod geodPt = SGGeod::fromCart(SG_FEET_TO_METER*SGVec3d(pt));
   SGQuatd hlToEc = SGQuatd::fromLonLat(geodPt);
 
+  // The terrain properties are read and written by copy_to_JSBsim() and
+  // copy_from_JSBsim(): this may run in the FDM thread.
 #ifdef JSBSIM_USE_GROUNDREACTIONS
-  bool terrain_active = (terrain->getIntValue("override-level", -1) > 0) ? false : true;
-  terrain->setBoolValue("active", terrain_active);
-  terrain->setBoolValue("valid", (material && terrain_active) ? true : false);
+  terrain_active = (terrain_override_level > 0) ? false : true;
+  terrain_valid = (material && terrain_active) ? true : false;
   if (terrain_active)
   {
     static bool material_valid = false;
@@ -1389,7 +1842,7 @@ FGJSBsim::get_agl_ft(double t, const FGColumnVector3& loc, double alt_off,
     }
   }
 #else
-  terrain->setBoolValue("valid", false);
+  terrain_valid = false;
 #endif
   return dot(hlToEc.rotate(SGVec3d(0, 0, 1)), SGVec3d(contact) - SGVec3d(pt));
 }
@@ -1446,10 +1899,10 @@ void FGJSBsim::update_external_forces(double t_off)
     hook_area[1][1] = hook_root(2);
     hook_area[1][2] = hook_root(3);
     
-    hook_length = fgGetDouble("/fdm/jsbsim/systems/hook/tailhook-length-ft", 6.75);
-    double fi_min = fgGetDouble("/fdm/jsbsim/systems/hook/tailhook-pos-min-deg", -18);
-    double fi_max = fgGetDouble("/fdm/jsbsim/systems/hook/tailhook-pos-max-deg", 30);
-    double fi = fgGetDouble("/fdm/jsbsim/systems/hook/tailhook-pos-norm") * (fi_max - fi_min) + fi_min;
+    hook_length = fdm_props->getDoubleValue("/fdm/jsbsim/systems/hook/tailhook-length-ft", 6.75);
+    double fi_min = fdm_props->getDoubleValue("/fdm/jsbsim/systems/hook/tailhook-pos-min-deg", -18);
+    double fi_max = fdm_props->getDoubleValue("/fdm/jsbsim/systems/hook/tailhook-pos-max-deg", 30);
+    double fi = fdm_props->getDoubleValue("/fdm/jsbsim/systems/hook/tailhook-pos-norm") * (fi_max - fi_min) + fi_min;
     double cos_fi = cos(fi * SG_DEGREES_TO_RADIANS);
     double sin_fi = sin(fi * SG_DEGREES_TO_RADIANS);
 
@@ -1523,7 +1976,7 @@ void FGJSBsim::update_external_forces(double t_off)
         if (rel_vel.Magnitude() < 3) {
             got_wire = false;
             release_wire();
-            fgSetDouble("/fdm/jsbsim/external_reactions/hook/magnitude", 0.0);
+            fdm_props->setDoubleValue("/fdm/jsbsim/external_reactions/hook/magnitude", 0.0);
         } else {
             FGColumnVector3 wire_end1_body = Tl2b * Location.LocationToLocal(FGColumnVector3(wire_ends_ec[0][0], wire_ends_ec[0][1], wire_ends_ec[0][2])) - hook_root_body;
             FGColumnVector3 wire_end2_body = Tl2b * Location.LocationToLocal(FGColumnVector3(wire_ends_ec[1][0], wire_ends_ec[1][1], wire_ends_ec[1][2])) - hook_root_body;
@@ -1534,10 +1987,10 @@ void FGJSBsim::update_external_forces(double t_off)
             sin_fi = sqrt(1 - sqr(cos_fi));
             fi = atan2(sin_fi, cos_fi) * SG_RADIANS_TO_DEGREES;
         
-            fgSetDouble("/fdm/jsbsim/external_reactions/hook/x", -cos_fi);
-            fgSetDouble("/fdm/jsbsim/external_reactions/hook/y", 0);
-            fgSetDouble("/fdm/jsbsim/external_reactions/hook/z", sin_fi);
-            fgSetDouble("/fdm/jsbsim/external_reactions/hook/magnitude", fgGetDouble("/fdm/jsbsim/systems/hook/force"));
+            fdm_props->setDoubleValue("/fdm/jsbsim/external_reactions/hook/x", -cos_fi);
+            fdm_props->setDoubleValue("/fdm/jsbsim/external_reactions/hook/y", 0);
+            fdm_props->setDoubleValue("/fdm/jsbsim/external_reactions/hook/z", sin_fi);
+            fdm_props->setDoubleValue("/fdm/jsbsim/external_reactions/hook/magnitude", fdm_props->getDoubleValue("/fdm/jsbsim/systems/hook/force"));
         }
     }
 
@@ -1571,9 +2024,9 @@ void FGJSBsim::update_external_forces(double t_off)
     last_hook_root[1] = hook_area[1][1];
     last_hook_root[2] = hook_area[1][2];
     
-    fgSetDouble("/fdm/jsbsim/systems/hook/tailhook-pos-deg", fi);
+    fdm_props->setDoubleValue("/fdm/jsbsim/systems/hook/tailhook-pos-deg", fi);
 
-    if (_ai_wake_enabled->getBoolValue()) {
+    if (ai_wake_enabled) {
       FGColumnVector3 uvw = Propagate->GetUVW();
       FGQuaternion ql2b = Propagate->GetQuaternion();
       FGLocation l = Auxiliary->GetLocationVRP();
@@ -54,7 +54,11 @@ FORWARD DECLARATIONS
 
 #include <simgear/props/props.hxx>
 
+#include <vector>
+#include <atomic>
+
 #include <FDM/JSBSim/FGFDMExec.h>
+#include <FDM/fdm_snapshot.hxx>
 #include "FDM/AIWake/AircraftMesh.hxx"
 
 namespace JSBSim {
@@ -221,7 +225,90 @@ public:
     double get_agl_ft(double t, const JSBSim::FGColumnVector3& loc,
                       double alt_off, double contact[3], double normal[3],
                       double vel[3], double angularVel[3]);
+
+    /// @name Threaded update (see FDMShell)
+    //@{
+    bool thread_supported() const { return private_props; }
+    void thread_start(double step_dt);
+    void thread_stop();
+    void thread_prepare(double dt);
+    bool thread_step();
+    void thread_publish();
+    //@}
+
 private:
+    /** What the FDM reads from FlightGear at each update: the controls, the
+        environment and the fuel levels. The main loop fills it from the
+        property tree; it is applied to JSBSim in the thread that steps it. */
+    struct EngineInputs {
+      double throttle, mixture, prop_advance, condition;
+      bool feather, augmentation, reverser, cutoff, generator_breaker;
+      bool starter, running;
+      int magnetos, ignition;
+    };
+    struct TankInputs {
+      double density, level;
+    };
+    struct Inputs {
+      double aileron, aileron_trim, elevator, elevator_trim;
+      double rudder, rudder_trim, flaps, speedbrake, spoilers;
+      double left_brake, right_brake, gear_down;
+      std::vector<EngineInputs> engines;
+      double temperature_degc, altitude_ft, pressure_sl_inhg;
+      int turbulence_type;
+      double turbulence_gain, turbulence_rate, ground_wind;
+      double wind_from_north, wind_from_east, wind_from_down;
+      std::vector<TankInputs> tanks;
+      bool fuel_freeze, slaved, ai_wake_enabled;
+      int terrain_override_level;
+      // the mirrored properties, with the serial of the inputs in which
+      // FlightGear last changed them
+      std::vector<double> props;
+      std::vector<unsigned> props_serial;
+      unsigned serial;
+    };
+
+    /** What FlightGear reads from the FDM after each update. Filled in the
+        thread that steps JSBSim, published to FGInterface and to the property
+        tree by the main loop. */
+    struct EngineOutputs {
+      int type, thruster_type;
+      double egt_degf, oil_temperature_degf, oil_pressure_psi, mp_inhg;
+      double cht_degf, rpm, n1, n2, itt_degf, nozzle_pos, inlet_pos, epr;
+      double fuel_flow_gph, fuel_flow_pph, thrust_lb;
+      double prop_rpm, prop_pitch, prop_torque;
+      bool augmentation, water_injection, ignition, reversed, cutoff;
+      bool starting, generator_power, damaged, ielu_intervent;
+      bool running, starter, cranking, prop_feathered;
+    };
+    struct TankOutputs {
+      double density, level, temperature_degc, arm_in;
+    };
+    struct GearOutputs {
+      bool wow, steerable;
+      double rollspeed_ms, position_norm, compression_ft, steering_norm;
+    };
+    struct Outputs {
+      double sim_time;
+      double cg[3], accel_body[3], accel_cg_n[3], accel_pilot[3], nlf;
+      double vel_local[3], uvw[3], vt, veas_kts, vcas_kts, vground;
+      double pqr[3], euler_rates[3], mach;
+      double vrp[3], lon, lat, radius, agl, runway_radius;
+      double euler[3], alpha, beta, gamma, earth_position_angle, hdot;
+      double tl2b[3][3];
+      std::vector<EngineOutputs> engines;
+      bool fuel_freeze;
+      std::vector<TankOutputs> tanks;
+      std::vector<GearOutputs> gear;
+      double stall_warning, elevator_pos, left_aileron_pos, right_aileron_pos;
+      double rudder_pos, flap_pos, speedbrake_pos, spoilers_pos;
+      double tailhook_pos, wing_fold_pos;
+      bool terrain_active, terrain_valid, crashed;
+      // the mirrored properties, after the inputs of that serial
+      std::vector<double> props;
+      unsigned serial;
+    };
+
     JSBSim::FGFDMExec *fdmex;
     JSBSim::FGInitialCondition *fgic;
     bool needTrim;
@@ -303,7 +390,8 @@ private:
     double hook_length;
     bool got_wire;
 
-    bool crashed;
+    // set by the FDM thread, read by the main loop
+    std::atomic<bool> crashed;
 
     AircraftMesh_ptr mesh;
     SGPropertyNode_ptr _ai_wake_enabled;
@@ -311,11 +399,51 @@ private:
     SGPropertyNode_ptr _fbx{nullptr}, _fby{nullptr}, _fbz{nullptr};
     SGPropertyNode_ptr _mbx{nullptr}, _mby{nullptr}, _mbz{nullptr};
 
+    // Property nodes read or written at each update
+    std::vector<SGPropertyNode_ptr> engine_nodes, thruster_nodes;
+    std::vector<SGPropertyNode_ptr> tank_nodes, gear_nodes;
+    SGPropertyNode_ptr fuel_freeze;
+
+    // Copies of the inputs the FDM reads outside of apply_inputs()
+    bool ai_wake_enabled;
+    int terrain_override_level;
+    bool terrain_active, terrain_valid;
+
+    // Threaded update: the main loop owns inputs and outputs, the FDM thread
+    // owns thread_inputs and thread_outputs.
+    Inputs inputs, thread_inputs;
+    Outputs outputs, thread_outputs;
+    FDMSnapshotBuffer<Inputs> input_buffer;
+    FDMSnapshotBuffer<Outputs> output_buffer;
+    double unthreaded_dt;
+
+    // The property tree of JSBSim. When it may run in the FDM thread, JSBSim
+    // gets a tree of its own, so that the thread never touches the one of
+    // FlightGear; its leaves are mirrored to the same paths in FlightGear's
+    // tree through the Inputs and Outputs, see build_mirror().
+    bool private_props;
+    SGPropertyNode_ptr fdm_props;
+    std::vector<SGPropertyNode_ptr> mirror_fdm, mirror_fg;
+    std::vector<double> mirror_last;      // main loop: value last exchanged
+    std::vector<unsigned> mirror_written; // main loop: serial of the last change
+    unsigned input_serial;                // main loop
+    unsigned applied_serial;              // thread stepping the FDM
+
+    void build_mirror();
+    void add_mirror(SGPropertyNode* node);
+
+    void read_inputs(Inputs& in);
+    void apply_inputs(const Inputs& in);
+    void read_outputs(Outputs& out);
+    void publish_outputs(const Outputs& out);
+    bool process_messages(void);
+
     void do_trim(void);
 
     bool update_ground_cache(const JSBSim::FGLocation& cart, double dt);
+    bool update_ground_cache(const double cart[3], double t0, double speed,
+                             double dt);
     void init_gear(void);
-    void update_gear(void);
 
     void update_external_forces(double t_off);
 };
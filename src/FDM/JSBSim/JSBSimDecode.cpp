@@ -0,0 +1,173 @@
+/*%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+
+ Module:       JSBSimDecode.cpp
+ Purpose:      Converts the packets of the BINARY output to CSV
+ Called by:    The USER.
+
+ This program is free software; you can redistribute it and/or modify it under
+ the terms of the GNU Lesser General Public License as published by the Free Software
+ Foundation; either version 2 of the License, or (at your option) any later
+ version.
+
+ This program is distributed in the hope that it will be useful, but WITHOUT
+ ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ details.
+
+ You should have received a copy of the GNU Lesser General Public License along with
+ this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+ Place - Suite 330, Boston, MA  02111-1307, USA.
+
+ Further information about the GNU Lesser General Public License can also be found on
+ the world wide web at http://www.gnu.org.
+
+FUNCTIONAL DESCRIPTION
+--------------------------------------------------------------------------------
+
+Reads the packets sent by an output of type BINARY (see FGBinaryPacket.h) from
+a file, or from the standard input when no file is given, and writes the frames
+as CSV on the standard output. The packets are self delimiting, so a capture
+of a TCP stream or of consecutive UDP datagrams can be decoded alike, e.g.:
+
+  nc -l 5500 | JSBSimDecode > run.csv
+
+Frames that do not match the last schema received are counted and skipped.
+
+%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+INCLUDES
+%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%*/
+
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <string>
+#include <vector>
+
+#include "input_output/FGBinaryPacket.h"
+
+using namespace std;
+using JSBSim::FGBinaryPacket;
+
+/*%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+IMPLEMENTATION
+%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%*/
+
+static bool ReadSchema(const vector<char>& payload, vector<string>& names)
+{
+  names.clear();
+  if (payload.size() < 4) return false;
+
+  uint32_t count = FGBinaryPacket::GetUInt32(&payload[0]);
+  size_t pos = 4;
+  for (uint32_t i=0; i<count; i++) {
+    if (pos + 2 > payload.size()) return false;
+    size_t length = FGBinaryPacket::GetUInt16(&payload[pos]);
+    pos += 2;
+    if (pos + length > payload.size()) return false;
+    names.push_back(string(&payload[pos], length));
+    pos += length;
+  }
+  return true;
+}
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+
+static int Decode(istream& in)
+{
+  vector<char> header(FGBinaryPacket::HeaderSize);
+  vector<char> payload;
+  vector<string> names;
+  uint32_t schema_id = 0;
+  bool have_schema = false;
+  unsigned long frames = 0, skipped = 0;
+
+  cout << setprecision(12);
+
+  while (in.read(&header[0], header.size())) {
+    if (FGBinaryPacket::GetUInt32(&header[0]) != FGBinaryPacket::Magic) {
+      cerr << "Not a JSBSim binary output stream." << endl;
+      return 1;
+    }
+    if (FGBinaryPacket::GetUInt16(&header[4]) != FGBinaryPacket::Version) {
+      cerr << "Unsupported format version "
+           << FGBinaryPacket::GetUInt16(&header[4]) << endl;
+      return 1;
+    }
+
+    uint16_t type = FGBinaryPacket::GetUInt16(&header[6]);
+    uint32_t id = FGBinaryPacket::GetUInt32(&header[8]);
+    payload.resize(FGBinaryPacket::GetUInt32(&header[12]));
+    if (!payload.empty() && !in.read(&payload[0], payload.size())) {
+      cerr << "Truncated packet." << endl;
+      break;
+    }
+
+    switch (type) {
+    case FGBinaryPacket::ptSchema:
+      if (!ReadSchema(payload, names) || FGBinaryPacket::SchemaId(names) != id) {
+        cerr << "Corrupted schema packet." << endl;
+        have_schema = false;
+        break;
+      }
+      schema_id = id;
+      have_schema = true;
+      for (unsigned int i=0; i<names.size(); i++)
+        cout << (i ? "," : "") << names[i];
+      cout << endl;
+      break;
+    case FGBinaryPacket::ptFrames:
+      {
+        if (payload.size() < 4) break;
+        uint32_t count = FGBinaryPacket::GetUInt32(&payload[0]);
+        size_t frame_size = names.size()*sizeof(double);
+        if (!have_schema || id != schema_id
+            || payload.size() != 4 + count*frame_size) {
+          skipped += count;
+          break;
+        }
+        const char* p = &payload[4];
+        for (uint32_t f=0; f<count; f++) {
+          for (unsigned int i=0; i<names.size(); i++, p += sizeof(double))
+            cout << (i ? "," : "") << FGBinaryPacket::GetDouble(p);
+          cout << "\n";
+        }
+        frames += count;
+      }
+      break;
+    case FGBinaryPacket::ptStatus:
+      cerr << "<STATUS> " << string(payload.begin(), payload.end()) << endl;
+      break;
+    default:
+      break;
+    }
+  }
+
+  cout.flush();
+  cerr << frames << " frames decoded";
+  if (skipped > 0) cerr << ", " << skipped << " frames without a matching schema skipped";
+  cerr << "." << endl;
+  return 0;
+}
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+
+int main(int argc, char* argv[])
+{
+  if (argc > 2 || (argc == 2 && string(argv[1]) == "--help")) {
+    cout << "Usage: JSBSimDecode [file]" << endl
+         << "  Writes the frames of a BINARY output capture as CSV. The capture"
+            " is read from the standard input when no file is given." << endl;
+    return argc > 2 ? 1 : 0;
+  }
+
+  if (argc == 2) {
+    ifstream in(argv[1], ios::in | ios::binary);
+    if (!in.is_open()) {
+      cerr << "Could not open file: " << argv[1] << endl;
+      return 1;
+    }
+    return Decode(in);
+  }
+
+  return Decode(cin);
+}
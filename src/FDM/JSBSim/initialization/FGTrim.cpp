@@ -227,7 +227,10 @@ bool FGTrim::DoTrim(void) {
     //<< "  " << TrimAxes[current_axis]->GetControlName()<< endl;
     xlo=TrimAxes[current_axis].GetControlMin();
     xhi=TrimAxes[current_axis].GetControlMax();
-    TrimAxes[current_axis].SetControl((xlo+xhi)/2);
+    if (current_axis < initial_controls.size())
+      TrimAxes[current_axis].SetControl(Constrain(xlo, initial_controls[current_axis], xhi));
+    else
+      TrimAxes[current_axis].SetControl((xlo+xhi)/2);
     TrimAxes[current_axis].Run();
     //TrimAxes[current_axis].AxisReport();
     sub_iterations[current_axis]=0;
@@ -146,6 +146,7 @@ private:
   double xlo,xhi,alo,ahi;
   double targetNlf;
   int debug_axis;
+  std::vector<double> initial_controls;
 
   double psidot;
 
@@ -295,6 +296,29 @@ public:
   inline void SetTargetNlf(double nlf) { targetNlf=nlf; }
   inline double GetTargetNlf(void) { return targetNlf; }
 
+  /** Start the next DoTrim() from the given control values instead of the
+      middle of the control ranges, e.g. from the solution found for a nearby
+      flight condition. The values are given in the order of the trim axes and
+      are clipped to the control limits. An empty vector restores the default.
+  */
+  inline void SetInitialControls(const std::vector<double>& controls) {
+    initial_controls = controls;
+  }
+
+  /// @return the number of state-control pairs being trimmed.
+  inline unsigned int GetNumAxes(void) const { return TrimAxes.size(); }
+
+  /// @return the current value of the control of a trim axis.
+  inline double GetControl(unsigned int axis) { return TrimAxes[axis].GetControl(); }
+
+  /// @return the name of the control of a trim axis.
+  inline std::string GetControlName(unsigned int axis) {
+    return TrimAxes[axis].GetControlName();
+  }
+
+  /// @return the number of top-level iterations of the last DoTrim().
+  inline unsigned int GetIterations(void) const { return total_its; }
+
 };
 }
 
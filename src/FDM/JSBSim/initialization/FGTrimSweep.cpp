@@ -0,0 +1,494 @@
+/*%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+
+ Module:       FGTrimSweep.cpp
+ Purpose:      Trims and linearizes a model over a grid of flight conditions
+ Called by:    JSBSim standalone, user applications
+
+ This program is free software; you can redistribute it and/or modify it under
+ the terms of the GNU Lesser General Public License as published by the Free Software
+ Foundation; either version 2 of the License, or (at your option) any later
+ version.
+
+ This program is distributed in the hope that it will be useful, but WITHOUT
+ ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ details.
+
+ You should have received a copy of the GNU Lesser General Public License along with
+ this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+ Place - Suite 330, Boston, MA  02111-1307, USA.
+
+ Further information about the GNU Lesser General Public License can also be found on
+ the world wide web at http://www.gnu.org.
+
+FUNCTIONAL DESCRIPTION
+--------------------------------------------------------------------------------
+Each point is trimmed from the initial conditions the executive was loaded
+with: the IC is restored and the models are reset before the axis properties
+are set, so that the result of a point does not depend on the points trimmed
+before it on the same executive. Only the starting controls are carried over
+from one point to the next.
+
+%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+INCLUDES
+%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%*/
+
+#include <iostream>
+#include <iomanip>
+#include <thread>
+#include <chrono>
+#include <limits>
+#include <stdint.h>
+
+#include "FGTrimSweep.h"
+#include "FGFDMExec.h"
+#include "initialization/FGInitialCondition.h"
+#include "math/FGStateSpace.h"
+#include "input_output/FGPropertyManager.h"
+#include "simgear/io/iostreams/sgstream.hxx"
+
+using namespace std;
+
+namespace JSBSim {
+
+IDENT(IdSrc,"$Id$");
+IDENT(IdHdr,ID_TRIMSWEEP);
+
+static const uint32_t table_magic = 0x5453424A; // "JBST" on little endian machines
+static const uint32_t table_version = 1;
+
+/*%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+CLASS IMPLEMENTATION
+%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%*/
+
+// FGStateSpace does not own its components: the caller deletes them.
+static void MakeComponents(vector<FGStateSpace::Component*>& states,
+                           vector<FGStateSpace::Component*>& inputs)
+{
+  states.push_back(new FGStateSpace::Vt);
+  states.push_back(new FGStateSpace::Alpha);
+  states.push_back(new FGStateSpace::Theta);
+  states.push_back(new FGStateSpace::Q);
+  states.push_back(new FGStateSpace::Beta);
+  states.push_back(new FGStateSpace::Phi);
+  states.push_back(new FGStateSpace::P);
+  states.push_back(new FGStateSpace::R);
+  states.push_back(new FGStateSpace::Alt);
+
+  inputs.push_back(new FGStateSpace::ThrottleCmd);
+  inputs.push_back(new FGStateSpace::DaCmd);
+  inputs.push_back(new FGStateSpace::DeCmd);
+  inputs.push_back(new FGStateSpace::DrCmd);
+}
+
+static void DeleteComponents(vector<FGStateSpace::Component*>& components)
+{
+  for (unsigned int i=0; i<components.size(); i++) delete components[i];
+  components.clear();
+}
+
+static void Flatten(const vector< vector<double> >& matrix, vector<double>& flat)
+{
+  flat.clear();
+  for (unsigned int i=0; i<matrix.size(); i++)
+    flat.insert(flat.end(), matrix[i].begin(), matrix[i].end());
+}
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+
+FGTrimSweep::FGTrimSweep(TrimMode tm)
+  : mode(tm), warm_start(true), linearize(false)
+{
+  next_line = 0;
+  Debug(0);
+}
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+
+FGTrimSweep::~FGTrimSweep()
+{
+  Debug(1);
+}
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+
+void FGTrimSweep::AddAxis(const string& property, const vector<double>& axis_values)
+{
+  properties.push_back(property);
+  values.push_back(axis_values);
+}
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+
+unsigned int FGTrimSweep::GetNumPoints(void) const
+{
+  if (values.empty()) return 0;
+
+  unsigned int n = 1;
+  for (unsigned int i=0; i<values.size(); i++) n *= values[i].size();
+  return n;
+}
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+
+bool FGTrimSweep::Run(const vector<FGFDMExec*>& executives)
+{
+  unsigned int num_points = GetNumPoints();
+  if (executives.empty() || num_points == 0) return false;
+
+  for (unsigned int i=0; i<properties.size(); i++) {
+    if (!executives[0]->GetPropertyManager()->GetNode(properties[i])) {
+      cerr << "  No property by the name " << properties[i] << endl;
+      return false;
+    }
+  }
+
+  {
+    FGTrim trim(executives[0], mode);
+    control_names.clear();
+    for (unsigned int i=0; i<trim.GetNumAxes(); i++)
+      control_names.push_back(trim.GetControlName(i));
+  }
+
+  state_names.clear();
+  input_names.clear();
+  output_names.clear();
+  if (linearize) {
+    vector<FGStateSpace::Component*> states, inputs;
+    MakeComponents(states, inputs);
+    for (unsigned int i=0; i<states.size(); i++)
+      state_names.push_back(states[i]->getName());
+    for (unsigned int i=0; i<inputs.size(); i++)
+      input_names.push_back(inputs[i]->getName());
+    output_names = state_names;
+    DeleteComponents(states);
+    DeleteComponents(inputs);
+  }
+
+  points.assign(num_points, Point());
+  for (unsigned int p=0; p<num_points; p++) {
+    Point& point = points[p];
+    unsigned int index = p;
+    for (unsigned int a=0; a<values.size(); a++) {
+      point.condition.push_back(values[a][index % values[a].size()]);
+      index /= values[a].size();
+    }
+    point.converged = false;
+    point.warm_started = false;
+    point.iterations = 0;
+    point.wall_time = 0.0;
+  }
+
+  cold_retries.assign(executives.size(), 0);
+  next_line = 0;
+
+  if (executives.size() == 1) {
+    RunLines(executives[0], 0);
+  } else {
+    vector<std::thread> workers;
+    for (unsigned int t=0; t<executives.size(); t++)
+      workers.push_back(std::thread(&FGTrimSweep::RunLines, this, executives[t], t));
+    for (unsigned int t=0; t<workers.size(); t++)
+      workers[t].join();
+  }
+
+  return true;
+}
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// Takes lines of the grid along the first axis until there are none left.
+
+void FGTrimSweep::RunLines(FGFDMExec* exec, unsigned int thread)
+{
+  FGInitialCondition base(exec);
+  base = *exec->GetIC();
+
+  FGStateSpace ss(exec);
+  vector<FGStateSpace::Component*> states, inputs;
+  if (linearize) {
+    MakeComponents(states, inputs);
+    for (unsigned int i=0; i<states.size(); i++) {
+      ss.x.add(states[i]);
+      ss.y.add(states[i]);
+    }
+    for (unsigned int i=0; i<inputs.size(); i++) ss.u.add(inputs[i]);
+  }
+
+  unsigned int line_size = values[0].size();
+  unsigned int num_lines = points.size() / line_size;
+  unsigned int l;
+
+  while ((l = next_line++) < num_lines) {
+    vector<double> start;
+
+    for (unsigned int i=0; i<line_size; i++) {
+      Point& point = points[l*line_size + i];
+      chrono::steady_clock::time_point t0 = chrono::steady_clock::now();
+
+      bool converged = TrimPoint(exec, base, point, start);
+      point.warm_started = converged && !start.empty();
+      if (!converged && !start.empty()) {
+        cold_retries[thread]++;
+        converged = TrimPoint(exec, base, point, vector<double>());
+      }
+
+      if (converged && linearize) {
+        vector< vector<double> > A, B, C, D;
+        ss.linearize(ss.x.get(), ss.u.get(), ss.y.get(), A, B, C, D);
+        Flatten(A, point.A);
+        Flatten(B, point.B);
+        Flatten(C, point.C);
+        Flatten(D, point.D);
+      }
+
+      // The next point starts from the last one that converged.
+      if (converged && warm_start) start = point.controls;
+
+      point.wall_time = chrono::duration<double>(chrono::steady_clock::now() - t0).count();
+    }
+  }
+
+  DeleteComponents(states);
+  DeleteComponents(inputs);
+}
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+
+bool FGTrimSweep::TrimPoint(FGFDMExec* exec, const FGInitialCondition& base,
+                            Point& point, const vector<double>& start)
+{
+  *exec->GetIC() = base;
+  exec->DisableOutput();
+  exec->ResetToInitialConditions(0);
+
+  // The properties that are not initial conditions (tank contents, point
+  // masses, ...) have just been reset by the models so they are set again.
+  for (unsigned int i=0; i<properties.size(); i++)
+    exec->SetPropertyValue(properties[i], point.condition[i]);
+  exec->RunIC();
+
+  FGTrim trim(exec, mode);
+  trim.SetInitialControls(start);
+  point.converged = trim.DoTrim();
+  point.iterations = trim.GetIterations();
+
+  point.controls.resize(trim.GetNumAxes());
+  for (unsigned int i=0; i<point.controls.size(); i++)
+    point.controls[i] = trim.GetControl(i);
+
+  return point.converged;
+}
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+
+FGTrimSweep::Statistics FGTrimSweep::GetStatistics(void) const
+{
+  Statistics stats = { 0, 0, 0, 0, 0.0, 0.0, 0.0 };
+  unsigned int cold = 0;
+
+  stats.points = points.size();
+  for (unsigned int p=0; p<points.size(); p++) {
+    const Point& point = points[p];
+    stats.wall_time += point.wall_time;
+    if (!point.converged) continue;
+
+    stats.converged++;
+    if (point.warm_started) {
+      stats.warm_starts++;
+      stats.mean_iterations_warm += point.iterations;
+    } else {
+      cold++;
+      stats.mean_iterations_cold += point.iterations;
+    }
+  }
+  for (unsigned int t=0; t<cold_retries.size(); t++)
+    stats.cold_retries += cold_retries[t];
+
+  if (stats.warm_starts > 0) stats.mean_iterations_warm /= stats.warm_starts;
+  if (cold > 0) stats.mean_iterations_cold /= cold;
+
+  return stats;
+}
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+
+void FGTrimSweep::PrintStatistics(ostream& out) const
+{
+  Statistics stats = GetStatistics();
+
+  out << "  Points: " << stats.points << " (" << stats.converged << " trimmed, "
+      << stats.points - stats.converged << " failed)" << endl;
+  out << "  Warm starts: " << stats.warm_starts << " converged, "
+      << stats.cold_retries << " retried from scratch" << endl;
+  out << setprecision(3)
+      << "  Mean iterations: " << stats.mean_iterations_warm << " warm, "
+      << stats.mean_iterations_cold << " cold" << endl;
+  if (stats.points > 0)
+    out << "  Time per point: " << 1000.0 * stats.wall_time / stats.points
+        << " ms" << endl;
+}
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+
+static void WriteMatrixNames(ostream& out, const string& matrix,
+                             const vector<string>& rows, const vector<string>& cols)
+{
+  for (unsigned int i=0; i<rows.size(); i++)
+    for (unsigned int j=0; j<cols.size(); j++)
+      out << "," << matrix << "_" << rows[i] << "_" << cols[j];
+}
+
+static void WriteMatrix(ostream& out, const vector<double>& matrix, unsigned int size)
+{
+  for (unsigned int i=0; i<size; i++) {
+    out << ",";
+    if (i < matrix.size()) out << matrix[i];
+  }
+}
+
+bool FGTrimSweep::WriteCSV(const SGPath& filename) const
+{
+  sg_ofstream out(filename, ios::out | ios::trunc);
+  if (!out.is_open()) {
+    cerr << "  Could not open the file " << filename << endl;
+    return false;
+  }
+
+  unsigned int nx = state_names.size();
+  unsigned int nu = input_names.size();
+  unsigned int ny = output_names.size();
+
+  for (unsigned int i=0; i<properties.size(); i++) out << properties[i] << ",";
+  out << "converged,warm_start,iterations,wall_time";
+  for (unsigned int i=0; i<control_names.size(); i++) out << "," << control_names[i];
+  WriteMatrixNames(out, "A", state_names, state_names);
+  WriteMatrixNames(out, "B", state_names, input_names);
+  WriteMatrixNames(out, "C", output_names, state_names);
+  WriteMatrixNames(out, "D", output_names, input_names);
+  out << endl;
+
+  out << setprecision(10);
+  for (unsigned int p=0; p<points.size(); p++) {
+    const Point& point = points[p];
+    for (unsigned int i=0; i<point.condition.size(); i++) out << point.condition[i] << ",";
+    out << point.converged << "," << point.warm_started << ","
+        << point.iterations << "," << point.wall_time;
+    for (unsigned int i=0; i<point.controls.size(); i++) out << "," << point.controls[i];
+    WriteMatrix(out, point.A, nx*nx);
+    WriteMatrix(out, point.B, nx*nu);
+    WriteMatrix(out, point.C, ny*nx);
+    WriteMatrix(out, point.D, ny*nu);
+    out << endl;
+  }
+
+  return !out.fail();
+}
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+
+static void WriteUInt(ostream& out, uint32_t value)
+{
+  out.write(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+static void WriteNames(ostream& out, const vector<string>& names)
+{
+  for (unsigned int i=0; i<names.size(); i++) {
+    WriteUInt(out, names[i].size());
+    out.write(names[i].data(), names[i].size());
+  }
+}
+
+// Writes exactly size values, padding with NaN for the points that have none.
+static void WriteDoubles(ostream& out, const vector<double>& data, unsigned int size)
+{
+  const double nan = numeric_limits<double>::quiet_NaN();
+  for (unsigned int i=0; i<size; i++) {
+    double value = i < data.size() ? data[i] : nan;
+    out.write(reinterpret_cast<const char*>(&value), sizeof(value));
+  }
+}
+
+bool FGTrimSweep::WriteBinary(const SGPath& filename) const
+{
+  sg_ofstream out(filename, ios::out | ios::binary | ios::trunc);
+  if (!out.is_open()) {
+    cerr << "  Could not open the file " << filename << endl;
+    return false;
+  }
+
+  unsigned int nx = state_names.size();
+  unsigned int nu = input_names.size();
+  unsigned int ny = output_names.size();
+  unsigned int nc = control_names.size();
+
+  WriteUInt(out, table_magic);
+  WriteUInt(out, table_version);
+  WriteUInt(out, nx > 0);
+  WriteUInt(out, properties.size());
+  WriteUInt(out, nc);
+  WriteUInt(out, nx);
+  WriteUInt(out, nu);
+  WriteUInt(out, ny);
+  WriteUInt(out, points.size());
+
+  WriteNames(out, properties);
+  WriteNames(out, control_names);
+  WriteNames(out, state_names);
+  WriteNames(out, input_names);
+  WriteNames(out, output_names);
+
+  for (unsigned int p=0; p<points.size(); p++) {
+    const Point& point = points[p];
+    char flags[2] = { point.converged, point.warm_started };
+    out.write(flags, sizeof(flags));
+    WriteUInt(out, point.iterations);
+    out.write(reinterpret_cast<const char*>(&point.wall_time), sizeof(point.wall_time));
+    WriteDoubles(out, point.condition, properties.size());
+    WriteDoubles(out, point.controls, nc);
+    if (nx > 0) {
+      WriteDoubles(out, point.A, nx*nx);
+      WriteDoubles(out, point.B, nx*nu);
+      WriteDoubles(out, point.C, ny*nx);
+      WriteDoubles(out, point.D, ny*nu);
+    }
+  }
+
+  return !out.fail();
+}
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+//    The bitmasked value choices are as follows:
+//    unset: In this case (the default) JSBSim would only print
+//       out the normally expected messages, essentially echoing
+//       the config files as they are read. If the environment
+//       variable is not set, debug_lvl is set to 1 internally
+//    0: This requests JSBSim not to output any messages
+//       whatsoever.
+//    1: This value explicity requests the normal JSBSim
+//       startup messages
+//    2: This value asks for a message to be printed out when
+//       a class is instantiated
+//    4: When this value is set, a message is displayed when a
+//       FGModel object executes its Run() method
+//    8: When this value is set, various runtime state variables
+//       are printed out periodically
+//    16: When set various parameters are sanity checked and
+//       a message is printed out when they go out of bounds
+
+void FGTrimSweep::Debug(int from)
+{
+  if (debug_lvl <= 0) return;
+
+  if (debug_lvl & 2 ) { // Instantiation/Destruction notification
+    if (from == 0) cout << "Instantiated: FGTrimSweep" << endl;
+    if (from == 1) cout << "Destroyed:    FGTrimSweep" << endl;
+  }
+  if (debug_lvl & 64) {
+    if (from == 0) { // Constructor
+      cout << IdSrc << endl;
+      cout << IdHdr << endl;
+    }
+  }
+}
+}
@@ -0,0 +1,175 @@
+/*%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+
+ Header:       FGTrimSweep.h
+ Purpose:      Trims and linearizes a model over a grid of flight conditions
+
+ This program is free software; you can redistribute it and/or modify it under
+ the terms of the GNU Lesser General Public License as published by the Free Software
+ Foundation; either version 2 of the License, or (at your option) any later
+ version.
+
+ This program is distributed in the hope that it will be useful, but WITHOUT
+ ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ details.
+
+ You should have received a copy of the GNU Lesser General Public License along with
+ this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+ Place - Suite 330, Boston, MA  02111-1307, USA.
+
+ Further information about the GNU Lesser General Public License can also be found on
+ the world wide web at http://www.gnu.org.
+
+%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+SENTRY
+%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%*/
+
+#ifndef FGTRIMSWEEP_H
+#define FGTRIMSWEEP_H
+
+/*%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+INCLUDES
+%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%*/
+
+#include <vector>
+#include <string>
+#include <iosfwd>
+#include <atomic>
+
+#include "FGJSBBase.h"
+#include "FGTrim.h"
+#include "simgear/misc/sg_path.hxx"
+
+/*%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+DEFINITIONS
+%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%*/
+
+#define ID_TRIMSWEEP "$Id$"
+
+/*%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+FORWARD DECLARATIONS
+%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%*/
+
+namespace JSBSim {
+
+class FGFDMExec;
+class FGInitialCondition;
+
+/*%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+CLASS DOCUMENTATION
+%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%*/
+
+/** Trims, and optionally linearizes, a model at every point of a grid of
+    flight conditions.
+
+    The grid is the full factorial of the axes given to AddAxis(). An axis is
+    any property that can be set before the trim, typically ic/vc-kts or
+    ic/h-sl-ft, a tank content or a point mass weight for the weight and the
+    CG. The first axis varies fastest.
+
+    The points are trimmed on several threads, one per executive given to
+    Run(). JSBSim cannot copy an executive, so the caller loads the same model
+    and initial conditions in each of them beforehand, one after the other.
+    Each thread takes a whole line of the grid along the first axis and, when
+    warm starts are on, starts the trim of each point from the controls found
+    at the previous point of the line. A warm start that fails to converge is
+    retried from the middle of the control ranges, so that a bad neighbour
+    never costs a point.
+
+    The linearization uses FGStateSpace with the states Vt, alpha, theta, q,
+    beta, phi, p, r and altitude, the inputs throttle, aileron, elevator and
+    rudder commands, and the states as outputs.
+
+    The results can be written as CSV, one line per point, or in a binary
+    table made of:
+    - a header: the magic number 0x5453424A ("JBST"), the format version, a
+      flag telling whether the matrices are present and the numbers of axes,
+      controls, states, inputs, outputs and points, all as 32 bit integers;
+    - the names of the axes, controls, states, inputs and outputs, each as a
+      32 bit length followed by the characters;
+    - one record per point: converged and warm start flags (8 bits each), the
+      number of iterations (32 bits), the wall time in seconds, the axis
+      values, the controls, and then A, B, C and D in row-major order when
+      present (all as doubles, NaN for a point that did not converge).
+    All the numbers are written in the byte order of the machine.
+*/
+
+/*%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+CLASS DECLARATION
+%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%*/
+
+class FGTrimSweep : public FGJSBBase
+{
+public:
+  /// The outcome of the trim of one point of the grid.
+  struct Point {
+    std::vector<double> condition;   ///< value of each axis
+    bool converged;
+    bool warm_started;               ///< converged from a neighbour's controls
+    unsigned int iterations;
+    double wall_time;                ///< seconds spent on the point
+    std::vector<double> controls;    ///< in the order of the trim axes
+    std::vector<double> A, B, C, D;  ///< row-major, empty if not linearized
+  };
+
+  struct Statistics {
+    unsigned int points;
+    unsigned int converged;
+    unsigned int warm_starts;        ///< points that converged from a warm start
+    unsigned int cold_retries;       ///< warm starts that had to be retried
+    double mean_iterations_warm;
+    double mean_iterations_cold;
+    double wall_time;                ///< sum of the time spent on each point
+  };
+
+  /** Constructor
+      @param mode the trim mode used at each point. */
+  FGTrimSweep(TrimMode mode=tFull);
+  ~FGTrimSweep();
+
+  /** Adds an axis to the grid.
+      @param property the property set before each trim
+      @param values the values it takes */
+  void AddAxis(const std::string& property, const std::vector<double>& values);
+
+  void SetWarmStart(bool ws) { warm_start = ws; }
+  void SetLinearize(bool lin) { linearize = lin; }
+
+  /// @return the number of points of the grid.
+  unsigned int GetNumPoints(void) const;
+
+  /** Trims every point of the grid.
+      @param executives the executives to use, one per thread, all loaded
+             with the same model and initial conditions. They must outlive
+             the call; their state is not restored.
+      @return false if the grid is empty or a property does not exist. */
+  bool Run(const std::vector<FGFDMExec*>& executives);
+
+  const std::vector<Point>& GetPoints(void) const { return points; }
+  const std::vector<std::string>& GetControlNames(void) const { return control_names; }
+  Statistics GetStatistics(void) const;
+
+  bool WriteCSV(const SGPath& filename) const;
+  bool WriteBinary(const SGPath& filename) const;
+  void PrintStatistics(std::ostream& out) const;
+
+private:
+  TrimMode mode;
+  bool warm_start;
+  bool linearize;
+  std::vector<std::string> properties;
+  std::vector< std::vector<double> > values;
+  std::vector<std::string> control_names;
+  std::vector<std::string> state_names, input_names, output_names;
+  std::vector<Point> points;
+  std::vector<unsigned int> cold_retries;
+  std::atomic<unsigned int> next_line;
+
+  void RunLines(FGFDMExec* exec, unsigned int thread);
+  bool TrimPoint(FGFDMExec* exec, const FGInitialCondition& base, Point& point,
+                 const std::vector<double>& start);
+  void Debug(int from);
+};
+}
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+#endif
@@ -0,0 +1,149 @@
+/*%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+
+ Header:       FGBinaryPacket.h
+ Purpose:      Layout of the packets of the binary socket output
+
+ This program is free software; you can redistribute it and/or modify it under
+ the terms of the GNU Lesser General Public License as published by the Free Software
+ Foundation; either version 2 of the License, or (at your option) any later
+ version.
+
+ This program is distributed in the hope that it will be useful, but WITHOUT
+ ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ details.
+
+ You should have received a copy of the GNU Lesser General Public License along with
+ this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+ Place - Suite 330, Boston, MA  02111-1307, USA.
+
+ Further information about the GNU Lesser General Public License can also be found on
+ the world wide web at http://www.gnu.org.
+
+%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+SENTRY
+%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%*/
+
+#ifndef FGBINARYPACKET_H
+#define FGBINARYPACKET_H
+
+/*%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+INCLUDES
+%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%*/
+
+#include <string>
+#include <vector>
+#include <cstring>
+#include <stdint.h>
+
+/*%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+DEFINITIONS
+%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%*/
+
+#define ID_BINARYPACKET "$Id$"
+
+namespace JSBSim {
+
+/*%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+CLASS DOCUMENTATION
+%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%*/
+
+/** Layout of the packets sent by FGOutputBinarySocket, shared with the
+    decoder. All the numbers are little endian, whatever the machine.
+
+    Each packet starts with a 16 bytes header:
+    - magic number 0x4242534A ("JSBB"), 32 bits
+    - format version, 16 bits
+    - packet type (see PacketType), 16 bits
+    - schema id, 32 bits: a hash of the names of the values, so that a
+      decoder can tell that the frames it receives match the schema it has
+    - length of the payload that follows the header, 32 bits
+
+    The payload of a schema packet is the number of values per frame (32 bits)
+    followed by their names, each as a 16 bits length and the characters. The
+    first value is always the simulation time.
+
+    The payload of a frames packet is the number of frames (32 bits) followed
+    by the values of each frame, as IEEE 754 doubles.
+
+    The payload of a status packet is a text message.
+
+    Over TCP the packets follow each other in the stream; over UDP each packet
+    is a datagram.
+*/
+
+/*%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+CLASS DECLARATION
+%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%*/
+
+class FGBinaryPacket
+{
+public:
+  enum PacketType { ptSchema = 0, ptFrames = 1, ptStatus = 2 };
+
+  static const uint32_t Magic = 0x4242534A;
+  static const uint16_t Version = 1;
+  static const unsigned int HeaderSize = 16;
+
+  static void PutUInt16(char* p, uint16_t v) {
+    p[0] = (char)(v & 0xff);
+    p[1] = (char)(v >> 8);
+  }
+
+  static void PutUInt32(char* p, uint32_t v) {
+    for (int i=0; i<4; i++) p[i] = (char)((v >> (8*i)) & 0xff);
+  }
+
+  static void PutDouble(char* p, double v) {
+    uint64_t u;
+    memcpy(&u, &v, sizeof(u));
+    for (int i=0; i<8; i++) p[i] = (char)((u >> (8*i)) & 0xff);
+  }
+
+  static uint16_t GetUInt16(const char* p) {
+    const unsigned char* q = reinterpret_cast<const unsigned char*>(p);
+    return (uint16_t)(q[0] | (q[1] << 8));
+  }
+
+  static uint32_t GetUInt32(const char* p) {
+    const unsigned char* q = reinterpret_cast<const unsigned char*>(p);
+    uint32_t v = 0;
+    for (int i=0; i<4; i++) v |= (uint32_t)q[i] << (8*i);
+    return v;
+  }
+
+  static double GetDouble(const char* p) {
+    const unsigned char* q = reinterpret_cast<const unsigned char*>(p);
+    uint64_t u = 0;
+    for (int i=0; i<8; i++) u |= (uint64_t)q[i] << (8*i);
+    double v;
+    memcpy(&v, &u, sizeof(v));
+    return v;
+  }
+
+  static void PutHeader(char* p, PacketType type, uint32_t schema_id,
+                        uint32_t payload_length) {
+    PutUInt32(p, Magic);
+    PutUInt16(p+4, Version);
+    PutUInt16(p+6, type);
+    PutUInt32(p+8, schema_id);
+    PutUInt32(p+12, payload_length);
+  }
+
+  /// FNV-1a hash of the names of the values.
+  static uint32_t SchemaId(const std::vector<std::string>& names) {
+    uint32_t h = 2166136261u;
+    for (unsigned int i=0; i<names.size(); i++) {
+      for (unsigned int j=0; j<names[i].size(); j++) {
+        h ^= (unsigned char)names[i][j];
+        h *= 16777619u;
+      }
+      h ^= 0xff;  // separator, so that "ab","c" and "a","bc" differ
+      h *= 16777619u;
+    }
+    return h;
+  }
+};
+}
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+#endif
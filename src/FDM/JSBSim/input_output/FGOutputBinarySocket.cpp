@@ -0,0 +1,311 @@
+/*%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+
+ Module:       FGOutputBinarySocket.cpp
+ Purpose:      Binary, batched output of sim parameters to a socket
+ Called by:    FGOutput
+
+ This program is free software; you can redistribute it and/or modify it under
+ the terms of the GNU Lesser General Public License as published by the Free Software
+ Foundation; either version 2 of the License, or (at your option) any later
+ version.
+
+ This program is distributed in the hope that it will be useful, but WITHOUT
+ ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ details.
+
+ You should have received a copy of the GNU Lesser General Public License along with
+ this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+ Place - Suite 330, Boston, MA  02111-1307, USA.
+
+ Further information about the GNU Lesser General Public License can also be found on
+ the world wide web at http://www.gnu.org.
+
+FUNCTIONAL DESCRIPTION
+--------------------------------------------------------------------------------
+The names in the schema and the values of the frames are produced by the same
+function, AddValues(), so that they cannot get out of step.
+
+%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+INCLUDES
+%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%*/
+
+#include <iostream>
+
+#include "FGOutputBinarySocket.h"
+#include "FGFDMExec.h"
+#include "models/FGAerodynamics.h"
+#include "models/FGAccelerations.h"
+#include "models/FGAircraft.h"
+#include "models/FGAtmosphere.h"
+#include "models/FGAuxiliary.h"
+#include "models/FGMassBalance.h"
+#include "models/FGPropagate.h"
+#include "models/FGFCS.h"
+#include "models/atmosphere/FGWinds.h"
+#include "input_output/FGXMLElement.h"
+
+using namespace std;
+
+namespace JSBSim {
+
+IDENT(IdSrc,"$Id$");
+IDENT(IdHdr,ID_OUTPUTBINARYSOCKET);
+
+// Largest payload of a UDP datagram over IPv4
+static const size_t max_datagram_size = 65507;
+
+/*%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+CLASS IMPLEMENTATION
+%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%*/
+
+FGOutputBinarySocket::FGOutputBinarySocket(FGFDMExec* fdmex) :
+  FGOutputSocket(fdmex),
+  FramesPerPacket(1),
+  Frames(0),
+  CollectNames(false),
+  SchemaId(0),
+  PacketPos(0)
+{
+}
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+
+FGOutputBinarySocket::~FGOutputBinarySocket()
+{
+  Flush();
+}
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+
+bool FGOutputBinarySocket::Load(Element* el)
+{
+  if (!FGOutputSocket::Load(el))
+    return false;
+
+  if (!el->GetAttributeValue("frames").empty())
+    SetFramesPerPacket((unsigned int)el->GetAttributeValueAsNumber("frames"));
+
+  return true;
+}
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+
+bool FGOutputBinarySocket::InitModel(void)
+{
+  // The frames of the previous output go to the socket they were meant for.
+  Flush();
+
+  return FGOutputSocket::InitModel();
+}
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+
+void FGOutputBinarySocket::PrintHeaders(void)
+{
+  const int text_only = ssAeroFunctions | ssFCS | ssGroundReactions | ssPropulsion;
+  if (SubSystems & text_only) {
+    cerr << "Output " << Name << ": the aero functions, FCS, ground reactions"
+            " and propulsion subsystems are not available in binary form and"
+            " are ignored. Output their properties instead." << endl;
+    SubSystems &= ~text_only;
+  }
+
+  Names.clear();
+  CollectNames = true;
+  AddValues();
+  CollectNames = false;
+  SchemaId = FGBinaryPacket::SchemaId(Names);
+
+  size_t frame_size = Names.size() * sizeof(double);
+  size_t header_size = FGBinaryPacket::HeaderSize + 4;
+  if (SockProtocol == FGfdmSocket::ptUDP &&
+      header_size + FramesPerPacket*frame_size > max_datagram_size) {
+    FramesPerPacket = (max_datagram_size - header_size) / frame_size;
+    if (FramesPerPacket == 0) FramesPerPacket = 1;
+    cerr << "Output " << Name << ": too many frames for a datagram, "
+         << FramesPerPacket << " frames will be sent per packet." << endl;
+  }
+
+  // Sized once for a full packet: Print() never reallocates it.
+  Packet.assign(header_size + FramesPerPacket*frame_size, 0);
+  Frames = 0;
+  PacketPos = header_size;
+
+  // Schema packet
+  size_t length = 4;
+  for (unsigned int i=0; i<Names.size(); i++) length += 2 + Names[i].size();
+
+  vector<char> schema(FGBinaryPacket::HeaderSize + length);
+  FGBinaryPacket::PutHeader(&schema[0], FGBinaryPacket::ptSchema, SchemaId, length);
+  char* p = &schema[FGBinaryPacket::HeaderSize];
+  FGBinaryPacket::PutUInt32(p, Names.size());
+  p += 4;
+  for (unsigned int i=0; i<Names.size(); i++) {
+    FGBinaryPacket::PutUInt16(p, Names[i].size());
+    memcpy(p+2, Names[i].data(), Names[i].size());
+    p += 2 + Names[i].size();
+  }
+
+  socket->Send(&schema[0], schema.size());
+}
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+
+void FGOutputBinarySocket::Add(const char* name, double value)
+{
+  if (CollectNames)
+    Names.push_back(name);
+  else
+    Put(value);
+}
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+
+void FGOutputBinarySocket::Put(double value)
+{
+  FGBinaryPacket::PutDouble(&Packet[PacketPos], value);
+  PacketPos += sizeof(double);
+}
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+
+void FGOutputBinarySocket::AddValues(void)
+{
+  Add("Time", FDMExec->GetSimTime());
+
+  if (SubSystems & ssAerosurfaces) {
+    Add("Aileron Command", FCS->GetDaCmd());
+    Add("Elevator Command", FCS->GetDeCmd());
+    Add("Rudder Command", FCS->GetDrCmd());
+    Add("Flap Command", FCS->GetDfCmd());
+    Add("Left Aileron Position", FCS->GetDaLPos());
+    Add("Right Aileron Position", FCS->GetDaRPos());
+    Add("Elevator Position", FCS->GetDePos());
+    Add("Rudder Position", FCS->GetDrPos());
+    Add("Flap Position", FCS->GetDfPos());
+  }
+  if (SubSystems & ssRates) {
+    Add("P", radtodeg*Propagate->GetPQR(eP));
+    Add("Q", radtodeg*Propagate->GetPQR(eQ));
+    Add("R", radtodeg*Propagate->GetPQR(eR));
+    Add("PDot", radtodeg*Accelerations->GetPQRdot(eP));
+    Add("QDot", radtodeg*Accelerations->GetPQRdot(eQ));
+    Add("RDot", radtodeg*Accelerations->GetPQRdot(eR));
+  }
+  if (SubSystems & ssVelocities) {
+    Add("QBar", Auxiliary->Getqbar());
+    Add("Vtotal", Auxiliary->GetVt());
+    Add("UBody", Propagate->GetUVW(eU));
+    Add("VBody", Propagate->GetUVW(eV));
+    Add("WBody", Propagate->GetUVW(eW));
+    Add("UAero", Auxiliary->GetAeroUVW(eU));
+    Add("VAero", Auxiliary->GetAeroUVW(eV));
+    Add("WAero", Auxiliary->GetAeroUVW(eW));
+    Add("Vn", Propagate->GetVel(eNorth));
+    Add("Ve", Propagate->GetVel(eEast));
+    Add("Vd", Propagate->GetVel(eDown));
+  }
+  if (SubSystems & ssForces) {
+    Add("F_Drag", Aerodynamics->GetvFw()(eDrag));
+    Add("F_Side", Aerodynamics->GetvFw()(eSide));
+    Add("F_Lift", Aerodynamics->GetvFw()(eLift));
+    Add("LoD", Aerodynamics->GetLoD());
+    Add("Fx", Aircraft->GetForces(eX));
+    Add("Fy", Aircraft->GetForces(eY));
+    Add("Fz", Aircraft->GetForces(eZ));
+  }
+  if (SubSystems & ssMoments) {
+    Add("L", Aircraft->GetMoments(eL));
+    Add("M", Aircraft->GetMoments(eM));
+    Add("N", Aircraft->GetMoments(eN));
+  }
+  if (SubSystems & ssAtmosphere) {
+    Add("Rho", Atmosphere->GetDensity());
+    Add("SL pressure", Atmosphere->GetPressureSL());
+    Add("Ambient pressure", Atmosphere->GetPressure());
+    Add("Turbulence Magnitude", Winds->GetTurbMagnitude());
+    Add("Turbulence Direction", Winds->GetTurbDirection());
+    Add("NWind", Winds->GetTotalWindNED(eNorth));
+    Add("EWind", Winds->GetTotalWindNED(eEast));
+    Add("DWind", Winds->GetTotalWindNED(eDown));
+  }
+  if (SubSystems & ssMassProps) {
+    Add("Ixx", MassBalance->GetJ()(1,1));
+    Add("Ixy", MassBalance->GetJ()(1,2));
+    Add("Ixz", MassBalance->GetJ()(1,3));
+    Add("Iyx", MassBalance->GetJ()(2,1));
+    Add("Iyy", MassBalance->GetJ()(2,2));
+    Add("Iyz", MassBalance->GetJ()(2,3));
+    Add("Izx", MassBalance->GetJ()(3,1));
+    Add("Izy", MassBalance->GetJ()(3,2));
+    Add("Izz", MassBalance->GetJ()(3,3));
+    Add("Mass", MassBalance->GetMass());
+    Add("Xcg", MassBalance->GetXYZcg()(eX));
+    Add("Ycg", MassBalance->GetXYZcg()(eY));
+    Add("Zcg", MassBalance->GetXYZcg()(eZ));
+  }
+  if (SubSystems & ssPropagate) {
+    Add("Altitude", Propagate->GetAltitudeASL());
+    Add("Phi (deg)", radtodeg*Propagate->GetEuler(ePhi));
+    Add("Tht (deg)", radtodeg*Propagate->GetEuler(eTht));
+    Add("Psi (deg)", radtodeg*Propagate->GetEuler(ePsi));
+    Add("Alpha (deg)", Auxiliary->Getalpha(inDegrees));
+    Add("Beta (deg)", Auxiliary->Getbeta(inDegrees));
+    Add("Latitude (deg)", Propagate->GetLocation().GetLatitudeDeg());
+    Add("Longitude (deg)", Propagate->GetLocation().GetLongitudeDeg());
+  }
+
+  for (unsigned int i=0;i<OutputProperties.size();i++) {
+    if (!CollectNames)
+      Put(OutputProperties[i]->getDoubleValue());
+    else if (OutputCaptions[i].size() > 0)
+      Names.push_back(OutputCaptions[i]);
+    else
+      Names.push_back(OutputProperties[i]->GetPrintableName());
+  }
+}
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+
+void FGOutputBinarySocket::Print(void)
+{
+  if (socket == 0) return;
+  if (!socket->GetConnectStatus()) return;
+  if (Packet.empty()) return;
+
+  AddValues();
+
+  if (++Frames == FramesPerPacket) Flush();
+}
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+
+void FGOutputBinarySocket::Flush(void)
+{
+  if (Frames == 0) return;
+
+  if (socket && socket->GetConnectStatus()) {
+    size_t length = PacketPos - FGBinaryPacket::HeaderSize;
+    FGBinaryPacket::PutHeader(&Packet[0], FGBinaryPacket::ptFrames, SchemaId, length);
+    FGBinaryPacket::PutUInt32(&Packet[FGBinaryPacket::HeaderSize], Frames);
+    socket->Send(&Packet[0], PacketPos);
+  }
+
+  Frames = 0;
+  PacketPos = FGBinaryPacket::HeaderSize + 4;
+}
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+
+void FGOutputBinarySocket::SocketStatusOutput(const string& out_str)
+{
+  if (socket == 0) return;
+
+  vector<char> status(FGBinaryPacket::HeaderSize + out_str.size());
+  FGBinaryPacket::PutHeader(&status[0], FGBinaryPacket::ptStatus, SchemaId,
+                            out_str.size());
+  memcpy(&status[FGBinaryPacket::HeaderSize], out_str.data(), out_str.size());
+  socket->Send(&status[0], status.size());
+}
+}
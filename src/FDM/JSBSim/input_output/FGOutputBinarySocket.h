@@ -0,0 +1,130 @@
+/*%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+
+ Header:       FGOutputBinarySocket.h
+ Purpose:      Binary, batched output of sim parameters to a socket
+
+ This program is free software; you can redistribute it and/or modify it under
+ the terms of the GNU Lesser General Public License as published by the Free Software
+ Foundation; either version 2 of the License, or (at your option) any later
+ version.
+
+ This program is distributed in the hope that it will be useful, but WITHOUT
+ ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ details.
+
+ You should have received a copy of the GNU Lesser General Public License along with
+ this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+ Place - Suite 330, Boston, MA  02111-1307, USA.
+
+ Further information about the GNU Lesser General Public License can also be found on
+ the world wide web at http://www.gnu.org.
+
+%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+SENTRY
+%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%*/
+
+#ifndef FGOUTPUTBINARYSOCKET_H
+#define FGOUTPUTBINARYSOCKET_H
+
+/*%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+INCLUDES
+%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%*/
+
+#include <vector>
+#include <string>
+
+#include "FGOutputSocket.h"
+#include "FGBinaryPacket.h"
+
+/*%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+DEFINITIONS
+%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%*/
+
+#define ID_OUTPUTBINARYSOCKET "$Id$"
+
+/*%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+FORWARD DECLARATIONS
+%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%*/
+
+namespace JSBSim {
+
+/*%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+CLASS DOCUMENTATION
+%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%*/
+
+/** Outputs the same data as FGOutputSocket in binary form (see
+    FGBinaryPacket). The names of the values are sent once in a schema packet
+    when the output starts; each output cycle then adds a frame of doubles,
+    and the frames are sent in packets of several frames:
+
+    @code
+    <output name="localhost" type="BINARY" protocol="UDP" port="5500"
+            rate="120" frames="12">
+      ...
+    </output>
+    @endcode
+
+    sends 10 datagrams per second of 12 frames each. The frames of an
+    incomplete packet are sent when the output is restarted or deleted.
+
+    The aero functions, FCS components, ground reactions and propulsion
+    subsystems are only available as text and are not supported: list the
+    properties to output instead. The packet buffer is allocated once, so
+    that an output cycle does no memory allocation.
+ */
+
+/*%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+CLASS DECLARATION
+%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%*/
+
+class FGOutputBinarySocket : public FGOutputSocket
+{
+public:
+  /** Constructor. */
+  FGOutputBinarySocket(FGFDMExec* fdmex);
+
+  /** Destructor. */
+  ~FGOutputBinarySocket();
+
+  /** Init the output directives from an XML file.
+      @param element XML Element that is pointing to the output directives
+  */
+  virtual bool Load(Element* el);
+
+  /** Sets the number of frames sent in each packet. */
+  void SetFramesPerPacket(unsigned int n) { FramesPerPacket = n > 0 ? n : 1; }
+
+  /** Sends the pending frames, then opens the socket and sends the schema.
+      @result true if the execution succeeded.
+   */
+  bool InitModel(void);
+
+  /// Adds a frame to the packet, and sends the packet when it is full.
+  void Print(void);
+
+  /** Outputs a status thru the socket in a status packet.
+      @param out_str status message
+   */
+  void SocketStatusOutput(const std::string& out_str);
+
+protected:
+  void PrintHeaders(void);
+
+private:
+  unsigned int FramesPerPacket;
+  unsigned int Frames;
+  bool CollectNames;
+  std::vector<std::string> Names;
+  uint32_t SchemaId;
+  std::vector<char> Packet;
+  size_t PacketPos;
+
+  void AddValues(void);
+  void Add(const char* name, double value);
+  void Put(double value);
+  void Flush(void);
+};
+}
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+#endif
@@ -105,7 +105,7 @@ public:
       by the string "<STATUS>" to the socket.
       @param out_str status message
    */
-  void SocketStatusOutput(const std::string& out_str);
+  virtual void SocketStatusOutput(const std::string& out_str);
 
 protected:
   virtual void PrintHeaders(void);
@@ -0,0 +1,308 @@
+/*%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+
+ Module:       FGXMLCache.cpp
+ Purpose:      Keeps parsed XML documents in memory and on disk
+ Called by:    FGXMLFileRead
+
+ This program is free software; you can redistribute it and/or modify it under
+ the terms of the GNU Lesser General Public License as published by the Free Software
+ Foundation; either version 2 of the License, or (at your option) any later
+ version.
+
+ This program is distributed in the hope that it will be useful, but WITHOUT
+ ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ details.
+
+ You should have received a copy of the GNU Lesser General Public License along with
+ this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+ Place - Suite 330, Boston, MA  02111-1307, USA.
+
+ Further information about the GNU Lesser General Public License can also be found on
+ the world wide web at http://www.gnu.org.
+
+FUNCTIONAL DESCRIPTION
+--------------------------------------------------------------------------------
+A disk cache file starts with a header identifying the XML file it was made
+from (path, modification time and size) followed by the document in the form
+written by Element::WriteBinary(). A file that does not match the XML file any
+more, or that cannot be read completely, is simply rebuilt.
+
+%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+INCLUDES
+%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%*/
+
+#include <iostream>
+#include <sstream>
+#include <iomanip>
+#include <map>
+#include <mutex>
+#include <chrono>
+#include <functional>
+#include <stdint.h>
+
+#include "FGJSBBase.h"
+#include "FGXMLCache.h"
+#include "FGXMLParse.h"
+#include "simgear/io/iostreams/sgstream.hxx"
+
+using namespace std;
+
+namespace JSBSim {
+
+IDENT(IdSrc,"$Id$");
+IDENT(IdHdr,ID_XMLCACHE);
+
+/*%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+GLOBAL DATA
+%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%*/
+
+struct CachedDocument {
+  time_t mod_time;
+  size_t size;
+  Element_ptr document;
+};
+
+static std::mutex cache_mutex;
+static map<string, CachedDocument> cached_documents;
+static bool cache_enabled = true;
+static SGPath cache_dir;
+static FGXMLCache::Statistics cache_statistics = { 0, 0, 0 };
+static thread_local double load_time = 0.0;
+
+static const uint32_t cache_file_magic = 0x5842534A; // "JSBX" on little endian machines
+static const uint32_t cache_file_version = 1;
+
+/*%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+CLASS IMPLEMENTATION
+%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%*/
+
+static Element_ptr ParseFile(const SGPath& filename, bool verbose)
+{
+  sg_ifstream infile(filename);
+  if (!infile.is_open()) {
+    if (verbose) cerr << "Could not open file: " << filename << endl;
+    return 0L;
+  }
+
+  FGXMLParse parser;
+  readXML(infile, parser, filename.utf8Str());
+  return parser.GetDocument();
+}
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+
+static SGPath CacheFileName(const SGPath& dir, const string& key)
+{
+  ostringstream name;
+  name << hex << setw(16) << setfill('0')
+       << static_cast<unsigned long long>(std::hash<string>()(key)) << ".jsbx";
+  return dir / name.str();
+}
+
+static void WriteHeader(ostream& out, const string& key, time_t mod_time, size_t size)
+{
+  uint32_t header[2] = { cache_file_magic, cache_file_version };
+  uint32_t key_size = static_cast<uint32_t>(key.size());
+  int64_t time = mod_time;
+  uint64_t bytes = size;
+
+  out.write(reinterpret_cast<const char*>(header), sizeof(header));
+  out.write(reinterpret_cast<const char*>(&key_size), sizeof(key_size));
+  out.write(key.data(), key.size());
+  out.write(reinterpret_cast<const char*>(&time), sizeof(time));
+  out.write(reinterpret_cast<const char*>(&bytes), sizeof(bytes));
+}
+
+static bool CheckHeader(istream& in, const string& key, time_t mod_time, size_t size)
+{
+  uint32_t header[2];
+  uint32_t key_size;
+  int64_t time;
+  uint64_t bytes;
+
+  in.read(reinterpret_cast<char*>(header), sizeof(header));
+  if (!in || header[0] != cache_file_magic || header[1] != cache_file_version)
+    return false;
+
+  in.read(reinterpret_cast<char*>(&key_size), sizeof(key_size));
+  if (!in || key_size != key.size()) return false;
+
+  string file_key(key_size, '\0');
+  if (key_size > 0) in.read(&file_key[0], key_size);
+  in.read(reinterpret_cast<char*>(&time), sizeof(time));
+  in.read(reinterpret_cast<char*>(&bytes), sizeof(bytes));
+
+  return in && file_key == key && time == mod_time && bytes == size;
+}
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+
+static Element_ptr ReadCacheFile(const SGPath& file, const string& key,
+                                 time_t mod_time, size_t size)
+{
+  if (!file.exists()) return 0L;
+
+  sg_ifstream in(file, ios::in | ios::binary);
+  if (!in.is_open() || !CheckHeader(in, key, mod_time, size)) return 0L;
+
+  return Element::ReadBinary(in);
+}
+
+static void WriteCacheFile(const SGPath& file, const string& key,
+                           time_t mod_time, size_t size, Element* document)
+{
+  // Written under a temporary name, then renamed, so that another thread or
+  // process never reads a partial file.
+  ostringstream suffix;
+  suffix << ".tmp" << hex << reinterpret_cast<uintptr_t>(document);
+  SGPath tmp(file);
+  tmp.concat(suffix.str());
+
+  {
+    sg_ofstream out(tmp, ios::out | ios::binary | ios::trunc);
+    if (!out.is_open()) return;
+
+    WriteHeader(out, key, mod_time, size);
+    document->WriteBinary(out);
+    if (!out) {
+      out.close();
+      tmp.remove();
+      return;
+    }
+  }
+
+  SGPath target(file);
+  if (target.exists()) target.remove();
+  if (!tmp.rename(target)) tmp.remove();
+}
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+
+static Element_ptr LoadDocument(const SGPath& filename, bool verbose)
+{
+  bool enabled;
+  SGPath dir;
+  {
+    std::lock_guard<std::mutex> lock(cache_mutex);
+    enabled = cache_enabled;
+    dir = cache_dir;
+  }
+
+  if (!enabled || !filename.exists()) {
+    Element_ptr document = ParseFile(filename, verbose);
+    if (document) {
+      std::lock_guard<std::mutex> lock(cache_mutex);
+      cache_statistics.parsed++;
+    }
+    return document;
+  }
+
+  string key = filename.utf8Str();
+  time_t mod_time = filename.modTime();
+  size_t size = filename.sizeInBytes();
+
+  Element_ptr cached;
+  {
+    std::lock_guard<std::mutex> lock(cache_mutex);
+    map<string, CachedDocument>::iterator it = cached_documents.find(key);
+    if (it != cached_documents.end() && it->second.mod_time == mod_time
+        && it->second.size == size) {
+      cache_statistics.memory_hits++;
+      cached = it->second.document;
+    }
+  }
+
+  // The cached trees are never modified so they can be copied without the lock.
+  if (cached) return cached->Clone();
+
+  // Not in memory: read from the disk cache or parse the file. The lock is not
+  // held meanwhile so that other threads can be served; two threads missing
+  // the same document both read it and the last one is kept.
+  Element_ptr document;
+  bool from_disk = false;
+  SGPath cache_file;
+
+  if (!dir.isNull()) {
+    cache_file = CacheFileName(dir, key);
+    document = ReadCacheFile(cache_file, key, mod_time, size);
+    from_disk = document.valid();
+  }
+
+  if (!document) {
+    document = ParseFile(filename, verbose);
+    if (!document) return 0L;
+
+    if (!dir.isNull()) {
+      if (!dir.exists()) (dir / "dummy").create_dir(0755);
+      WriteCacheFile(cache_file, key, mod_time, size, document);
+    }
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(cache_mutex);
+    CachedDocument& cached = cached_documents[key];
+    cached.mod_time = mod_time;
+    cached.size = size;
+    cached.document = document;
+
+    if (from_disk) cache_statistics.disk_hits++;
+    else cache_statistics.parsed++;
+  }
+
+  return document->Clone();
+}
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+
+Element_ptr FGXMLCache::Load(const SGPath& filename, bool verbose)
+{
+  chrono::steady_clock::time_point start = chrono::steady_clock::now();
+
+  Element_ptr document = LoadDocument(filename, verbose);
+
+  load_time += chrono::duration<double>(chrono::steady_clock::now() - start).count();
+  return document;
+}
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+
+void FGXMLCache::SetEnabled(bool enabled)
+{
+  std::lock_guard<std::mutex> lock(cache_mutex);
+  cache_enabled = enabled;
+  if (!enabled) cached_documents.clear();
+}
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+
+void FGXMLCache::SetDirectory(const SGPath& dir)
+{
+  std::lock_guard<std::mutex> lock(cache_mutex);
+  cache_dir = dir;
+}
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+
+void FGXMLCache::Clear(void)
+{
+  std::lock_guard<std::mutex> lock(cache_mutex);
+  cached_documents.clear();
+}
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+
+FGXMLCache::Statistics FGXMLCache::GetStatistics(void)
+{
+  std::lock_guard<std::mutex> lock(cache_mutex);
+  return cache_statistics;
+}
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+
+double FGXMLCache::GetLoadTime(void)
+{
+  return load_time;
+}
+
+} // namespace JSBSim
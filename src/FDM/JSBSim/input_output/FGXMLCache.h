@@ -0,0 +1,110 @@
+/*%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+
+ Header:       FGXMLCache.h
+ Purpose:      Keeps parsed XML documents in memory and on disk
+
+ This program is free software; you can redistribute it and/or modify it under
+ the terms of the GNU Lesser General Public License as published by the Free Software
+ Foundation; either version 2 of the License, or (at your option) any later
+ version.
+
+ This program is distributed in the hope that it will be useful, but WITHOUT
+ ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ details.
+
+ You should have received a copy of the GNU Lesser General Public License along with
+ this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+ Place - Suite 330, Boston, MA  02111-1307, USA.
+
+ Further information about the GNU Lesser General Public License can also be found on
+ the world wide web at http://www.gnu.org.
+
+%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+SENTRY
+%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%*/
+
+#ifndef FGXMLCACHE_H
+#define FGXMLCACHE_H
+
+/*%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+INCLUDES
+%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%*/
+
+#include "FGXMLElement.h"
+#include "simgear/misc/sg_path.hxx"
+
+/*%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+DEFINITIONS
+%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%*/
+
+#define ID_XMLCACHE "$Id$"
+
+/*%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+FORWARD DECLARATIONS
+%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%*/
+
+namespace JSBSim {
+
+/*%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+CLASS DOCUMENTATION
+%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%*/
+
+/** Process-wide cache of the XML documents read by FGXMLFileRead.
+
+    Each document is parsed once and kept in memory, keyed by its path, its
+    modification time and its size, so that resets and repeated loads of the
+    same aircraft no longer go through the XML parser. Callers get their own
+    copy of the cached tree since the models modify the elements they read
+    (attributes are merged, included files are attached to their parent and
+    the element counters are moved around).
+
+    When a cache directory is set, the parsed documents are also written there
+    in the binary form of Element::WriteBinary(), which speeds up the first
+    load of a later session.
+
+    The cache can be used from several threads at once.
+*/
+
+/*%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+CLASS DECLARATION
+%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%*/
+
+class FGXMLCache
+{
+public:
+  struct Statistics {
+    unsigned int memory_hits;
+    unsigned int disk_hits;
+    unsigned int parsed;
+  };
+
+  /** Returns a private copy of the document read from a file.
+      @param filename full name of the XML file, extension included.
+      @param verbose whether to complain if the file cannot be opened.
+      @return the root element, or 0 if the file could not be read. */
+  static Element_ptr Load(const SGPath& filename, bool verbose=true);
+
+  /** Turns the cache on or off. It is on by default; when off, every call to
+      Load() parses the file. */
+  static void SetEnabled(bool enabled);
+
+  /** Sets the directory where parsed documents are stored between sessions.
+      An empty path (the default) disables the disk cache. */
+  static void SetDirectory(const SGPath& dir);
+
+  /// Drops all the documents kept in memory.
+  static void Clear(void);
+
+  static Statistics GetStatistics(void);
+
+  /** Returns the time, in seconds, spent by the calling thread in Load(). The
+      value is cumulative: callers measure a phase by taking the difference. */
+  static double GetLoadTime(void);
+};
+
+} // namespace JSBSim
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+
+#endif
@@ -32,6 +32,7 @@ INCLUDES
 #include <cstdlib>
 #include <iostream>
 #include <sstream>
+#include <stdint.h>
 
 #include "FGXMLElement.h"
 #include "string_utilities.h"
@@ -711,4 +712,124 @@ void Element::MergeAttributes(Element* el)
   }
 }
 
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+
+Element_ptr Element::Clone(void) const
+{
+  Element_ptr copy = new Element(name);
+
+  copy->attributes = attributes;
+  copy->data_lines = data_lines;
+  copy->file_name = file_name;
+  copy->line_number = line_number;
+
+  copy->children.reserve(children.size());
+  for (unsigned int i=0; i<children.size(); ++i) {
+    Element_ptr child = children[i]->Clone();
+    child->SetParent(copy);
+    copy->children.push_back(child);
+  }
+
+  return copy;
+}
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// Binary form: strings are written as a 32 bit length followed by the
+// characters, counts and line numbers as 32 bit integers in the byte order of
+// the machine. The file name is only written when it differs from the parent's.
+
+static void WriteUInt(ostream& out, uint32_t v)
+{
+  out.write(reinterpret_cast<const char*>(&v), sizeof(v));
+}
+
+static void WriteString(ostream& out, const string& str)
+{
+  WriteUInt(out, static_cast<uint32_t>(str.size()));
+  out.write(str.data(), str.size());
+}
+
+static bool ReadUInt(istream& in, uint32_t& v)
+{
+  in.read(reinterpret_cast<char*>(&v), sizeof(v));
+  return in.good();
+}
+
+static bool ReadString(istream& in, string& str)
+{
+  uint32_t size;
+  if (!ReadUInt(in, size) || size > (1u << 24)) return false;
+
+  str.resize(size);
+  if (size > 0) in.read(&str[0], size);
+  return in.good();
+}
+
+void Element::WriteBinary(ostream& out) const
+{
+  WriteString(out, name);
+  WriteString(out, (parent && parent->file_name == file_name) ? string() : file_name);
+  WriteUInt(out, static_cast<uint32_t>(line_number));
+
+  WriteUInt(out, static_cast<uint32_t>(attributes.size()));
+  map<string, string>::const_iterator it;
+  for (it=attributes.begin(); it != attributes.end(); ++it) {
+    WriteString(out, it->first);
+    WriteString(out, it->second);
+  }
+
+  WriteUInt(out, static_cast<uint32_t>(data_lines.size()));
+  for (unsigned int i=0; i<data_lines.size(); ++i)
+    WriteString(out, data_lines[i]);
+
+  WriteUInt(out, static_cast<uint32_t>(children.size()));
+  for (unsigned int i=0; i<children.size(); ++i)
+    children[i]->WriteBinary(out);
+}
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+
+static Element_ptr ReadBinaryElement(istream& in, Element* parent, unsigned int depth)
+{
+  string name, file_name;
+  uint32_t line_number, count;
+
+  if (depth > 256 || !ReadString(in, name) || !ReadString(in, file_name)
+      || !ReadUInt(in, line_number))
+    return 0L;
+
+  Element_ptr el = new Element(name);
+  el->SetParent(parent);
+  el->SetFileName(file_name.empty() && parent ? parent->GetFileName() : file_name);
+  el->SetLineNumber(static_cast<int>(line_number));
+
+  if (!ReadUInt(in, count)) return 0L;
+  for (uint32_t i=0; i<count; ++i) {
+    string key, value;
+    if (!ReadString(in, key) || !ReadString(in, value)) return 0L;
+    el->AddAttribute(key, value);
+  }
+
+  if (!ReadUInt(in, count)) return 0L;
+  for (uint32_t i=0; i<count; ++i) {
+    string line;
+    if (!ReadString(in, line)) return 0L;
+    el->AddData(line);
+  }
+
+  if (!ReadUInt(in, count)) return 0L;
+  for (uint32_t i=0; i<count; ++i) {
+    Element_ptr child = ReadBinaryElement(in, el, depth+1);
+    if (!child) return 0L;
+    el->AddChildElement(child);
+  }
+
+  return el;
+}
+
+Element_ptr Element::ReadBinary(istream& in)
+{
+  return ReadBinaryElement(in, 0L, 0);
+}
+
 } // end namespace JSBSim
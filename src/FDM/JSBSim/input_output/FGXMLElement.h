@@ -37,6 +37,7 @@ INCLUDES
 #include <string>
 #include <map>
 #include <vector>
+#include <iosfwd>
 
 #include "simgear/structure/SGSharedPtr.hxx"
 #include "math/FGColumnVector3.h"
@@ -380,6 +381,25 @@ public:
    */
   void MergeAttributes(Element* el);
 
+  /** Makes a deep copy of this element and of its children. The copy has no
+   *  parent and its internal element counter is reset.
+   *  @return the copy.
+   */
+  SGSharedPtr<Element> Clone(void) const;
+
+  /** Writes this element and its children in a compact binary form that can
+   *  be read back with ReadBinary(). The format is only meant for caching on
+   *  the machine that wrote it.
+   *  @param out the stream to write to.
+   */
+  void WriteBinary(std::ostream& out) const;
+
+  /** Reads back an element tree written by WriteBinary().
+   *  @param in the stream to read from.
+   *  @return the root element, or 0 if the data is truncated or corrupt.
+   */
+  static SGSharedPtr<Element> ReadBinary(std::istream& in);
+
 private:
   std::string name;
   std::map <std::string, std::string> attributes;
@@ -39,6 +39,7 @@ INCLUDES
 #include <fstream>
 
 #include "input_output/FGXMLParse.h"
+#include "input_output/FGXMLCache.h"
 #include "simgear/misc/sg_path.hxx"
 #include "simgear/io/iostreams/sgstream.hxx"
 
@@ -59,9 +60,23 @@ public:
   FGXMLFileRead(void) {}
   ~FGXMLFileRead(void) {}
 
+  /** Reads a document through FGXMLCache. The returned element belongs to
+      this instance and stays valid until ResetParser() is called or the
+      instance is destroyed. */
   Element* LoadXMLDocument(const SGPath& XML_filename, bool verbose=true)
   {
-    return LoadXMLDocument(XML_filename, file_parser, verbose);
+    SGPath filename(XML_filename);
+
+    if (filename.isNull()) {
+      std::cerr << "No filename given." << std::endl;
+      return 0L;
+    }
+
+    if (filename.extension().empty())
+      filename.concat(".xml");
+
+    document = FGXMLCache::Load(filename, verbose);
+    return document;
   }
 
   Element* LoadXMLDocument(const SGPath& XML_filename, FGXMLParse& fparse, bool verbose=true)
@@ -90,10 +105,11 @@ public:
     return document;
   }
 
-  void ResetParser(void) {file_parser.reset();}
+  void ResetParser(void) {file_parser.reset(); document = 0L;}
 
 private:
   FGXMLParse file_parser;
+  Element_ptr document;
 };
 }
 #endif
@@ -45,6 +45,7 @@ INCLUDES
 #include "input_output/FGOutputTextFile.h"
 #include "input_output/FGOutputFG.h"
 #include "input_output/FGUDPOutputSocket.h"
+#include "input_output/FGOutputBinarySocket.h"
 #include "input_output/FGXMLFileRead.h"
 #include "input_output/FGXMLElement.h"
 #include "input_output/FGModelLoader.h"
@@ -182,6 +183,15 @@ string FGOutput::GetOutputName(unsigned int idx) const
 
 //%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
 
+bool FGOutput::IsFileOutput(unsigned int idx) const
+{
+  if (idx >= OutputTypes.size()) return false;
+
+  return dynamic_cast<FGOutputFile*>(OutputTypes[idx]) != 0;
+}
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+
 bool FGOutput::SetDirectivesFile(const SGPath& fname)
 {
   FGXMLFileRead XMLFile;
@@ -224,6 +234,9 @@ bool FGOutput::Load(int subSystems, std::string protocol, std::string type,
   } else if (type == "QTJSBSIM") {
     Output = new FGUDPOutputSocket(FDMExec);
     name += ":" + port + "/" + protocol;
+  } else if (type == "BINARY") {
+    Output = new FGOutputBinarySocket(FDMExec);
+    name += ":" + port + "/" + protocol;
   } else if (type == "TERMINAL") {
     // Not done yet
   } else if (type != string("NONE")) {
@@ -278,6 +291,8 @@ bool FGOutput::Load(Element* el)
     Output = new FGOutputFG(FDMExec);
   } else if (type == "QTJSBSIM") {
     Output = new FGUDPOutputSocket(FDMExec);
+  } else if (type == "BINARY") {
+    Output = new FGOutputBinarySocket(FDMExec);
   } else if (type == "TERMINAL") {
     // Not done yet
   } else if (type != string("NONE")) {
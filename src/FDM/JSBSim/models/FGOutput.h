@@ -221,6 +221,12 @@ public:
                  be obtained
       @result the name identifier.*/
   std::string GetOutputName(unsigned int idx) const;
+  /// Returns the number of output instances.
+  unsigned int GetNumOutputs(void) const { return OutputTypes.size(); }
+  /** Tells whether an output instance is directed to a file.
+      @param idx ID of the output instance
+      @result false if the instance does not exist or is not a file output. */
+  bool IsFileOutput(unsigned int idx) const;
 
 private:
   std::vector<FGOutputType*> OutputTypes;
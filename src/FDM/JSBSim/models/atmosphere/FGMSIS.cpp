@@ -59,7 +59,9 @@ INCLUDES
 
 #include "FGMSIS.h"
 #include "models/FGAuxiliary.h"
+#include "input_output/FGPropertyManager.h"
 #include <cmath>          /* maths functions */
+#include <algorithm>
 #include <iostream>        // for cout, endl
 
 using namespace std;
@@ -87,6 +89,25 @@ EXTERNAL GLOBAL DATA
   extern double pdm[8][10];
   extern double pavgm[10];
 
+/*%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+GLOBAL DATA
+%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%*/
+
+  /* Layout of the tables: altitude varies fastest, then local time, then
+     latitude, so that the corners of a cell are in 4 pairs of neighbours. */
+  static const double table_alt_step = 2.0;     // km
+  static const int table_num_alt = 251;         // 0 to 500 km
+  static const double table_lat_step = 10.0;    // deg
+  static const int table_num_lat = 19;          // -90 to 90 deg
+  static const double table_lst_step = 2.0;     // hours
+  static const int table_num_lst = 13;          // 0 to 24 hours
+  static const unsigned int table_size = table_num_alt*table_num_lat*table_num_lst;
+  // cells whose centre is checked against the model once a table is built
+  static const unsigned int table_num_checks = 4*(table_num_alt-1);
+  // model evaluations spent on the next table in each Run()
+  static const unsigned int table_evaluations_per_run = 32;
+  static const double table_refresh_sec = 1800.0;
+
 /*%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
 CLASS IMPLEMENTATION
 %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%*/
@@ -108,6 +129,20 @@ MSIS::MSIS(FGFDMExec* fdmex) : FGAtmosphere(fdmex)
   for (int i=0; i<2; i++) meso_tgn2[i] = 0.0;
   for (int i=0; i<2; i++) meso_tgn3[i] = 0.0;
 
+  tabulated = false;
+  building = false;
+  build_index = 0;
+  table.ready = next_table.ready = false;
+  table.density_error = table.temperature_error = 0.0;
+
+  PropertyManager->Tie("atmosphere/msis/tabulated", this, &MSIS::GetTabulated,
+                       &MSIS::SetTabulated);
+  PropertyManager->Tie("atmosphere/msis/table-ready", this, &MSIS::GetTableReady);
+  PropertyManager->Tie("atmosphere/msis/table-density-error", this,
+                       &MSIS::GetTableDensityError);
+  PropertyManager->Tie("atmosphere/msis/table-temperature-error", this,
+                       &MSIS::GetTableTemperatureError);
+
   Debug(0);
 }
 
@@ -163,6 +198,10 @@ bool MSIS::Run(bool Holding)
 
   double h = FDMExec->GetPropagate()->GetAltitudeASL();
 
+  if (tabulated)
+    UpdateTable(FDMExec->GetAuxiliary()->GetDayOfYear(),
+                FDMExec->GetAuxiliary()->GetSecondsInDay());
+
   //do temp, pressure, and density first
   //if (!useExternal) {
     // get sea-level values
@@ -201,21 +240,182 @@ bool MSIS::Run(bool Holding)
 //%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
 
 void MSIS::Calculate(int day, double sec, double alt, double lat, double lon)
+{
+  double lst = (sec/3600) + (lon/15);
+  if (lst > 24.0) lst -= 24.0;
+  if (lst < 0.0) lst += 24.0;
+
+  alt /= 3281;  //feet to kilometers
+
+  if (tabulated && table.ready && table.doy == day
+      && fabs(sec - table.sec) <= 2.0*table_refresh_sec
+      && table.f107A == input.f107A && table.f107 == input.f107
+      && table.ap == input.ap) {
+    double density, temperature;
+    if (Interpolate(table, alt, lat, lst, density, temperature)) {
+      output.d[5] = density;
+      output.t[1] = temperature;
+      return;
+    }
+  }
+
+  input.g_long = lon;
+  Evaluate(day, sec, alt, lat, lst);
+}
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+
+void MSIS::Compute(int day, double sec, double alt, double lat, double lon,
+                   double& density, double& temperature)
+{
+  Calculate(day, sec, alt, lat, lon);
+  density = output.d[5];
+  temperature = output.t[1];
+}
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// Runs the full model. The longitude is expected in input.g_long.
+
+void MSIS::Evaluate(int day, double sec, double alt, double lat, double lst)
 {
   input.year = 2000;
   input.doy = day;
   input.sec = sec;
-  input.alt = alt / 3281;  //feet to kilometers
+  input.alt = alt;
   input.g_lat = lat;
-  input.g_long = lon;
-
-  input.lst = (sec/3600) + (lon/15);
-  if (input.lst > 24.0) input.lst -= 24.0;
-  if (input.lst < 0.0) input.lst = 24 - input.lst;
+  input.lst = lst;
 
   gtd7d(&input, &flags, &output);
 }
 
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// Trilinear interpolation in a table; alt in km, lat in degrees, lst in hours.
+// Returns false outside of the altitude range of the table.
+
+bool MSIS::Interpolate(const msis_table& t, double alt, double lat, double lst,
+                       double& density, double& temperature) const
+{
+  double x = alt / table_alt_step;
+  if (x < 0.0 || x > table_num_alt - 1) return false;
+
+  double y = (Constrain(-90.0, lat, 90.0) + 90.0) / table_lat_step;
+  lst = fmod(lst, 24.0);
+  if (lst < 0.0) lst += 24.0;
+  double z = lst / table_lst_step;
+
+  int i = std::min((int)x, table_num_alt-2);
+  int j = std::min((int)y, table_num_lat-2);
+  int k = std::min((int)z, table_num_lst-2);
+  double fx = x - i, fy = y - j, fz = z - k;
+
+  const msis_table::entry* e00 = &t.entries[(j*table_num_lst + k)*table_num_alt + i];
+  const msis_table::entry* e01 = e00 + table_num_alt;
+  const msis_table::entry* e10 = e00 + table_num_lst*table_num_alt;
+  const msis_table::entry* e11 = e10 + table_num_alt;
+
+  double d00 = e00[0].log_density + fx*(e00[1].log_density - e00[0].log_density);
+  double d01 = e01[0].log_density + fx*(e01[1].log_density - e01[0].log_density);
+  double d10 = e10[0].log_density + fx*(e10[1].log_density - e10[0].log_density);
+  double d11 = e11[0].log_density + fx*(e11[1].log_density - e11[0].log_density);
+  double d0 = d00 + fz*(d01 - d00);
+  double d1 = d10 + fz*(d11 - d10);
+  density = exp(d0 + fy*(d1 - d0));
+
+  double t00 = e00[0].temperature + fx*(e00[1].temperature - e00[0].temperature);
+  double t01 = e01[0].temperature + fx*(e01[1].temperature - e01[0].temperature);
+  double t10 = e10[0].temperature + fx*(e10[1].temperature - e10[0].temperature);
+  double t11 = e11[0].temperature + fx*(e11[1].temperature - e11[0].temperature);
+  double t0 = t00 + fz*(t01 - t00);
+  double t1 = t10 + fz*(t11 - t10);
+  temperature = t0 + fy*(t1 - t0);
+
+  return true;
+}
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+
+void MSIS::BuildTable(int day, double sec)
+{
+  table.ready = false;
+  building = false;
+  do {
+    UpdateTable(day, sec);
+  } while (building);
+}
+
+//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
+// Starts a new table when the inputs have changed and spends a fixed number of
+// model evaluations on it. The table is filled first, then checked at the
+// centre of some of its cells, and replaces the table in use once complete.
+
+void MSIS::UpdateTable(int day, double sec)
+{
+  bool changed = !table.ready || table.doy != day
+                 || fabs(sec - table.sec) > table_refresh_sec
+                 || table.f107A != input.f107A || table.f107 != input.f107
+                 || table.ap != input.ap;
+
+  if (building && (next_table.doy != day || next_table.f107A != input.f107A
+                   || next_table.f107 != input.f107 || next_table.ap != input.ap))
+    building = false;  // obsolete before completion: start over
+
+  if (!building) {
+    if (!changed) return;
+
+    next_table.entries.resize(table_size);
+    next_table.doy = day;
+    next_table.sec = sec;
+    next_table.f107A = input.f107A;
+    next_table.f107 = input.f107;
+    next_table.ap = input.ap;
+    next_table.density_error = next_table.temperature_error = 0.0;
+    next_table.ready = false;
+    build_index = 0;
+    building = true;
+  }
+
+  for (unsigned int n=0; n<table_evaluations_per_run; n++) {
+    unsigned int index = build_index++;
+    bool check = index >= table_size;
+    double alt, lat, lst;
+
+    if (!check) {
+      alt = (index % table_num_alt) * table_alt_step;
+      lst = ((index / table_num_alt) % table_num_lst) * table_lst_step;
+      lat = -90.0 + (index / (table_num_alt*table_num_lst)) * table_lat_step;
+    } else if (index < table_size + table_num_checks) {
+      // centres of cells spread over latitude and local time
+      index -= table_size;
+      alt = (index / 4 + 0.5) * table_alt_step;
+      lst = ((index * 5) % (table_num_lst-1) + 0.5) * table_lst_step;
+      lat = -90.0 + ((index * 7) % (table_num_lat-1) + 0.5) * table_lat_step;
+    } else {
+      next_table.ready = true;
+      std::swap(table, next_table);
+      building = false;
+      return;
+    }
+
+    input.g_long = lst*15.0 - next_table.sec/240.0;
+    if (input.g_long > 180.0) input.g_long -= 360.0;
+    if (input.g_long < -180.0) input.g_long += 360.0;
+    Evaluate(next_table.doy, next_table.sec, alt, lat, lst);
+
+    if (!check) {
+      msis_table::entry& entry = next_table.entries[index];
+      entry.log_density = log(output.d[5]);
+      entry.temperature = output.t[1];
+    } else {
+      double density, temperature;
+      Interpolate(next_table, alt, lat, lst, density, temperature);
+      next_table.density_error = std::max(next_table.density_error,
+                                          fabs(density/output.d[5] - 1.0));
+      next_table.temperature_error = std::max(next_table.temperature_error,
+                                              fabs(temperature/output.t[1] - 1.0));
+    }
+  }
+}
+
 //%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
 
 
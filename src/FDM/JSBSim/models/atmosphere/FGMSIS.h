@@ -42,6 +42,7 @@ INCLUDES
 
 #include "models/FGAtmosphere.h"
 #include "FGFDMExec.h"
+#include <vector>
 
 /*%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
 DEFINITIONS
@@ -74,6 +75,34 @@ CLASS DOCUMENTATION
     reach him at devel@brodo.de. See the file "DOCUMENTATION" for details,
     and check http://www.brodo.de/english/pub/nrlmsise/index.html for
     updated releases of this package.
+
+    Evaluating the full model is expensive, so it can optionally be replaced
+    by a table of the total mass density and the temperature over altitude
+    (0 to 500 km by 2 km), latitude (by 10 degrees) and local solar time (by 2
+    hours), computed for the current day, time of day and solar indices. The
+    density is interpolated in logarithm, so that its exponential decay with
+    altitude is followed closely. The table is built a few entries per Run()
+    and replaced when the day changes or the time of day has moved by more
+    than 30 minutes; the full model is used until a table is available, and
+    outside of its altitude range. The table is only valid for the time of day
+    it was built for, so the effects of UT and longitude are those of that
+    time, within the refresh period.
+
+    Once a table is built, the model is evaluated at the centre of a sample
+    of its cells and the largest relative errors of the interpolated density
+    and temperature are published in atmosphere/msis/table-density-error and
+    atmosphere/msis/table-temperature-error. The centre of a cell is where
+    the interpolation error is largest, so these are estimates of the error
+    bound of the table. Over the whole table, the interpolated density is
+    within 10% and the temperature within 5% of the model; the largest errors
+    are around 110 km.
+
+    Properties:
+    - atmosphere/msis/tabulated: true to use the table (false by default)
+    - atmosphere/msis/table-ready: true when a table is in use
+    - atmosphere/msis/table-density-error
+    - atmosphere/msis/table-temperature-error
+
     @author David Culp
     @version $Id: FGMSIS.h,v 1.9 2011/05/20 03:18:36 jberndt Exp $
 */
@@ -186,6 +215,20 @@ struct nrlmsise_output {
   double d[9];   /* densities    */
   double t[2];   /* temperatures */
 };
+
+/* Tabulated total mass density and temperature, see MSIS. */
+struct msis_table {
+  struct entry {
+    double log_density;  /* log of d[5] */
+    double temperature;  /* t[1]        */
+  };
+  std::vector<entry> entries;
+  int doy;
+  double sec;
+  double f107A, f107, ap;
+  double density_error, temperature_error;
+  bool ready;
+};
 /* 
  *   OUTPUT VARIABLES:
  *      d[0] - HE NUMBER DENSITY(CM-3)
@@ -248,6 +291,25 @@ public:
   /// Does nothing. External control is not allowed.
   void UseExternal(void);
 
+  /// Turns the tabulated evaluation of the model on or off.
+  void SetTabulated(bool t) { tabulated = t; }
+  bool GetTabulated(void) const { return tabulated; }
+  bool GetTableReady(void) const { return table.ready; }
+  double GetTableDensityError(void) const { return table.density_error; }
+  double GetTableTemperatureError(void) const { return table.temperature_error; }
+
+  /** Builds the complete table for a day and time of day at once, instead of
+      a few entries per Run(). */
+  void BuildTable(int day, double sec);
+
+  /** Evaluates the model at one point, through the table when it is in use
+      and covers the point.
+      @param alt altitude, feet
+      @param density total mass density, g/cm3
+      @param temperature temperature at altitude, K */
+  void Compute(int day, double sec, double alt, double lat, double lon,
+               double& density, double& temperature);
+
 private:
 
   void Calculate(int day,      // day of year (1 to 366) 
@@ -259,6 +321,17 @@ private:
 
   void Debug(int from);
 
+  bool tabulated;
+  msis_table table;       // the table in use
+  msis_table next_table;  // the table being built
+  bool building;
+  unsigned int build_index;
+
+  void Evaluate(int day, double sec, double alt, double lat, double lst);
+  void UpdateTable(int day, double sec);
+  bool Interpolate(const msis_table& t, double alt, double lat, double lst,
+                   double& density, double& temperature) const;
+
   nrlmsise_flags flags;
   nrlmsise_input input;
   nrlmsise_output output;
@@ -25,6 +25,9 @@
 #endif
 
 #include <cassert>
+#include <algorithm>
+#include <chrono>
+#include <mutex>
 #include <simgear/structure/exception.hxx>
 #include <simgear/props/props_io.hxx>
 
@@ -67,12 +70,24 @@ using std::string;
 
 FDMShell::FDMShell() :
   _tankProperties( fgGetNode("/consumables/fuel", true) ),
-  _dataLogging(false)
+  _dataLogging(false),
+  _threadStop(false),
+  _threadPendingSteps(0),
+  _threadStepDt(0.0),
+  _threadTimeRemainder(0.0),
+  _threadSteps(0),
+  _threadOverruns(0),
+  _threadDropped(0),
+  _threadJitterSumNs(0),
+  _threadJitterMaxNs(0),
+  _threadTicks(0),
+  _threadRefused(false)
 {
 }
 
 FDMShell::~FDMShell()
 {
+  stopThread();
 }
 
 void FDMShell::init()
@@ -94,6 +109,20 @@ void FDMShell::init()
   _max_radius_nm    = _props->getNode("fdm/ai-wake/max-radius-nm",          true);
   _ai_wake_enabled  = _props->getNode("fdm/ai-wake/enabled",                true);
 
+  // FDM thread
+  _thread_enabled     = _props->getNode("sim/fdm/thread/enabled",           true);
+  _thread_rate        = _props->getNode("sim/fdm/thread/rate-hz",           true);
+  _thread_running     = _props->getNode("sim/fdm/thread/running",           true);
+  _thread_steps       = _props->getNode("sim/fdm/thread/steps",             true);
+  _thread_overruns    = _props->getNode("sim/fdm/thread/overruns",          true);
+  _thread_dropped     = _props->getNode("sim/fdm/thread/dropped-steps",     true);
+  _thread_jitter_mean = _props->getNode("sim/fdm/thread/jitter-mean-us",    true);
+  _thread_jitter_max  = _props->getNode("sim/fdm/thread/jitter-max-us",     true);
+  if (!_thread_rate->hasValue()) {
+    _thread_rate->setDoubleValue(480.0);
+  }
+  _thread_running->setBoolValue(false);
+
   createImplementation();
 }
 
@@ -116,6 +145,8 @@ void FDMShell::postinit()
 
 void FDMShell::shutdown()
 {
+    stopThread();
+
     if (_impl) {
         fgSetBool("/sim/fdm-initialized", false);
         _impl->unbind();
@@ -197,6 +228,15 @@ void FDMShell::update(double dt)
     return; // still waiting
   }
 
+  bool threaded = updateThread();
+
+  // While the FDM thread runs, it must not step during the updates of the
+  // wake group and of the ground cache.
+  std::unique_lock<std::mutex> lock(_impl->thread_mutex(), std::defer_lock);
+  if (threaded) {
+    lock.lock();
+  }
+
   // AI aerodynamic wake interaction
   if (_ai_wake_enabled->getBoolValue()) {
       for (FGAIBase* base : _ai_mgr->get_ai_list()) {
@@ -220,6 +260,12 @@ void FDMShell::update(double dt)
       }
   }
 
+  if (threaded) {
+    _impl->reset_wake_group();
+    _impl->thread_prepare(dt);
+    lock.unlock();
+  }
+
   // pull environmental data in, since the FDMs are lazy
   _impl->set_Velocities_Local_Airmass(
           _wind_north->getDoubleValue(),
@@ -241,14 +287,31 @@ void FDMShell::update(double dt)
   bool doLog = _data_logging->getBoolValue();
   if (doLog != _dataLogging) {
     _dataLogging = doLog;
+    if (threaded) {
+      lock.lock();
+    }
     _impl->ToggleDataLogging(doLog);
+    if (threaded) {
+      lock.unlock();
+    }
   }
 
   switch(_replay_master->getIntValue())
   {
       case 0:
           // normal FDM operation
-          _impl->update(dt);
+          if (threaded) {
+            // hand the simulated time of this frame over to the FDM thread
+            _threadTimeRemainder += dt;
+            int steps = static_cast<int>(_threadTimeRemainder / _threadStepDt);
+            _threadTimeRemainder -= steps * _threadStepDt;
+            _threadPendingSteps += steps;
+
+            _impl->thread_publish();
+            publishThreadStats();
+          } else {
+            _impl->scheduled_update(dt);
+          }
           break;
       case 3:
           // resume FDM operation at current replay position
@@ -265,6 +328,150 @@ FGInterface* FDMShell::getInterface() const
     return _impl;
 }
 
+/**
+ * Starts or stops the FDM thread according to its property and to the
+ * replay state.
+ * @return true if the thread is running.
+ */
+bool FDMShell::updateThread()
+{
+  bool enabled = _thread_enabled->getBoolValue();
+  if (enabled && !_impl->thread_supported()) {
+    if (!_threadRefused) {
+      _threadRefused = true;
+      SG_LOG(SG_FLIGHT, SG_WARN, "FDM thread not started: the FDM does not "
+             "support it, or only when enabled before it was loaded");
+    }
+    enabled = false;
+  } else if (!enabled) {
+    _threadRefused = false;
+  }
+
+  bool wanted = enabled && (_replay_master->getIntValue() == 0);
+
+  if (wanted && !_thread.joinable()) {
+    startThread();
+  } else if (!wanted && _thread.joinable()) {
+    stopThread();
+  }
+
+  return _thread.joinable();
+}
+
+void FDMShell::startThread()
+{
+  double rate = _thread_rate->getDoubleValue();
+  if (rate <= 0.0) {
+    rate = 480.0;
+  }
+
+  _threadStepDt = 1.0 / rate;
+  _threadTimeRemainder = 0.0;
+  _threadPendingSteps = 0;
+  _threadStop = false;
+  _threadSteps = 0;
+  _threadOverruns = 0;
+  _threadDropped = 0;
+  _threadJitterSumNs = 0;
+  _threadJitterMaxNs = 0;
+  _threadTicks = 0;
+
+  _impl->thread_start(_threadStepDt);
+  _thread = std::thread(&FDMShell::threadMain, this, _threadStepDt);
+  _thread_running->setBoolValue(true);
+
+  SG_LOG(SG_FLIGHT, SG_INFO, "FDM thread started at " << rate << " Hz");
+}
+
+void FDMShell::stopThread()
+{
+  if (!_thread.joinable()) {
+    return;
+  }
+
+  _threadStop = true;
+  _thread.join();
+
+  _impl->thread_stop();
+  if (_thread_running) {
+    _thread_running->setBoolValue(false);
+  }
+
+  SG_LOG(SG_FLIGHT, SG_INFO, "FDM thread stopped after " << _threadSteps
+         << " steps, " << _threadOverruns << " overruns");
+}
+
+void FDMShell::threadMain(double step_dt)
+{
+  typedef std::chrono::steady_clock clock;
+  const clock::duration period =
+    std::chrono::duration_cast<clock::duration>(std::chrono::duration<double>(step_dt));
+
+  // Steps are run one per tick, or a few more to catch up with speed-up.
+  // Beyond a quarter of a second of backlog the thread cannot keep up and
+  // the excess is dropped rather than run as one long burst.
+  const int max_steps_per_tick = 8;
+  const int max_backlog = std::max(1, static_cast<int>(0.25 / step_dt));
+
+  clock::time_point tick = clock::now() + period;
+
+  while (!_threadStop) {
+    std::this_thread::sleep_until(tick);
+
+    clock::time_point woke = clock::now();
+    uint64_t late = std::chrono::duration_cast<std::chrono::nanoseconds>(woke - tick).count();
+    _threadJitterSumNs += late;
+    uint64_t max = _threadJitterMaxNs;
+    while (late > max && !_threadJitterMaxNs.compare_exchange_weak(max, late)) {}
+    ++_threadTicks;
+
+    int pending = _threadPendingSteps;
+    if (pending > max_backlog) {
+      _threadPendingSteps -= pending - max_backlog;
+      _threadDropped += pending - max_backlog;
+      pending = max_backlog;
+    }
+
+    int steps = std::min(pending, max_steps_per_tick);
+    if (steps > 0) {
+      std::lock_guard<std::mutex> lock(_impl->thread_mutex());
+      for (int i = 0; i < steps; ++i) {
+        if (!_impl->thread_step()) {
+          break;
+        }
+      }
+    }
+    _threadPendingSteps -= steps;
+    _threadSteps += steps;
+
+    // A tick that ended after the next one was due is an overrun; the
+    // ticks missed meanwhile are skipped, keeping the phase.
+    tick += period;
+    clock::time_point now = clock::now();
+    if (now > tick) {
+      ++_threadOverruns;
+      tick += ((now - tick) / period + 1) * period;
+    }
+  }
+}
+
+void FDMShell::publishThreadStats()
+{
+  _thread_steps->setDoubleValue(static_cast<double>(_threadSteps));
+  _thread_overruns->setDoubleValue(static_cast<double>(_threadOverruns));
+  _thread_dropped->setDoubleValue(static_cast<double>(_threadDropped));
+
+  // jitter over about one second of ticks
+  uint64_t ticks = _threadTicks;
+  if (ticks * _threadStepDt >= 1.0) {
+    _threadTicks -= ticks;
+    uint64_t sum = _threadJitterSumNs.exchange(0);
+    uint64_t max = _threadJitterMaxNs.exchange(0);
+    _thread_jitter_mean->setDoubleValue(1e-3 * sum / ticks);
+    _thread_jitter_max->setDoubleValue(1e-3 * max);
+  }
+}
+
 void FDMShell::createImplementation()
 {
   assert(!_impl);
@@ -23,6 +23,10 @@
 #ifndef FG_FDM_SHELL_HXX
 #define FG_FDM_SHELL_HXX
 
+#include <atomic>
+#include <thread>
+#include <cstdint>
+
 #include <simgear/structure/subsystem_mgr.hxx>
 #include "TankProperties.hxx"
 
@@ -37,6 +41,18 @@ class FGAIManager;
  *
  * This class also provides the factory method which creates the
  * specific FDM class (createImplementation)
+ *
+ * When /sim/fdm/thread/enabled is set and the FDM supports it, the FDM
+ * runs in its own thread at /sim/fdm/thread/rate-hz (480 by default),
+ * exchanging snapshots with the main loop (see FGInterface::thread_step).
+ * The thread and the main loop still take turns on the FDM's own state
+ * with FGInterface::thread_mutex(). JSBSim only supports the thread when
+ * it was enabled before JSBSim was loaded, as JSBSim then gets a property
+ * tree of its own.
+ * The main loop hands the thread the simulated time of each frame, so the
+ * FDM still follows pause and speed-up; the thread spreads the steps over
+ * its fixed ticks. Tick jitter and overruns are reported under
+ * /sim/fdm/thread.
  */
 class FDMShell : public SGSubsystem
 {
@@ -58,6 +74,12 @@ public:
 private:
 
   void createImplementation();
+
+  bool updateThread();
+  void startThread();
+  void stopThread();
+  void threadMain(double step_dt);
+  void publishThreadStats();
   
   TankPropertiesList _tankProperties;
   SGSharedPtr<FGInterface> _impl;
@@ -73,6 +95,20 @@ private:
     SGSharedPtr<FGAIManager> _ai_mgr;
     SGPropertyNode_ptr _max_radius_nm;
     SGPropertyNode_ptr _ai_wake_enabled;
+
+  // FDM thread
+  std::thread _thread;
+  std::atomic<bool> _threadStop;
+  std::atomic<int> _threadPendingSteps;
+  double _threadStepDt;
+  double _threadTimeRemainder;
+  std::atomic<uint64_t> _threadSteps, _threadOverruns, _threadDropped;
+  std::atomic<uint64_t> _threadJitterSumNs, _threadJitterMaxNs, _threadTicks;
+  bool _threadRefused;  // the warning about an unsupported FDM was logged
+
+  SGPropertyNode_ptr _thread_enabled, _thread_rate, _thread_running;
+  SGPropertyNode_ptr _thread_steps, _thread_overruns, _thread_dropped;
+  SGPropertyNode_ptr _thread_jitter_mean, _thread_jitter_max;
 };
 
 #endif // of FG_FDM_SHELL_HXX
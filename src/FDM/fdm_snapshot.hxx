@@ -0,0 +1,84 @@
+// fdm_snapshot.hxx -- hand typed FDM state over between two threads
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation; either version 2 of the
+// License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+#ifndef FG_FDM_SNAPSHOT_HXX
+#define FG_FDM_SNAPSHOT_HXX
+
+#include <atomic>
+
+/**
+ * Lock-free exchange of a snapshot struct between one writer thread and
+ * one reader thread.
+ *
+ * The writer fills the back buffer and publishes it; the reader picks up
+ * the latest published snapshot, if any, into its front buffer. A third
+ * buffer sits between the two so that neither side ever waits for the
+ * other: a snapshot the reader did not pick up in time is simply replaced
+ * by the next one.
+ *
+ * T is copied with its assignment operator. Containers in T keep their
+ * capacity across copies, so once every buffer has been sized by init()
+ * no memory is allocated.
+ */
+template <class T>
+class FDMSnapshotBuffer
+{
+public:
+    FDMSnapshotBuffer() : _back(0), _middle(1), _front(2) {}
+
+    /** Sets the three buffers to the same value. Not thread safe: call it
+     * before the threads start. */
+    void init(const T& value)
+    {
+        for (int i = 0; i < 3; ++i) {
+            _buffers[i] = value;
+        }
+        _back = 0;
+        _middle.store(1);
+        _front = 2;
+    }
+
+    /// Writer side: publish a snapshot.
+    void write(const T& value)
+    {
+        _buffers[_back] = value;
+        _back = _middle.exchange(_back | FRESH) & INDEX;
+    }
+
+    /**
+     * Reader side: copy the latest snapshot published since the last call.
+     * @return false, leaving value untouched, if nothing new was published.
+     */
+    bool read(T& value)
+    {
+        if (!(_middle.load() & FRESH)) {
+            return false;
+        }
+        _front = _middle.exchange(_front) & INDEX;
+        value = _buffers[_front];
+        return true;
+    }
+
+private:
+    enum { INDEX = 3, FRESH = 4 };
+
+    T _buffers[3];
+    int _back;                 // owned by the writer
+    std::atomic<int> _middle;  // index, plus FRESH when not read yet
+    int _front;                // owned by the reader
+};
+
+#endif // of FG_FDM_SNAPSHOT_HXX
@@ -71,7 +71,8 @@ FGInterface::_calc_multiloop (double dt)
     // this method is now obsolete - multiloop is handled by
     // SGSubsystemGroup; the FDM group operates with a fixed time interval
     // (defined by /sim/model-hz), so at this level we always want to run
-    // exactly one FDM iteration
+    // exactly one FDM iteration. The pacing of these iterations within a
+    // frame is up to scheduled_update().
     return 1;
 }
 
@@ -120,6 +121,15 @@ FGInterface::_setup ()
     _state.climb_rate=0;
     _state.altitude_agl=0;
     _state.track=0;
+
+    _frame_sim_time = 0;
+    _frame_horizon = 0;
+    _frame_cost = 0;
+    _frame_missed = false;
+    _backlog = 0;
+    _scheduling = false;
+    _stepped = false;
+    _blended = false;
 }
 
 void
@@ -443,6 +453,178 @@ FGInterface::update (double dt)
     SG_LOG(SG_FLIGHT, SG_ALERT, "dummy update() ... SHOULDN'T BE CALLED!");
 }
 
+/**
+ * Run one sub-step of the FDM group under the per-frame CPU budget.
+ */
+void
+FGInterface::scheduled_update(double dt)
+{
+    if (!_sched_budget_ms) {
+        SGPropertyNode* node = fgGetNode("/sim/fdm/scheduler", true);
+        _sched_budget_ms = node->getNode("budget-ms", true);
+        _sched_max_backlog = node->getNode("max-backlog-sec", true);
+        if (!_sched_max_backlog->hasValue())
+            _sched_max_backlog->setDoubleValue(0.25);
+        _sched_substeps = node->getNode("substeps", true);
+        _sched_deferred = node->getNode("deferred-substeps", true);
+        _sched_dropped = node->getNode("dropped-substeps", true);
+        _sched_missed_frames = node->getNode("missed-frames", true);
+        _sched_backlog = node->getNode("backlog-sec", true);
+        _sched_frame_cost_ms = node->getNode("frame-cost-ms", true);
+        _sched_cache_builds = node->getNode("ground-cache-builds", true);
+        _sched_cache_reuses = node->getNode("ground-cache-reuses", true);
+        _sched_remainder = fgGetNode("/sim/time/remainder-sec", true);
+    }
+
+    if (dt <= 0.0) {
+        update(dt);
+        return;
+    }
+
+    // The sim time moves once per frame, before the FDM group runs.
+    double sim_time = globals->get_sim_time_sec();
+    if (sim_time != _frame_sim_time)
+        _begin_frame(sim_time, dt);
+
+    double budget = _sched_budget_ms->getDoubleValue() * 1e-3;
+    if (budget <= 0.0 || _frame_cost < budget) {
+        _run_substep(dt);
+        _blend_pose(dt);
+        return;
+    }
+
+    // Out of time: keep the step for a later frame.
+    if (!_frame_missed) {
+        _frame_missed = true;
+        _sched_missed_frames->setIntValue(_sched_missed_frames->getIntValue() + 1);
+    }
+    _sched_deferred->setIntValue(_sched_deferred->getIntValue() + 1);
+    _frame_horizon -= dt;
+    _backlog += dt;
+
+    double max_backlog = _sched_max_backlog->getDoubleValue();
+    if (_backlog > max_backlog) {
+        int dropped = static_cast<int>(ceil((_backlog - max_backlog) / dt - 1e-9));
+        _backlog = SGMiscd::max(0.0, _backlog - dropped * dt);
+        _sched_dropped->setIntValue(_sched_dropped->getIntValue() + dropped);
+    }
+    _sched_backlog->setDoubleValue(_backlog);
+    _blend_pose(dt);
+}
+
+void
+FGInterface::_begin_frame(double sim_time, double dt)
+{
+    _sched_frame_cost_ms->setDoubleValue(_frame_cost * 1e3);
+    _sched_cache_builds->setIntValue(ground_cache.get_build_count());
+    _sched_cache_reuses->setIntValue(ground_cache.get_reuse_count());
+
+    // The group steps the whole frame, see TimeManager::computeTimeDeltas().
+    _frame_sim_time = sim_time;
+    _frame_horizon = fgGetDouble("/sim/time/delta-sec") + _backlog;
+    _frame_cost = 0;
+    _frame_missed = false;
+
+    // Catch up with the steps deferred by the previous frames first, so
+    // that they run in their original order.
+    double budget = _sched_budget_ms->getDoubleValue() * 1e-3;
+    while (_backlog >= 0.5 * dt && (budget <= 0.0 || _frame_cost < budget)) {
+        _backlog -= dt;
+        _run_substep(dt);
+    }
+    _backlog = SGMiscd::max(0.0, _backlog);
+    _sched_backlog->setDoubleValue(_backlog);
+}
+
+void
+FGInterface::_run_substep(double dt)
+{
+    _restore_pose();
+    _step_position[0] = _state.geodetic_position_v;
+    _step_attitude[0] = _state.euler_angles_v;
+
+    SGTimeStamp start = SGTimeStamp::now();
+    _scheduling = true;
+    update(dt);
+    _scheduling = false;
+    _frame_cost += (SGTimeStamp::now() - start).toSecs();
+
+    _step_position[1] = _state.geodetic_position_v;
+    _step_attitude[1] = _state.euler_angles_v;
+    _stepped = true;
+    _frame_horizon -= dt;
+    _sched_substeps->setIntValue(_sched_substeps->getIntValue() + 1);
+}
+
+/**
+ * Publish the pose at the time of the last sub-step less dt, plus the
+ * remainder of the frame the FDM group did not step, see
+ * TimeManager::computeTimeDeltas(). That time moves with the frames, while
+ * the sub-steps only move in increments of dt.
+ */
+void
+FGInterface::_blend_pose(double dt)
+{
+    if (!_stepped)
+        return;
+    _restore_pose();
+
+    double alpha = SGMiscd::clip(_sched_remainder->getDoubleValue() / dt, 0, 1);
+    if (alpha == 1)
+        return;
+
+    const SGGeod& p0 = _step_position[0];
+    const SGGeod& p1 = _step_position[1];
+    double dlon = SGMiscd::normalizePeriodic(-SGD_PI, SGD_PI,
+                                             p1.getLongitudeRad() - p0.getLongitudeRad());
+    SGGeod position = SGGeod::fromRadM(
+        SGMiscd::normalizePeriodic(-SGD_PI, SGD_PI, p0.getLongitudeRad() + alpha*dlon),
+        p0.getLatitudeRad() + alpha*(p1.getLatitudeRad() - p0.getLatitudeRad()),
+        p0.getElevationM() + alpha*(p1.getElevationM() - p0.getElevationM()));
+
+    // phi and psi wrap around, theta stays within +-90 degrees
+    const SGVec3d& a0 = _step_attitude[0];
+    const SGVec3d& a1 = _step_attitude[1];
+    SGVec3d attitude;
+    attitude[0] = SGMiscd::normalizePeriodic(-SGD_PI, SGD_PI, a0[0] +
+        alpha*SGMiscd::normalizePeriodic(-SGD_PI, SGD_PI, a1[0] - a0[0]));
+    attitude[1] = a0[1] + alpha*(a1[1] - a0[1]);
+    attitude[2] = SGMiscd::normalizePeriodic(0, SGD_2PI, a0[2] +
+        alpha*SGMiscd::normalizePeriodic(-SGD_PI, SGD_PI, a1[2] - a0[2]));
+
+    _state.geodetic_position_v = position;
+    _state.cartesian_position_v = SGVec3d::fromGeod(position);
+    _state.geocentric_position_v = SGGeoc::fromCart(_state.cartesian_position_v);
+    _state.euler_angles_v = attitude;
+    _blend_position = position;
+    _blend_attitude = attitude;
+    _blended = true;
+}
+
+/**
+ * Put the pose of the last sub-step back before the FDM steps again,
+ * unless the aircraft was moved in between.
+ */
+void
+FGInterface::_restore_pose()
+{
+    if (!_blended)
+        return;
+    _blended = false;
+
+    const SGGeod& p = _state.geodetic_position_v;
+    if (p.getLongitudeRad() != _blend_position.getLongitudeRad() ||
+        p.getLatitudeRad() != _blend_position.getLatitudeRad() ||
+        p.getElevationM() != _blend_position.getElevationM() ||
+        _state.euler_angles_v != _blend_attitude)
+        return;
+
+    _state.geodetic_position_v = _step_position[1];
+    _state.cartesian_position_v = SGVec3d::fromGeod(_step_position[1]);
+    _state.geocentric_position_v = SGGeoc::fromCart(_state.cartesian_position_v);
+    _state.euler_angles_v = _step_attitude[1];
+}
+
 bool FGInterface::readState(SGIOChannel* io)
 {
     FlightState buf;
@@ -650,6 +832,15 @@ bool
 FGInterface::prepare_ground_cache_m(double startSimTime, double endSimTime,
                                     const double pt[3], double rad)
 {
+  // Stretch the request of a sub-step to the end of its frame, moving at
+  // the current speed, so that it also covers the following sub-steps.
+  // Only scheduled_update() keeps track of the frame; the FDM thread and
+  // the other callers get the cache they ask for.
+  double extra = _frame_horizon - (endSimTime - startSimTime);
+  if (_scheduling && 0 < extra) {
+    endSimTime += extra;
+    rad += 2*extra*norm(_state.v_local_v)*SG_FEET_TO_METER;
+  }
   return ground_cache.prepare_ground_cache(startSimTime, endSimTime,
                                            SGVec3d(pt), rad);
 }
@@ -659,9 +850,9 @@ FGInterface::prepare_ground_cache_ft(double startSimTime, double endSimTime,
                                      const double pt[3], double rad)
 {
   // Convert units and do the real work.
-  SGVec3d pt_ft = SG_FEET_TO_METER*SGVec3d(pt);
-  return ground_cache.prepare_ground_cache(startSimTime, endSimTime,
-                                           pt_ft, rad*SG_FEET_TO_METER);
+  SGVec3d pt_m = SG_FEET_TO_METER*SGVec3d(pt);
+  return prepare_ground_cache_m(startSimTime, endSimTime,
+                                pt_m.data(), rad*SG_FEET_TO_METER);
 }
 
 bool
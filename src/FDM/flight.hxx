@@ -74,6 +74,7 @@
 
 
 #include <cmath>
+#include <mutex>
 
 #include <simgear/compiler.h>
 #include <simgear/constants.h>
@@ -212,6 +213,40 @@ class FGInterface : public SGSubsystem {
 
     AIWakeGroup wake_group;
 
+    std::mutex _thread_mutex;
+
+    // Sub-step scheduler, see scheduled_update().
+    double _frame_sim_time;       // sim time of the frame being stepped
+    double _frame_horizon;        // FDM time left to step in this frame
+    double _frame_cost;           // wall time spent stepping this frame
+    bool _frame_missed;           // a sub-step of this frame was deferred
+    double _backlog;              // deferred FDM time, run in later frames
+    SGPropertyNode_ptr _sched_budget_ms;
+    SGPropertyNode_ptr _sched_max_backlog;
+    SGPropertyNode_ptr _sched_substeps;
+    SGPropertyNode_ptr _sched_deferred;
+    SGPropertyNode_ptr _sched_dropped;
+    SGPropertyNode_ptr _sched_missed_frames;
+    SGPropertyNode_ptr _sched_backlog;
+    SGPropertyNode_ptr _sched_frame_cost_ms;
+    SGPropertyNode_ptr _sched_cache_builds;
+    SGPropertyNode_ptr _sched_cache_reuses;
+    SGPropertyNode_ptr _sched_remainder;
+    bool _scheduling;             // a sub-step is running in scheduled_update()
+
+    // Published pose, blended between the last two sub-steps.
+    SGGeod _step_position[2];     // position before and after the last sub-step
+    SGVec3d _step_attitude[2];    // attitude before and after the last sub-step
+    bool _stepped;                // _step_* hold a sub-step
+    bool _blended;                // _state holds the blend, not the last sub-step
+    SGGeod _blend_position;
+    SGVec3d _blend_attitude;
+
+    void _begin_frame(double sim_time, double dt);
+    void _run_substep(double dt);
+    void _blend_pose(double dt);
+    void _restore_pose();
+
     void set_A_X_pilot(double x)
     { _set_Accels_Pilot_Body(x, _state.a_pilot_body_v[1], _state.a_pilot_body_v[2]); }
     
@@ -395,6 +430,19 @@ public:
     virtual void bind ();
     virtual void unbind ();
     virtual void update(double dt);
+
+    // Runs update() for one sub-step of the FDM subsystem group. The group
+    // steps the FDM at /sim/model-hz, several times per frame; once the
+    // sub-steps of a frame have used /sim/fdm/scheduler/budget-ms of CPU
+    // time (0: no limit), the rest are deferred and run first thing in the
+    // following frames, dropping whatever exceeds max-backlog-sec. Every
+    // sub-step has the same dt, so the FDM sees the same sequence of steps
+    // whatever the frame rate, unless steps are dropped. The ground cache
+    // built by the first sub-step of a frame covers the whole frame.
+    // The position and attitude published between frames are blended from
+    // the last two sub-steps by the part of a sub-step the frame has left
+    // over, so that they move smoothly at one sub-step behind the FDM.
+    void scheduled_update(double dt);
     virtual bool ToggleDataLogging(bool state) { return false; }
     virtual bool ToggleDataLogging(void) { return false; }
 
@@ -681,6 +729,8 @@ public:
     // Prepare the ground cache for the wgs84 position pt_*.
     // That is take all vertices in the ball with radius rad around the
     // position given by the pt_* and store them in a local scene graph.
+    // During scheduled_update() the ball and the time span are stretched to
+    // the end of the frame so that the following sub-steps reuse the cache.
     bool prepare_ground_cache_m(double startSimTime, double endSimTime,
                                 const double pt[3], double rad);
     bool prepare_ground_cache_ft(double startSimTime, double endSimTime,
@@ -757,6 +807,23 @@ public:
     void add_ai_wake(FGAIAircraft* ai) { wake_group.AddAI(ai); }
     void reset_wake_group(void) { wake_group.gc(); }
     const AIWakeGroup& get_wake_group(void) { return wake_group; }
+
+    // Threaded update, driven by FDMShell. An FDM supporting it splits
+    // update() in three: thread_prepare() and thread_publish() run in the
+    // main loop and exchange typed snapshots with thread_step(), which runs
+    // in the FDM thread at a fixed rate and must not touch FlightGear's
+    // property tree at all. The shell holds thread_mutex() during each step
+    // and while the main loop updates the ground cache and the AI wake
+    // group, which the step reads, and during thread_prepare().
+    virtual bool thread_supported() const { return false; }
+    // Called in the main loop before the thread starts and after it stops.
+    virtual void thread_start(double step_dt) {}
+    virtual void thread_stop() {}
+    virtual void thread_prepare(double dt) {}
+    // Advances the FDM by one step; returns false once it cannot go on.
+    virtual bool thread_step() { return false; }
+    virtual void thread_publish() {}
+    std::mutex& thread_mutex() { return _thread_mutex; }
 };
 
 #endif // _FLIGHT_HXX
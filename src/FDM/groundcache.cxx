@@ -296,12 +296,15 @@ FGGroundCache::FGGroundCache() :
     _altitude(0),
     _material(0),
     cache_ref_time(0),
+    cache_end_time(0),
     cache_time_offset(0),
     _wire(0),
     reference_wgs84_point(SGVec3d(0, 0, 0)),
     reference_vehicle_radius(0),
     down(0.0, 0.0, 0.0),
-    found_ground(false)
+    found_ground(false),
+    _builds(0),
+    _reuses(0)
 {
 #ifdef GROUNDCACHE_DEBUG
     _lookupTime = SGTimeStamp::fromSec(0.0);
@@ -324,6 +327,17 @@ FGGroundCache::prepare_ground_cache(double startSimTime, double endSimTime,
         rad = 10000.0;
     }
     
+    // The cache built for a bigger ball and a longer time span still holds
+    // everything asked for. This is the case for the sub-steps following the
+    // first one of a frame, see FGInterface::prepare_ground_cache_m().
+    if (found_ground && !_wire && cache_ref_time <= startSimTime
+        && endSimTime <= cache_end_time
+        && dist(pt, reference_wgs84_point) + rad <= reference_vehicle_radius) {
+        ++_reuses;
+        return true;
+    }
+    ++_builds;
+
 #ifdef GROUNDCACHE_DEBUG
     SGTimeStamp t0 = SGTimeStamp::now();
 #endif
@@ -350,6 +364,7 @@ FGGroundCache::prepare_ground_cache(double startSimTime, double endSimTime,
     reference_vehicle_radius = rad;
     // Store the time reference used to compute movements of moving triangles.
     cache_ref_time = startSimTime;
+    cache_end_time = endSimTime;
     
     // Get a normalized down vector valid for the whole cache
     SGQuatd hlToEc = SGQuatd::fromLonLat(geodPt);
@@ -62,6 +62,13 @@ public:
     // is valid for are returned.
     bool is_valid(double& ref_time, SGVec3d& pt, double& rad);
 
+    // Number of times prepare_ground_cache() built the cache, and number of
+    // times it found the cache already covering the request.
+    unsigned get_build_count() const
+    { return _builds; }
+    unsigned get_reuse_count() const
+    { return _reuses; }
+
     // Returns the unit down vector at the ground cache
     const SGVec3d& get_down() const
     { return down; }
@@ -126,6 +133,8 @@ private:
     // The time reference for later call to intersection test routines.
     // Is required since we will have moving triangles in carriers.
     double cache_ref_time;
+    // The end of the time span the cache was built for.
+    double cache_end_time;
     // The time the cache was initialized.
     double cache_time_offset;
     // The wire to track.
@@ -140,6 +149,9 @@ private:
 
     SGSharedPtr<simgear::BVHNode> _localBvhTree;
 
+    unsigned _builds;
+    unsigned _reuses;
+
 #ifdef GROUNDCACHE_DEBUG
     SGTimeStamp _lookupTime;
     unsigned _lookupCount;
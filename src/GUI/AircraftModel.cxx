@@ -21,7 +21,12 @@
 #include "AircraftModel.hxx"
 
 #include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QRunnable>
+#include <QSaveFile>
 #include <QThread>
+#include <QThreadPool>
 #include <QMutex>
 #include <QMutexLocker>
 #include <QDataStream>
@@ -188,6 +193,39 @@ QPixmap AircraftItem::thumbnail(bool loadIfRequired) const
     return m_thumbnail;
 }
 
+// Parses one -set.xml file on the pool of AircraftScanThread.
+class AircraftParseTask : public QRunnable
+{
+public:
+    AircraftParseTask(QDir dir, QString filePath, AircraftItemPtr* result,
+                      const bool* done) :
+        m_dir(dir),
+        m_filePath(filePath),
+        m_result(result),
+        m_done(done)
+    {
+    }
+
+    virtual void run()
+    {
+        if (*m_done) {
+            return;
+        }
+
+        try {
+            *m_result = AircraftItemPtr(new AircraftItem(m_dir, m_filePath));
+        } catch (sg_exception&) {
+            // leave it out, as a scan always did
+        }
+    }
+
+private:
+    QDir m_dir;
+    QString m_filePath;
+    AircraftItemPtr* m_result;
+    const bool* m_done;
+};
+
 class AircraftScanThread : public QThread
 {
     Q_OBJECT
@@ -196,6 +234,8 @@ public:
         m_dirs(dirsToScan),
         m_done(false)
     {
+        QDir fgHome(QString::fromStdString(globals->get_fg_home().utf8Str()));
+        m_indexPath = fgHome.filePath("aircraft-index.dat");
     }
 
     ~AircraftScanThread()
@@ -222,8 +262,13 @@ Q_SIGNALS:
 protected:
     virtual void run()
     {
-        readCache();
+        QElapsedTimer timer;
+        timer.start();
+        readIndex();
+        qint64 loadTime = timer.restart();
 
+        // directories seen unchanged are added right away, the others
+        // once their -set.xml files are parsed
         Q_FOREACH(QString d, m_dirs) {
             scanAircraftDir(QDir(d));
             if (m_done) {
@@ -231,123 +276,228 @@ protected:
             }
         }
 
-        writeCache();
+        int parsed = parseChangedDirs();
+        if (m_done) {
+            return;
+        }
+        qint64 scanTime = timer.restart();
+
+        writeIndex();
+        qDebug() << "aircraft index: loaded" << m_index.count()
+                 << "directories in" << loadTime << "ms;"
+                 << m_nextIndex.count() - m_changedDirs.count()
+                 << "unchanged," << m_changedDirs.count()
+                 << "rescanned with" << parsed << "files parsed in"
+                 << scanTime << "ms; written in" << timer.elapsed() << "ms";
     }
 
 private:
-    void readCache()
+    // the -set.xml files found in an aircraft directory, when it was last
+    // modified
+    struct IndexedDir
     {
-        QSettings settings;
-        QByteArray cacheData = settings.value("aircraft-cache").toByteArray();
-        if (!cacheData.isEmpty()) {
-            QDataStream ds(cacheData);
-            quint32 count, cacheVersion;
-            ds >> cacheVersion >> count;
-
-            if (cacheVersion != CACHE_VERSION) {
-                return; // mis-matched cache, version, drop
-            }
+        QDateTime modTime;
+        QVector<AircraftItemPtr> items;
+    };
+
+    // a directory which changed, with the files still to be parsed
+    struct ChangedDir
+    {
+        QDir dir;
+        QString path;
+        QDateTime modTime;
+        QStringList files;
+        QVector<AircraftItemPtr> items;
+        QVector<int> toParse;
+    };
+
+    void readIndex()
+    {
+        QFile file(m_indexPath);
+        if (!file.open(QIODevice::ReadOnly)) {
+            return;
+        }
+
+        QDataStream ds(&file);
+        quint32 indexVersion, dirCount;
+        ds >> indexVersion >> dirCount;
+        if (indexVersion != CACHE_VERSION) {
+            return; // mis-matched index version, drop
+        }
 
-             for (quint32 i=0; i<count; ++i) {
+        for (quint32 d=0; d<dirCount && ds.status() == QDataStream::Ok; ++d) {
+            QString dirPath;
+            IndexedDir dir;
+            quint32 count;
+            ds >> dirPath >> dir.modTime >> count;
+            for (quint32 i=0; i<count; ++i) {
                 AircraftItemPtr item(new AircraftItem);
                 item->fromDataStream(ds);
+                dir.items.append(item);
+                m_indexedItems[item->path] = item;
+            }
+            m_index[dirPath] = dir;
+        }
 
-                QFileInfo finfo(item->path);
-                if (finfo.exists() && (finfo.lastModified() == item->pathModTime)) {
-                    // corresponding -set.xml file still exists and is
-                    // unmodified
-                    m_cachedItems[item->path] = item;
-                }
-            } // of cached item iteration
+        if (ds.status() != QDataStream::Ok) {
+            qWarning() << "aircraft index is truncated, rescanning";
+            m_index.clear();
+            m_indexedItems.clear();
         }
     }
 
-    void writeCache()
+    void writeIndex()
     {
-        QSettings settings;
-        QByteArray cacheData;
+        QSaveFile file(m_indexPath);
+        if (!file.open(QIODevice::WriteOnly)) {
+            qWarning() << "can't write the aircraft index" << m_indexPath;
+            return;
+        }
+
         {
-            QDataStream ds(&cacheData, QIODevice::WriteOnly);
-            quint32 count = m_nextCache.count();
+            QDataStream ds(&file);
+            quint32 count = m_nextIndex.count();
             ds << CACHE_VERSION << count;
 
-            Q_FOREACH(AircraftItemPtr item, m_nextCache.values()) {
-                item->toDataStream(ds);
+            QMap<QString, IndexedDir>::const_iterator it;
+            for (it = m_nextIndex.begin(); it != m_nextIndex.end(); ++it) {
+                quint32 itemCount = it.value().items.count();
+                ds << it.key() << it.value().modTime << itemCount;
+                Q_FOREACH(AircraftItemPtr item, it.value().items) {
+                    item->toDataStream(ds);
+                }
             }
         }
 
-        settings.setValue("aircraft-cache", cacheData);
+        file.commit();
+
+        // superseded by the index file
+        QSettings settings;
+        settings.remove("aircraft-cache");
     }
 
     void scanAircraftDir(QDir path)
     {
-        QTime t;
-        t.start();
-
         QStringList filters;
         filters << "*-set.xml";
         Q_FOREACH(QFileInfo child, path.entryInfoList(QDir::Dirs | QDir::NoDotAndDotDot)) {
-            QDir childDir(child.absoluteFilePath());
-            QMap<QString, AircraftItemPtr> baseAircraft;
-            QList<AircraftItemPtr> variants;
-
-            Q_FOREACH(QFileInfo xmlChild, childDir.entryInfoList(filters, QDir::Files)) {
-                try {
-                    QString absolutePath = xmlChild.absoluteFilePath();
-                    AircraftItemPtr item;
-
-                    if (m_cachedItems.contains(absolutePath)) {
-                        item = m_cachedItems.value(absolutePath);
-                    } else {
-                        item = AircraftItemPtr(new AircraftItem(childDir, absolutePath));
-                    }
-
-                    m_nextCache[absolutePath] = item;
-
-                    if (item->excluded) {
-                        continue;
-                    }
-
-                    if (item->isPrimary) {
-                        baseAircraft.insert(item->baseName(), item);
-                    } else {
-                        variants.append(item);
-                    }
-                } catch (sg_exception& e) {
-                    continue;
-                }
+            QString childPath = child.absoluteFilePath();
+            QDateTime modTime = child.lastModified();
+
+            // adding, removing or replacing a file changes the directory:
+            // if it did not, neither did its -set.xml files
+            QMap<QString, IndexedDir>::const_iterator indexed = m_index.find(childPath);
+            if (indexed != m_index.end() && indexed.value().modTime == modTime) {
+                m_nextIndex[childPath] = indexed.value();
+                addAircraft(indexed.value().items);
+                continue;
+            }
 
-                if (m_done) {
-                    return;
+            ChangedDir changed;
+            changed.dir = QDir(childPath);
+            changed.path = childPath;
+            changed.modTime = modTime;
+            Q_FOREACH(QFileInfo xmlChild, changed.dir.entryInfoList(filters, QDir::Files)) {
+                QString absolutePath = xmlChild.absoluteFilePath();
+                AircraftItemPtr item = m_indexedItems.value(absolutePath);
+                if (!item || (item->pathModTime != xmlChild.lastModified())) {
+                    changed.toParse.append(changed.items.count());
+                    item.clear();
                 }
+                changed.files.append(absolutePath);
+                changed.items.append(item);
             } // of set.xml iteration
 
-            // bind variants to their principals
-            Q_FOREACH(AircraftItemPtr item, variants) {
-                if (!baseAircraft.contains(item->variantOf)) {
-                    qWarning() << "can't find principal aircraft " << item->variantOf << " for variant:" << item->path;
-                    continue;
+            m_changedDirs.append(changed);
+
+            if (m_done) {
+                return;
+            }
+        } // of subdir iteration
+    }
+
+    // parse the changed -set.xml files on a pool of threads, then add the
+    // aircraft of the directories they are in. Returns the files parsed.
+    int parseChangedDirs()
+    {
+        QThreadPool pool;
+        int parsed = 0;
+        for (int d = 0; d < m_changedDirs.count(); ++d) {
+            ChangedDir& changed(m_changedDirs[d]);
+            Q_FOREACH(int i, changed.toParse) {
+                pool.start(new AircraftParseTask(changed.dir, changed.files[i],
+                                                 &changed.items[i], &m_done));
+                ++parsed;
+            }
+        }
+        pool.waitForDone();
+
+        for (int d = 0; d < m_changedDirs.count() && !m_done; ++d) {
+            ChangedDir& changed(m_changedDirs[d]);
+            IndexedDir dir;
+            dir.modTime = changed.modTime;
+            Q_FOREACH(AircraftItemPtr item, changed.items) {
+                if (item) {
+                    dir.items.append(item);
                 }
+            }
+            m_nextIndex[changed.path] = dir;
+            addAircraft(dir.items);
+        }
 
-                baseAircraft.value(item->variantOf)->variants.append(item);
+        return parsed;
+    }
+
+    // add the aircraft of one directory, their variants bound to them
+    void addAircraft(const QVector<AircraftItemPtr>& items)
+    {
+        QMap<QString, AircraftItemPtr> baseAircraft;
+        QList<AircraftItemPtr> variants;
+
+        Q_FOREACH(AircraftItemPtr item, items) {
+            if (item->excluded) {
+                continue;
             }
 
-            // lock mutex while we modify the items array
-            {
-                QMutexLocker g(&m_lock);
-                m_items+=(baseAircraft.values().toVector());
+            if (item->isPrimary) {
+                baseAircraft.insert(item->baseName(), item);
+            } else {
+                variants.append(item);
             }
+        }
 
-            emit addedItems();
-        } // of subdir iteration
+        // bind variants to their principals
+        Q_FOREACH(AircraftItemPtr item, variants) {
+            if (!baseAircraft.contains(item->variantOf)) {
+                qWarning() << "can't find principal aircraft " << item->variantOf << " for variant:" << item->path;
+                continue;
+            }
+
+            baseAircraft.value(item->variantOf)->variants.append(item);
+        }
+
+        if (baseAircraft.isEmpty()) {
+            return;
+        }
+
+        // lock mutex while we modify the items array
+        {
+            QMutexLocker g(&m_lock);
+            m_items+=(baseAircraft.values().toVector());
+        }
+
+        emit addedItems();
     }
 
     QMutex m_lock;
     QStringList m_dirs;
+    QString m_indexPath;
     QVector<AircraftItemPtr> m_items;
 
-    QMap<QString, AircraftItemPtr > m_cachedItems;
-    QMap<QString, AircraftItemPtr > m_nextCache;
+    QMap<QString, IndexedDir> m_index;
+    QMap<QString, AircraftItemPtr> m_indexedItems;
+    QMap<QString, IndexedDir> m_nextIndex;
+    QVector<ChangedDir> m_changedDirs;
 
     bool m_done;
 };
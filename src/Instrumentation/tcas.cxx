@@ -120,6 +120,7 @@ using std::string;
 
 #include <Main/fg_props.hxx>
 #include <Main/globals.hxx>
+#include <AIModel/AIManager.hxx>
 #include "instrument_mgr.hxx"
 #include "tcas.hxx"
 
@@ -587,12 +588,12 @@ TCAS::ThreatDetector::update(void)
 
 /** Check if plane's transponder is enabled. */
 bool
-TCAS::ThreatDetector::checkTransponder(const SGPropertyNode* pModel, float velocityKt)
+TCAS::ThreatDetector::checkTransponder(const FGAITrafficIndex& traffic, int i, float velocityKt)
 {
-    const string name = pModel->getName();
-    if (name != "multiplayer" && name != "aircraft")
+    if (!traffic.hasTransponder(i))
     {
-        // assume non-MP/non-AI planes (e.g. ships) have no transponder
+        // assume non-MP/non-AI planes (e.g. ships) have no transponder,
+        // ignored MP planes: pretend transponder is switched off
         return false;
     }
 
@@ -603,33 +604,24 @@ TCAS::ThreatDetector::checkTransponder(const SGPropertyNode* pModel, float veloc
         return false;
     }
 
-    if ((name == "multiplayer")&&
-        (pModel->getBoolValue("controls/invisible")))
-    {
-        // ignored MP plane: pretend transponder is switched off
-        return false;
-    }
-
     return true;
 }
 
 /** Check if plane is a threat. */
 int
-TCAS::ThreatDetector::checkThreat(int mode, const SGPropertyNode* pModel)
+TCAS::ThreatDetector::checkThreat(int mode, const FGAITrafficIndex& traffic, int i)
 {
 #ifdef FEATURE_TCAS_DEBUG_THREAT_DETECTOR
     checkCount++;
 #endif
-    if (!pModel->getBoolValue("valid", true))
-        return ThreatInvisible;
+    const SGPropertyNode* pModel = traffic.props(i);
+    float velocityKt  = traffic.speedKt(i);
 
-    float velocityKt  = pModel->getDoubleValue("velocities/true-airspeed-kt");
-
-    if (!checkTransponder(pModel, velocityKt))
+    if (!checkTransponder(traffic, i, velocityKt))
         return ThreatInvisible;
 
     int threatLevel = ThreatNone;
-    float altFt = pModel->getDoubleValue("position/altitude-ft");
+    float altFt = traffic.altitudeFt(i);
     currentThreat.relativeAltitudeFt = altFt - self.pressureAltFt;
 
     // save computation time: don't care when relative altitude is excessive
@@ -637,9 +629,9 @@ TCAS::ThreatDetector::checkThreat(int mode, const SGPropertyNode* pModel)
         return threatLevel;
 
     // position data of current intruder
-    double lat        = pModel->getDoubleValue("position/latitude-deg");
-    double lon        = pModel->getDoubleValue("position/longitude-deg");
-    float heading     = pModel->getDoubleValue("orientation/true-heading-deg");
+    double lat        = traffic.geod(i).getLatitudeDeg();
+    double lon        = traffic.geod(i).getLongitudeDeg();
+    float heading     = traffic.headingDeg(i);
 
     double distanceNm, bearing;
     calcRangeBearing(self.lat, self.lon, lat, lon, distanceNm, bearing);
@@ -648,7 +640,7 @@ TCAS::ThreatDetector::checkThreat(int mode, const SGPropertyNode* pModel)
     if ((distanceNm > 10)||(distanceNm < 0))
         return threatLevel;
 
-    currentThreat.verticalFps = pModel->getDoubleValue("velocities/vertical-speed-fps");
+    currentThreat.verticalFps = traffic.verticalFps(i);
     
     /* Detect proximity targets
      * [TCASII]: "Any target that is less than 6 nmi in range and within +/-1200ft
@@ -1154,6 +1146,7 @@ TCAS::TCAS(SGPropertyNode* pNode) :
     num(0),
     nextUpdateTime(0),
     selfTestStep(0),
+    reportGeneration(0),
     properties_handler(this),
     threatDetector(this),
     tracker(this),
@@ -1286,28 +1279,87 @@ TCAS::update(double dt)
         else
 #endif
         {
-            SGPropertyNode* pAi = fgGetNode("/ai/models", true);
-
-            // check all aircraft
-            for (int i = pAi->nChildren() - 1; i >= -1; i--)
-            {
-                SGPropertyNode* pModel = pAi->getChild(i);
-                if ((pModel)&&(pModel->nChildren()))
-                {
-                    int threatLevel = threatDetector.checkThreat(mode, pModel);
-                    /* expose aircraft threat-level (to be used by other instruments,
-                     * i.e. TCAS display) */
-                    if (threatLevel==ThreatRA)
-                        pModel->setIntValue("tcas/ra-sense", -threatDetector.getRASense());
-                    pModel->setIntValue("tcas/threat-level", threatLevel);
-                }
-            }
+            checkTraffic(mode);
         }
         advisoryCoordinator.update(mode);
     }
     annunciator.update();
 }
 
+/** Check all aircraft close enough to be considered by the threat detector. */
+void
+TCAS::checkTraffic(int mode)
+{
+    FGAIManager* aiManager = globals->get_subsystem<FGAIManager>();
+    if (!aiManager)
+        return;
+
+    const FGAITrafficIndex& traffic = aiManager->getTrafficIndex();
+    ++reportGeneration;
+
+    /* the threat detector ignores intruders beyond 10nm or 10000ft, only
+     * those within the enclosing sphere need the full check */
+    SGVec3d ownPos = SGVec3d::fromGeod(globals->get_aircraft_position());
+    traffic.query(ownPos, 10 * SG_NM_TO_METER + 10000 * SG_FEET_TO_METER, nearbyTraffic);
+
+    // check all aircraft, in reverse order as the /ai/models scan used to
+    std::vector<int>::const_reverse_iterator nearby = nearbyTraffic.rbegin();
+    for (int i = traffic.size() - 1; i >= 0; i--)
+    {
+        SGPropertyNode* pModel = traffic.props(i);
+        int threatLevel;
+        if ((nearby != nearbyTraffic.rend())&&(*nearby == i))
+        {
+            ++nearby;
+            threatLevel = threatDetector.checkThreat(mode, traffic, i);
+        }
+        else
+        {
+            threatLevel = threatDetector.checkTransponder(traffic, i, traffic.speedKt(i)) ?
+                ThreatNone : ThreatInvisible;
+        }
+
+        /* expose aircraft threat-level (to be used by other instruments,
+         * i.e. TCAS display) */
+        if (threatLevel==ThreatRA)
+            pModel->setIntValue("tcas/ra-sense", -threatDetector.getRASense());
+        reportThreatLevel(pModel, threatLevel);
+    }
+
+    // forget about aircraft which disappeared
+    ReportedThreats::iterator it = reportedThreats.begin();
+    while (it != reportedThreats.end())
+    {
+        if (it->second.generation != reportGeneration)
+            reportedThreats.erase(it++);
+        else
+            ++it;
+    }
+}
+
+/** Write an aircraft's threat level, unless it is unchanged since the last update. */
+void
+TCAS::reportThreatLevel(SGPropertyNode* pModel, int threatLevel)
+{
+    ReportedThreats::iterator it = reportedThreats.find(pModel);
+    if (it == reportedThreats.end())
+    {
+        ReportedThreat report;
+        report.model = pModel;
+        report.level = pModel->getNode("tcas/threat-level", true);
+        report.value = threatLevel;
+        report.level->setIntValue(threatLevel);
+        it = reportedThreats.insert(std::make_pair(pModel, report)).first;
+    }
+    else if (it->second.value != threatLevel)
+    {
+        it->second.value = threatLevel;
+        it->second.level->setIntValue(threatLevel);
+    }
+
+    it->second.generation = reportGeneration;
+}
+
 /** Run a single self-test iteration. */
 void
 TCAS::selfTest(void)
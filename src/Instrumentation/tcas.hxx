@@ -39,6 +39,8 @@ class SGSampleGroup;
 
 #include <Main/globals.hxx>
 
+class FGAITrafficIndex;
+
 #ifdef _MSC_VER
 #  pragma warning( push )
 #  pragma warning( disable: 4355 )
@@ -317,8 +319,8 @@ class TCAS : public SGSubsystem
         void  init                (void);
         void  update              (void);
 
-        bool  checkTransponder    (const SGPropertyNode* pModel, float velocityKt);
-        int   checkThreat         (int mode, const SGPropertyNode* pModel);
+        bool  checkTransponder    (const FGAITrafficIndex& traffic, int i, float velocityKt);
+        int   checkThreat         (int mode, const FGAITrafficIndex& traffic, int i);
         void  checkVerticalThreat (void);
         void  horizontalThreat    (float bearing, float distanceNm, float heading,
                                    float velocityKt);
@@ -369,6 +371,19 @@ private:
     SGPropertyNode_ptr  nodeDebugRA;
     SGPropertyNode_ptr  nodeDebugThreat;
 
+    /** last threat level written to each intruder's tcas/threat-level */
+    struct ReportedThreat
+    {
+        SGPropertyNode_ptr model;
+        SGPropertyNode_ptr level;
+        int                value;
+        unsigned int       generation;
+    };
+    typedef std::map<const SGPropertyNode*, ReportedThreat> ReportedThreats;
+    ReportedThreats     reportedThreats;
+    unsigned int        reportGeneration;
+    std::vector<int>    nearbyTraffic;
+
     PropertiesHandler   properties_handler;
     ThreatDetector      threatDetector;
     Tracker             tracker;
@@ -378,6 +393,8 @@ private:
 
 private:
     void selfTest       (void);
+    void checkTraffic   (int mode);
+    void reportThreatLevel(SGPropertyNode* pModel, int threatLevel);
 
 public:
     TCAS (SGPropertyNode* node);
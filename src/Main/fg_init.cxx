@@ -109,6 +109,7 @@
 #include <Main/locale.hxx>
 #include <Navaids/navdb.hxx>
 #include <Navaids/navlist.hxx>
+#include <Radio/radio.hxx>
 #include <Scenery/scenery.hxx>
 #include <Scenery/SceneryPager.hxx>
 #include <Scripting/NasalSys.hxx>
@@ -877,6 +878,7 @@ void fgCreateSubsystems(bool duringReset) {
     ////////////////////////////////////////////////////////////////////
 
     globals->add_new_subsystem<PerformanceDB>(SGSubsystemMgr::POST_FDM);
+    globals->add_new_subsystem<FGRadioPropagation>(SGSubsystemMgr::POST_FDM);
     globals->add_subsystem("ATC", new FGATCManager, SGSubsystemMgr::POST_FDM);
 
     ////////////////////////////////////////////////////////////////////
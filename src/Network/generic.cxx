@@ -26,7 +26,10 @@
 
 #include <string.h>                // strstr()
 #include <stdlib.h>                // strtod(), atoi()
+#include <ctype.h>
+#include <math.h>
 #include <cstdio>
+#include <algorithm>
 
 #include <simgear/debug/logstream.hxx>
 #include <simgear/io/iochannel.hxx>
@@ -221,7 +224,8 @@ int FGSTXETXWrapper::unwrap( size_t n, uint8_t * buf )
   return n;
 }
 
-FGGeneric::FGGeneric(vector<string> tokens) : exitOnError(false), initOk(false), wrapper(NULL)
+FGGeneric::FGGeneric(vector<string> tokens) :
+    batch_size(1), batched(0), exitOnError(false), initOk(false), wrapper(NULL)
 {
     size_t configToken;
     if (tokens[1] == "socket") {
@@ -265,81 +269,223 @@ union u64 {
     double doubleVal;
 };
 
+// binary records, in network or host byte order
+static inline void put32(char *p, uint32_t v, bool swap)
+{
+    if (swap) v = sg_bswap_32(v);
+    memcpy(p, &v, sizeof(v));
+}
+
+static inline void put64(char *p, uint64_t v, bool swap)
+{
+    if (swap) v = sg_bswap_64(v);
+    memcpy(p, &v, sizeof(v));
+}
+
+static inline uint32_t get32(const char *p, bool swap)
+{
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return swap ? sg_bswap_32(v) : v;
+}
+
+static inline uint64_t get64(const char *p, bool swap)
+{
+    uint64_t v;
+    memcpy(&v, p, sizeof(v));
+    return swap ? sg_bswap_64(v) : v;
+}
+
+// ASCII chunks: the fast paths below give the same text as snprintf() and
+// the same values as strtod() and atoi(), and give up on anything else
+
+static const double powers_of_10[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+static inline char *append(char *p, const string &s)
+{
+    memcpy(p, s.data(), s.size());
+    return p + s.size();
+}
+
+static char *writeUnsigned(char *p, uint64_t v)
+{
+    char digits[20];
+    int n = 0;
+    do {
+        digits[n++] = '0' + v % 10;
+        v /= 10;
+    } while (v);
+    while (n)
+        *p++ = digits[--n];
+    return p;
+}
+
+static char *writeInt(char *p, int v)
+{
+    if (v < 0) {
+        *p++ = '-';
+        return writeUnsigned(p, -(int64_t)v);
+    }
+    return writeUnsigned(p, v);
+}
+
+// like "%.*f", for precisions up to 9
+static char *writeFixed(char *p, double v, int precision)
+{
+    double scaled = fabs(v) * powers_of_10[precision];
+    double rounded = floor(scaled + 0.5);
+
+    // printf() rounds the exact value, which the multiplication may have
+    // moved across a tie: leave those to it, as well as the large values,
+    // infinity and NaN
+    if (!(scaled < 1e15) ||
+        fabs(fabs(scaled - rounded) - 0.5) < scaled * 1e-15 + 1e-9) {
+        int n = snprintf(p, 255, "%.*f", precision, v);
+        return p + std::min(std::max(n, 0), 254);
+    }
+
+    uint64_t n = (uint64_t)rounded;
+    uint64_t unit = (uint64_t)powers_of_10[precision];
+    if (signbit(v))
+        *p++ = '-';
+    p = writeUnsigned(p, n / unit);
+    if (precision > 0) {
+        *p++ = '.';
+        uint64_t frac = n % unit;
+        for (int i = precision - 1; i >= 0; --i) {
+            p[i] = '0' + frac % 10;
+            frac /= 10;
+        }
+        p += precision;
+    }
+    return p;
+}
+
+template<class T>
+static char *writeFormatted(char *p, const string &format, T val)
+{
+    int n = snprintf(p, 255, format.c_str(), val);
+    return p + std::min(std::max(n, 0), 254);
+}
+
+// strtod() of a plain decimal number with up to 15 digits, which converts
+// exactly with a single multiplication or division
+static bool parseDouble(const char *s, double &v)
+{
+    while (isspace((unsigned char)*s))
+        s++;
+    bool negative = *s == '-';
+    if (*s == '-' || *s == '+')
+        s++;
+
+    uint64_t mantissa = 0;
+    int digits = 0, exponent = 0;
+    bool any = false;
+    for (; *s >= '0' && *s <= '9'; s++, any = true) {
+        if (mantissa || *s != '0') {
+            if (++digits > 15) return false;
+            mantissa = mantissa * 10 + (*s - '0');
+        }
+    }
+    if (*s == '.') {
+        for (s++; *s >= '0' && *s <= '9'; s++, any = true) {
+            if (mantissa || *s != '0') {
+                if (++digits > 15) return false;
+                mantissa = mantissa * 10 + (*s - '0');
+            }
+            exponent--;
+        }
+    }
+    // exponents, hex numbers, inf and nan
+    if (!any || exponent < -22 ||
+        *s == 'e' || *s == 'E' || *s == 'x' || *s == 'X')
+        return false;
+
+    v = (double)mantissa;
+    if (exponent < 0)
+        v /= powers_of_10[-exponent];
+    if (negative)
+        v = -v;
+    return true;
+}
+
+// atoi() of up to 9 digits
+static bool parseInt(const char *s, int &v)
+{
+    while (isspace((unsigned char)*s))
+        s++;
+    bool negative = *s == '-';
+    if (*s == '-' || *s == '+')
+        s++;
+
+    int n = 0, digits = 0;
+    for (; *s >= '0' && *s <= '9'; s++) {
+        if (++digits > 9) return false;
+        n = n * 10 + (*s - '0');
+    }
+    v = negative ? -n : n;
+    return true;
+}
+
 // generate the message
 bool FGGeneric::gen_message_binary() {
-    string generic_sentence;
+    bool swap = binary_byte_order != BYTE_ORDER_MATCHES_NETWORK_ORDER;
     length = 0;
 
     double val;
     for (unsigned int i = 0; i < _out_message.size(); i++) {
+        _serial_prot &chunk = _out_message[i];
 
-        switch (_out_message[i].type) {
+        switch (chunk.type) {
         case FG_INT:
         {
-            val = _out_message[i].offset +
-                  _out_message[i].prop->getFloatValue() * _out_message[i].factor;
+            val = chunk.offset + chunk.prop->getFloatValue() * chunk.factor;
             int32_t intVal = val;
-            if (binary_byte_order != BYTE_ORDER_MATCHES_NETWORK_ORDER) {
-                intVal = (int32_t) sg_bswap_32((uint32_t)intVal);
-            }
-            memcpy(&buf[length], &intVal, sizeof(int32_t));
+            put32(&buf[length], (uint32_t)intVal, swap);
             length += sizeof(int32_t);
             break;
         }
 
         case FG_BOOL:
-            buf[length] = (char) (_out_message[i].prop->getBoolValue() ? true : false);
+            buf[length] = (char) (chunk.prop->getBoolValue() ? true : false);
             length += 1;
             break;
 
         case FG_FIXED:
         {
-            val = _out_message[i].offset +
-                 _out_message[i].prop->getFloatValue() * _out_message[i].factor;
-
+            val = chunk.offset + chunk.prop->getFloatValue() * chunk.factor;
             int32_t fixed = (int)(val * 65536.0f);
-            if (binary_byte_order != BYTE_ORDER_MATCHES_NETWORK_ORDER) {
-                fixed = (int32_t) sg_bswap_32((uint32_t)fixed);
-            } 
-            memcpy(&buf[length], &fixed, sizeof(int32_t));
+            put32(&buf[length], (uint32_t)fixed, swap);
             length += sizeof(int32_t);
             break;
         }
 
         case FG_FLOAT:
         {
-            val = _out_message[i].offset +
-                 _out_message[i].prop->getFloatValue() * _out_message[i].factor;
+            val = chunk.offset + chunk.prop->getFloatValue() * chunk.factor;
             u32 tmpun32;
             tmpun32.floatVal = static_cast<float>(val);
-
-            if (binary_byte_order != BYTE_ORDER_MATCHES_NETWORK_ORDER) {
-                tmpun32.intVal = sg_bswap_32(tmpun32.intVal);
-            }
-            memcpy(&buf[length], &tmpun32.intVal, sizeof(uint32_t));
+            put32(&buf[length], tmpun32.intVal, swap);
             length += sizeof(uint32_t);
             break;
         }
 
         case FG_DOUBLE:
         {
-            val = _out_message[i].offset +
-                 _out_message[i].prop->getDoubleValue() * _out_message[i].factor;
+            val = chunk.offset + chunk.prop->getDoubleValue() * chunk.factor;
             u64 tmpun64;
             tmpun64.doubleVal = val;
-
-            if (binary_byte_order != BYTE_ORDER_MATCHES_NETWORK_ORDER) {
-                tmpun64.longVal = sg_bswap_64(tmpun64.longVal);
-            }
-            memcpy(&buf[length], &tmpun64.longVal, sizeof(uint64_t));
+            put64(&buf[length], tmpun64.longVal, swap);
             length += sizeof(uint64_t);
             break;
         }
 
         case FG_BYTE:
         {
-            val = _out_message[i].offset +
-                  _out_message[i].prop->getFloatValue() * _out_message[i].factor;
+            val = chunk.offset + chunk.prop->getFloatValue() * chunk.factor;
             int8_t byteVal = val;
             memcpy(&buf[length], &byteVal, sizeof(int8_t));
             length += sizeof(int8_t);
@@ -348,8 +494,7 @@ bool FGGeneric::gen_message_binary() {
 
         case FG_WORD:
         {
-            val = _out_message[i].offset +
-                  _out_message[i].prop->getFloatValue() * _out_message[i].factor;
+            val = chunk.offset + chunk.prop->getFloatValue() * chunk.factor;
             int16_t wordVal = val;
             memcpy(&buf[length], &wordVal, sizeof(int16_t));
             length += sizeof(int16_t);
@@ -357,7 +502,7 @@ bool FGGeneric::gen_message_binary() {
         }
 
         default: // SG_STRING
-            const char *strdata = _out_message[i].prop->getStringValue();
+            const char *strdata = chunk.prop->getStringValue();
             int32_t strlength = strlen(strdata);
 
             if (binary_byte_order == BYTE_ORDER_NEEDS_CONVERSION) {
@@ -367,12 +512,9 @@ bool FGGeneric::gen_message_binary() {
             /* Format for strings is 
              * [length as int, 4 bytes][ASCII data, length bytes]
              */
-            if (binary_byte_order != BYTE_ORDER_MATCHES_NETWORK_ORDER) {
-                strlength = sg_bswap_32(strlength);
-            }
-            memcpy(&buf[length], &strlength, sizeof(int32_t));
+            put32(&buf[length], (uint32_t)strlength, swap);
             length += sizeof(int32_t);
-            strncpy(&buf[length], strdata, strlength);
+            memcpy(&buf[length], strdata, strlength);
             length += strlength; 
             /* FIXME padding for alignment? Something like: 
              * length += (strlength % 4 > 0 ? sizeof(int32_t) - strlength % 4 : 0;
@@ -394,11 +536,7 @@ bool FGGeneric::gen_message_binary() {
     }
 
     if (binary_footer_type != FOOTER_NONE) {
-        int32_t intValue = binary_footer_value;
-        if (binary_byte_order != BYTE_ORDER_MATCHES_NETWORK_ORDER) {
-            intValue = sg_bswap_32(binary_footer_value);
-        }
-        memcpy(&buf[length], &intValue, sizeof(int32_t));
+        put32(&buf[length], (uint32_t)binary_footer_value, swap);
         length += sizeof(int32_t);
     }
 
@@ -408,67 +546,88 @@ bool FGGeneric::gen_message_binary() {
 }
 
 bool FGGeneric::gen_message_ascii() {
-    string generic_sentence;
-    char tmp[255];
-    length = 0;
+    char *p = buf;
+    // leaves room for the line separator, and a value of 254 characters at
+    // most, as snprintf() writes them below
+    char *end = buf + FG_MAX_MSG_SIZE - 255 - line_separator.size();
 
     double val;
     for (unsigned int i = 0; i < _out_message.size(); i++) {
+        _serial_prot &chunk = _out_message[i];
+
+        if (p + var_separator.size() + chunk.prefix.size() + chunk.suffix.size() > end) {
+            SG_LOG(SG_IO, SG_ALERT, "Generic protocol: output line too long, truncated.");
+            break;
+        }
 
         if (i > 0) {
-            generic_sentence += var_separator;
+            p = append(p, var_separator);
+        }
+        if (chunk.fmt != FORMAT_PRINTF) {
+            p = append(p, chunk.prefix);
         }
-        
-        string format = simgear::strutils::sanitizePrintfFormat(_out_message[i].format);
 
-        switch (_out_message[i].type) {
+        switch (chunk.type) {
         case FG_BYTE:
         case FG_WORD:
         case FG_INT:
-            val = _out_message[i].offset +
-                  _out_message[i].prop->getFloatValue() * _out_message[i].factor;
-            snprintf(tmp, 255, format.c_str(), (int)val);
+            val = chunk.offset + chunk.prop->getFloatValue() * chunk.factor;
+            if (chunk.fmt == FORMAT_INT) {
+                p = writeInt(p, (int)val);
+            } else {
+                p = writeFormatted(p, chunk.format, (int)val);
+            }
             break;
 
         case FG_BOOL:
-            snprintf(tmp, 255, format.c_str(),
-                               _out_message[i].prop->getBoolValue());
+            if (chunk.fmt == FORMAT_INT) {
+                *p++ = chunk.prop->getBoolValue() ? '1' : '0';
+            } else {
+                p = writeFormatted(p, chunk.format, chunk.prop->getBoolValue());
+            }
             break;
 
         case FG_FIXED:
-            val = _out_message[i].offset +
-                _out_message[i].prop->getFloatValue() * _out_message[i].factor;
-            snprintf(tmp, 255, format.c_str(), (float)val);
-            break;
-
         case FG_FLOAT:
-            val = _out_message[i].offset +
-                _out_message[i].prop->getFloatValue() * _out_message[i].factor;
-            snprintf(tmp, 255, format.c_str(), (float)val);
+            val = chunk.offset + chunk.prop->getFloatValue() * chunk.factor;
+            if (chunk.fmt == FORMAT_FLOAT) {
+                p = writeFixed(p, (float)val, chunk.precision);
+            } else {
+                p = writeFormatted(p, chunk.format, (float)val);
+            }
             break;
 
         case FG_DOUBLE:
-            val = _out_message[i].offset +
-                _out_message[i].prop->getDoubleValue() * _out_message[i].factor;
-            snprintf(tmp, 255, format.c_str(), (double)val);
+            val = chunk.offset + chunk.prop->getDoubleValue() * chunk.factor;
+            if (chunk.fmt == FORMAT_FLOAT) {
+                p = writeFixed(p, val, chunk.precision);
+            } else {
+                p = writeFormatted(p, chunk.format, val);
+            }
             break;
 
         default: // SG_STRING
-            snprintf(tmp, 255, format.c_str(),
-                                   _out_message[i].prop->getStringValue());
+            if (chunk.fmt == FORMAT_STRING) {
+                const char *strdata = chunk.prop->getStringValue();
+                size_t n = std::min(strlen(strdata), (size_t)254);
+                memcpy(p, strdata, n);
+                p += n;
+            } else {
+                p = writeFormatted(p, chunk.format, chunk.prop->getStringValue());
+            }
         }
 
-        generic_sentence += tmp;
+        if (chunk.fmt != FORMAT_PRINTF) {
+            p = append(p, chunk.suffix);
+        }
     }
 
     /* After each lot of variables has been added, put the line separator
      * char/string
      */
-    generic_sentence += line_separator;
-
-    length =  generic_sentence.length();
-    strncpy( buf, generic_sentence.c_str(), length );
+    p = append(p, line_separator);
 
+    length = p - buf;
     return true;
 }
 
@@ -481,76 +640,56 @@ bool FGGeneric::gen_message() {
 }
 
 bool FGGeneric::parse_message_binary(int length) {
-    char *p2, *p1 = buf;
-    int32_t tmp32;
-    int i = -1;
+    parse_record_binary(buf, length);
+    return true;
+}
 
-    p2 = p1 + length;
-    while ((++i < (int)_in_message.size()) && (p1  < p2)) {
+void FGGeneric::parse_record_binary(const char *record, int length) {
+    bool swap = binary_byte_order == BYTE_ORDER_NEEDS_CONVERSION;
+    u32 tmpun32;
+    u64 tmpun64;
 
-        switch (_in_message[i].type) {
+    for (unsigned int i = 0; i < _in_message.size(); i++) {
+        _serial_prot &chunk = _in_message[i];
+        if (chunk.pos + chunk.size > length)
+            break;
+        const char *p = record + chunk.pos;
+
+        switch (chunk.type) {
         case FG_INT:
-            if (binary_byte_order == BYTE_ORDER_NEEDS_CONVERSION) {
-                tmp32 = sg_bswap_32(*(int32_t *)p1);
-            } else {
-                tmp32 = *(int32_t *)p1;
-            }
-            updateValue(_in_message[i], (int)tmp32);
-            p1 += sizeof(int32_t);
+            updateValue(chunk, (int)(int32_t)get32(p, swap));
             break;
 
         case FG_BOOL:
-            updateValue(_in_message[i], p1[0] != 0);
-            p1 += 1;
+            updateValue(chunk, p[0] != 0);
             break;
 
         case FG_FIXED:
-            if (binary_byte_order == BYTE_ORDER_NEEDS_CONVERSION) {
-                tmp32 = sg_bswap_32(*(int32_t *)p1);
-            } else {
-                tmp32 = *(int32_t *)p1;
-            }
-            updateValue(_in_message[i], (float)tmp32 / 65536.0f);
-            p1 += sizeof(int32_t);
+            updateValue(chunk, (float)(int32_t)get32(p, swap) / 65536.0f);
             break;
 
         case FG_FLOAT:
-            u32 tmpun32;
-            if (binary_byte_order == BYTE_ORDER_NEEDS_CONVERSION) {
-                tmpun32.intVal = sg_bswap_32(*(uint32_t *)p1);
-            } else {
-                tmpun32.floatVal = *(float *)p1;
-            }
-            updateValue(_in_message[i], tmpun32.floatVal);
-            p1 += sizeof(int32_t);
+            tmpun32.intVal = get32(p, swap);
+            updateValue(chunk, tmpun32.floatVal);
             break;
 
         case FG_DOUBLE:
-            u64 tmpun64;
-            if (binary_byte_order == BYTE_ORDER_NEEDS_CONVERSION) {
-                tmpun64.longVal = sg_bswap_64(*(uint64_t *)p1);
-            } else {
-                tmpun64.doubleVal = *(double *)p1;
-            }
-            updateValue(_in_message[i], tmpun64.doubleVal);
-            p1 += sizeof(int64_t);
+            tmpun64.longVal = get64(p, swap);
+            updateValue(chunk, tmpun64.doubleVal);
             break;
 
         case FG_BYTE:
-            tmp32 = *(int8_t *)p1;
-            updateValue(_in_message[i], (int)tmp32);
-            p1 += sizeof(int8_t);
+            updateValue(chunk, (int)*(const int8_t *)p);
             break;
 
         case FG_WORD:
-            if (binary_byte_order == BYTE_ORDER_NEEDS_CONVERSION) {
-                tmp32 = sg_bswap_16(*(int16_t *)p1);
-            } else {
-                tmp32 = *(int16_t *)p1;
-            }
-            updateValue(_in_message[i], (int)tmp32);
-            p1 += sizeof(int16_t);
+        {
+            uint16_t word;
+            memcpy(&word, p, sizeof(word));
+            // a converted word has always been read unsigned
+            updateValue(chunk, swap ? (int)sg_bswap_16(word) : (int)(int16_t)word);
             break;
+        }
 
         default: // SG_STRING
             SG_LOG( SG_IO, SG_ALERT, "Generic protocol: "
@@ -558,8 +697,6 @@ bool FGGeneric::parse_message_binary(int length) {
             break;
         }
     }
-    
-    return true;
 }
 
 bool FGGeneric::parse_message_ascii(int length) {
@@ -583,31 +720,41 @@ bool FGGeneric::parse_message_ascii(int length) {
 
         if (varsep_len > 0)
         {
-            p2 = strstr(p1, var_separator.c_str());
+            if (varsep_len == 1) {
+                p2 = strchr(p1, var_separator[0]);
+            } else {
+                p2 = strstr(p1, var_separator.c_str());
+            }
             if (p2) {
                 *p2 = 0;
                 p2 += varsep_len;
             }
         }
 
+        int intVal;
+        double doubleVal;
         switch (_in_message[i].type) {
         case FG_BYTE:
         case FG_WORD:
         case FG_INT:
-            updateValue(_in_message[i], atoi(p1));
+            if (!parseInt(p1, intVal)) intVal = atoi(p1);
+            updateValue(_in_message[i], intVal);
             break;
 
         case FG_BOOL:
-            updateValue(_in_message[i], atof(p1) != 0.0);
+            if (!parseDouble(p1, doubleVal)) doubleVal = atof(p1);
+            updateValue(_in_message[i], doubleVal != 0.0);
             break;
 
         case FG_FIXED:
         case FG_FLOAT:
-            updateValue(_in_message[i], (float)strtod(p1, 0));
+            if (!parseDouble(p1, doubleVal)) doubleVal = strtod(p1, 0);
+            updateValue(_in_message[i], (float)doubleVal);
             break;
 
         case FG_DOUBLE:
-            updateValue(_in_message[i], (double)strtod(p1, 0));
+            if (!parseDouble(p1, doubleVal)) doubleVal = strtod(p1, 0);
+            updateValue(_in_message[i], doubleVal);
             break;
 
         default: // SG_STRING
@@ -667,7 +814,13 @@ bool FGGeneric::process() {
     if ( (get_direction() == SG_IO_OUT) ||
          (get_direction() == SG_IO_BI) ) {
         gen_message();
-        if ( ! io->write( buf, length ) ) {
+        if (batch_size > 1) {
+            batch_buf.append( buf, length );
+            if ( ++batched >= batch_size && ! write_batch() ) {
+                SG_LOG( SG_IO, SG_WARN, "Error writing data." );
+                goto error_out;
+            }
+        } else if ( ! io->write( buf, length ) ) {
             SG_LOG( SG_IO, SG_WARN, "Error writing data." );
             goto error_out;
         }
@@ -701,6 +854,22 @@ bool FGGeneric::process() {
                 while ((length = io->readline( buf, FG_MAX_MSG_SIZE )) > 0 ) {
                     parse_message_len( length );
                 }
+            } else if (batch_size > 1) {
+                // a datagram of a batched sender holds several records
+                while ((length = io->read( buf, binary_record_length * batch_size )) > 0 ) {
+                    for (int pos = 0; pos + binary_record_length <= length;
+                         pos += binary_record_length) {
+                        parse_record_binary( buf + pos, binary_record_length );
+                    }
+
+                    if ( length % binary_record_length ) {
+                        SG_LOG( SG_IO, SG_ALERT,
+                            "Generic protocol: Received binary "
+                            "batch of unexpected size, expected a multiple of: "
+                            << binary_record_length << " but received: "
+                            << length);
+                    }
+                }
             } else {
                 while ((length = io->read( buf, binary_record_length )) 
                           == binary_record_length ) {
@@ -727,10 +896,29 @@ error_out:
 }
 
 
+// write the frames batched so far
+bool FGGeneric::write_batch() {
+    if (batched == 0) {
+        return true;
+    }
+
+    bool ok = get_io_channel()->write( batch_buf.data(), batch_buf.size() );
+    batch_buf.clear();
+    batched = 0;
+    return ok;
+}
+
+
 // close the channel
 bool FGGeneric::close() {
     SGIOChannel *io = get_io_channel();
 
+    if ( ((get_direction() == SG_IO_OUT)||
+          (get_direction() == SG_IO_BI))
+          && ! write_batch() ) {
+        SG_LOG( SG_IO, SG_WARN, "Error writing data." );
+    }
+
     if ( ((get_direction() == SG_IO_OUT)||
           (get_direction() == SG_IO_BI))
           && ! postamble.empty() ) {
@@ -806,6 +994,9 @@ bool
 FGGeneric::read_config(SGPropertyNode *root, vector<_serial_prot> &msg)
 {
     binary_mode = root->getBoolValue("binary_mode");
+    batch_size = std::max(root->getIntValue("batch", 1), 1);
+    batched = 0;
+    batch_buf.clear();
 
     if (!binary_mode) {
         /* These variables specified in the $FG_ROOT/data/Protocol/xxx.xml
@@ -916,7 +1107,8 @@ FGGeneric::read_config(SGPropertyNode *root, vector<_serial_prot> &msg)
         _serial_prot chunk;
 
         // chunk.name = chunks[i]->getStringValue("name");
-        chunk.format = unescape(chunks[i]->getStringValue("format", "%d"));
+        chunk.format = simgear::strutils::sanitizePrintfFormat(
+            unescape(chunks[i]->getStringValue("format", "%d")));
         chunk.offset = chunks[i]->getDoubleValue("offset");
         chunk.factor = chunks[i]->getDoubleValue("factor", 1.0);
         chunk.min = chunks[i]->getDoubleValue("min");
@@ -924,15 +1116,8 @@ FGGeneric::read_config(SGPropertyNode *root, vector<_serial_prot> &msg)
         chunk.wrap = chunks[i]->getBoolValue("wrap");
         chunk.rel = chunks[i]->getBoolValue("relative");
 
-        if( chunks[i]->hasChild("const") ) {
-            chunk.prop = new SGPropertyNode();
-            chunk.prop->setStringValue( chunks[i]->getStringValue("const", "" ) );
-        } else {
-            string node = chunks[i]->getStringValue("node", "/null");
-            chunk.prop = fgGetNode(node.c_str(), true);
-        }
-
         string type = chunks[i]->getStringValue("type");
+        chunk.pos = record_length;
 
         // Note: officially the type is called 'bool' but for backward
         //       compatibility 'boolean' will also be supported.
@@ -960,6 +1145,22 @@ FGGeneric::read_config(SGPropertyNode *root, vector<_serial_prot> &msg)
             chunk.type = FG_INT;
             record_length += sizeof(int32_t);
         }
+        chunk.size = record_length - chunk.pos;
+
+        if( chunks[i]->hasChild("const") ) {
+            chunk.prop = new SGPropertyNode();
+            // a constant number is parsed once, not on every frame
+            if (chunk.type == FG_STRING || chunk.type == FG_BOOL) {
+                chunk.prop->setStringValue( chunks[i]->getStringValue("const", "" ) );
+            } else {
+                chunk.prop->setDoubleValue( chunks[i]->getDoubleValue("const") );
+            }
+        } else {
+            string node = chunks[i]->getStringValue("node", "/null");
+            chunk.prop = fgGetNode(node.c_str(), true);
+        }
+
+        compile_format(chunk);
         msg.push_back(chunk);
 
     }
@@ -985,11 +1186,79 @@ FGGeneric::read_config(SGPropertyNode *root, vector<_serial_prot> &msg)
                    " requested record representation.");
             binary_record_length = record_length;
         }
+
+        // input batches are read into the message buffer
+        if (binary_record_length > 0) {
+            batch_size = std::min(batch_size, FG_MAX_MSG_SIZE / binary_record_length);
+        }
     }
 
     return true;
 }
 
+// Pick the fast path for the formats made of literal text and one
+// conversion matching the type of the chunk, without flags or width.
+void
+FGGeneric::compile_format(_serial_prot &chunk)
+{
+    const string &format = chunk.format;
+    chunk.fmt = FORMAT_PRINTF;
+    chunk.precision = 0;
+    chunk.prefix.clear();
+    chunk.suffix.clear();
+
+    size_t conversion = format.find('%');
+    if (conversion == string::npos) {
+        return;
+    }
+
+    size_t i = conversion + 1;
+    int precision = -1;
+    if (i < format.size() && format[i] == '.') {
+        precision = 0;
+        for (i++; i < format.size() && isdigit((unsigned char)format[i]); i++) {
+            precision = std::min(precision * 10 + (format[i] - '0'), 100);
+        }
+    }
+    if (i >= format.size() || format.find('%', i + 1) != string::npos) {
+        return;
+    }
+
+    bool number = chunk.type == FG_FLOAT || chunk.type == FG_FIXED ||
+                  chunk.type == FG_DOUBLE;
+    e_format fmt = FORMAT_PRINTF;
+    switch (format[i]) {
+    case 'd':
+    case 'i':
+        if (precision < 0 && !number && chunk.type != FG_STRING) {
+            fmt = FORMAT_INT;
+        }
+        break;
+
+    case 'f':
+        if (precision < 0) {
+            precision = 6;
+        }
+        if (precision <= 9 && number) {
+            fmt = FORMAT_FLOAT;
+        }
+        break;
+
+    case 's':
+        if (precision < 0 && chunk.type == FG_STRING) {
+            fmt = FORMAT_STRING;
+        }
+        break;
+    }
+
+    if (fmt != FORMAT_PRINTF) {
+        chunk.fmt = fmt;
+        chunk.precision = precision;
+        chunk.prefix = format.substr(0, conversion);
+        chunk.suffix = format.substr(i + 1);
+    }
+}
+
 void FGGeneric::updateValue(FGGeneric::_serial_prot& prot, bool val)
 {
   if( prot.rel )
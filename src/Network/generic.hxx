@@ -61,9 +61,13 @@ protected:
 
     enum e_type { FG_BOOL=0, FG_INT, FG_FLOAT, FG_DOUBLE, FG_STRING, FG_FIXED, FG_BYTE, FG_WORD };
 
+    // how an ASCII chunk is written: the formats made of one plain %d, %i,
+    // %.Nf or %s conversion and literal text are done without snprintf()
+    enum e_format { FORMAT_PRINTF=0, FORMAT_INT, FORMAT_FLOAT, FORMAT_STRING };
+
     typedef struct {
      // string name;
-        string format;
+        string format;     // sanitized once by read_config()
         e_type type;
         double offset;
         double factor;
@@ -71,6 +75,14 @@ protected:
         bool wrap;
         bool rel;
         SGPropertyNode_ptr prop;
+
+        // compiled by read_config()
+        int pos;           // offset in a binary record, strings not counted
+        int size;          // bytes in a binary record, 0 for a string
+        e_format fmt;
+        int precision;     // for FORMAT_FLOAT
+        string prefix;     // the text of the format around the conversion,
+        string suffix;     // for all but FORMAT_PRINTF
     } _serial_prot;
 
 private:
@@ -96,11 +108,19 @@ private:
     int binary_record_length;
     enum {BYTE_ORDER_NEEDS_CONVERSION, BYTE_ORDER_MATCHES_NETWORK_ORDER} binary_byte_order;
 
+    // frames written at once, and binary records read at once
+    int batch_size;
+    int batched;
+    string batch_buf;
+
     bool gen_message_ascii();
     bool gen_message_binary();
     bool parse_message_ascii(int length);
     bool parse_message_binary(int length);
+    void parse_record_binary(const char *record, int length);
+    bool write_batch();
     bool read_config(SGPropertyNode *root, vector<_serial_prot> &msg);
+    static void compile_format(_serial_prot &chunk);
     bool exitOnError;
     bool initOk;
 
@@ -0,0 +1,310 @@
+// ImageEncoder.cxx -- encode captured images on a pool of threads
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation; either version 2 of the
+// License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+#include "ImageEncoder.hxx"
+
+#include <algorithm>
+#include <ostream>
+#include <sstream>
+#include <streambuf>
+#include <thread>
+
+#include <osgDB/Registry>
+
+#include <simgear/debug/logstream.hxx>
+#include <simgear/threads/SGGuard.hxx>
+
+namespace flightgear {
+namespace http {
+
+///////////////////////////////////////////////////////////////////////////
+
+ImageEncoding::ImageEncoding()
+    : format("jpg"), jpegQuality(80), pngCompression(9), downscale(1)
+{
+}
+
+void ImageEncoding::clamp()
+{
+  jpegQuality = std::min(std::max(jpegQuality, 1), 100);
+  pngCompression = std::min(std::max(pngCompression, 0), 9);
+  downscale = std::min(std::max(downscale, 1), 16);
+}
+
+std::string ImageEncoding::options() const
+{
+  std::ostringstream s;
+  s << "JPEG_QUALITY " << jpegQuality << " PNG_COMPRESSION " << pngCompression;
+  return s.str();
+}
+
+bool downscaleImage(const osg::Image & image, int factor, osg::Image & target)
+{
+  if (image.getDataType() != GL_UNSIGNED_BYTE || image.isCompressed() || image.r() != 1)
+    return false;
+
+  unsigned components = osg::Image::computeNumComponents(image.getPixelFormat());
+  if (components < 1 || components > 4)
+    return false;
+
+  factor = std::max(factor, 1);
+  int s = std::max(image.s() / factor, 1);
+  int t = std::max(image.t() / factor, 1);
+  // keeps the storage when the size has not changed
+  target.allocateImage(s, t, 1, image.getPixelFormat(), GL_UNSIGNED_BYTE, 1);
+
+  for (int y = 0; y < t; ++y) {
+    int y0 = y * factor;
+    int y1 = std::min(y0 + factor, image.t());
+    unsigned char * dst = target.data(0, y);
+    for (int x = 0; x < s; ++x) {
+      int x0 = x * factor;
+      int x1 = std::min(x0 + factor, image.s());
+      unsigned sum[4] = { 0, 0, 0, 0 };
+      for (int row = y0; row < y1; ++row) {
+        const unsigned char * src = image.data(x0, row);
+        for (int col = x0; col < x1; ++col, src += components) {
+          for (unsigned c = 0; c < components; ++c)
+            sum[c] += src[c];
+        }
+      }
+      unsigned count = (x1 - x0) * (y1 - y0);
+      for (unsigned c = 0; c < components; ++c)
+        *dst++ = (unsigned char)((sum[c] + count / 2) / count);
+    }
+  }
+  target.dirty();
+  return true;
+}
+
+/**
+ * Lets the osgDB writers append to a string, whose storage is kept
+ */
+class StringAppendBuffer : public std::streambuf {
+public:
+  StringAppendBuffer( std::string & s ) : _s(s) {}
+
+protected:
+  virtual int_type overflow( int_type c )
+  {
+    if (!traits_type::eq_int_type(c, traits_type::eof()))
+      _s.push_back(traits_type::to_char_type(c));
+    return traits_type::not_eof(c);
+  }
+
+  virtual std::streamsize xsputn( const char * s, std::streamsize n )
+  {
+    _s.append(s, n);
+    return n;
+  }
+
+private:
+  std::string & _s;
+};
+
+///////////////////////////////////////////////////////////////////////////
+
+ImageEncoderQueue::ImageEncoderQueue( const ImageEncoding & encoding, size_t capacity )
+    : _encoding(encoding),
+      _capacity(std::max(capacity, size_t(1))),
+      _scheduled(false),
+      _closed(false),
+      _hasReady(false),
+      _encoded(0),
+      _dropped(0)
+{
+  _encoding.clamp();
+  _options = new osgDB::ReaderWriter::Options(_encoding.options());
+}
+
+ImageEncoderQueue::~ImageEncoderQueue()
+{
+}
+
+bool ImageEncoderQueue::take( std::string & buffer )
+{
+  SGGuard<SGMutex> g(_lock);
+  if (!_hasReady)
+    return false;
+  buffer.swap(_ready);
+  _hasReady = false;
+  return true;
+}
+
+void ImageEncoderQueue::close()
+{
+  SGGuard<SGMutex> g(_lock);
+  _closed = true;
+  _pending.clear();
+}
+
+unsigned ImageEncoderQueue::getEncoded() const
+{
+  SGGuard<SGMutex> g(_lock);
+  return _encoded;
+}
+
+unsigned ImageEncoderQueue::getDropped() const
+{
+  SGGuard<SGMutex> g(_lock);
+  return _dropped;
+}
+
+bool ImageEncoderQueue::push( osg::Image * image )
+{
+  SGGuard<SGMutex> g(_lock);
+  if (_closed)
+    return false;
+
+  while (_pending.size() >= _capacity) {
+    _pending.pop_front();
+    ++_dropped;
+  }
+  _pending.push_back(image);
+
+  if (_scheduled)
+    return false;
+  _scheduled = true;
+  return true;
+}
+
+bool ImageEncoderQueue::encodeNext()
+{
+  osg::ref_ptr<osg::Image> image;
+  std::string out;
+  {
+    SGGuard<SGMutex> g(_lock);
+    if (_closed || _pending.empty()) {
+      _scheduled = false;
+      return false;
+    }
+    image = _pending.front();
+    _pending.pop_front();
+    out.swap(_spare);
+  }
+
+  const osg::Image * source = image.get();
+  if (_encoding.downscale > 1) {
+    if (!_scaled.valid())
+      _scaled = new osg::Image;
+    if (downscaleImage(*image, _encoding.downscale, *_scaled))
+      source = _scaled.get();
+  }
+
+  bool ok = false;
+  osgDB::ReaderWriter * writer = osgDB::Registry::instance()->getReaderWriterForExtension(_encoding.format);
+  if (writer) {
+    out.clear();
+    StringAppendBuffer buffer(out);
+    std::ostream stream(&buffer);
+    ok = writer->writeImage(*source, stream, _options.get()).success();
+  }
+  if (!ok)
+    SG_LOG(SG_NETWORK, SG_DEBUG, "ImageEncoder: can't encode to " << _encoding.format);
+
+  SGGuard<SGMutex> g(_lock);
+  if (ok) {
+    if (_hasReady)
+      ++_dropped;
+    _ready.swap(out);
+    _hasReady = true;
+    ++_encoded;
+  }
+  _spare.swap(out);
+
+  if (_closed || _pending.empty()) {
+    _scheduled = false;
+    return false;
+  }
+  return true;
+}
+
+///////////////////////////////////////////////////////////////////////////
+
+class ImageEncoderPool::Worker : public SGThread {
+public:
+  Worker( ImageEncoderPool * pool ) : _pool(pool) {}
+
+protected:
+  virtual void run() { _pool->work(); }
+
+private:
+  ImageEncoderPool * _pool;
+};
+
+ImageEncoderPool::ImageEncoderPool( unsigned threads )
+    : _stopping(false)
+{
+  if (threads == 0)
+    threads = std::min(std::max(std::thread::hardware_concurrency() / 2, 1u), 4u);
+
+  SG_LOG(SG_NETWORK, SG_INFO, "ImageEncoderPool: starting " << threads << " encoder threads");
+  for (unsigned i = 0; i < threads; ++i) {
+    Worker * worker = new Worker(this);
+    worker->start();
+    _threads.push_back(worker);
+  }
+}
+
+ImageEncoderPool::~ImageEncoderPool()
+{
+  {
+    SGGuard<SGMutex> g(_lock);
+    _stopping = true;
+    _wake.broadcast();
+  }
+  for (size_t i = 0; i < _threads.size(); ++i) {
+    _threads[i]->join();
+    delete _threads[i];
+  }
+}
+
+void ImageEncoderPool::submit( ImageEncoderQueue * queue, osg::Image * image )
+{
+  if (queue->push(image))
+    schedule(queue);
+}
+
+void ImageEncoderPool::schedule( ImageEncoderQueue * queue )
+{
+  SGGuard<SGMutex> g(_lock);
+  if (_stopping)
+    return;
+  _scheduled.push_back(queue);
+  _wake.signal();
+}
+
+void ImageEncoderPool::work()
+{
+  for (;;) {
+    ImageEncoderQueue_ptr queue;
+    {
+      SGGuard<SGMutex> g(_lock);
+      while (!_stopping && _scheduled.empty())
+        _wake.wait(_lock);
+      if (_stopping)
+        return;
+      queue = _scheduled.front();
+      _scheduled.pop_front();
+    }
+    // back to the end of the line, so that all clients get their turn
+    if (queue->encodeNext())
+      schedule(queue);
+  }
+}
+
+} // namespace http
+} // namespace flightgear
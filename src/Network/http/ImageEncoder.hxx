@@ -0,0 +1,169 @@
+// ImageEncoder.hxx -- encode captured images on a pool of threads
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation; either version 2 of the
+// License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+#ifndef __FG_IMAGE_ENCODER_HXX
+#define __FG_IMAGE_ENCODER_HXX
+
+#include <deque>
+#include <string>
+#include <vector>
+
+#include <osg/Image>
+#include <osg/ref_ptr>
+#include <osgDB/ReaderWriter>
+
+#include <simgear/structure/SGReferenced.hxx>
+#include <simgear/structure/SGSharedPtr.hxx>
+#include <simgear/threads/SGThread.hxx>
+
+namespace flightgear {
+namespace http {
+
+/**
+ * How a client wants its images: the format is an osgDB extension, the
+ * quality and compression are passed to the jpeg and png writers.
+ */
+struct ImageEncoding {
+  ImageEncoding();
+
+  std::string format;
+  int jpegQuality;    ///< 1 to 100
+  int pngCompression; ///< 0 (fastest) to 9 (smallest)
+  int downscale;      ///< 1 for the full size, 2 for half the width and height...
+
+  /**
+   * Bring the settings into their valid ranges.
+   */
+  void clamp();
+
+  /**
+   * The option string for the osgDB writers
+   */
+  std::string options() const;
+};
+
+/**
+ * Shrink an 8 bit image by an integer factor, averaging each block of
+ * factor x factor pixels. The result is written to target, whose storage is
+ * reused when it already has the size.
+ * @return false if the image is not 8 bit per component
+ */
+bool downscaleImage(const osg::Image & image, int factor, osg::Image & target);
+
+class ImageEncoderPool;
+
+/**
+ * The images waiting to be encoded for one client, and the last one encoded.
+ *
+ * The queue holds at most capacity images: when a new one comes in, the
+ * oldest one waiting is dropped. An encoded image that has not been taken
+ * by the time the next one is ready is dropped, too. The images of a queue
+ * are encoded one at a time, in order.
+ *
+ * The encoded data goes through three buffers handed round between the
+ * encoder and the client, so a stream reuses their storage.
+ */
+class ImageEncoderQueue : public SGReferenced {
+public:
+  ImageEncoderQueue( const ImageEncoding & encoding, size_t capacity = 2 );
+  ~ImageEncoderQueue();
+
+  const ImageEncoding & getEncoding() const { return _encoding; }
+
+  /**
+   * Take the last encoded image, if there is one, swapping it with buffer.
+   * The old contents of buffer are given back to the encoder.
+   */
+  bool take( std::string & buffer );
+
+  /**
+   * Drop the waiting images and stop taking new ones
+   */
+  void close();
+
+  unsigned getEncoded() const;
+  unsigned getDropped() const;
+
+private:
+  friend class ImageEncoderPool;
+
+  // from ImageEncoderPool, return whether the queue has to be scheduled
+  bool push( osg::Image * image );
+  // from an encoder thread, return whether there is more to encode
+  bool encodeNext();
+
+  ImageEncoding _encoding;
+  osg::ref_ptr<osgDB::ReaderWriter::Options> _options;
+  size_t _capacity;
+
+  mutable SGMutex _lock;
+  std::deque<osg::ref_ptr<osg::Image> > _pending;
+  bool _scheduled; // waiting in the pool or being encoded
+  bool _closed;
+  bool _hasReady;
+  std::string _ready;
+  std::string _spare;
+  unsigned _encoded;
+  unsigned _dropped;
+
+  // only used by the thread encoding for this queue
+  osg::ref_ptr<osg::Image> _scaled;
+};
+
+typedef SGSharedPtr<ImageEncoderQueue> ImageEncoderQueue_ptr;
+
+/**
+ * Threads encoding the images of all queues, taking the queues in turn.
+ */
+class ImageEncoderPool : public SGReferenced {
+public:
+  /**
+   * @param threads number of encoder threads, 0 for about half the cores
+   */
+  explicit ImageEncoderPool( unsigned threads = 0 );
+
+  /**
+   * Stops the threads, images still waiting are not encoded
+   */
+  ~ImageEncoderPool();
+
+  /**
+   * Queue an image for encoding, may be called from any thread
+   */
+  void submit( ImageEncoderQueue * queue, osg::Image * image );
+
+  size_t getThreadCount() const { return _threads.size(); }
+
+private:
+  class Worker;
+  friend class Worker;
+
+  void schedule( ImageEncoderQueue * queue );
+  void work();
+
+  SGMutex _lock;
+  SGWaitCondition _wake;
+  std::deque<ImageEncoderQueue_ptr> _scheduled;
+  std::vector<Worker*> _threads;
+  bool _stopping;
+};
+
+typedef SGSharedPtr<ImageEncoderPool> ImageEncoderPool_ptr;
+
+} // namespace http
+} // namespace flightgear
+
+#endif //#define __FG_IMAGE_ENCODER_HXX
@@ -56,7 +56,11 @@ bool JsonUriHandler::handleRequest( const HTTPRequest & request, HTTPResponse &
       return true;
     } 
 
-    response.Content = JSON::toJsonString( indent, node, depth, timestamp ? fgGetDouble("/sim/time/elapsed-sec") : -1.0 );
+    // serialize straight into the response body, sized after the last one
+    response.Content.reserve( _lastContentSize );
+    JSONWriter writer( response.Content, indent );
+    JSON::write( writer, node, depth, timestamp ? fgGetDouble("/sim/time/elapsed-sec") : -1.0 );
+    _lastContentSize = response.Content.size();
 
     return true;
   }
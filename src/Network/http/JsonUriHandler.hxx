@@ -29,10 +29,12 @@ namespace http {
 
 class JsonUriHandler : public URIHandler {
 public:
-  JsonUriHandler( const char * uri = "/json/" ) : URIHandler( uri  ) {}
+  JsonUriHandler( const char * uri = "/json/" ) : URIHandler( uri  ), _lastContentSize(0) {}
   virtual bool handleRequest( const HTTPRequest & request, HTTPResponse & response, Connection * connection );
 private:
   SGPropertyNode_ptr getRequestedNode(const HTTPRequest & request);
+
+  size_t _lastContentSize;
 };
 
 } // namespace http
@@ -24,6 +24,9 @@
 #include <algorithm>
 #include <unordered_map>
 #include <set>
+#include <cstdint>
+#include <cstring>
+#include <cstdlib>
 
 #include <simgear/debug/logstream.hxx>
 #include <simgear/props/props.hxx>
@@ -35,6 +38,8 @@
 
 #include <3rdparty/cjson/cJSON.h>
 
+#include <zlib.h>
+
 namespace flightgear {
 namespace http {
 
@@ -42,6 +47,103 @@ using std::string;
 
     typedef unsigned int PropertyId; // connection local property id
 
+    /**
+     * Helper to build the frames of the binary mirror encoding. See
+     * MirrorPropertyTreeWebsocket.hxx for a description of the format.
+     */
+    class BinaryFrameWriter
+    {
+    public:
+        BinaryFrameWriter(std::vector<unsigned char>& buf) :
+            _buf(buf)
+        {
+        }
+
+        void putByte(unsigned char b)
+        {
+            _buf.push_back(b);
+        }
+
+        void putVarint(uint64_t v)
+        {
+            while (v >= 0x80) {
+                _buf.push_back(static_cast<unsigned char>(v | 0x80));
+                v >>= 7;
+            }
+            _buf.push_back(static_cast<unsigned char>(v));
+        }
+
+        void putSignedVarint(int64_t v)
+        {
+            // zig-zag encoding, so small negative values stay short
+            putVarint((static_cast<uint64_t>(v) << 1) ^ static_cast<uint64_t>(v >> 63));
+        }
+
+        void putString(const char* s)
+        {
+            const size_t len = strlen(s);
+            putVarint(len);
+            _buf.insert(_buf.end(), s, s + len);
+        }
+
+        void putFloat(float f)
+        {
+            uint32_t bits;
+            memcpy(&bits, &f, sizeof(bits));
+            for (int i = 0; i < 4; ++i) {
+                _buf.push_back(static_cast<unsigned char>(bits >> (i * 8)));
+            }
+        }
+
+        void putDouble(double d)
+        {
+            uint64_t bits;
+            memcpy(&bits, &d, sizeof(bits));
+            for (int i = 0; i < 8; ++i) {
+                _buf.push_back(static_cast<unsigned char>(bits >> (i * 8)));
+            }
+        }
+
+        void putValue(SGPropertyNode* prop)
+        {
+            if (!prop->hasValue()) {
+                putByte(MirrorPropertyTreeWebsocket::VALUE_NONE);
+                return;
+            }
+
+            switch (prop->getType()) {
+            case simgear::props::BOOL:
+                putByte(prop->getBoolValue() ? MirrorPropertyTreeWebsocket::VALUE_TRUE
+                                             : MirrorPropertyTreeWebsocket::VALUE_FALSE);
+                break;
+
+            case simgear::props::INT:
+            case simgear::props::LONG:
+                putByte(MirrorPropertyTreeWebsocket::VALUE_INT);
+                putSignedVarint(prop->getLongValue());
+                break;
+
+            case simgear::props::FLOAT:
+                putByte(MirrorPropertyTreeWebsocket::VALUE_FLOAT);
+                putFloat(prop->getFloatValue());
+                break;
+
+            case simgear::props::DOUBLE:
+                putByte(MirrorPropertyTreeWebsocket::VALUE_DOUBLE);
+                putDouble(prop->getDoubleValue());
+                break;
+
+            default:
+                putByte(MirrorPropertyTreeWebsocket::VALUE_STRING);
+                putString(prop->getStringValue());
+                break;
+            }
+        }
+
+    private:
+        std::vector<unsigned char>& _buf;
+    };
+
     struct PropertyValue
     {
         PropertyValue(SGPropertyNode* cur = nullptr) :
@@ -225,66 +327,140 @@ using std::string;
             return it->second;
         }
 
-        cJSON* makeJSONData()
+        void makeJSONData(JSONWriter& w)
         {
             SGTimeStamp st;
             st.stamp();
 
-            cJSON* result = cJSON_CreateObject();
+            w.beginObject();
 
             int newSize = newNodes.size();
             int changedSize = changedNodes.size();
             int removedSize = removedNodes.size();
 
             if (!newNodes.empty()) {
-                cJSON * newNodesArray = cJSON_CreateArray();
+                w.key("created");
+                w.beginArray();
 
                 for (auto prop : newNodes) {
                     changedNodes.erase(prop); // avoid duplicate send
-                    cJSON* newPropData = cJSON_CreateObject();
-                    cJSON_AddItemToObject(newPropData, "path", cJSON_CreateString(prop->getPath(true).c_str()));
-                    cJSON_AddItemToObject(newPropData, "type", cJSON_CreateString(JSON::getPropertyTypeString(prop->getType())));
-                    cJSON_AddItemToObject(newPropData, "index", cJSON_CreateNumber(prop->getIndex()));
-                    cJSON_AddItemToObject(newPropData, "position", cJSON_CreateNumber(prop->getPosition()));
-                    cJSON_AddItemToObject(newPropData, "id", cJSON_CreateNumber(idForProperty(prop)));
+                    w.beginObject();
+                    w.key("path");
+                    w.stringValue(prop->getPath(true));
+                    w.key("type");
+                    w.stringValue(JSON::getPropertyTypeString(prop->getType()));
+                    w.key("index");
+                    w.numberValue(prop->getIndex());
+                    w.key("position");
+                    w.numberValue(prop->getPosition());
+                    w.key("id");
+                    w.numberValue(idForProperty(prop));
                     if (prop->getType() != simgear::props::NONE) {
-                        cJSON_AddItemToObject(newPropData, "value", JSON::valueToJson(prop));
+                        w.key("value");
+                        JSON::writeValue(w, prop);
                     }
-                    cJSON_AddItemToArray(newNodesArray, newPropData);
+                    w.endObject();
                 }
 
                 newNodes.clear();
-                cJSON_AddItemToObject(result, "created", newNodesArray);
+                w.endArray();
             }
 
 
             if (!removedNodes.empty()) {
-                cJSON * deletedNodesArray = cJSON_CreateArray();
+                w.key("removed");
+                w.beginArray();
                 for (auto propId : removedNodes) {
-                    cJSON_AddItemToArray(deletedNodesArray, cJSON_CreateNumber(propId));
+                    w.numberValue(propId);
                 }
-                cJSON_AddItemToObject(result, "removed", deletedNodesArray);
+                w.endArray();
                 removedNodes.clear();
             }
 
             if (!changedNodes.empty()) {
-                cJSON * changedNodesArray = cJSON_CreateArray();
+                w.key("changed");
+                w.beginArray();
 
                 for (auto prop : changedNodes) {
-                    cJSON* propData = cJSON_CreateArray();
-                    cJSON_AddItemToArray(propData, cJSON_CreateNumber(idForProperty(prop)));
-                    cJSON_AddItemToArray(propData, JSON::valueToJson(prop));
-                    cJSON_AddItemToArray(changedNodesArray, propData);
+                    w.beginArray();
+                    w.numberValue(idForProperty(prop));
+                    JSON::writeValue(w, prop);
+                    w.endArray();
                 }
 
                 changedNodes.clear();
-                cJSON_AddItemToObject(result, "changed", changedNodesArray);
+                w.endArray();
             }
 
+            w.endObject();
+
             SG_LOG(SG_NETWORK, SG_INFO, "making JSON data took:" << st.elapsedMSec() << " for " << newSize << "/" << changedSize << "/" << removedSize);
             recentlyRemoved.clear();
+        }
+
+        /**
+         * Encode the pending changes using the binary format, appending
+         * the payload (without the frame header) to buf.
+         */
+        void makeBinaryData(std::vector<unsigned char>& buf)
+        {
+            BinaryFrameWriter w(buf);
+
+            if (!newNodes.empty()) {
+                std::vector<std::pair<PropertyId, SGPropertyNode*> > created;
+                created.reserve(newNodes.size());
+                for (auto prop : newNodes) {
+                    changedNodes.erase(prop); // avoid duplicate send
+                    created.push_back(std::make_pair(idForProperty(prop), prop));
+                }
+                newNodes.clear();
+                std::sort(created.begin(), created.end());
+
+                w.putByte(MirrorPropertyTreeWebsocket::BLOCK_CREATED);
+                w.putVarint(created.size());
+                PropertyId prevId = 0;
+                for (const auto& c : created) {
+                    SGPropertyNode* prop = c.second;
+                    w.putVarint(c.first - prevId);
+                    prevId = c.first;
+                    w.putString(prop->getPath(true).c_str());
+                    w.putVarint(prop->getPosition());
+                    w.putValue(prop);
+                }
+            }
+
+            if (!removedNodes.empty()) {
+                // std::set is ordered, so the deltas are always positive
+                w.putByte(MirrorPropertyTreeWebsocket::BLOCK_REMOVED);
+                w.putVarint(removedNodes.size());
+                PropertyId prevId = 0;
+                for (auto propId : removedNodes) {
+                    w.putVarint(propId - prevId);
+                    prevId = propId;
+                }
+                removedNodes.clear();
+            }
 
-            return result;
+            if (!changedNodes.empty()) {
+                std::vector<std::pair<PropertyId, SGPropertyNode*> > changed;
+                changed.reserve(changedNodes.size());
+                for (auto prop : changedNodes) {
+                    changed.push_back(std::make_pair(idForProperty(prop), prop));
+                }
+                changedNodes.clear();
+                std::sort(changed.begin(), changed.end());
+
+                w.putByte(MirrorPropertyTreeWebsocket::BLOCK_CHANGED);
+                w.putVarint(changed.size());
+                PropertyId prevId = 0;
+                for (const auto& c : changed) {
+                    w.putVarint(c.first - prevId);
+                    prevId = c.first;
+                    w.putValue(c.second);
+                }
+            }
+
+            recentlyRemoved.clear();
         }
 
         bool haveChangesToSend() const
@@ -357,10 +533,22 @@ static void handleExecCommand(cJSON* json)
 }
 #endif
 
-MirrorPropertyTreeWebsocket::MirrorPropertyTreeWebsocket(const std::string& path) :
+MirrorPropertyTreeWebsocket::MirrorPropertyTreeWebsocket(const std::string& path,
+                                                         const HTTPRequest::StringMap& options) :
     _listener(new MirrorTreeListener),
-    _minSendInterval(100)
+    _minSendInterval(100),
+    _binary(options.get("encoding") == "binary"),
+    _compress(_binary && (options.get("compress") == "1"))
 {
+    const std::string interval = options.get("interval");
+    if (!interval.empty()) {
+        _minSendInterval = std::max(0, atoi(interval.c_str()));
+    }
+
+    SG_LOG(SG_NETWORK, SG_INFO, "MirrorPropertyTreeWebsocket: using "
+           << (_binary ? "binary" : "JSON") << " encoding"
+           << (_compress ? " with compression" : ""));
+
     _subtreeRoot = globals->get_props()->getNode(path, true);
     _subtreeRoot->addChangeListener(_listener.get());
     _listener->registerSubtree(_subtreeRoot);
@@ -453,11 +641,51 @@ void MirrorPropertyTreeWebsocket::poll(WebsocketWriter & writer)
     // okay, we will send now, update the send stamp
     _lastSendTime.stamp();
 
-    cJSON * json = _listener->makeJSONData();
-    char * jsonString = cJSON_PrintUnformatted( json );
-    writer.writeText( jsonString );
-    free( jsonString );
-    cJSON_Delete( json );
+    if (_binary) {
+        sendBinaryFrame(writer);
+        return;
+    }
+
+    _jsonBuffer.clear();
+    JSONWriter json(_jsonBuffer);
+    _listener->makeJSONData(json);
+    writer.writeText(_jsonBuffer);
+}
+
+void MirrorPropertyTreeWebsocket::sendBinaryFrame(WebsocketWriter& writer)
+{
+    _frameBuffer.clear();
+    _frameBuffer.push_back(BINARY_VERSION);
+    _frameBuffer.push_back(0); // flags, patched below
+    _listener->makeBinaryData(_frameBuffer);
+
+    const size_t payloadSize = _frameBuffer.size() - BINARY_HEADER_SIZE;
+    if (_compress && (payloadSize >= MIN_COMPRESS_SIZE)) {
+        uLongf compressedSize = compressBound(payloadSize);
+        _compressBuffer.resize(BINARY_HEADER_SIZE + 4 + compressedSize);
+
+        int result = compress2(_compressBuffer.data() + BINARY_HEADER_SIZE + 4,
+                               &compressedSize,
+                               _frameBuffer.data() + BINARY_HEADER_SIZE,
+                               payloadSize, Z_BEST_SPEED);
+
+        // only use the compressed data if it actually helps
+        if ((result == Z_OK) && (compressedSize + 4 < payloadSize)) {
+            _compressBuffer[0] = BINARY_VERSION;
+            _compressBuffer[1] = FLAG_COMPRESSED;
+            // uncompressed size as big-endian uint32, as expected by qUncompress
+            _compressBuffer[2] = static_cast<unsigned char>(payloadSize >> 24);
+            _compressBuffer[3] = static_cast<unsigned char>(payloadSize >> 16);
+            _compressBuffer[4] = static_cast<unsigned char>(payloadSize >> 8);
+            _compressBuffer[5] = static_cast<unsigned char>(payloadSize);
+            writer.writeBinary(reinterpret_cast<const char*>(_compressBuffer.data()),
+                               BINARY_HEADER_SIZE + 4 + compressedSize);
+            return;
+        }
+    }
+
+    writer.writeBinary(reinterpret_cast<const char*>(_frameBuffer.data()),
+                       _frameBuffer.size());
 }
 
 } // namespace http
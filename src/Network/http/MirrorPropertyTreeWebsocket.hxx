@@ -33,24 +33,83 @@ namespace flightgear {
 namespace http {
 
     class MirrorTreeListener;
-    
+
+/**
+ * Mirror a property sub-tree to a remote client.
+ *
+ * By default changes are sent as JSON text frames. A client may request the
+ * binary encoding by passing 'encoding=binary' in the query string of the
+ * websocket URI, optionally with 'compress=1'. A server which does not
+ * know about the binary encoding simply ignores the query and keeps
+ * sending text frames, so clients must accept both.
+ * 'interval=<msec>' overrides the minimum time between updates.
+ *
+ * Binary frames start with a two byte header: the format version and a
+ * flags byte. If FLAG_COMPRESSED is set, the remaining data is a big-endian
+ * uint32 of the uncompressed size followed by a zlib stream (the layout
+ * qUncompress expects). The payload is a sequence of blocks, each a block
+ * tag byte and a varint entry count:
+ *
+ *   BLOCK_CREATED: id-delta, path (varint length + UTF-8), position, value
+ *   BLOCK_REMOVED: id-delta
+ *   BLOCK_CHANGED: id-delta, value
+ *
+ * All integers are unsigned LEB128 varints. Within a block, entries are
+ * sorted by property id and each id is sent as the difference to the
+ * previous one (starting at zero). A value is a VALUE_* tag byte followed by
+ * a zig-zag varint (INT), a little-endian IEEE float or double, or a
+ * varint length plus UTF-8 bytes (STRING).
+ */
 class MirrorPropertyTreeWebsocket : public Websocket
 {
 public:
-    MirrorPropertyTreeWebsocket(const std::string& path);
+    MirrorPropertyTreeWebsocket(const std::string& path,
+                                const HTTPRequest::StringMap& options = HTTPRequest::StringMap());
   virtual ~MirrorPropertyTreeWebsocket();
 
   virtual void close();
   virtual void handleRequest(const HTTPRequest & request, WebsocketWriter & writer);
   virtual void poll(WebsocketWriter & writer);
 
+  enum {
+      BINARY_VERSION = 1,
+      BINARY_HEADER_SIZE = 2,
+      FLAG_COMPRESSED = 1 << 0,
+      MIN_COMPRESS_SIZE = 512
+  };
+
+  enum BlockTag {
+      BLOCK_CREATED = 1,
+      BLOCK_REMOVED = 2,
+      BLOCK_CHANGED = 3
+  };
+
+  enum ValueTag {
+      VALUE_NONE = 0,
+      VALUE_FALSE = 1,
+      VALUE_TRUE = 2,
+      VALUE_INT = 3,
+      VALUE_FLOAT = 4,
+      VALUE_DOUBLE = 5,
+      VALUE_STRING = 6
+  };
+
 private:
     friend class MirrorTreeListener;
 
+    void sendBinaryFrame(WebsocketWriter& writer);
+
     SGPropertyNode_ptr _subtreeRoot;
     std::unique_ptr<MirrorTreeListener> _listener;
     int _minSendInterval;
     SGTimeStamp _lastSendTime;
+
+    bool _binary;
+    bool _compress;
+    /// re-used between frames to avoid allocating on every update
+    std::vector<unsigned char> _frameBuffer;
+    std::vector<unsigned char> _compressBuffer;
+    std::string _jsonBuffer;
 };
 
 }
@@ -146,7 +146,10 @@ void PropertyChangeWebsocket::handleGetCommand(const string_list& nodes, Websock
       return;
     }
     
-    writer.writeText( JSON::toJsonString( false, n, 0, t ) );
+    _buffer.clear();
+    JSONWriter json( _buffer );
+    JSON::write( json, n, 0, t );
+    writer.writeText( _buffer );
   } // of nodes iteration
 }
   
@@ -223,9 +226,11 @@ void PropertyChangeWebsocket::poll(WebsocketWriter & writer)
 
     string newValue;
     if (_propertyChangeObserver->isChangedValue(node)) {
-      string out = JSON::toJsonString( false, node, 0, now );
-      SG_LOG(SG_NETWORK, SG_DEBUG, "PropertyChangeWebsocket::poll() new Value for " << node->getPath(true) << " '" << node->getStringValue() << "' #" << id << ": " << out );
-      writer.writeText( out );
+      _buffer.clear();
+      JSONWriter json( _buffer );
+      JSON::write( json, node, 0, now );
+      SG_LOG(SG_NETWORK, SG_DEBUG, "PropertyChangeWebsocket::poll() new Value for " << node->getPath(true) << " '" << node->getStringValue() << "' #" << id << ": " << _buffer );
+      writer.writeText( _buffer );
     }
   }
 }
@@ -53,6 +53,7 @@ private:
   WatchedNodesList _watchedNodes;
   double _minTriggerInterval;
   double _lastTrigger;
+  std::string _buffer; // re-used for every outgoing message
 };
 
 }
@@ -27,12 +27,10 @@
 #include <osgUtil/SceneView>
 #include <osgViewer/Viewer>
 
-#include <simgear/threads/SGQueue.hxx>
-#include <simgear/structure/Singleton.hxx>
 #include <Main/globals.hxx>
 #include <Viewer/renderer.hxx>
 
-#include <queue>
+#include <cstdlib>
 #include <boost/lexical_cast.hpp>
 
 using std::string;
@@ -52,89 +50,6 @@ public:
   }
 };
 
-class StringReadyListener {
-public:
-  virtual void stringReady(const std::string &) = 0;
-  virtual ~StringReadyListener()
-  {
-  }
-};
-
-struct ImageCompressionTask {
-  StringReadyListener * stringReadyListener;
-  string format;
-  osg::ref_ptr<osg::Image> image;
-
-  ImageCompressionTask()
-  {
-    stringReadyListener = NULL;
-  }
-
-  ImageCompressionTask(const ImageCompressionTask & other)
-  {
-    stringReadyListener = other.stringReadyListener;
-    format = other.format;
-    image = other.image;
-  }
-
-  ImageCompressionTask & operator =(const ImageCompressionTask & other)
-  {
-    stringReadyListener = other.stringReadyListener;
-    format = other.format;
-    image = other.image;
-    return *this;
-  }
-
-};
-
-class ImageCompressor: public OpenThreads::Thread {
-public:
-  ImageCompressor()
-  {
-  }
-  virtual void run();
-  void addTask(ImageCompressionTask & task);
-  private:
-  typedef SGBlockingQueue<ImageCompressionTask> TaskList;
-  TaskList _tasks;
-};
-
-typedef simgear::Singleton<ImageCompressor> ImageCompressorSingleton;
-
-void ImageCompressor::run()
-{
-  osg::ref_ptr<osgDB::ReaderWriter::Options> options = new osgDB::ReaderWriter::Options("JPEG_QUALITY 80 PNG_COMPRESSION 9");
-
-  SG_LOG(SG_NETWORK, SG_DEBUG, "ImageCompressor is running");
-  for (;;) {
-    ImageCompressionTask task = _tasks.pop();
-    SG_LOG(SG_NETWORK, SG_DEBUG, "ImageCompressor has an image");
-    if ( NULL != task.stringReadyListener) {
-      SG_LOG(SG_NETWORK, SG_DEBUG, "ImageCompressor checking for writer for " << task.format);
-      osgDB::ReaderWriter* writer = osgDB::Registry::instance()->getReaderWriterForExtension(task.format);
-      if (!writer)
-      continue;
-
-      SG_LOG(SG_NETWORK, SG_DEBUG, "ImageCompressor compressing to " << task.format);
-      std::stringstream outputStream;
-      osgDB::ReaderWriter::WriteResult wr;
-      wr = writer->writeImage(*task.image, outputStream, options);
-
-      if (wr.success()) {
-        SG_LOG(SG_NETWORK, SG_DEBUG, "ImageCompressor compressed to  " << task.format);
-        task.stringReadyListener->stringReady(outputStream.str());
-      }
-      SG_LOG(SG_NETWORK, SG_DEBUG, "ImageCompressor done for this image" << task.format);
-    }
-  }
-  SG_LOG(SG_NETWORK, SG_DEBUG, "ImageCompressor exiting");
-}
-
-void ImageCompressor::addTask(ImageCompressionTask & task)
-{
-  _tasks.push(task);
-}
-
 /**
  * Based on <a href="http://code.google.com/p/osgworks">osgworks</a> ScreenCapture.cpp
  *
@@ -201,13 +116,13 @@ private:
 
 ///////////////////////////////////////////////////////////////////////////
 
-class ScreenshotRequest: public ConnectionData, public ImageReadyListener, StringReadyListener {
+class ScreenshotRequest: public ConnectionData, public ImageReadyListener {
 public:
-  ScreenshotRequest(const string & window, const string & type, bool stream)
-      : _type(type), _stream(stream)
+  ScreenshotRequest(const string & window, ImageEncoderPool * encoders, const ImageEncoding & encoding, bool stream, bool mjpeg)
+      : _encoders(encoders), _queue(new ImageEncoderQueue(encoding)), _stream(stream), _mjpeg(mjpeg)
   {
-    if ( NULL == osgDB::Registry::instance()->getReaderWriterForExtension(_type))
-    throw sg_format_exception("Unsupported image type: " + type, type);
+    if ( NULL == osgDB::Registry::instance()->getReaderWriterForExtension(encoding.format))
+    throw sg_format_exception("Unsupported image type: " + encoding.format, encoding.format);
 
     osg::Camera * camera = findLastCamera(globals->get_renderer()->getViewer(), window);
     if ( NULL == camera)
@@ -229,16 +144,16 @@ public:
   virtual ~ScreenshotRequest()
   {
     _screenshotCallback->unsubscribe(this);
+    // the pool may still hold the queue, stop it from encoding for us
+    _queue->close();
+    SG_LOG(SG_NETWORK, SG_DEBUG, "ScreenshotRequest: " << _queue->getEncoded()
+           << " images encoded, " << _queue->getDropped() << " dropped");
   }
 
   virtual void imageReady(osg::ref_ptr<osg::Image> rawImage)
   {
     // called from a rendering thread, not from the main loop
-    ImageCompressionTask task;
-    task.image = rawImage;
-    task.format = _type;
-    task.stringReadyListener = this;
-    ImageCompressorSingleton::instance()->addTask(task);
+    _encoders->submit(_queue, rawImage.get());
   }
 
   void requestScreenshot()
@@ -246,25 +161,25 @@ public:
     _screenshotCallback->subscribe(this);
   }
 
-  mutable OpenThreads::Mutex _lock;
+  /**
+   * Called from the main loop: move the last encoded image to
+   * getScreenshot(), handing the buffer of the previous one back to the
+   * encoder.
+   */
+  bool takeScreenshot()
+  {
+    return _queue->take(_screenshot);
+  }
 
-  virtual void stringReady(const string & s)
+  const string & getScreenshot() const
   {
-    // called from the compressor thread
-    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_lock);
-    _compressedData = s;
+    return _screenshot;
   }
 
-  string getScreenshot()
+  // reused for the header of each part of a stream
+  string & getPartHeader()
   {
-    string reply;
-    {
-      // called from the main loop
-      OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_lock);
-      reply = _compressedData;
-      _compressedData.clear();
-    }
-    return reply;
+    return _partHeader;
   }
 
   osg::Camera* findLastCamera(osgViewer::ViewerBase * viewer, const string & windowName)
@@ -316,15 +231,23 @@ public:
     return _stream;
   }
 
+  bool isMJpeg() const
+  {
+    return _mjpeg;
+  }
+
   const string & getType() const
   {
-    return _type;
+    return _queue->getEncoding().format;
   }
 
 private:
-  string _type;
+  ImageEncoderPool_ptr _encoders;
+  ImageEncoderQueue_ptr _queue;
   bool _stream;
-  string _compressedData;
+  bool _mjpeg;
+  string _screenshot;
+  string _partHeader;
   ScreenshotCallback * _screenshotCallback;
 };
 
@@ -335,30 +258,43 @@ ScreenshotUriHandler::ScreenshotUriHandler(const char * uri)
 
 ScreenshotUriHandler::~ScreenshotUriHandler()
 {
-  ImageCompressorSingleton::instance()->cancel();
-  //ImageCompressorSingleton::instance()->join();
 }
 
 const static string KEY("ScreenshotUriHandler::ScreenshotRequest");
 #define BOUNDARY "--fgfs-screenshot-boundary"
+#define MJPEG_BOUNDARY "fgfs-mjpeg-boundary"
+
+static void getIntVariable(const HTTPRequest & request, const char * name, int & value)
+{
+  string s = request.RequestVariables.get(name);
+  if (false == s.empty()) value = atoi(s.c_str());
+}
 
 bool ScreenshotUriHandler::handleGetRequest(const HTTPRequest & request, HTTPResponse & response, Connection * connection)
 {
-  if (!ImageCompressorSingleton::instance()->isRunning())
-  ImageCompressorSingleton::instance()->start();
+  if (!_encoders.valid())
+  _encoders = new ImageEncoderPool;
+
+  // <uri>mjpeg is a jpeg stream for MJPEG viewers
+  bool mjpeg = request.Uri.substr(getUri().size()) == "mjpeg";
 
+  ImageEncoding encoding;
   string type = request.RequestVariables.get("type");
-  if (type.empty()) type = "jpg";
+  if (false == mjpeg && false == type.empty()) encoding.format = type;
+  getIntVariable(request, "quality", encoding.jpegQuality);
+  getIntVariable(request, "compression", encoding.pngCompression);
+  getIntVariable(request, "downscale", encoding.downscale);
+  encoding.clamp();
 
   //  string camera = request.RequestVariables.get("camera");
   string window = request.RequestVariables.get("window");
 
-  bool stream = (false == request.RequestVariables.get("stream").empty());
+  bool stream = mjpeg || (false == request.RequestVariables.get("stream").empty());
 
   SGSharedPtr<ScreenshotRequest> screenshotRequest;
   try {
-    SG_LOG(SG_NETWORK, SG_DEBUG, "new ScreenshotRequest("<<window<<","<<type<<"," << stream << ")");
-    screenshotRequest = new ScreenshotRequest(window, type, stream);
+    SG_LOG(SG_NETWORK, SG_DEBUG, "new ScreenshotRequest("<<window<<","<<encoding.format<<"," << stream << ")");
+    screenshotRequest = new ScreenshotRequest(window, _encoders, encoding, stream, mjpeg);
   }
   catch (sg_format_exception & ex)
   {
@@ -377,9 +313,12 @@ bool ScreenshotUriHandler::handleGetRequest(const HTTPRequest & request, HTTPRes
     return true;
   }
 
-  if (false == stream) {
-    response.Header["Content-Type"] = string("image/").append(type);
-    response.Header["Content-Disposition"] = string("inline; filename=\"fgfs-screen.").append(type).append("\"");
+  if (mjpeg) {
+    response.Header["Content-Type"] = string("multipart/x-mixed-replace; boundary=" MJPEG_BOUNDARY);
+    response.Header["Cache-Control"] = "no-cache";
+  } else if (false == stream) {
+    response.Header["Content-Type"] = string("image/").append(encoding.format);
+    response.Header["Content-Disposition"] = string("inline; filename=\"fgfs-screen.").append(encoding.format).append("\"");
   } else {
     response.Header["Content-Type"] = string("multipart/x-mixed-replace; boundary=" BOUNDARY);
 
@@ -396,30 +335,38 @@ bool ScreenshotUriHandler::poll(Connection * connection)
   ScreenshotRequest * screenshotRequest = dynamic_cast<ScreenshotRequest*>(data.get());
   if ( NULL == screenshotRequest) return true; // Should not happen, kill the connection
 
-  const string & screenshot = screenshotRequest->getScreenshot();
-  if (screenshot.empty()) {
+  if (false == screenshotRequest->takeScreenshot()) {
     SG_LOG(SG_NETWORK, SG_DEBUG, "No screenshot available.");
     return false; // not ready yet, call again.
   }
+  const string & screenshot = screenshotRequest->getScreenshot();
 
   SG_LOG(SG_NETWORK, SG_DEBUG, "Screenshot is ready, size=" << screenshot.size());
 
   if (screenshotRequest->isStream()) {
-    string s( BOUNDARY "\r\nContent-Type: image/");
-    s.append(screenshotRequest->getType()).append("\r\nContent-Length:");
+    // ask for the next one before sending this one
+    screenshotRequest->requestScreenshot();
+
+    string & s = screenshotRequest->getPartHeader();
+    if (screenshotRequest->isMJpeg()) {
+      s.assign("--" MJPEG_BOUNDARY "\r\nContent-Type: image/jpeg\r\nContent-Length: ");
+    } else {
+      s.assign(BOUNDARY "\r\nContent-Type: image/");
+      s.append(screenshotRequest->getType()).append("\r\nContent-Length:");
+    }
     s += boost::lexical_cast<string>(screenshot.size());
     s += "\r\n\r\n";
-    connection->write(s.c_str(), s.length());
-  }
-
-  connection->write(screenshot.data(), screenshot.size());
+    connection->write(s.data(), s.length());
+    connection->write(screenshot.data(), screenshot.size());
+    if (screenshotRequest->isMJpeg())
+      connection->write("\r\n", 2);
 
-  if (screenshotRequest->isStream()) {
-    screenshotRequest->requestScreenshot();
     // continue until user closes connection
     return false;
   }
 
+  connection->write(screenshot.data(), screenshot.size());
+
   // single screenshot, send terminating chunk
   connection->remove(KEY);
   connection->write("", 0);
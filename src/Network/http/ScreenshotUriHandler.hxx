@@ -22,6 +22,7 @@
 #define __FG_SCREENSHOT_URI_HANDLER_HXX
 
 #include "urihandler.hxx"
+#include "ImageEncoder.hxx"
 
 namespace flightgear {
 namespace http {
@@ -32,6 +33,10 @@ public:
   ~ScreenshotUriHandler();
   virtual bool handleGetRequest( const HTTPRequest & request, HTTPResponse & response, Connection * connection );
   virtual bool poll( Connection * connection );
+
+private:
+  // started with the first request
+  ImageEncoderPool_ptr _encoders;
 };
 
 } // namespace http
@@ -35,6 +35,12 @@
 #include <3rdparty/mongoose/mongoose.h>
 #include <3rdparty/cjson/cJSON.h>
 
+#include <simgear/threads/SGThread.hxx>
+#include <simgear/threads/SGGuard.hxx>
+#include <simgear/timing/timestamp.hxx>
+
+#include <algorithm>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -161,10 +167,20 @@ public:
 
 };
 
+class MongooseConnection;
+typedef SGSharedPtr<MongooseConnection> MongooseConnectionRef;
+
 /**
  * A FGHttpd implementation based on mongoose httpd
  *
  * Mongoose API is documented here: http://cesanta.com/docs/API.shtml
+ *
+ * By default, mongoose is polled from a dedicated network thread, so
+ * accepting connections, parsing requests, serving static files and sending
+ * responses happens off the main loop. URI handlers and websockets use the
+ * property tree and other simulation state, so they are run from update()
+ * on the main loop, within a per-frame time budget. Output they produce is
+ * buffered in the connection and sent by the network thread.
  */
 class MongooseHttpd: public FGHttpd {
 public:
@@ -201,7 +217,7 @@ public:
 
   /**
    * overrride SGSubsystem::update()
-   * poll connections, check for changed properties
+   * run URI handlers and websockets for pending connections, check for changed properties
    */
   void update(double dt);
 
@@ -215,15 +231,34 @@ public:
     return _uriHandler.findHandler(uri);
   }
 
-  Websocket * newWebsocket(const string & uri);
+  Websocket * newWebsocket(const HTTPRequest & request);
+
+  /**
+   * Queue a connection for processing on the main loop.
+   * Called from the network thread.
+   */
+  void scheduleConnection(MongooseConnection * connection);
+
+  /**
+   * Record the time from receiving a request until its response was sent.
+   * Called from the network thread.
+   */
+  void requestCompleted(double latencyMSec);
 
 private:
+  class NetworkThread;
+
   int poll(struct mg_connection * connection);
   int auth(struct mg_connection * connection);
   int request(struct mg_connection * connection);
   int onConnect(struct mg_connection * connection);
   void close(struct mg_connection * connection);
 
+  void startNetworkThread();
+  void stopNetworkThread();
+  void processConnections(double budgetMSec);
+  void updateStatistics(double dt, double frameMSec);
+
   static int staticRequestHandler(struct mg_connection *, mg_event event);
 
   struct mg_server *_server;
@@ -233,35 +268,148 @@ private:
   URIHandlerMap _uriHandler;
 
   PropertyChangeObserver _propertyChangeObserver;
+
+  std::unique_ptr<NetworkThread> _networkThread;
+  double _maxHandlerMSec;
+
+  SGMutex _scheduledLock;
+  std::vector<MongooseConnectionRef> _scheduledConnections; // guarded by _scheduledLock
+  std::vector<MongooseConnectionRef> _activeConnections; // main loop only
+  int _deferredRequests;
+
+  SGMutex _statsLock;
+  int _completedRequests; // guarded by _statsLock
+  double _latencySumMSec; // guarded by _statsLock
+  double _latencyMaxMSec; // guarded by _statsLock
+
+  double _statsElapsed;
+  double _frameMSecSum;
+  int _frames;
+  SGPropertyNode_ptr _statsNode;
+};
+
+class MongooseHttpd::NetworkThread : public SGThread
+{
+public:
+  NetworkThread(MongooseHttpd * httpd, int pollIntervalMSec)
+      : _httpd(httpd), _pollIntervalMSec(pollIntervalMSec), _stop(false)
+  {
+  }
+
+  virtual void run()
+  {
+    SG_LOG(SG_NETWORK, SG_INFO, "httpd: network thread started");
+    while (!stopRequested()) {
+      mg_poll_server(_httpd->_server, _pollIntervalMSec);
+    }
+    SG_LOG(SG_NETWORK, SG_INFO, "httpd: network thread exiting");
+  }
+
+  void requestStop()
+  {
+    SGGuard<SGMutex> g(_lock);
+    _stop = true;
+  }
+
+private:
+  bool stopRequested() const
+  {
+    SGGuard<SGMutex> g(_lock);
+    return _stop;
+  }
+
+  MongooseHttpd * _httpd;
+  int _pollIntervalMSec;
+  mutable SGMutex _lock;
+  bool _stop;
 };
 
-class MongooseConnection: public Connection {
+/**
+ * State of a mongoose connection, shared between the network thread, which
+ * owns the mongoose side of the connection, and the main loop, which runs
+ * the URI handler or websocket.
+ *
+ * Methods taking a mg_connection are called on the network thread, process()
+ * and the Connection interface used by the URI handlers run on the main loop.
+ */
+class MongooseConnection: public Connection, public SGReferenced {
 public:
   MongooseConnection(MongooseHttpd * httpd)
-      : _httpd(httpd)
+      : _httpd(httpd), _scheduled(false), _closed(false)
   {
   }
   virtual ~MongooseConnection();
 
-  virtual void close(struct mg_connection * connection) = 0;
+  // both bases have get()/put() members, make all of them visible so
+  // SGSharedPtr finds the SGReferenced ones
+  using Connection::get;
+  using Connection::put;
+  using SGReferenced::get;
+  using SGReferenced::put;
+
   virtual int poll(struct mg_connection * connection) = 0;
   virtual int request(struct mg_connection * connection) = 0;
   virtual int onConnect(struct mg_connection * connection) {return 0;}
+
+  /**
+   * The connection was closed by mongoose. The main loop will release
+   * the handler or websocket the next time it processes this connection.
+   */
+  void close()
+  {
+    SGGuard<SGMutex> g(_lock);
+    _closed = true;
+    scheduleLocked();
+  }
+
+  /**
+   * Run the pending work of this connection, on the main loop
+   *
+   * @param allowNewRequests false if the time budget of this frame is used
+   * up, and no new requests should be started
+   * @return true if the connection needs to be processed again next frame
+   */
+  virtual bool process(bool allowNewRequests) = 0;
+
+  /**
+   * Buffer data written by a URI handler until the network thread sends it
+   */
   virtual void write(const char * data, size_t len)
   {
-    if (_connection) mg_send_data(_connection, data, len);
+    SGGuard<SGMutex> g(_lock);
+    _outgoing.push_back(string(data, len));
   }
 
   static MongooseConnection * getConnection(MongooseHttpd * httpd, struct mg_connection * connection);
 
 protected:
-  void setConnection(struct mg_connection * connection)
+  /**
+   * Make sure the main loop processes this connection, _lock must be held
+   */
+  void scheduleLocked()
   {
-    _connection = connection;
+    if (_scheduled) return;
+    _scheduled = true;
+    _httpd->scheduleConnection(this);
+  }
+
+  /**
+   * Drop the connection from the main loop list unless it has more work to
+   * do, _lock must be held
+   */
+  bool keepScheduledLocked(bool hasWork)
+  {
+    if (hasWork && !_closed) return true;
+    _scheduled = false;
+    // a close or new request arriving from now on schedules us again
+    return false;
   }
-  MongooseHttpd * _httpd;
-  struct mg_connection * _connection;
 
+  MongooseHttpd * _httpd;
+  SGMutex _lock;
+  bool _scheduled; // in the main loop list, guarded by _lock
+  bool _closed; // guarded by _lock
+  string_list _outgoing; // guarded by _lock
 };
 
 MongooseConnection::~MongooseConnection()
@@ -271,52 +419,88 @@ MongooseConnection::~MongooseConnection()
 class RegularConnection: public MongooseConnection {
 public:
   RegularConnection(MongooseHttpd * httpd)
-      : MongooseConnection(httpd)
+      : MongooseConnection(httpd), _state(IDLE), _responseReady(false), _headerSent(false)
   {
   }
   virtual ~RegularConnection()
   {
   }
 
-  virtual void close(struct mg_connection * connection);
   virtual int poll(struct mg_connection * connection);
   virtual int request(struct mg_connection * connection);
+  virtual bool process(bool allowNewRequests);
 
 private:
+  enum State {
+    IDLE,     // no request on this connection
+    PENDING,  // waiting for the main loop to run the handler
+    POLLING,  // handler wants to be polled again
+    FINISHED  // handler done, waiting for the network thread to finish sending
+  };
+
+  // all guarded by _lock
+  State _state;
   SGSharedPtr<URIHandler> _handler;
+  HTTPRequest _request;
+  HTTPResponse _response;
+  bool _responseReady;
+  bool _headerSent;
+  SGTimeStamp _requestTime;
 };
 
 class WebsocketConnection: public MongooseConnection {
 public:
   WebsocketConnection(MongooseHttpd * httpd)
-      : MongooseConnection(httpd), _websocket(NULL)
+      : MongooseConnection(httpd), _websocket(NULL), _connectPending(false), _failed(false)
   {
   }
   virtual ~WebsocketConnection()
   {
     delete _websocket;
   }
-  virtual void close(struct mg_connection * connection);
   virtual int poll(struct mg_connection * connection);
   virtual int request(struct mg_connection * connection);
   virtual int onConnect(struct mg_connection * connection);
+  virtual bool process(bool allowNewRequests);
 
 private:
-  class MongooseWebsocketWriter: public WebsocketWriter {
+  struct Frame {
+    int opcode;
+    string data;
+  };
+
+  /**
+   * Buffers frames written by the websocket on the main loop, they are sent
+   * by the network thread on its next poll.
+   */
+  class BufferedWebsocketWriter: public WebsocketWriter {
   public:
-    MongooseWebsocketWriter(struct mg_connection * connection)
+    BufferedWebsocketWriter(WebsocketConnection * connection)
         : _connection(connection)
     {
     }
 
     virtual int writeToWebsocket(int opcode, const char * data, size_t len)
     {
-      return mg_websocket_write(_connection, opcode, data, len);
+      SGGuard<SGMutex> g(_connection->_lock);
+      Frame frame;
+      frame.opcode = opcode;
+      frame.data.assign(data, len);
+      _connection->_outgoingFrames.push_back(frame);
+      return len;
     }
   private:
-    struct mg_connection * _connection;
+    WebsocketConnection * _connection;
   };
-  Websocket * _websocket;
+
+  Websocket * _websocket; // main loop only
+
+  // guarded by _lock
+  HTTPRequest _connectRequest;
+  bool _connectPending;
+  bool _failed;
+  vector<HTTPRequest> _incoming;
+  vector<Frame> _outgoingFrames;
 };
 
 MongooseConnection * MongooseConnection::getConnection(MongooseHttpd * httpd, struct mg_connection * connection)
@@ -326,126 +510,233 @@ MongooseConnection * MongooseConnection::getConnection(MongooseHttpd * httpd, st
   if (connection->is_websocket) c = new WebsocketConnection(httpd);
   else c = new RegularConnection(httpd);
 
+  // reference held by mongoose, released in MongooseHttpd::close()
+  SGReferenced::get(c);
   connection->connection_param = c;
   return c;
 }
 
 int RegularConnection::request(struct mg_connection * connection)
 {
-  setConnection(connection);
   MongooseHTTPRequest request(connection);
   SG_LOG(SG_NETWORK, SG_INFO, "RegularConnection::request for " << request.Uri);
 
   // find a handler for the uri and remember it for possible polls on this connection
-  _handler = _httpd->findHandler(request.Uri);
-  if (false == _handler.valid()) {
+  SGSharedPtr<URIHandler> handler = _httpd->findHandler(request.Uri);
+  if (false == handler.valid()) {
     // uri not registered - pass false to indicate we have not processed the request
     return MG_FALSE;
   }
 
-  // We handle this URI, prepare the response
-  HTTPResponse response;
-  response.Header["Server"] = "FlightGear/" FLIGHTGEAR_VERSION " Mongoose/" MONGOOSE_VERSION;
-  response.Header["Connection"] = "keep-alive";
-  response.Header["Cache-Control"] = "no-cache";
-  {
-    char buf[64];
-    time_t now = time(NULL);
-    strftime(buf, sizeof(buf), "%a, %d %b %Y %H:%M:%S GMT", gmtime(&now));
-    response.Header["Date"] = buf;
-  }
-
-  // hand the request over to the handler, returns true if request is finished, 
-  // false the handler wants to get polled again (calling handlePoll() next time)
-  bool done = _handler->handleRequest(request, response, this);
-  // fill in the response header
-  mg_send_status(connection, response.StatusCode);
-  for (HTTPResponse::Header_t::const_iterator it = response.Header.begin(); it != response.Header.end(); ++it) {
-    const string name = it->first;
-    const string value = it->second;
-    if (name.empty() || value.empty()) continue;
-    mg_send_header(connection, name.c_str(), value.c_str());
-  }
-  if (done || false == response.Content.empty()) {
-    SG_LOG(SG_NETWORK, SG_INFO,
-        "RegularConnection::request() responding " << response.Content.length() << " Bytes, done=" << done);
-    mg_send_data(connection, response.Content.c_str(), response.Content.length());
-  }
-  return done ? MG_TRUE : MG_MORE;
+  // hand the request over to the main loop, the response is sent from poll()
+  SGGuard<SGMutex> g(_lock);
+  _handler = handler;
+  _request = request;
+  _state = PENDING;
+  _responseReady = false;
+  _headerSent = false;
+  _requestTime.stamp();
+  scheduleLocked();
+  return MG_MORE;
 }
 
-int RegularConnection::poll(struct mg_connection * connection)
+bool RegularConnection::process(bool allowNewRequests)
 {
-  setConnection(connection);
-  if (false == _handler.valid()) return MG_FALSE;
-  // only return MG_TRUE if we handle this request
-  return _handler->poll(this) ? MG_TRUE : MG_MORE;
-}
+  State state;
+  SGSharedPtr<URIHandler> handler;
+  {
+    SGGuard<SGMutex> g(_lock);
+    if (_closed) {
+      _handler.clear();
+      return keepScheduledLocked(false);
+    }
+    state = _state;
+    handler = _handler;
+  }
 
-void RegularConnection::close(struct mg_connection * connection)
-{
-  setConnection(connection);
-  // nothing to close
+  // _request is only modified by the network thread while IDLE, so it is
+  // safe to use without holding the lock while the handler runs
+  if (state == PENDING) {
+    if (!allowNewRequests) return true; // out of time, try again next frame
+
+    // We handle this URI, prepare the response
+    HTTPResponse response;
+    response.Header["Server"] = "FlightGear/" FLIGHTGEAR_VERSION " Mongoose/" MONGOOSE_VERSION;
+    response.Header["Connection"] = "keep-alive";
+    response.Header["Cache-Control"] = "no-cache";
+    {
+      char buf[64];
+      time_t now = time(NULL);
+      strftime(buf, sizeof(buf), "%a, %d %b %Y %H:%M:%S GMT", gmtime(&now));
+      response.Header["Date"] = buf;
+    }
+
+    // hand the request over to the handler, returns true if request is finished,
+    // false the handler wants to get polled again (calling handlePoll() next time)
+    bool done = handler->handleRequest(_request, response, this);
+
+    SGGuard<SGMutex> g(_lock);
+    // swap rather than copy, the content can be large
+    _response.StatusCode = response.StatusCode;
+    _response.Header.swap(response.Header);
+    _response.Content.swap(response.Content);
+    _responseReady = true;
+    _state = done ? FINISHED : POLLING;
+    return keepScheduledLocked(!done);
+  }
+
+  if (state == POLLING) {
+    bool done = handler->poll(this);
+    SGGuard<SGMutex> g(_lock);
+    if (done) _state = FINISHED;
+    return keepScheduledLocked(!done);
+  }
+
+  SGGuard<SGMutex> g(_lock);
+  return keepScheduledLocked(false);
 }
 
-void WebsocketConnection::close(struct mg_connection * connection)
+int RegularConnection::poll(struct mg_connection * connection)
 {
-  setConnection(connection);
-  if ( NULL != _websocket) _websocket->close();
-  delete _websocket;
-  _websocket = NULL;
+  SGGuard<SGMutex> g(_lock);
+  if (_state == IDLE) return MG_FALSE;
+
+  if (_responseReady && !_headerSent) {
+    // fill in the response header
+    mg_send_status(connection, _response.StatusCode);
+    for (HTTPResponse::Header_t::const_iterator it = _response.Header.begin(); it != _response.Header.end(); ++it) {
+      const string name = it->first;
+      const string value = it->second;
+      if (name.empty() || value.empty()) continue;
+      mg_send_header(connection, name.c_str(), value.c_str());
+    }
+    if (_state == FINISHED || false == _response.Content.empty()) {
+      SG_LOG(SG_NETWORK, SG_INFO,
+          "RegularConnection::poll() responding " << _response.Content.length() << " Bytes, done=" << (_state == FINISHED));
+      mg_send_data(connection, _response.Content.c_str(), _response.Content.length());
+    }
+    _response.Content.clear();
+    _headerSent = true;
+    _httpd->requestCompleted(_requestTime.elapsedMSec());
+  }
+
+  if (!_headerSent) return MG_MORE;
+
+  for (string_list::const_iterator it = _outgoing.begin(); it != _outgoing.end(); ++it) {
+    mg_send_data(connection, it->c_str(), it->length());
+  }
+  _outgoing.clear();
+
+  if (_state != FINISHED) return MG_MORE;
+
+  // only return MG_TRUE if we handle this request
+  _state = IDLE;
+  _handler.clear();
+  return MG_TRUE;
 }
 
 int WebsocketConnection::poll(struct mg_connection * connection)
 {
-  setConnection(connection);
-  // we get polled before the first request came in but we know 
+  // we get polled before the first request came in but we know
   // nothing about how to handle that before we know the URI.
-  // so simply ignore that poll
-  if ( NULL != _websocket) {
-    MongooseWebsocketWriter writer(connection);
-    _websocket->poll(writer);
+  // so simply send whatever the main loop produced since the last poll
+  SGGuard<SGMutex> g(_lock);
+  for (vector<Frame>::const_iterator it = _outgoingFrames.begin(); it != _outgoingFrames.end(); ++it) {
+    mg_websocket_write(connection, it->opcode, it->data.c_str(), it->data.length());
   }
+  _outgoingFrames.clear();
   return MG_MORE;
 }
 
 int WebsocketConnection::onConnect(struct mg_connection * connection)
 {
-  setConnection(connection);
   MongooseHTTPRequest request(connection);
   SG_LOG(SG_NETWORK, SG_INFO, "WebsocketConnection::connect for " << request.Uri);
-  if ( NULL == _websocket) _websocket = _httpd->newWebsocket(request.Uri);
-  if ( NULL == _websocket) {
-    SG_LOG(SG_NETWORK, SG_WARN, "httpd: unhandled websocket uri: " << request.Uri);
-    return 0;
-  }
 
+  // the websocket itself is created on the main loop
+  SGGuard<SGMutex> g(_lock);
+  _connectRequest = request;
+  _connectPending = true;
+  scheduleLocked();
   return 0;
 }
 
 int WebsocketConnection::request(struct mg_connection * connection)
 {
-  setConnection(connection);
   MongooseHTTPRequest request(connection);
   SG_LOG(SG_NETWORK, SG_INFO, "WebsocketConnection::request for " << request.Uri);
 
-  if ( NULL == _websocket) {
+  SGGuard<SGMutex> g(_lock);
+  if (_failed) {
     SG_LOG(SG_NETWORK, SG_ALERT, "httpd: unhandled websocket uri: " << request.Uri);
     return MG_TRUE; // close connection - good bye
   }
 
-  MongooseWebsocketWriter writer(connection);
-  _websocket->handleRequest(request, writer);
+  _incoming.push_back(request);
+  scheduleLocked();
   return MG_MORE;
 }
 
+bool WebsocketConnection::process(bool allowNewRequests)
+{
+  HTTPRequest connectRequest;
+  bool connect;
+  bool closed;
+  {
+    SGGuard<SGMutex> g(_lock);
+    connect = _connectPending;
+    _connectPending = false;
+    if (connect) connectRequest = _connectRequest;
+    closed = _closed;
+  }
+
+  if (closed) {
+    if ( NULL != _websocket) _websocket->close();
+    delete _websocket;
+    _websocket = NULL;
+
+    SGGuard<SGMutex> g(_lock);
+    return keepScheduledLocked(false);
+  }
+
+  if (connect && NULL == _websocket) {
+    _websocket = _httpd->newWebsocket(connectRequest);
+    if ( NULL == _websocket) {
+      SG_LOG(SG_NETWORK, SG_WARN, "httpd: unhandled websocket uri: " << connectRequest.Uri);
+      SGGuard<SGMutex> g(_lock);
+      _failed = true;
+      return keepScheduledLocked(false);
+    }
+  }
+
+  if ( NULL == _websocket) return true; // still waiting for the connect
+
+  vector<HTTPRequest> incoming;
+  {
+    SGGuard<SGMutex> g(_lock);
+    incoming.swap(_incoming);
+  }
+
+  BufferedWebsocketWriter writer(this);
+  for (vector<HTTPRequest>::const_iterator it = incoming.begin(); it != incoming.end(); ++it) {
+    _websocket->handleRequest(*it, writer);
+  }
+  _websocket->poll(writer);
+
+  // open websockets are polled every frame
+  return true;
+}
+
 MongooseHttpd::MongooseHttpd(SGPropertyNode_ptr configNode)
-    : _server(NULL), _configNode(configNode)
+    : _server(NULL), _configNode(configNode), _maxHandlerMSec(5.0), _deferredRequests(0),
+    _completedRequests(0), _latencySumMSec(0.0), _latencyMaxMSec(0.0),
+    _statsElapsed(0.0), _frameMSecSum(0.0), _frames(0)
 {
 }
 
 MongooseHttpd::~MongooseHttpd()
 {
+  stopNetworkThread();
   mg_destroy_server(&_server);
 }
 
@@ -548,6 +839,13 @@ void MongooseHttpd::init()
 
   }
 
+  _maxHandlerMSec = _configNode->getDoubleValue("options/max-handler-time-ms", _maxHandlerMSec);
+  _statsNode = _configNode->getNode("stats", true);
+
+  if (_configNode->getBoolValue("options/threaded", true)) {
+    startNetworkThread();
+  }
+
   _configNode->setBoolValue("running",true);
 
 }
@@ -559,16 +857,120 @@ void MongooseHttpd::bind()
 void MongooseHttpd::unbind()
 {
   _configNode->setBoolValue("running",false);
+  stopNetworkThread();
   mg_destroy_server(&_server);
+
+  // release handlers and websockets of the connections closed above
+  processConnections(0.0);
+  _activeConnections.clear();
+
   _uriHandler.clear();
   _propertyChangeObserver.clear();
 }
 
 void MongooseHttpd::update(double dt)
 {
+  SGTimeStamp st;
+  st.stamp();
+
+  // without a network thread, requests are received and answered from here
+  if (!_networkThread) mg_poll_server(_server, 0);
+
   _propertyChangeObserver.check();
-  mg_poll_server(_server, 0);
+  processConnections(_maxHandlerMSec);
   _propertyChangeObserver.uncheck();
+
+  if (!_networkThread) mg_poll_server(_server, 0);
+
+  updateStatistics(dt, st.elapsedMSec());
+}
+
+void MongooseHttpd::startNetworkThread()
+{
+  int pollInterval = _configNode->getIntValue("options/poll-interval-ms", 5);
+  _networkThread.reset(new NetworkThread(this, pollInterval));
+  _networkThread->start();
+}
+
+void MongooseHttpd::stopNetworkThread()
+{
+  if (!_networkThread) return;
+  _networkThread->requestStop();
+  _networkThread->join();
+  _networkThread.reset();
+}
+
+void MongooseHttpd::scheduleConnection(MongooseConnection * connection)
+{
+  SGGuard<SGMutex> g(_scheduledLock);
+  _scheduledConnections.push_back(connection);
+}
+
+void MongooseHttpd::requestCompleted(double latencyMSec)
+{
+  SGGuard<SGMutex> g(_statsLock);
+  ++_completedRequests;
+  _latencySumMSec += latencyMSec;
+  _latencyMaxMSec = std::max(_latencyMaxMSec, latencyMSec);
+}
+
+void MongooseHttpd::processConnections(double budgetMSec)
+{
+  {
+    SGGuard<SGMutex> g(_scheduledLock);
+    _activeConnections.insert(_activeConnections.end(),
+        _scheduledConnections.begin(), _scheduledConnections.end());
+    _scheduledConnections.clear();
+  }
+
+  SGTimeStamp st;
+  st.stamp();
+
+  // process in arrival order, dropping connections without further work
+  size_t keep = 0;
+  _deferredRequests = 0;
+  for (size_t i = 0; i < _activeConnections.size(); ++i) {
+    const bool allowNewRequests = (budgetMSec <= 0.0) || (st.elapsedMSec() < budgetMSec);
+    if (!allowNewRequests) ++_deferredRequests;
+
+    if (_activeConnections[i]->process(allowNewRequests)) {
+      if (keep != i) _activeConnections[keep] = _activeConnections[i];
+      ++keep;
+    }
+  }
+  _activeConnections.resize(keep);
+}
+
+void MongooseHttpd::updateStatistics(double dt, double frameMSec)
+{
+  _frameMSecSum += frameMSec;
+  ++_frames;
+  _statsElapsed += dt;
+  if (_statsElapsed < 1.0) return;
+
+  int completed;
+  double latencySum, latencyMax;
+  {
+    SGGuard<SGMutex> g(_statsLock);
+    completed = _completedRequests;
+    latencySum = _latencySumMSec;
+    latencyMax = _latencyMaxMSec;
+    _completedRequests = 0;
+    _latencySumMSec = 0.0;
+    _latencyMaxMSec = 0.0;
+  }
+
+  _statsNode->setIntValue("requests", _statsNode->getIntValue("requests") + completed);
+  _statsNode->setDoubleValue("requests-per-second", completed / _statsElapsed);
+  _statsNode->setDoubleValue("latency-avg-ms", completed > 0 ? latencySum / completed : 0.0);
+  _statsNode->setDoubleValue("latency-max-ms", latencyMax);
+  _statsNode->setDoubleValue("main-loop-avg-ms", _frameMSecSum / _frames);
+  _statsNode->setIntValue("active-connections", _activeConnections.size());
+  _statsNode->setIntValue("deferred-requests", _deferredRequests);
+
+  _statsElapsed = 0.0;
+  _frameMSecSum = 0.0;
+  _frames = 0;
 }
 
 int MongooseHttpd::poll(struct mg_connection * connection)
@@ -601,17 +1003,21 @@ int MongooseHttpd::onConnect(struct mg_connection * connection)
 void MongooseHttpd::close(struct mg_connection * connection)
 {
   MongooseConnection * c = MongooseConnection::getConnection(this, connection);
-  c->close(connection);
-  delete c;
+  connection->connection_param = NULL;
+  // close() schedules the connection, so the main loop holds a reference
+  // and the final release happens there
+  c->close();
+  if (0 == SGReferenced::put(c)) delete c;
 }
-Websocket * MongooseHttpd::newWebsocket(const string & uri)
+Websocket * MongooseHttpd::newWebsocket(const HTTPRequest & request)
 {
+  const string & uri = request.Uri;
   if (uri.find("/PropertyListener") == 0) {
     SG_LOG(SG_NETWORK, SG_INFO, "new PropertyChangeWebsocket for: " << uri);
     return new PropertyChangeWebsocket(&_propertyChangeObserver);
   } else if (uri.find("/PropertyTreeMirror/") == 0) {
       SG_LOG(SG_NETWORK, SG_INFO, "new MirrorPropertyTreeWebsocket for: " << uri);
-    return new MirrorPropertyTreeWebsocket(uri.substr(20));
+    return new MirrorPropertyTreeWebsocket(uri.substr(20), request.RequestVariables);
   }
   return NULL;
 }
@@ -21,11 +21,201 @@
 #include "jsonprops.hxx"
 #include <simgear/misc/strutils.hxx>
 #include <simgear/math/SGMath.hxx>
+
+#include <cfloat>
+#include <climits>
+#include <cmath>
+#include <cstdio>
+#include <cstdint>
+
 namespace flightgear {
 namespace http {
 
 using std::string;
 
+JSONWriter::JSONWriter(string & buffer, bool indent) :
+  _buffer(buffer),
+  _indent(indent),
+  _afterKey(false)
+{
+  _empty.reserve(16);
+}
+
+void JSONWriter::appendTabs(int n)
+{
+  _buffer.append(n, '\t');
+}
+
+void JSONWriter::beginValue()
+{
+  // object members get their separator in key()
+  if (_afterKey || _empty.empty()) {
+    _afterKey = false;
+    return;
+  }
+
+  if (_empty.back()) {
+    _empty.back() = false;
+  } else {
+    _buffer += _indent ? ", " : ",";
+  }
+}
+
+void JSONWriter::beginObject()
+{
+  beginValue();
+  _buffer += _indent ? "{\n" : "{";
+  _empty.push_back(true);
+}
+
+void JSONWriter::endObject()
+{
+  const bool empty = _empty.back();
+  _empty.pop_back();
+  if (_indent) {
+    // cJSON closes empty objects one level further out
+    if (!empty) _buffer += '\n';
+    appendTabs(empty && !_empty.empty() ? _empty.size() - 1 : _empty.size());
+  }
+  _buffer += '}';
+}
+
+void JSONWriter::beginArray()
+{
+  beginValue();
+  _buffer += '[';
+  _empty.push_back(true);
+}
+
+void JSONWriter::endArray()
+{
+  _empty.pop_back();
+  _buffer += ']';
+}
+
+void JSONWriter::key(const char * name)
+{
+  if (_empty.back()) {
+    _empty.back() = false;
+  } else {
+    _buffer += _indent ? ",\n" : ",";
+  }
+  if (_indent) appendTabs(_empty.size());
+  appendString(name);
+  _buffer += _indent ? ":\t" : ":";
+  _afterKey = true;
+}
+
+void JSONWriter::nullValue()
+{
+  beginValue();
+  _buffer += "null";
+}
+
+void JSONWriter::boolValue(bool b)
+{
+  beginValue();
+  _buffer += b ? "true" : "false";
+}
+
+void JSONWriter::numberValue(double d)
+{
+  beginValue();
+  appendNumber(_buffer, d);
+}
+
+void JSONWriter::stringValue(const char * s)
+{
+  beginValue();
+  appendString(s);
+}
+
+void JSONWriter::appendString(const char * s)
+{
+  static const char hex[] = "0123456789abcdef";
+
+  _buffer += '"';
+  if (s) {
+    const char * run = s;
+    for (const char * p = s; *p; ++p) {
+      const unsigned char c = *p;
+      if (c > 31 && c != '"' && c != '\\') continue;
+
+      // copy the unescaped run in one go
+      _buffer.append(run, p - run);
+      run = p + 1;
+      _buffer += '\\';
+      switch (c) {
+        case '\\': _buffer += '\\'; break;
+        case '"':  _buffer += '"'; break;
+        case '\b': _buffer += 'b'; break;
+        case '\f': _buffer += 'f'; break;
+        case '\n': _buffer += 'n'; break;
+        case '\r': _buffer += 'r'; break;
+        case '\t': _buffer += 't'; break;
+        default:
+          _buffer += "u00";
+          _buffer += hex[c >> 4];
+          _buffer += hex[c & 0xf];
+          break;
+      }
+    }
+    _buffer += run;
+  }
+  _buffer += '"';
+}
+
+static void appendUnsigned(string & buffer, uint64_t v, int minDigits = 1)
+{
+  char digits[24];
+  int n = 0;
+  do {
+    digits[n++] = static_cast<char>('0' + v % 10);
+    v /= 10;
+  } while (v || n < minDigits);
+
+  while (n) buffer += digits[--n];
+}
+
+void JSONWriter::appendNumber(string & buffer, double d)
+{
+  // same cases as print_number() in cJSON.c, but without going through
+  // sprintf for the common ones
+  if (d <= INT_MAX && d >= INT_MIN) {
+    const int i = static_cast<int>(d);
+    if (fabs(static_cast<double>(i) - d) <= DBL_EPSILON) {
+      if (i < 0) buffer += '-';
+      appendUnsigned(buffer, i < 0 ? -static_cast<int64_t>(i) : i);
+      return;
+    }
+  }
+
+  const double a = fabs(d);
+  char buf[64];
+  if (fabs(floor(d) - d) <= DBL_EPSILON && a < 1.0e60) {
+    snprintf(buf, sizeof(buf), "%.0f", d);
+  } else if (a < 1.0e-6 || a > 1.0e9) {
+    snprintf(buf, sizeof(buf), "%e", d);
+  } else {
+    // equivalent of "%f". Round the exact value of a * 1e6 the way printf
+    // does, using the rounding error of the product to settle near-ties.
+    const double p = a * 1.0e6;
+    const double err = fma(a, 1.0e6, -p);
+    const double ip = floor(p);
+    const double frac = p - ip;
+    uint64_t scaled = static_cast<uint64_t>(ip);
+    if (frac > 0.5 || (frac == 0.5 && (err > 0.0 || (err == 0.0 && (scaled & 1)))))
+      ++scaled;
+    if (d < 0) buffer += '-';
+    appendUnsigned(buffer, scaled / 1000000);
+    buffer += '.';
+    appendUnsigned(buffer, scaled % 1000000, 6);
+    return;
+  }
+
+  buffer += buf;
+}
+
 const char * JSON::getPropertyTypeString(simgear::props::Type type)
 {
   switch (type) {
@@ -130,6 +320,86 @@ cJSON * JSON::toJson(SGPropertyNode_ptr n, int depth, double timestamp )
   return json;
 }
 
+void JSON::writeValue(JSONWriter & writer, SGPropertyNode * n)
+{
+  if( !n->hasValue() ) {
+    writer.nullValue();
+    return;
+  }
+
+  switch( n->getType() ) {
+    case simgear::props::BOOL:
+      writer.boolValue(n->getBoolValue());
+      break;
+    case simgear::props::INT:
+    case simgear::props::LONG:
+    case simgear::props::FLOAT:
+    case simgear::props::DOUBLE: {
+      double val = n->getDoubleValue();
+      if( SGMiscd::isNaN(val) )
+        writer.nullValue();
+      else
+        writer.numberValue(val);
+      break;
+    }
+    default:
+      writer.stringValue(n->getStringValue());
+      break;
+  }
+}
+
+// path is the simplified path of n, children append to it and restore it
+// afterwards rather than calling getPath() for every node
+static void writeNode(JSONWriter & writer, SGPropertyNode * n, string & path, int depth, double timestamp)
+{
+  writer.beginObject();
+  writer.key("path");
+  writer.stringValue(path);
+  writer.key("name");
+  writer.stringValue(n->getName());
+  if( n->hasValue() ) {
+    writer.key("value");
+    JSON::writeValue(writer, n);
+  }
+  writer.key("type");
+  writer.stringValue(JSON::getPropertyTypeString(n->getType()));
+  writer.key("index");
+  writer.numberValue(n->getIndex());
+  if( timestamp >= 0.0 ) {
+    writer.key("ts");
+    writer.numberValue(timestamp);
+  }
+  const int nChildren = n->nChildren();
+  writer.key("nChildren");
+  writer.numberValue(nChildren);
+
+  if (depth > 0 && nChildren > 0) {
+    writer.key("children");
+    writer.beginArray();
+    const size_t pathLength = path.size();
+    for (int i = 0; i < nChildren; i++) {
+      SGPropertyNode * child = n->getChild(i);
+      path += '/';
+      path += child->getName();
+      if (child->getIndex() != 0) {
+        path += '[';
+        JSONWriter::appendNumber(path, child->getIndex());
+        path += ']';
+      }
+      writeNode(writer, child, path, depth - 1, timestamp);
+      path.resize(pathLength);
+    }
+    writer.endArray();
+  }
+  writer.endObject();
+}
+
+void JSON::write(JSONWriter & writer, SGPropertyNode * n, int depth, double timestamp )
+{
+  string path = n->getPath(true);
+  writeNode(writer, n, path, depth, timestamp);
+}
+
 void JSON::toProp(cJSON * json, SGPropertyNode_ptr base)
 {
   if (NULL == json) return;
@@ -202,11 +472,9 @@ void JSON::addChildrenToProp(cJSON * json, SGPropertyNode_ptr n)
 
 string JSON::toJsonString(bool indent, SGPropertyNode_ptr n, int depth, double timestamp )
 {
-  cJSON * json = toJson( n, depth, timestamp );
-  char * jsonString = indent ? cJSON_Print( json ) : cJSON_PrintUnformatted( json );
-  string reply(jsonString);
-  free( jsonString );
-  cJSON_Delete( json );
+  string reply;
+  JSONWriter writer( reply, indent );
+  write( writer, n, depth, timestamp );
   return reply;
 }
 
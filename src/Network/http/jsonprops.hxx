@@ -24,10 +24,52 @@
 #include <simgear/props/props.hxx>
 #include <3rdparty/cjson/cJSON.h>
 #include <string>
+#include <vector>
 
 namespace flightgear {
 namespace http {
 
+/**
+ * Streaming JSON writer which appends straight to a caller owned buffer,
+ * without building a cJSON tree first. The caller can keep the buffer
+ * around between documents so its capacity is reused.
+ * The output matches cJSON_Print (indent) and cJSON_PrintUnformatted.
+ */
+class JSONWriter {
+public:
+  JSONWriter(std::string & buffer, bool indent = false);
+
+  void beginObject();
+  void endObject();
+  void beginArray();
+  void endArray();
+
+  /// start an object member, must be followed by exactly one value
+  void key(const char * name);
+
+  void nullValue();
+  void boolValue(bool b);
+  void numberValue(double d);
+  void stringValue(const char * s);
+  void stringValue(const std::string & s) { stringValue(s.c_str()); }
+
+  std::string & buffer() { return _buffer; }
+
+  /// append a number formatted the way cJSON prints it
+  static void appendNumber(std::string & buffer, double d);
+
+private:
+  void beginValue();
+  void appendString(const char * s);
+  void appendTabs(int n);
+
+  std::string & _buffer;
+  bool _indent;
+  bool _afterKey;
+  /// one entry per open object or array, true until it has a member
+  std::vector<bool> _empty;
+};
+
 class JSON {
 public:
   static cJSON * toJson(SGPropertyNode_ptr n, int depth, double timestamp = -1.0 );
@@ -36,6 +78,10 @@ public:
   static const char * getPropertyTypeString(simgear::props::Type type);
   static cJSON * valueToJson(SGPropertyNode_ptr n);
 
+  /// streaming equivalents of toJson() and valueToJson()
+  static void write(JSONWriter & writer, SGPropertyNode * n, int depth, double timestamp = -1.0 );
+  static void writeValue(JSONWriter & writer, SGPropertyNode * n);
+
   static void toProp(cJSON * json, SGPropertyNode_ptr base);
   static void addChildrenToProp(cJSON * json, SGPropertyNode_ptr base);
 };
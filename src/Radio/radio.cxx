@@ -172,6 +172,20 @@ void FGRadioTransmission::receiveATC(SGGeod tx_pos, double freq, string text, in
 		}
 		else if ( _propagation_model == 2 ) {	// Use ITM propagation model
 			
+			// leave ITM itself to the propagation thread, it shows the message later
+			FGRadioPropagation *propagation = globals->get_subsystem<FGRadioPropagation>();
+			if (propagation && _root_node->getBoolValue("threaded", true)) {
+				ITMPath path;
+				double signal = -1.0;
+				if (ITM_prepare(tx_pos, freq, ground_to_air, path, signal)) {
+					propagation->queueATC(*this, path, text);
+				}
+				else if (signal > 0.0) {
+					fgSetString("/sim/messages/atc", text.c_str());
+				}
+				return;
+			}
+			
 			double signal = ITM_calculate_attenuation(tx_pos, freq, ground_to_air);
 			if (signal <= 0.0) {
 				return;
@@ -210,31 +224,27 @@ void FGRadioTransmission::receiveATC(SGGeod tx_pos, double freq, string text, in
 
 double FGRadioTransmission::ITM_calculate_attenuation(SGGeod pos, double freq, int transmission_type) {
 
+	ITMPath path;
+	double signal = -1.0;
+	if (!ITM_prepare(pos, freq, transmission_type, path, signal))
+		return signal;
+	ITM_run(path);
+	return ITM_finish(path);
+}
+
+
+bool FGRadioTransmission::ITM_prepare(SGGeod pos, double freq, int transmission_type, ITMPath &path, double &signal) {
+
 	
-	if((freq < 40.0) || (freq > 20000.0))	// frequency out of recommended range 
-		return -1;
-	/** ITM default parameters 
-		TODO: take them from tile materials (especially for sea)?
-	**/
-	double eps_dielect=15.0;
-	double sgm_conductivity = 0.005;
-	double eno = 301.0;
+	if((freq < 40.0) || (freq > 20000.0)) {	// frequency out of recommended range 
+		signal = -1;
+		return false;
+	}
 	double frq_mhz = freq;
-	
-	int radio_climate = 5;		// continental temperate
-	int pol= _polarization;	
-	double conf = 0.90;	// 90% of situations and time, take into account speed
-	double rel = 0.90;	
 	double dbloss;
-	char strmode[150];
-	int p_mode = 0; // propgation mode selector: 0 LOS, 1 diffraction dominant, 2 troposcatter
-	double horizons[2];
-	int errnum;
 	
-	double clutter_loss = 0.0; 	// loss due to vegetation and urban
 	double tx_pow = _transmitter_power;
 	double ant_gain = _rx_antenna_gain + _tx_antenna_gain;
-	double signal = 0.0;
 	
 	
 	double link_budget = tx_pow - _receiver_sensitivity - _rx_line_losses - _tx_line_losses + ant_gain;	
@@ -255,7 +265,6 @@ double FGRadioTransmission::ITM_calculate_attenuation(SGGeod pos, double freq, i
 	
 	SGGeod own_pos = SGGeod::fromDegM( own_lon, own_lat, own_alt );
 	SGGeod max_own_pos = SGGeod::fromDegM( own_lon, own_lat, SG_MAX_ELEVATION_M );
-	SGGeoc center = SGGeoc::fromGeod( max_own_pos );
 	SGGeoc own_pos_c = SGGeoc::fromGeod( own_pos );
 	
 	
@@ -270,14 +279,14 @@ double FGRadioTransmission::ITM_calculate_attenuation(SGGeod pos, double freq, i
 	SGGeoc sender_pos_c = SGGeoc::fromGeod( sender_pos );
 	
 	
-	double point_distance= _terrain_sampling_distance; 
 	double course = SGGeodesy::courseRad(own_pos_c, sender_pos_c);
 	double reverse_course = SGGeodesy::courseRad(sender_pos_c, own_pos_c);
 	double distance_m = SGGeodesy::distanceM(own_pos, sender_pos);
-	double probe_distance = 0.0;
 	/** If distance larger than this value (300 km), assume reception imposssible to spare CPU cycles */
-	if (distance_m > 300000)
-		return -1.0;
+	if (distance_m > 300000) {
+		signal = -1.0;
+		return false;
+	}
 	/** If above 8000 meters, consider LOS mode and calculate free-space att to spare CPU cycles */
 	if (own_alt > 8000) {
 		dbloss = 20 * log10(distance_m) +20 * log10(frq_mhz) -27.55;
@@ -285,16 +294,9 @@ double FGRadioTransmission::ITM_calculate_attenuation(SGGeod pos, double freq, i
 			"ITM Free-space mode:: Link budget: " << link_budget << ", Attenuation: " << dbloss << " dBm, free-space attenuation");
 		//cerr << "ITM Free-space mode:: Link budget: " << link_budget << ", Attenuation: " << dbloss << " dBm, free-space attenuation" << endl;
 		signal = link_budget - dbloss;
-		return signal;
+		return false;
 	}
 	
-		
-	int max_points = (int)floor(distance_m / point_distance);
-	//double delta_last = fmod(distance_m, point_distance);
-	
-	deque<double> elevations;
-	deque<string*> materials;
-	
 
 	double elevation_under_pilot = 0.0;
 	if (scenery->get_elevation_m( max_own_pos, elevation_under_pilot, NULL )) {
@@ -318,119 +320,50 @@ double FGRadioTransmission::ITM_calculate_attenuation(SGGeod pos, double freq, i
 	_root_node->setDoubleValue("station[0]/tx-height", transmitter_height);
 	_root_node->setDoubleValue("station[0]/distance", distance_m / 1000);
 	
-	unsigned int e_size = (deque<unsigned>::size_type)max_points;
-	
-	while (elevations.size() <= e_size) {
-		probe_distance += point_distance;
-		SGGeod probe = SGGeod::fromGeoc(center.advanceRadM( course, probe_distance ));
-		const simgear::BVHMaterial *material = 0;
-		double elevation_m = 0.0;
-	
-		if (scenery->get_elevation_m( probe, elevation_m, &material )) {
-                        const SGMaterial *mat;
-                        mat = dynamic_cast<const SGMaterial*>(material);
-			if((transmission_type == 3) || (transmission_type == 4)) {
-				elevations.push_back(elevation_m);
-				if(mat) {
-					const std::vector<string> mat_names = mat->get_names();
-					string* name = new string(mat_names[0]);
-					materials.push_back(name);
-				}
-				else {
-					string* no_material = new string("None"); 
-					materials.push_back(no_material);
-				}
-			}
-			else {
-				 elevations.push_front(elevation_m);
-				 if(mat) {
-				 	 const std::vector<string> mat_names = mat->get_names();
-				 	 string* name = new string(mat_names[0]);
-				 	 materials.push_front(name);
-				}
-				else {
-					string* no_material = new string("None"); 
-					materials.push_front(no_material);
-				}
-			}
-		}
-		else {
-			if((transmission_type == 3) || (transmission_type == 4)) {
-				elevations.push_back(0.0);
-				string* no_material = new string("None"); 
-				materials.push_back(no_material);
-			}
-			else {
-				string* no_material = new string("None"); 
-				elevations.push_front(0.0);
-				materials.push_front(no_material);
-			}
-		}
-	}
-	if((transmission_type == 3) || (transmission_type == 4)) {
-		elevations.push_front(elevation_under_pilot);
-		//if (delta_last > (point_distance / 2) )			// only add last point if it's farther than half point_distance
-			elevations.push_back(elevation_under_sender);
-	}
-	else {
-		elevations.push_back(elevation_under_pilot);
-		//if (delta_last > (point_distance / 2) )
-			elevations.push_front(elevation_under_sender);
-	}
-	
-	
-	double num_points= (double)elevations.size();
-
-
-	elevations.push_front(point_distance);
-	elevations.push_front(num_points -1);
-
-	int size = elevations.size();
-        boost::scoped_array<double> itm_elev( new double[size] );
-
-	for(int i=0;i<size;i++) {
-		itm_elev[i]=elevations[i];
-	}
-	
-	if((transmission_type == 3) || (transmission_type == 4)) {
-		// the sender and receiver roles are switched
-		ITM::point_to_point(itm_elev.get(), receiver_height, transmitter_height,
-			eps_dielect, sgm_conductivity, eno, frq_mhz, radio_climate,
-			pol, conf, rel, dbloss, strmode, p_mode, horizons, errnum);
-		if( _root_node->getBoolValue( "use-clutter-attenuation", false ) )
-			calculate_clutter_loss(frq_mhz, itm_elev.get(), materials, receiver_height, transmitter_height, p_mode, horizons, clutter_loss);
+	/** the terrain in between comes from the profile cache, the scenery
+	*	is only queried under the two stations for each transmission
+	**/
+	FGRadioPropagation *propagation = globals->get_subsystem<FGRadioPropagation>();
+	static FGTerrainProfileCache *own_profiles = 0;
+	FGTerrainProfileCache *profiles = 0;
+	if (propagation) {
+		profiles = &propagation->profiles();
 	}
 	else {
-		ITM::point_to_point(itm_elev.get(), transmitter_height, receiver_height,
-			eps_dielect, sgm_conductivity, eno, frq_mhz, radio_climate,
-			pol, conf, rel, dbloss, strmode, p_mode, horizons, errnum);
-		if( _root_node->getBoolValue( "use-clutter-attenuation", false ) )
-			calculate_clutter_loss(frq_mhz, itm_elev.get(), materials, transmitter_height, receiver_height, p_mode, horizons, clutter_loss);
+		if (!own_profiles)
+			own_profiles = new FGTerrainProfileCache;
+		profiles = own_profiles;
 	}
 	
-	double pol_loss = 0.0;
+	path.profile = profiles->get(own_pos, sender_pos, _terrain_sampling_distance);
+	path.pilot_transmits = ((transmission_type == 3) || (transmission_type == 4));
+	path.elevation_under_pilot = elevation_under_pilot;
+	path.elevation_under_sender = elevation_under_sender;
+	path.transmitter_height = transmitter_height;
+	path.receiver_height = receiver_height;
+	path.frq_mhz = frq_mhz;
+	path.polarization = _polarization;
+	path.use_clutter = _root_node->getBoolValue( "use-clutter-attenuation", false );
+	path.link_budget = link_budget;
+	path.signal_strength = signal_strength;
+	path.tx_erp = tx_erp;
+	
+	path.pol_loss = 0.0;
 	// TODO: remove this check after we check a bit the axis calculations in this function
 	if (_polarization == 1) {
-		pol_loss = polarization_loss();
+		path.pol_loss = polarization_loss();
 	}
-	//SG_LOG(SG_GENERAL, SG_BULK,
-	//		"ITM:: Link budget: " << link_budget << ", Attenuation: " << dbloss << " dBm, " << strmode << ", Error: " << errnum);
-	//cerr << "ITM:: Link budget: " << link_budget << ", Attenuation: " << dbloss << " dBm, " << strmode << ", Error: " << errnum << endl;
-	_root_node->setDoubleValue("station[0]/link-budget", link_budget);
-	_root_node->setDoubleValue("station[0]/terrain-attenuation", dbloss);
-	_root_node->setStringValue("station[0]/prop-mode", strmode);
-	_root_node->setDoubleValue("station[0]/clutter-attenuation", clutter_loss);
-	_root_node->setDoubleValue("station[0]/polarization-attenuation", pol_loss);
-	//if (errnum == 4)	// if parameters are outside sane values for lrprop, bail out fast
-	//	return -1;
 	
 	// temporary, keep this antenna radiation pattern code here
+	// the first and last points of the elevation profile handed to ITM
+	double first_elev = path.pilot_transmits ? elevation_under_pilot : elevation_under_sender;
+	double last_elev = path.pilot_transmits ? elevation_under_sender : elevation_under_pilot;
 	double tx_pattern_gain = 0.0;
 	double rx_pattern_gain = 0.0;
 	double sender_heading = 270.0; // due West
 	double tx_antenna_bearing = sender_heading - reverse_course * SGD_RADIANS_TO_DEGREES;
 	double rx_antenna_bearing = own_heading - course * SGD_RADIANS_TO_DEGREES;
-	double rx_elev_angle = atan((itm_elev[2] + transmitter_height - itm_elev[(int)itm_elev[0] + 2] + receiver_height) / distance_m) * SGD_RADIANS_TO_DEGREES;
+	double rx_elev_angle = atan((first_elev + transmitter_height - last_elev + receiver_height) / distance_m) * SGD_RADIANS_TO_DEGREES;
 	double tx_elev_angle = 0.0 - rx_elev_angle;
 	if (_root_node->getBoolValue("use-tx-antenna-pattern", false)) {
 		FGRadioAntenna* TX_antenna;
@@ -448,28 +381,116 @@ double FGRadioTransmission::ITM_calculate_attenuation(SGGeod pos, double freq, i
 		rx_pattern_gain = RX_antenna->calculate_gain(rx_antenna_bearing, rx_elev_angle);
 		delete RX_antenna;
 	}
+	path.pattern_gain = rx_pattern_gain + tx_pattern_gain;
+	
+	return true;
+}
+
+
+/*** ITM keeps its state in static variables, one run at a time
+***/
+static std::mutex itm_mutex;
+
+void FGRadioTransmission::ITM_run(ITMPath &path) {
+
+	/** ITM default parameters 
+		TODO: take them from tile materials (especially for sea)?
+	**/
+	double eps_dielect=15.0;
+	double sgm_conductivity = 0.005;
+	double eno = 301.0;
+	
+	int radio_climate = 5;		// continental temperate
+	double conf = 0.90;	// 90% of situations and time, take into account speed
+	double rel = 0.90;	
+	double horizons[2];
+	
+	path.clutter_loss = 0.0; 	// loss due to vegetation and urban
+	path.p_mode = 0; // propgation mode selector: 0 LOS, 1 diffraction dominant, 2 troposcatter
+	
+	const FGTerrainProfile &profile = *path.profile;
+	size_t num_samples = profile.elevations.size();
+	
+	/** ITM wants the number of intervals, the distance between points and
+	*	the elevations from the transmitter to the receiver
+	**/
+	int size = num_samples + 4;
+	boost::scoped_array<double> itm_elev( new double[size] );
+	std::vector<const string*> materials(num_samples);
+	
+	itm_elev[0] = num_samples + 1;
+	itm_elev[1] = profile.sampling_distance;
+	if (path.pilot_transmits) {
+		itm_elev[2] = path.elevation_under_pilot;
+		for (size_t i = 0; i < num_samples; i++) {
+			itm_elev[i + 3] = profile.elevations[i];
+			materials[i] = profile.materials[i];
+		}
+		itm_elev[size - 1] = path.elevation_under_sender;
+	}
+	else {
+		itm_elev[2] = path.elevation_under_sender;
+		for (size_t i = 0; i < num_samples; i++) {
+			itm_elev[i + 3] = profile.elevations[num_samples - 1 - i];
+			materials[i] = profile.materials[num_samples - 1 - i];
+		}
+		itm_elev[size - 1] = path.elevation_under_pilot;
+	}
+	
+	std::lock_guard<std::mutex> lock(itm_mutex);
+	if (path.pilot_transmits) {
+		// the sender and receiver roles are switched
+		ITM::point_to_point(itm_elev.get(), path.receiver_height, path.transmitter_height,
+			eps_dielect, sgm_conductivity, eno, path.frq_mhz, radio_climate,
+			path.polarization, conf, rel, path.dbloss, path.strmode, path.p_mode, horizons, path.errnum);
+		if( path.use_clutter )
+			calculate_clutter_loss(path.frq_mhz, itm_elev.get(), materials, path.receiver_height, path.transmitter_height, path.p_mode, horizons, path.clutter_loss);
+	}
+	else {
+		ITM::point_to_point(itm_elev.get(), path.transmitter_height, path.receiver_height,
+			eps_dielect, sgm_conductivity, eno, path.frq_mhz, radio_climate,
+			path.polarization, conf, rel, path.dbloss, path.strmode, path.p_mode, horizons, path.errnum);
+		if( path.use_clutter )
+			calculate_clutter_loss(path.frq_mhz, itm_elev.get(), materials, path.transmitter_height, path.receiver_height, path.p_mode, horizons, path.clutter_loss);
+	}
+}
+
+
+double FGRadioTransmission::ITM_finish(const ITMPath &path) {
+
+	double dbloss = path.dbloss;
+	double clutter_loss = path.clutter_loss;
+	double pol_loss = path.pol_loss;
+	double link_budget = path.link_budget;
+	
+	//SG_LOG(SG_GENERAL, SG_BULK,
+	//		"ITM:: Link budget: " << link_budget << ", Attenuation: " << dbloss << " dBm, " << strmode << ", Error: " << errnum);
+	//cerr << "ITM:: Link budget: " << link_budget << ", Attenuation: " << dbloss << " dBm, " << strmode << ", Error: " << errnum << endl;
+	_root_node->setDoubleValue("station[0]/link-budget", link_budget);
+	_root_node->setDoubleValue("station[0]/terrain-attenuation", dbloss);
+	_root_node->setStringValue("station[0]/prop-mode", path.strmode);
+	_root_node->setDoubleValue("station[0]/clutter-attenuation", clutter_loss);
+	_root_node->setDoubleValue("station[0]/polarization-attenuation", pol_loss);
+	//if (errnum == 4)	// if parameters are outside sane values for lrprop, bail out fast
+	//	return -1;
 	
-	signal = link_budget - dbloss - clutter_loss + pol_loss + rx_pattern_gain + tx_pattern_gain;
-	double signal_strength_dbm = signal_strength - dbloss - clutter_loss + pol_loss + rx_pattern_gain + tx_pattern_gain;
+	double signal = link_budget - dbloss - clutter_loss + pol_loss + path.pattern_gain;
+	double signal_strength_dbm = path.signal_strength - dbloss - clutter_loss + pol_loss + path.pattern_gain;
 	double field_strength_uV = dbm_to_microvolt(signal_strength_dbm);
 	_root_node->setDoubleValue("station[0]/signal-dbm", signal_strength_dbm);
 	_root_node->setDoubleValue("station[0]/field-strength-uV", field_strength_uV);
 	_root_node->setDoubleValue("station[0]/signal", signal);
-	_root_node->setDoubleValue("station[0]/tx-erp", tx_erp);
+	_root_node->setDoubleValue("station[0]/tx-erp", path.tx_erp);
 
 	//_root_node->setDoubleValue("station[0]/tx-pattern-gain", tx_pattern_gain);
 	//_root_node->setDoubleValue("station[0]/rx-pattern-gain", rx_pattern_gain);
-
-	for (unsigned i =0; i < materials.size(); i++) {
-		delete materials[i];
-	}
 	
 	return signal;
 
 }
 
 
-void FGRadioTransmission::calculate_clutter_loss(double freq, double itm_elev[], deque<string*> &materials,
+void FGRadioTransmission::calculate_clutter_loss(double freq, double itm_elev[], const std::vector<const string*> &materials,
 	double transmitter_height, double receiver_height, int p_mode,
 	double horizons[], double &clutter_loss) {
 	
@@ -807,7 +828,7 @@ void FGRadioTransmission::calculate_clutter_loss(double freq, double itm_elev[],
 }
 
 
-void FGRadioTransmission::get_material_properties(string* mat_name, double &height, double &density) {
+void FGRadioTransmission::get_material_properties(const string* mat_name, double &height, double &density) {
 	
 	if(!mat_name)
 		return;
@@ -1024,3 +1045,111 @@ double FGRadioTransmission::dbm_to_microvolt(double dbm) {
 }
 
 
+
+FGRadioPropagation::FGRadioPropagation() :
+	_stop(false)
+{
+	_queued_node = fgGetNode("sim/radio/propagation/queued", true);
+	_computed_node = fgGetNode("sim/radio/propagation/computed", true);
+}
+
+FGRadioPropagation::~FGRadioPropagation()
+{
+	stop();
+}
+
+
+void FGRadioPropagation::init() {
+	stop();
+	_stop = false;
+	_thread = std::thread(&FGRadioPropagation::run, this);
+}
+
+
+void FGRadioPropagation::shutdown() {
+	stop();
+	_profiles.clear();
+}
+
+
+void FGRadioPropagation::stop() {
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_stop = true;
+	}
+	_cond.notify_all();
+	if (_thread.joinable())
+		_thread.join();
+
+	for (unsigned i = 0; i < _pending.size(); i++)
+		delete _pending[i];
+	for (unsigned i = 0; i < _done.size(); i++)
+		delete _done[i];
+	_pending.clear();
+	_done.clear();
+	_queued_node->setIntValue(0);
+}
+
+
+void FGRadioPropagation::queueATC(const FGRadioTransmission& radio, const FGRadioTransmission::ITMPath& path, const string& text) {
+	Job *job = new Job;
+	job->radio = radio;
+	job->path = path;
+	job->text = text;
+	
+	size_t queued;
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		if (!_thread.joinable()) {
+			// not running, do it here
+			job->radio.ITM_run(job->path);
+			_done.push_back(job);
+			return;
+		}
+		_pending.push_back(job);
+		queued = _pending.size();
+	}
+	_cond.notify_one();
+	_queued_node->setIntValue(queued);
+}
+
+
+void FGRadioPropagation::run() {
+	std::unique_lock<std::mutex> lock(_mutex);
+	while (!_stop) {
+		if (_pending.empty()) {
+			_cond.wait(lock);
+			continue;
+		}
+		Job *job = _pending.front();
+		_pending.pop_front();
+
+		lock.unlock();
+		job->radio.ITM_run(job->path);
+		lock.lock();
+
+		_done.push_back(job);
+	}
+}
+
+
+void FGRadioPropagation::update(double dt) {
+	std::deque<Job*> done;
+	size_t queued;
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		done.swap(_done);
+		queued = _pending.size();
+	}
+	_queued_node->setIntValue(queued);
+	
+	for (unsigned i = 0; i < done.size(); i++) {
+		Job *job = done[i];
+		double signal = job->radio.ITM_finish(job->path);
+		if (signal > 0.0) {
+			fgSetString("/sim/messages/atc", job->text.c_str());
+		}
+		delete job;
+	}
+	_computed_node->setIntValue(_computed_node->getIntValue() + done.size());
+}
@@ -21,20 +21,65 @@
 # error This library requires C++
 #endif
 
+#ifndef _FG_RADIO_HXX
+#define _FG_RADIO_HXX
+
 #include <simgear/compiler.h>
 #include <simgear/structure/subsystem_mgr.hxx>
+#include <condition_variable>
 #include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
 #include <Main/fg_props.hxx>
 
 #include <simgear/math/sg_geodesy.hxx>
 #include <simgear/debug/logstream.hxx>
 #include "antenna.hxx"
+#include "terrain_profile.hxx"
 
 using std::string;
 
 
 class FGRadioTransmission 
 {
+public:
+
+/*** One run of ITM: its inputs, found on the main thread by ITM_prepare,
+*	and its results. ITM_run needs nothing else and can be called from
+*	any thread.
+***/
+	struct ITMPath {
+		FGTerrainProfileRef profile;
+		bool pilot_transmits;	/// transmission types 3 and 4
+		double elevation_under_pilot;
+		double elevation_under_sender;
+		double transmitter_height;
+		double receiver_height;
+		double frq_mhz;
+		int polarization;
+		bool use_clutter;
+		double link_budget;
+		double signal_strength;
+		double tx_erp;
+		double pol_loss;
+		double pattern_gain;
+		
+		double dbloss;
+		double clutter_loss;
+		int p_mode;
+		int errnum;
+		char strmode[150];
+	};
+	
+	void ITM_run(ITMPath &path);
+	
+/*** Last step of ITM_calculate_attenuation, on the main thread
+*	@param: path after ITM_run
+*	@return: signal level above receiver treshhold sensitivity
+***/
+	double ITM_finish(const ITMPath &path);
+
 private:
 	
 	double _receiver_sensitivity;
@@ -62,6 +107,13 @@ private:
 ***/
 	double ITM_calculate_attenuation(SGGeod tx_pos, double freq, int ground_to_air);
 	
+/*** First step of ITM_calculate_attenuation, on the main thread: the geometry,
+*	the terrain profile and everything else that needs the property tree
+*	@param: transmitter position, frequency, transmission type, path to fill in, signal
+*	@return: false if the signal is known without running ITM, it is then set
+***/
+	bool ITM_prepare(SGGeod tx_pos, double freq, int transmission_type, ITMPath &path, double &signal);
+	
 /*** a simple alternative LOS propagation model (WIP)
 *	@param: transmitter position, frequency, flag to indicate if the transmission is from a ground station
 *	@return: signal level above receiver treshhold sensitivity
@@ -74,7 +126,7 @@ private:
 *	@param: frequency, elevation data, terrain type, horizon distances, calculated loss
 *	@return: none
 ***/
-	void calculate_clutter_loss(double freq, double itm_elev[], std::deque<string*> &materials,
+	void calculate_clutter_loss(double freq, double itm_elev[], const std::vector<const string*> &materials,
 			double transmitter_height, double receiver_height, int p_mode,
 			double horizons[], double &clutter_loss);
 	
@@ -82,7 +134,7 @@ private:
 *		@param: terrain type, median clutter height, radiowave attenuation factor
 *		@return: none
 ***/
-	void get_material_properties(string* mat_name, double &height, double &density);
+	void get_material_properties(const string* mat_name, double &height, double &density);
 	
 	
 public:
@@ -141,3 +193,53 @@ public:
 };
 
 
+/*** Keeps the terrain profiles and runs ITM for the ATC transmissions
+*	in a thread of its own. The messages are shown from update() once
+*	their signal is known.
+***/
+class FGRadioPropagation : public SGSubsystem
+{
+public:
+    FGRadioPropagation();
+    ~FGRadioPropagation();
+
+    void init();
+    void shutdown();
+    void update(double dt);
+
+    static const char* subsystemName() { return "radio-propagation"; }
+
+    FGTerrainProfileCache& profiles() { return _profiles; }
+
+/*** Queue an ATC message for which ITM_prepare returned true
+*	@param: the radio that prepared the path, the path, ATC text
+*	@return: none
+***/
+    void queueATC(const FGRadioTransmission& radio, const FGRadioTransmission::ITMPath& path, const string& text);
+
+private:
+    struct Job {
+        FGRadioTransmission radio;
+        FGRadioTransmission::ITMPath path;
+        string text;
+    };
+
+    void run();
+    void stop();
+
+    FGTerrainProfileCache _profiles;
+
+    std::thread _thread;
+    std::mutex _mutex;
+    std::condition_variable _cond;
+    std::deque<Job*> _pending;
+    std::deque<Job*> _done;
+    bool _stop;
+
+    SGPropertyNode_ptr _queued_node;
+    SGPropertyNode_ptr _computed_node;
+};
+
+#endif // _FG_RADIO_HXX
+
+
@@ -0,0 +1,203 @@
+// terrain_profile.cxx -- FGTerrainProfileCache: terrain profiles for radio propagation
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation; either version 2 of the
+// License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include <algorithm>
+#include <cmath>
+#include <set>
+
+#include <simgear/constants.h>
+#include <simgear/math/sg_geodesy.hxx>
+#include <simgear/scene/material/mat.hxx>
+#include <Main/fg_props.hxx>
+#include <Main/globals.hxx>
+#include <Scenery/scenery.hxx>
+
+#include "terrain_profile.hxx"
+
+
+bool FGTerrainProfileCache::Key::operator<(const Key& other) const {
+	if (rx.lat != other.rx.lat)
+		return rx.lat < other.rx.lat;
+	if (rx.lon != other.rx.lon)
+		return rx.lon < other.rx.lon;
+	if (tx.lat != other.tx.lat)
+		return tx.lat < other.tx.lat;
+	if (tx.lon != other.tx.lon)
+		return tx.lon < other.tx.lon;
+	return sampling_distance < other.sampling_distance;
+}
+
+
+FGTerrainProfileCache::FGTerrainProfileCache() :
+	_uses(0),
+	_tile_generation(0)
+{
+	SGPropertyNode* node = fgGetNode("sim/radio/profile-cache", true);
+	_cell_size_node = node->getNode("cell-size-m", true);
+	_max_entries_node = node->getNode("max-entries", true);
+	_hits_node = node->getNode("hits", true);
+	_misses_node = node->getNode("misses", true);
+	_samples_node = node->getNode("samples", true);
+	_entries_node = node->getNode("entries", true);
+	_tile_generation_node = fgGetNode("/sim/scenery/tile-generation", true);
+
+	if (!_cell_size_node->hasValue())
+		_cell_size_node->setDoubleValue(250.0);
+	if (!_max_entries_node->hasValue())
+		_max_entries_node->setIntValue(512);
+	_tile_generation = _tile_generation_node->getIntValue();
+}
+
+FGTerrainProfileCache::~FGTerrainProfileCache()
+{
+}
+
+
+const std::string* FGTerrainProfileCache::intern(const std::string& s) {
+	// the terrain only has a few dozen materials
+	static std::set<std::string> names;
+	return &*names.insert(s).first;
+}
+
+
+FGTerrainProfileCache::Cell FGTerrainProfileCache::cell(const SGGeod& pos, double cell_m) const {
+	double step_deg = cell_m * SG_METER_TO_NM / 60.0;
+	Cell c;
+	c.lat = (int)floor(pos.getLatitudeDeg() / step_deg);
+	double row_lat = (c.lat + 0.5) * step_deg;
+	double lon_step_deg = step_deg / SGMiscd::max(cos(row_lat * SGD_DEGREES_TO_RADIANS), 0.01);
+	c.lon = (int)floor(pos.getLongitudeDeg() / lon_step_deg);
+	return c;
+}
+
+SGGeod FGTerrainProfileCache::cell_center(const Cell& c, double cell_m) const {
+	double step_deg = cell_m * SG_METER_TO_NM / 60.0;
+	double lat = (c.lat + 0.5) * step_deg;
+	double lon_step_deg = step_deg / SGMiscd::max(cos(lat * SGD_DEGREES_TO_RADIANS), 0.01);
+	return SGGeod::fromDeg((c.lon + 0.5) * lon_step_deg, lat);
+}
+
+
+FGTerrainProfileRef FGTerrainProfileCache::get(const SGGeod& rx_pos, const SGGeod& tx_pos, double sampling_distance) {
+
+	int generation = _tile_generation_node->getIntValue();
+	if (generation != _tile_generation) {
+		// new tiles may fill the holes of the incomplete profiles
+		_tile_generation = generation;
+		drop_incomplete();
+	}
+
+	double cell_m = SGMiscd::max(_cell_size_node->getDoubleValue(), 1.0);
+	Key key;
+	key.rx = cell(rx_pos, cell_m);
+	key.tx = cell(tx_pos, cell_m);
+	key.sampling_distance = sampling_distance;
+
+	ProfileMap::iterator it = _profiles.find(key);
+	if (it != _profiles.end()) {
+		it->second.last_used = ++_uses;
+		_hits_node->setIntValue(_hits_node->getIntValue() + 1);
+		return it->second.profile;
+	}
+
+	_misses_node->setIntValue(_misses_node->getIntValue() + 1);
+	evict(std::max(_max_entries_node->getIntValue(), 1));
+
+	Entry entry;
+	entry.profile = sample(cell_center(key.rx, cell_m), cell_center(key.tx, cell_m), sampling_distance);
+	entry.last_used = ++_uses;
+	_profiles[key] = entry;
+	_entries_node->setIntValue(_profiles.size());
+	return entry.profile;
+}
+
+
+FGTerrainProfile* FGTerrainProfileCache::sample(const SGGeod& rx_pos, const SGGeod& tx_pos, double sampling_distance) {
+
+	FGTerrainProfile* profile = new FGTerrainProfile;
+	profile->sampling_distance = sampling_distance;
+
+	FGScenery* scenery = globals->get_scenery();
+	const std::string* no_material = intern("None");
+
+	SGGeoc center = SGGeoc::fromGeod(SGGeod::fromGeodM(rx_pos, SG_MAX_ELEVATION_M));
+	double course = SGGeodesy::courseRad(SGGeoc::fromGeod(rx_pos), SGGeoc::fromGeod(tx_pos));
+	double distance_m = SGGeodesy::distanceM(rx_pos, tx_pos);
+	unsigned num_samples = (unsigned)floor(distance_m / sampling_distance) + 1;
+
+	std::vector<SGGeod> probes(num_samples);
+	double probe_distance = 0.0;
+	for (unsigned i = 0; i < num_samples; i++) {
+		probe_distance += sampling_distance;
+		probes[i] = SGGeod::fromGeoc(center.advanceRadM(course, probe_distance));
+	}
+	
+	// one query for the whole profile, the samples are close to each other
+	std::vector<FGElevationResult> results(num_samples);
+	if (scenery && num_samples)
+		scenery->get_elevation_m_batch(&probes[0], num_samples, &results[0]);
+	
+	profile->elevations.resize(num_samples);
+	profile->materials.resize(num_samples);
+	for (unsigned i = 0; i < num_samples; i++) {
+		profile->elevations[i] = results[i].valid ? results[i].elevation_m : 0.0;
+		profile->materials[i] = no_material;
+		if (!results[i].valid) {
+			profile->complete = false;
+			continue;
+		}
+		const SGMaterial *mat = dynamic_cast<const SGMaterial*>(results[i].material);
+		if (mat && !mat->get_names().empty())
+			profile->materials[i] = intern(mat->get_names()[0]);
+	}
+	_samples_node->setIntValue(_samples_node->getIntValue() + num_samples);
+
+	return profile;
+}
+
+
+void FGTerrainProfileCache::drop_incomplete() {
+	ProfileMap::iterator it = _profiles.begin();
+	while (it != _profiles.end()) {
+		if (!it->second.profile->complete)
+			_profiles.erase(it++);
+		else
+			++it;
+	}
+	_entries_node->setIntValue(_profiles.size());
+}
+
+
+void FGTerrainProfileCache::evict(unsigned max_entries) {
+	while (!_profiles.empty() && (_profiles.size() >= max_entries)) {
+		ProfileMap::iterator oldest = _profiles.begin();
+		for (ProfileMap::iterator it = _profiles.begin(); it != _profiles.end(); ++it) {
+			if (it->second.last_used < oldest->second.last_used)
+				oldest = it;
+		}
+		_profiles.erase(oldest);
+	}
+}
+
+
+void FGTerrainProfileCache::clear() {
+	_profiles.clear();
+	_entries_node->setIntValue(0);
+}
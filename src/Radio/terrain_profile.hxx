@@ -0,0 +1,104 @@
+// terrain_profile.hxx -- FGTerrainProfileCache: terrain profiles for radio propagation
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation; either version 2 of the
+// License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+#ifndef _FG_TERRAIN_PROFILE_HXX
+#define _FG_TERRAIN_PROFILE_HXX
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include <simgear/math/SGMath.hxx>
+#include <simgear/props/props.hxx>
+#include <simgear/structure/SGReferenced.hxx>
+#include <simgear/structure/SGSharedPtr.hxx>
+
+/*** Terrain elevation between a receiver and a transmitter, sampled every
+*	sampling_distance meters, starting one step from the receiver.
+*	The end points are not part of the profile, the caller queries them.
+***/
+class FGTerrainProfile : public SGReferenced
+{
+public:
+	FGTerrainProfile() : sampling_distance(0.0), complete(true) {}
+
+	double sampling_distance;
+	bool complete;	/// false if some samples had no scenery
+	std::vector<double> elevations;
+	std::vector<const std::string*> materials;	/// interned, one per sample
+};
+
+typedef SGSharedPtr<const FGTerrainProfile> FGTerrainProfileRef;
+
+
+/*** Samples terrain profiles from the scenery and keeps them per pair of
+*	grid cells, one holding the transmitter and one the receiver, so that
+*	the stations and a slowly moving receiver reuse the same profile.
+*	The profiles with samples missing are dropped when tiles are loaded.
+*	Only to be used from the main thread, like the scenery itself.
+***/
+class FGTerrainProfileCache
+{
+public:
+	FGTerrainProfileCache();
+	~FGTerrainProfileCache();
+
+/*** @param: receiver and transmitter positions, distance between samples in meters
+*	@return: the profile between the centers of their cells
+***/
+	FGTerrainProfileRef get(const SGGeod& rx_pos, const SGGeod& tx_pos, double sampling_distance);
+
+	void clear();
+
+/*** @return: a string equal to s that lives as long as the program
+***/
+	static const std::string* intern(const std::string& s);
+
+private:
+	struct Cell {
+		int lat, lon;
+	};
+	struct Key {
+		Cell rx, tx;
+		double sampling_distance;
+		bool operator<(const Key& other) const;
+	};
+	struct Entry {
+		FGTerrainProfileRef profile;
+		unsigned last_used;
+	};
+	typedef std::map<Key, Entry> ProfileMap;
+
+	Cell cell(const SGGeod& pos, double cell_m) const;
+	SGGeod cell_center(const Cell& c, double cell_m) const;
+	FGTerrainProfile* sample(const SGGeod& rx_pos, const SGGeod& tx_pos, double sampling_distance);
+	void drop_incomplete();
+	void evict(unsigned max_entries);
+
+	ProfileMap _profiles;
+	unsigned _uses;
+	int _tile_generation;
+
+	SGPropertyNode_ptr _tile_generation_node;
+	SGPropertyNode_ptr _cell_size_node;
+	SGPropertyNode_ptr _max_entries_node;
+	SGPropertyNode_ptr _hits_node;
+	SGPropertyNode_ptr _misses_node;
+	SGPropertyNode_ptr _samples_node;
+	SGPropertyNode_ptr _entries_node;
+};
+
+#endif // _FG_TERRAIN_PROFILE_HXX
@@ -0,0 +1,249 @@
+// SceneryBatchIntersect.cxx -- intersect many line segments with the scenery at once
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation; either version 2 of the
+// License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include <stdint.h>
+
+#include <algorithm>
+#include <utility>
+
+#include <osg/Camera>
+#include <osg/CameraView>
+#include <osg/MatrixTransform>
+#include <osg/PositionAttitudeTransform>
+#include <osg/Transform>
+
+#include <simgear/scene/util/OsgMath.hxx>
+#include <simgear/scene/util/SGSceneUserData.hxx>
+#include <simgear/bvh/BVHNode.hxx>
+#include <simgear/bvh/BVHLineSegmentVisitor.hxx>
+
+#include "SceneryBatchIntersect.hxx"
+
+namespace flightgear
+{
+
+SceneryBatchIntersect::SceneryBatchIntersect(const osg::Node* skipNode) :
+    osg::NodeVisitor(osg::NodeVisitor::TRAVERSE_ACTIVE_CHILDREN),
+    _skipNode(skipNode)
+{
+    _range.begin = _range.end = 0;
+}
+
+size_t SceneryBatchIntersect::addLineSegment(const SGLineSegmentd& lineSegment)
+{
+    Query query;
+    query.lineSegment = lineSegment;
+    query.material = 0;
+    query.haveHit = false;
+    _queries.push_back(query);
+    return _queries.size() - 1;
+}
+
+void SceneryBatchIntersect::clear()
+{
+    _queries.clear();
+    _active.clear();
+    _range.begin = _range.end = 0;
+}
+
+void SceneryBatchIntersect::intersect(osg::Node& node)
+{
+    _active.resize(_queries.size());
+    for (size_t i = 0; i < _queries.size(); ++i)
+        _active[i] = i;
+    _range.begin = 0;
+    _range.end = _active.size();
+
+    node.accept(*this);
+
+    _active.clear();
+    _range.begin = _range.end = 0;
+}
+
+namespace
+{
+
+// Position of a point on a Morton (Z-order) curve over the globe, with
+// cells of about 600 m at the equator.
+uint32_t mortonKey(const SGGeod& geod)
+{
+    uint32_t x = (uint32_t)((geod.getLongitudeDeg() + 180.0) / 360.0 * 65535.0) & 0xffff;
+    uint32_t y = (uint32_t)((geod.getLatitudeDeg() + 90.0) / 180.0 * 65535.0) & 0xffff;
+    uint32_t key = 0;
+    for (int bit = 0; bit < 16; ++bit) {
+        key |= ((x >> bit) & 1) << (2 * bit);
+        key |= ((y >> bit) & 1) << (2 * bit + 1);
+    }
+    return key;
+}
+
+}
+
+void SceneryBatchIntersect::sortByArea(const SGGeod* geods, size_t n,
+                                       std::vector<size_t>& order)
+{
+    std::vector<std::pair<uint32_t, size_t> > keys(n);
+    for (size_t i = 0; i < n; ++i)
+        keys[i] = std::make_pair(mortonKey(geods[i]), i);
+    std::sort(keys.begin(), keys.end());
+
+    order.resize(n);
+    for (size_t i = 0; i < n; ++i)
+        order[i] = keys[i].second;
+}
+
+void SceneryBatchIntersect::apply(osg::Node& node)
+{
+    if (&node == _skipNode)
+        return;
+    Range outer;
+    if (!enter(node.getBound(), outer))
+        return;
+
+    addBoundingVolume(node);
+    leave(outer);
+}
+
+void SceneryBatchIntersect::apply(osg::Group& group)
+{
+    if (&group == _skipNode)
+        return;
+    Range outer;
+    if (!enter(group.getBound(), outer))
+        return;
+
+    traverse(group);
+    addBoundingVolume(group);
+    leave(outer);
+}
+
+void SceneryBatchIntersect::apply(osg::Camera& camera)
+{
+    if (camera.getRenderOrder() != osg::Camera::NESTED_RENDER)
+        return;
+    handleTransform(camera);
+}
+
+void SceneryBatchIntersect::apply(osg::CameraView& transform)
+{ handleTransform(transform); }
+void SceneryBatchIntersect::apply(osg::MatrixTransform& transform)
+{ handleTransform(transform); }
+void SceneryBatchIntersect::apply(osg::PositionAttitudeTransform& transform)
+{ handleTransform(transform); }
+
+bool SceneryBatchIntersect::enter(const osg::BoundingSphere& bound, Range& outer)
+{
+    if (!bound.valid())
+        return false;
+
+    SGSphered sphere(toVec3d(toSG(bound._center)), bound._radius);
+    size_t begin = _active.size();
+    // _active may grow here, so index it rather than iterating
+    for (size_t i = _range.begin; i < _range.end; ++i) {
+        size_t q = _active[i];
+        if (intersects(_queries[q].lineSegment, sphere))
+            _active.push_back(q);
+    }
+    if (_active.size() == begin)
+        return false;
+
+    outer = _range;
+    _range.begin = begin;
+    _range.end = _active.size();
+    return true;
+}
+
+void SceneryBatchIntersect::leave(const Range& outer)
+{
+    _active.resize(_range.begin);
+    _range = outer;
+}
+
+void SceneryBatchIntersect::handleTransform(osg::Transform& transform)
+{
+    if (&transform == _skipNode)
+        return;
+    // Hmm, may be this needs to be refined somehow ...
+    if (transform.getReferenceFrame() != osg::Transform::RELATIVE_RF)
+        return;
+
+    Range outer;
+    if (!enter(transform.getBound(), outer))
+        return;
+
+    osg::Matrix inverseMatrix;
+    osg::Matrix matrix;
+    if (!transform.computeWorldToLocalMatrix(inverseMatrix, this) ||
+        !transform.computeLocalToWorldMatrix(matrix, this)) {
+        leave(outer);
+        return;
+    }
+
+    // move the segments into the frame of the transform, keeping them as
+    // they were for those that do not hit below it
+    SGMatrixd toLocal(inverseMatrix.ptr());
+    std::vector<Query> saved;
+    saved.reserve(_range.end - _range.begin);
+    for (size_t i = _range.begin; i < _range.end; ++i) {
+        Query& query = _queries[_active[i]];
+        saved.push_back(query);
+        query.haveHit = false;
+        query.lineSegment = query.lineSegment.transform(toLocal);
+    }
+
+    addBoundingVolume(transform);
+    traverse(transform);
+
+    SGMatrixd toWorld(matrix.ptr());
+    for (size_t i = _range.begin; i < _range.end; ++i) {
+        Query& query = _queries[_active[i]];
+        if (query.haveHit)
+            query.lineSegment = query.lineSegment.transform(toWorld);
+        else
+            query = saved[i - _range.begin];
+    }
+
+    leave(outer);
+}
+
+void SceneryBatchIntersect::addBoundingVolume(osg::Node& node)
+{
+    SGSceneUserData* userData = SGSceneUserData::getSceneUserData(&node);
+    if (!userData)
+        return;
+    simgear::BVHNode* bvNode = userData->getBVHNode();
+    if (!bvNode)
+        return;
+
+    // Find ground intersection on the bvh nodes
+    for (size_t i = _range.begin; i < _range.end; ++i) {
+        Query& query = _queries[_active[i]];
+        simgear::BVHLineSegmentVisitor lineSegmentVisitor(query.lineSegment,
+                                                          0/*startTime*/);
+        bvNode->accept(lineSegmentVisitor);
+        if (!lineSegmentVisitor.empty()) {
+            query.lineSegment = lineSegmentVisitor.getLineSegment();
+            query.material = lineSegmentVisitor.getMaterial();
+            query.haveHit = true;
+        }
+    }
+}
+
+}
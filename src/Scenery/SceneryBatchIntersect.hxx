@@ -0,0 +1,112 @@
+// SceneryBatchIntersect.hxx -- intersect many line segments with the scenery at once
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation; either version 2 of the
+// License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+#ifndef FLIGHTGEAR_SCENERYBATCHINTERSECT_HXX
+#define FLIGHTGEAR_SCENERYBATCHINTERSECT_HXX 1
+
+#include <vector>
+
+#include <osg/BoundingSphere>
+#include <osg/NodeVisitor>
+
+#include <simgear/math/SGMath.hxx>
+#include <simgear/math/SGGeometry.hxx>
+
+namespace simgear {
+class BVHMaterial;
+class BVHNode;
+}
+
+namespace flightgear
+{
+
+/**
+ * Finds the nearest intersection of each of a set of line segments with
+ * the scene graph, in one traversal.
+ *
+ * A node is only entered with the segments that cross its bounding sphere,
+ * and left as soon as none does, so the upper part of the scene graph is
+ * walked once for all the segments. The bounding volume trees at the
+ * leaves are still searched segment by segment. The fewer the nodes the
+ * segments have in common, the less is gained: queries should be grouped
+ * by area, see FGStgTerrain::get_elevation_m_batch().
+ *
+ * The results replace the segments: a segment that hit ends at the hit.
+ */
+class SceneryBatchIntersect : public osg::NodeVisitor
+{
+public:
+    SceneryBatchIntersect(const osg::Node* skipNode);
+
+    /// @return the index of the segment
+    size_t addLineSegment(const SGLineSegmentd& lineSegment);
+    size_t size() const
+    { return _queries.size(); }
+    void clear();
+
+    bool getHaveHit(size_t i) const
+    { return _queries[i].haveHit; }
+    const SGLineSegmentd& getLineSegment(size_t i) const
+    { return _queries[i].lineSegment; }
+    const simgear::BVHMaterial* getMaterial(size_t i) const
+    { return _queries[i].material; }
+
+    /// Intersect all the segments added so far with node.
+    void intersect(osg::Node& node);
+
+    /// Order n positions so that those close in the order are close on
+    /// the ground, for splitting a set of queries in batches.
+    /// @param order filled with the indices of geods, in that order
+    static void sortByArea(const SGGeod* geods, size_t n,
+                           std::vector<size_t>& order);
+
+    virtual void apply(osg::Node& node);
+    virtual void apply(osg::Group& group);
+    virtual void apply(osg::Transform& transform)
+    { handleTransform(transform); }
+    virtual void apply(osg::Camera& camera);
+    virtual void apply(osg::CameraView& transform);
+    virtual void apply(osg::MatrixTransform& transform);
+    virtual void apply(osg::PositionAttitudeTransform& transform);
+
+private:
+    struct Query {
+        SGLineSegmentd lineSegment;
+        const simgear::BVHMaterial* material;
+        bool haveHit;
+    };
+
+    // The indices of the segments still in play are _active[_begin, _end).
+    // Entering a node pushes the ones crossing it at the end of _active.
+    struct Range {
+        size_t begin, end;
+    };
+
+    bool enter(const osg::BoundingSphere& bound, Range& outer);
+    void leave(const Range& outer);
+
+    void handleTransform(osg::Transform& transform);
+    void addBoundingVolume(osg::Node& node);
+
+    std::vector<Query> _queries;
+    std::vector<size_t> _active;
+    Range _range;
+    const osg::Node* _skipNode;
+};
+
+}
+
+#endif // FLIGHTGEAR_SCENERYBATCHINTERSECT_HXX
@@ -420,6 +420,14 @@ FGScenery::get_elevation_m(const SGGeod& geod, double& alt,
                                       butNotFrom );
 }
 
+void
+FGScenery::get_elevation_m_batch(const SGGeod* geods, size_t n,
+                                 FGElevationResult* results,
+                                 const osg::Node* butNotFrom)
+{
+    _terrain->get_elevation_m_batch( geods, n, results, butNotFrom );
+}
+
 bool
 FGScenery::get_cart_ground_intersection(const SGVec3d& pos, const SGVec3d& dir,
                                         SGVec3d& nearestHit,
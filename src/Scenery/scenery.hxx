@@ -91,6 +91,12 @@ public:
                          const simgear::BVHMaterial** material,
                          const osg::Node* butNotFrom = 0);
 
+    /// Compute the elevations of the scenery at n positions at once,
+    /// see FGTerrain::get_elevation_m_batch.
+    void get_elevation_m_batch(const SGGeod* geods, size_t n,
+                               FGElevationResult* results,
+                               const osg::Node* butNotFrom = 0);
+
     /// Compute the elevation of the scenery below the cartesian point pos.
     /// you the returned scenery altitude is not higher than the position
     /// pos plus an offset given with max_altoff.
@@ -45,6 +45,17 @@ namespace simgear {
 class BVHMaterial;
 }
 
+/// The result of one query of FGTerrain::get_elevation_m_batch.
+struct FGElevationResult
+{
+    FGElevationResult() : valid(false), elevation_m(0.0), material(0) {}
+
+    /// true if there is scenery at the position, see get_elevation_m
+    bool valid;
+    double elevation_m;
+    const simgear::BVHMaterial* material;
+};
+
 // Define a structure containing global scenery parameters
 class FGTerrain
 {
@@ -74,6 +85,21 @@ public:
                                  const simgear::BVHMaterial** material,
                                  const osg::Node* butNotFrom = 0) = 0;
 
+    /// Compute the elevations of the scenery at n positions at once, as
+    /// get_elevation_m does for one. The results are stored in results[i]
+    /// for geods[i]. The queries may be made in any order and share the
+    /// traversal of the scene graph: use this for the sets of close
+    /// positions, like the samples of a terrain profile.
+    virtual void get_elevation_m_batch(const SGGeod* geods, size_t n,
+                                       FGElevationResult* results,
+                                       const osg::Node* butNotFrom = 0)
+    {
+        for (size_t i = 0; i < n; ++i) {
+            results[i].valid = get_elevation_m(geods[i], results[i].elevation_m,
+                                               &results[i].material, butNotFrom);
+        }
+    }
+
     /// Compute the elevation of the scenery below the cartesian point pos.
     /// you the returned scenery altitude is not higher than the position
     /// pos plus an offset given with max_altoff.
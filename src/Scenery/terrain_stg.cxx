@@ -28,6 +28,11 @@
 #include <stdio.h>
 #include <string.h>
 
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+
 #include <osg/Camera>
 #include <osg/Transform>
 #include <osg/MatrixTransform>
@@ -58,6 +63,7 @@
 #include <GUI/MouseCursor.hxx>
 
 #include "terrain_stg.hxx"
+#include "SceneryBatchIntersect.hxx"
 
 using namespace flightgear;
 using namespace simgear;
@@ -228,6 +234,12 @@ FGStgTerrain::FGStgTerrain() :
     _tilemgr()
 {
     _inited  = false;
+    _batchChunkSize = fgGetNode("/sim/scenery/elevation-batch/chunk-size", true);
+    _batchThreads = fgGetNode("/sim/scenery/elevation-batch/threads", true);
+    if (!_batchChunkSize->hasValue())
+        _batchChunkSize->setIntValue(64);
+    if (!_batchThreads->hasValue())
+        _batchThreads->setIntValue(1);
 }
 
 FGStgTerrain::~FGStgTerrain()
@@ -334,6 +346,94 @@ FGStgTerrain::get_elevation_m(const SGGeod& geod, double& alt,
   return true;
 }
 
+namespace
+{
+
+// The queries of get_elevation_m_batch, shared by the threads working on
+// them. Each chunk is taken by one thread.
+struct ElevationBatch
+{
+    const SGGeod* geods;
+    FGElevationResult* results;
+    const osg::Node* butNotFrom;
+    osg::Group* terrain;
+    std::vector<size_t> order;
+    size_t chunkSize;
+    size_t numChunks;
+    std::atomic<size_t> nextChunk;
+
+    void run()
+    {
+        SceneryBatchIntersect intersectVisitor(butNotFrom);
+        intersectVisitor.setTraversalMask(SG_NODEMASK_TERRAIN_BIT);
+
+        for (size_t chunk = nextChunk++; chunk < numChunks; chunk = nextChunk++) {
+            size_t begin = chunk * chunkSize;
+            size_t end = std::min(begin + chunkSize, order.size());
+
+            intersectVisitor.clear();
+            for (size_t i = begin; i < end; ++i) {
+                const SGGeod& geod = geods[order[i]];
+                SGGeod geodEnd = geod;
+                geodEnd.setElevationM(SGMiscd::min(geod.getElevationM() - 10, -10000));
+                intersectVisitor.addLineSegment(SGLineSegmentd(SGVec3d::fromGeod(geod),
+                                                               SGVec3d::fromGeod(geodEnd)));
+            }
+            intersectVisitor.intersect(*terrain);
+
+            for (size_t i = begin; i < end; ++i) {
+                FGElevationResult& result = results[order[i]];
+                size_t query = i - begin;
+                result.valid = intersectVisitor.getHaveHit(query);
+                if (result.valid) {
+                    result.elevation_m = SGGeod::fromCart(intersectVisitor.getLineSegment(query).getEnd()).getElevationM();
+                    result.material = intersectVisitor.getMaterial(query);
+                } else {
+                    result.material = 0;
+                }
+            }
+        }
+    }
+};
+
+void runElevationBatch(ElevationBatch* batch)
+{
+    batch->run();
+}
+
+}
+
+void
+FGStgTerrain::get_elevation_m_batch(const SGGeod* geods, size_t n,
+                                    FGElevationResult* results,
+                                    const osg::Node* butNotFrom)
+{
+  if (n == 0)
+    return;
+
+  ElevationBatch batch;
+  batch.geods = geods;
+  batch.results = results;
+  batch.butNotFrom = butNotFrom;
+  batch.terrain = terrain_branch.get();
+  SceneryBatchIntersect::sortByArea(geods, n, batch.order);
+
+  batch.chunkSize = std::max(_batchChunkSize->getIntValue(), 1);
+  batch.numChunks = (n + batch.chunkSize - 1) / batch.chunkSize;
+  batch.nextChunk = 0;
+
+  // The scene graph is not changed while this runs, as the pager only
+  // merges new tiles from the main loop; the intersections only read it.
+  size_t numThreads = std::min<size_t>(std::max(_batchThreads->getIntValue(), 1),
+                                       batch.numChunks);
+  std::vector<std::thread> workers;
+  for (size_t i = 1; i < numThreads; ++i)
+    workers.push_back(std::thread(runElevationBatch, &batch));
+  batch.run();
+  for (size_t i = 0; i < workers.size(); ++i)
+    workers[i].join();
+}
+
 bool
 FGStgTerrain::get_cart_ground_intersection(const SGVec3d& pos, const SGVec3d& dir,
                                            SGVec3d& nearestHit,
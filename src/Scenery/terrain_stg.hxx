@@ -99,6 +99,15 @@ public:
     bool get_cart_ground_intersection(const SGVec3d& start, const SGVec3d& dir,
                                       SGVec3d& nearestHit,
                                       const osg::Node* butNotFrom = 0);
+
+    /// Compute the elevations of the scenery at n positions at once.
+    /// The positions are sorted along a space filling curve and split in
+    /// chunks of /sim/scenery/elevation-batch/chunk-size, each chunk making
+    /// one traversal of the terrain, in up to
+    /// /sim/scenery/elevation-batch/threads threads.
+    void get_elevation_m_batch(const SGGeod* geods, size_t n,
+                               FGElevationResult* results,
+                               const osg::Node* butNotFrom = 0);
     
     /// Returns true if scenery is available for the given lat, lon position
     /// within a range of range_m.
@@ -119,6 +128,8 @@ private:
     osg::ref_ptr<osg::Group> terrain_branch;
     
     bool _inited;
+
+    SGPropertyNode_ptr _batchChunkSize, _batchThreads;
 };
 
 #endif // _TERRAIN_STG_HXX
@@ -120,6 +120,8 @@ FGTileMgr::FGTileMgr():
     _disableNasalHooks(fgGetNode("/sim/temp/disable-scenery-nasal", true)),
     _scenery_loaded(fgGetNode("/sim/sceneryloaded", true)),
     _scenery_override(fgGetNode("/sim/sceneryloaded-override", true)),
+    _tile_generation(fgGetNode("/sim/scenery/tile-generation", true)),
+    _loaded_tiles(0),
     _pager(FGScenery::getPagerSingleton()),
     _enableCache(true)
 {
@@ -354,6 +356,7 @@ void FGTileMgr::update_queues(bool& isDownloadingScenery)
     double vis = _visibilityMeters->getDoubleValue();
     TileEntry *e;
     int loading=0;
+    int loaded=0;
     int sz=0;
     
     tile_cache.set_current_time( current_time );
@@ -384,6 +387,9 @@ void FGTileMgr::update_queues(bool& isDownloadingScenery)
                     loading++;
                 }
             } // of tile not loaded case
+            else {
+                loaded++;
+            }
         } else {
             SG_LOG(SG_TERRAIN, SG_ALERT, "Warning: empty tile in cache!");
         }
@@ -400,6 +406,10 @@ void FGTileMgr::update_queues(bool& isDownloadingScenery)
       drop_count = sz; // no limit on tiles to drop
     }
   
+    // a tile was merged into the scene graph, or one is dropped below
+    bool tilesChanged = (loaded != _loaded_tiles);
+    _loaded_tiles = loaded;
+
     if (dropTiles)
     {
         long drop_index = _enableCache ? tile_cache.get_drop_tile() :
@@ -411,6 +421,10 @@ void FGTileMgr::update_queues(bool& isDownloadingScenery)
             SG_LOG(SG_TERRAIN, SG_DEBUG, "Dropping:" << old->get_tile_bucket());
 
             tile_cache.clear_entry(drop_index);
+            if (old->is_loaded()) {
+                tilesChanged = true;
+                _loaded_tiles--;
+            }
             
             osg::ref_ptr<osg::Object> subgraph = old->getNode();
             old->removeFromSceneGraph();
@@ -428,6 +442,10 @@ void FGTileMgr::update_queues(bool& isDownloadingScenery)
                drop_index = -1;
         }
     } // of dropping tiles loop
+
+    if (tilesChanged) {
+        _tile_generation->setIntValue(_tile_generation->getIntValue() + 1);
+    }
 }
 
 // given the current lon/lat (in degrees), fill in the array of local
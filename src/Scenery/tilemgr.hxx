@@ -88,6 +88,10 @@ private:
     SGPropertyNode_ptr _visibilityMeters;
     SGPropertyNode_ptr _maxTileRangeM, _disableNasalHooks;
     SGPropertyNode_ptr _scenery_loaded, _scenery_override;
+    // bumped whenever the set of loaded tiles changes, for the users of
+    // elevation data that cache it (see Radio/terrain_profile.hxx)
+    SGPropertyNode_ptr _tile_generation;
+    int _loaded_tiles;
 
     osg::ref_ptr<flightgear::SceneryPager> _pager;
 
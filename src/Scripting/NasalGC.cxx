@@ -0,0 +1,82 @@
+// NasalGC.cxx - run the Nasal garbage collector between frames
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation; either version 2 of the
+// License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
+#include "NasalGC.hxx"
+
+#include <simgear/nasal/nasal.h>
+
+NasalGCPacer::NasalGCPacer() :
+    _mode(ALLOCATION),
+    _budgetMs(2.0),
+    _interval(1.0),
+    _maxInterval(10.0),
+    _deferring(false)
+{
+    _stats.collections = 0;
+    _stats.deferred = 0;
+    _stats.lastPauseMs = 0.0;
+    _stats.maxPauseMs = 0.0;
+    _stats.totalPauseMs = 0.0;
+    _stats.expectedPauseMs = 0.0;
+    _lastCollection.stamp();
+}
+
+void NasalGCPacer::collect()
+{
+    SGTimeStamp start = SGTimeStamp::now();
+    naGC();
+    _lastCollection.stamp();
+    double pauseMs = 1000.0 * (_lastCollection - start).toSecs();
+
+    // the pause grows with the heap, follow it without jumping on the
+    // odd slow one
+    if (_stats.collections == 0)
+        _stats.expectedPauseMs = pauseMs;
+    else
+        _stats.expectedPauseMs = 0.75 * _stats.expectedPauseMs + 0.25 * pauseMs;
+
+    ++_stats.collections;
+    _stats.lastPauseMs = pauseMs;
+    _stats.totalPauseMs += pauseMs;
+    if (pauseMs > _stats.maxPauseMs)
+        _stats.maxPauseMs = pauseMs;
+    _deferring = false;
+}
+
+bool NasalGCPacer::update()
+{
+    if (_mode != PACED)
+        return false;
+
+    double elapsed = (SGTimeStamp::now() - _lastCollection).toSecs();
+    if (elapsed < _interval)
+        return false;
+
+    if (_stats.expectedPauseMs > _budgetMs && elapsed < _maxInterval) {
+        if (!_deferring) {
+            _deferring = true;
+            ++_stats.deferred;
+        }
+        return false;
+    }
+
+    collect();
+    return true;
+}
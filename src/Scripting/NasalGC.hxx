@@ -0,0 +1,85 @@
+// NasalGC.hxx - run the Nasal garbage collector between frames
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation; either version 2 of the
+// License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+#ifndef __NASAL_GC_HXX
+#define __NASAL_GC_HXX
+
+#include <simgear/timing/timestamp.hxx>
+
+/**
+ * Decides when to run the Nasal garbage collector.
+ *
+ * The interpreter collects when an object pool runs out, which can be in
+ * the middle of any script, and then stops the frame for as long as the
+ * collection takes. In paced mode, collections are run at the end of a
+ * frame instead, at most every interval. Running them before the pools run
+ * out also keeps the pools, and so the pauses, small.
+ *
+ * A collection expected to take longer than the budget is put off, up to
+ * the maximum interval, when it is run anyway. Still, the interpreter
+ * collects whenever it has to, whatever the mode.
+ */
+class NasalGCPacer
+{
+public:
+    enum Mode {
+        ALLOCATION, ///< only when the interpreter runs out of objects
+        PACED       ///< also between frames, see update()
+    };
+
+    struct Stats {
+        unsigned collections;   ///< collections run by the pacer
+        unsigned deferred;      ///< collections put off for the budget
+        double lastPauseMs;
+        double maxPauseMs;
+        double totalPauseMs;
+        double expectedPauseMs; ///< running estimate of the next pause
+    };
+
+    NasalGCPacer();
+
+    void setMode(Mode mode) { _mode = mode; }
+    Mode getMode() const { return _mode; }
+
+    void setBudget(double ms) { _budgetMs = ms; }
+    void setInterval(double seconds) { _interval = seconds; }
+    void setMaxInterval(double seconds) { _maxInterval = seconds; }
+
+    /**
+     * Collect now, e.g. after loading scripts, and time it.
+     */
+    void collect();
+
+    /**
+     * Call at the end of a frame, when no Nasal code runs. Collects if due
+     * in paced mode, returns whether it did.
+     */
+    bool update();
+
+    const Stats& stats() const { return _stats; }
+
+private:
+    Mode _mode;
+    double _budgetMs;
+    double _interval;
+    double _maxInterval;
+
+    SGTimeStamp _lastCollection;
+    bool _deferring;
+    Stats _stats;
+};
+
+#endif // __NASAL_GC_HXX
@@ -0,0 +1,153 @@
+// NasalPropertyCache.cxx - remember the property nodes found by Nasal paths
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation; either version 2 of the
+// License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
+#include "NasalPropertyCache.hxx"
+
+#include <string.h>
+
+// FNV-1a over the key, starting from the base node
+static size_t hashKey(const SGPropertyNode* base, const char* key, size_t len)
+{
+    size_t hash = 2166136261u ^ reinterpret_cast<size_t>(base);
+    for (size_t i = 0; i < len; ++i) {
+        hash ^= (unsigned char)key[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+NasalPropertyCache::NasalPropertyCache(unsigned sizeLog2) :
+    _entries(size_t(1) << sizeLog2),
+    _enabled(true),
+    _hits(0),
+    _misses(0)
+{
+}
+
+SGPropertyNode* NasalPropertyCache::find(naContext c, SGPropertyNode* base,
+                                         naRef* path, int len, bool create)
+{
+    if (!_enabled)
+        return resolve(c, base, path, len, create);
+
+    const char* key;
+    size_t keyLen;
+    bool single = len == 1 && naIsString(path[0]);
+    if (single) {
+        key = naStr_data(path[0]);
+        keyLen = naStr_len(path[0]);
+    } else {
+        _key.clear();
+        for (int i = 0; i < len; ++i) {
+            if (naIsString(path[i])) {
+                _key += 's';
+                _key.append(naStr_data(path[i]), naStr_len(path[i]));
+                _key += '\0';
+            } else if (naIsNum(path[i])) {
+                _key += 'n';
+                _key.append(reinterpret_cast<const char*>(&path[i].num),
+                            sizeof(double));
+            } else {
+                // let resolve() complain about it
+                return resolve(c, base, path, len, create);
+            }
+        }
+        key = _key.data();
+        keyLen = _key.size();
+    }
+
+    size_t hash = hashKey(base, key, keyLen);
+    Entry& entry = _entries[hash & (_entries.size() - 1)];
+    if (entry.hash == hash && entry.base.get() == base
+        && entry.single == single && entry.key.size() == keyLen
+        && !memcmp(entry.key.data(), key, keyLen)
+        && attached(base, entry.node)) {
+        ++_hits;
+        return entry.node;
+    }
+
+    ++_misses;
+    SGPropertyNode* node = resolve(c, base, path, len, create);
+    // paths going up from the base are not remembered, as attached()
+    // could not tell whether they still lead to the same node
+    if (node && attached(base, node)) {
+        entry.hash = hash;
+        entry.single = single;
+        entry.key.assign(key, keyLen);
+        entry.base = base;
+        entry.node = node;
+    }
+    return node;
+}
+
+// The get/setprop functions accept a *list* of strings and walk
+// through the property tree with them to find the appropriate node.
+// This allows a Nasal object to hold onto a property path and use it
+// like a node object, e.g. setprop(ObjRoot, "size-parsecs", 2.02).  This
+// is the utility function that walks the property tree.
+SGPropertyNode* NasalPropertyCache::resolve(naContext c, SGPropertyNode* base,
+                                            naRef* path, int len, bool create)
+{
+    SGPropertyNode* p = base;
+    try {
+        for(int i=0; i<len; i++) {
+            naRef a = path[i];
+            if(!naIsString(a)) {
+                naRuntimeError(c, "bad argument to setprop/getprop path: expected a string");
+            }
+            naRef b = i < len-1 ? naNumValue(path[i+1]) : naNil();
+            if (!naIsNil(b)) {
+                p = p->getNode(naStr_data(a), (int)b.num, create);
+                i++;
+            } else {
+                p = p->getNode(naStr_data(a), create);
+            }
+            if(p == 0) return 0;
+        }
+    } catch (const std::string& err) {
+        naRuntimeError(c, (char *)err.c_str());
+    }
+    return p;
+}
+
+void NasalPropertyCache::setEnabled(bool enabled)
+{
+    if (_enabled && !enabled)
+        clear();
+    _enabled = enabled;
+}
+
+void NasalPropertyCache::clear()
+{
+    for (size_t i = 0; i < _entries.size(); ++i)
+        _entries[i] = Entry();
+}
+
+// whether node is still below base: a removed node is flagged, and so is
+// the top of a removed subtree
+bool NasalPropertyCache::attached(const SGPropertyNode* base,
+                                  const SGPropertyNode* node)
+{
+    for (; node != base; node = node->getParent()) {
+        if (!node || node->getAttribute(SGPropertyNode::REMOVED))
+            return false;
+    }
+    return true;
+}
@@ -0,0 +1,91 @@
+// NasalPropertyCache.hxx - remember the property nodes found by Nasal paths
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation; either version 2 of the
+// License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+#ifndef __NASAL_PROPERTY_CACHE_HXX
+#define __NASAL_PROPERTY_CACHE_HXX
+
+#include <string>
+#include <vector>
+
+#include <simgear/nasal/nasal.h>
+#include <simgear/props/props.hxx>
+
+/**
+ * The nodes found for the paths given to getprop(), setprop() and the
+ * props.Node functions taking a relative path.
+ *
+ * A path is the list of arguments getprop() walks: strings, each maybe
+ * followed by an index. A single string, the usual literal path, is used
+ * as the key as it is; longer lists are packed into one key.
+ *
+ * The cache is direct mapped: a path replaces whatever other path used
+ * its slot. A node found in the cache is only returned if neither it nor
+ * any node between it and the base has been removed from the tree since,
+ * otherwise the path is walked again.
+ */
+class NasalPropertyCache
+{
+public:
+    /**
+     * @param sizeLog2 log2 of the number of paths remembered
+     */
+    explicit NasalPropertyCache(unsigned sizeLog2 = 12);
+
+    /**
+     * The node at path relative to base, or NULL if it does not exist and
+     * create is false. Raises a Nasal runtime error for a bad path.
+     */
+    SGPropertyNode* find(naContext c, SGPropertyNode* base,
+                         naRef* path, int len, bool create);
+
+    /**
+     * The same without the cache: walk the path from base.
+     */
+    static SGPropertyNode* resolve(naContext c, SGPropertyNode* base,
+                                   naRef* path, int len, bool create);
+
+    /**
+     * Disabling the cache also forgets the paths remembered so far.
+     */
+    void setEnabled(bool enabled);
+    bool isEnabled() const { return _enabled; }
+
+    void clear();
+
+    unsigned long hits() const { return _hits; }
+    unsigned long misses() const { return _misses; }
+    void resetStats() { _hits = _misses = 0; }
+
+private:
+    struct Entry {
+        Entry() : hash(0), single(false) {}
+
+        size_t hash;
+        bool single;
+        std::string key;
+        SGPropertyNode_ptr base;
+        SGPropertyNode_ptr node;
+    };
+
+    static bool attached(const SGPropertyNode* base, const SGPropertyNode* node);
+
+    std::vector<Entry> _entries;
+    std::string _key;
+    bool _enabled;
+    unsigned long _hits, _misses;
+};
+
+#endif // __NASAL_PROPERTY_CACHE_HXX
@@ -233,7 +233,8 @@ static char* readfile(const char* file, int* lenOut)
 }
 
 FGNasalSys::FGNasalSys() :
-    _inited(false)
+    _inited(false),
+    _propertyCacheElapsed(0.0)
 {
     nasalSys = this;
     _context = 0;
@@ -336,32 +337,12 @@ FGNasalScript* FGNasalSys::parseScript(const char* src, const char* name)
 #endif
 
 // The get/setprop functions accept a *list* of strings and walk
-// through the property tree with them to find the appropriate node.
-// This allows a Nasal object to hold onto a property path and use it
-// like a node object, e.g. setprop(ObjRoot, "size-parsecs", 2.02).  This
-// is the utility function that walks the property tree.
+// through the property tree with them to find the appropriate node,
+// see NasalPropertyCache::resolve().  The nodes found are remembered, so
+// that the same path does not have to be parsed again on the next call.
 static SGPropertyNode* findnode(naContext c, naRef* vec, int len, bool create=false)
 {
-    SGPropertyNode* p = globals->get_props();
-    try {
-        for(int i=0; i<len; i++) {
-            naRef a = vec[i];
-            if(!naIsString(a)) {
-                naRuntimeError(c, "bad argument to setprop/getprop path: expected a string");
-            }
-            naRef b = i < len-1 ? naNumValue(vec[i+1]) : naNil();
-            if (!naIsNil(b)) {
-                p = p->getNode(naStr_data(a), (int)b.num, create);
-                i++;
-            } else {
-                p = p->getNode(naStr_data(a), create);
-            }
-            if(p == 0) return 0;
-        }
-    } catch (const string& err) {
-        naRuntimeError(c, (char *)err.c_str());
-    }
-    return p;
+    return nasalSys->propertyCache().find(c, globals->get_props(), vec, len, create);
 }
 
 // getprop() extension function.  Concatenates its string arguments as
@@ -937,6 +918,8 @@ void FGNasalSys::init()
     postinitNasalPositioned(_globals, _context);
     postinitNasalGUI(_globals, _context);
 
+    initGC();
+
     _inited = true;
 }
 
@@ -994,7 +977,7 @@ naRef FGNasalSys::wrappedPropsNode(SGPropertyNode* aProps)
     return wrapped;
 }
 
-void FGNasalSys::update(double)
+void FGNasalSys::update(double dt)
 {
 #ifndef FG_TESTLIB
     if( NasalClipboard::getInstance() )
@@ -1038,6 +1021,89 @@ void FGNasalSys::update(double)
     // they're very fast, just trust me). -Andy
     naFreeContext(_context);
     _context = naNewContext();
+
+    updatePropertyCache(dt);
+    updateGC();
+}
+
+// The garbage collection settings and statistics under /sim/nasal/gc.
+// Collect once now, while loading, to free what the scripts left behind
+// and learn how long a collection takes.
+void FGNasalSys::initGC()
+{
+    _gcNode = fgGetNode("/sim/nasal/gc", true);
+    _gcModeNode = _gcNode->getNode("mode", true);
+    if (!_gcModeNode->hasValue())
+        _gcModeNode->setStringValue("allocation");
+    _gcBudgetNode = _gcNode->getNode("budget-ms", true);
+    if (!_gcBudgetNode->hasValue())
+        _gcBudgetNode->setDoubleValue(2.0);
+    _gcIntervalNode = _gcNode->getNode("interval-s", true);
+    if (!_gcIntervalNode->hasValue())
+        _gcIntervalNode->setDoubleValue(1.0);
+    _gcMaxIntervalNode = _gcNode->getNode("max-interval-s", true);
+    if (!_gcMaxIntervalNode->hasValue())
+        _gcMaxIntervalNode->setDoubleValue(10.0);
+
+    _gcPacer.collect();
+    publishGCStats();
+    SG_LOG(SG_NASAL, SG_INFO, "Nasal garbage collection after loading took "
+           << _gcPacer.stats().lastPauseMs << " ms");
+}
+
+// In "paced" mode, collect at the end of the frame when due.
+void FGNasalSys::updateGC()
+{
+    if (!_gcNode)
+        return;
+
+    _gcPacer.setMode(!strcmp(_gcModeNode->getStringValue(), "paced")
+                     ? NasalGCPacer::PACED : NasalGCPacer::ALLOCATION);
+    _gcPacer.setBudget(_gcBudgetNode->getDoubleValue());
+    _gcPacer.setInterval(_gcIntervalNode->getDoubleValue());
+    _gcPacer.setMaxInterval(_gcMaxIntervalNode->getDoubleValue());
+
+    unsigned deferred = _gcPacer.stats().deferred;
+    if (_gcPacer.update() || _gcPacer.stats().deferred != deferred)
+        publishGCStats();
+}
+
+void FGNasalSys::publishGCStats()
+{
+    const NasalGCPacer::Stats& stats = _gcPacer.stats();
+    _gcNode->setIntValue("collections", stats.collections);
+    _gcNode->setIntValue("deferred", stats.deferred);
+    _gcNode->setDoubleValue("last-pause-ms", stats.lastPauseMs);
+    _gcNode->setDoubleValue("max-pause-ms", stats.maxPauseMs);
+    _gcNode->setDoubleValue("mean-pause-ms",
+                            stats.totalPauseMs / stats.collections);
+    _gcNode->setDoubleValue("expected-pause-ms", stats.expectedPauseMs);
+}
+
+// Follow the enabled flag of the property cache, and publish how often it
+// was hit in the last second.
+void FGNasalSys::updatePropertyCache(double dt)
+{
+    if (!_propertyCacheNode) {
+        _propertyCacheNode = fgGetNode("/sim/nasal/property-cache", true);
+        if (!_propertyCacheNode->hasValue("enabled"))
+            _propertyCacheNode->setBoolValue("enabled", true);
+    }
+
+    _propertyCache.setEnabled(_propertyCacheNode->getBoolValue("enabled"));
+
+    _propertyCacheElapsed += dt;
+    if (_propertyCacheElapsed < 1.0)
+        return;
+
+    unsigned long hits = _propertyCache.hits();
+    unsigned long lookups = hits + _propertyCache.misses();
+    _propertyCacheNode->setIntValue("hits", hits);
+    _propertyCacheNode->setIntValue("misses", lookups - hits);
+    _propertyCacheNode->setDoubleValue("hit-ratio",
+                                       lookups ? double(hits) / lookups : 0.0);
+    _propertyCache.resetStats();
+    _propertyCacheElapsed = 0.0;
 }
 
 bool pathSortPredicate(const SGPath& p1, const SGPath& p2)
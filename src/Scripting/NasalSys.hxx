@@ -18,6 +18,9 @@
 
 #include <map>
 
+#include "NasalGC.hxx"
+#include "NasalPropertyCache.hxx"
+
 
 class FGNasalScript;
 class FGNasalListener;
@@ -112,6 +115,10 @@ public:
     naRef callMethodWithContext(naContext ctx, naRef code, naRef self, int argc, naRef* args, naRef locals);
   
     naRef propNodeGhost(SGPropertyNode* handle);
+
+    // The nodes found by getprop(), setprop() and props.Node paths
+    NasalPropertyCache& propertyCache()
+    { return _propertyCache; }
   
     void registerToLoad(FGNasalModelData* data);
     void registerToUnload(FGNasalModelData* data);
@@ -207,6 +214,21 @@ private:
     NasalCommandDict _commands;
     
     naRef _wrappedNodeFunc;
+
+    NasalPropertyCache _propertyCache;
+    SGPropertyNode_ptr _propertyCacheNode;
+    double _propertyCacheElapsed;
+    void updatePropertyCache(double dt);
+
+    NasalGCPacer _gcPacer;
+    SGPropertyNode_ptr _gcNode,
+                       _gcModeNode,
+                       _gcBudgetNode,
+                       _gcIntervalNode,
+                       _gcMaxIntervalNode;
+    void initGC();
+    void updateGC();
+    void publishGCStats();
 public:
     void handleTimer(NasalTimer* t);
 };
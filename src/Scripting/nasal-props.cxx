@@ -52,6 +52,17 @@ SGPropertyNode* ghostToPropNode(naRef ref)
   return static_cast<SGPropertyNode*>(naGhost_ptr(ref));
 }
 
+// The nodes found by relative paths, shared with getprop() and setprop()
+static NasalPropertyCache* nasalPropertyCache = 0;
+
+static SGPropertyNode* relativeNode(naContext c, SGPropertyNode* node,
+                                    naRef path, bool create)
+{
+    if (nasalPropertyCache)
+        return nasalPropertyCache->find(c, node, &path, 1, create);
+    return NasalPropertyCache::resolve(c, node, &path, 1, create);
+}
+
 #define NASTR(s) s ? naStr_fromdata(naNewString(c),(char*)(s),strlen(s)) : naNil()
 
 //
@@ -86,12 +97,7 @@ SGPropertyNode* ghostToPropNode(naRef ref)
     if(cond1) {                                                                \
         naRef name = naVec_get(argv, 0);                                       \
         if(naIsString(name)) {                                                 \
-            try {                                                              \
-                node = node->getNode(naStr_data(name), create);                \
-            } catch(const string& err) {                                       \
-                naRuntimeError(c, (char *)err.c_str());                        \
-                return naNil();                                                \
-            }                                                                  \
+            node = relativeNode(c, node, name, create);                        \
             if(!node) return naNil();                                          \
             naVec_removefirst(argv); /* pop only if we were successful */      \
         }                                                                      \
@@ -726,14 +732,7 @@ static naRef f_getNode(naContext c, naRef me, int argc, naRef* args)
     naRef path = naVec_get(argv, 0);
     bool create = naTrue(naVec_get(argv, 1)) != 0;
     if(!naIsString(path)) return naNil();
-    SGPropertyNode* n;
-    try {
-        n = node->getNode(naStr_data(path), create);
-    } catch (const string& err) {
-        naRuntimeError(c, (char *)err.c_str());
-        return naNil();
-    }
-    return propNodeGhostCreate(c, n);
+    return propNodeGhostCreate(c, relativeNode(c, node, path, create));
 }
 
 
@@ -792,6 +791,7 @@ static struct {
 
 naRef FGNasalSys::genPropsModule()
 {
+    nasalPropertyCache = &_propertyCache;
     naRef namespc = naNewHash(_context);
     for(int i=0; propfuncs[i].name; i++)
         hashset(namespc, propfuncs[i].name,
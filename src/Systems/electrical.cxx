@@ -26,6 +26,7 @@
 
 #include <cstdlib>
 #include <cstring>
+#include <map>
 
 #include <simgear/structure/exception.hxx>
 #include <simgear/misc/sg_path.hxx>
@@ -341,7 +342,9 @@ FGElectricalSystem::FGElectricalSystem ( SGPropertyNode *node ) :
     name(node->getStringValue("name", "electrical")),
     num(node->getIntValue("number", 0)),
     path(node->getStringValue("path")),
-    enabled(false)
+    enabled(false),
+    _solved(false),
+    _serviceable(false)
 {
 }
 
@@ -356,6 +359,17 @@ void FGElectricalSystem::init () {
     _volts_out = fgGetNode( "/systems/electrical/volts", true );
     _amps_out = fgGetNode( "/systems/electrical/amps", true );
 
+    _serviceable_node = fgGetNode( "/systems/electrical/serviceable", true );
+    _alternator_node
+        = fgGetNode( "/systems/electrical/suppliers/alternator", true );
+    _master_bat_node
+        = fgGetNode( "/controls/engines/engine[0]/master-bat", true );
+    _master_alt_node
+        = fgGetNode( "/controls/engines/engine[0]/master-alt", true );
+    _rpm_node = fgGetNode( "/engines/engine[0]/rpm", true );
+    _beacon_node = fgGetNode( "/controls/switches/flashing-beacon", true );
+    _nav_lights_node = fgGetNode( "/controls/switches/nav-lights", true );
+
     // allow the electrical system to be specified via the
     // aircraft-set.xml file (for backwards compatibility) or through
     // the aircraft-systems.xml file.  If a -set.xml entry is
@@ -383,6 +397,7 @@ void FGElectricalSystem::init () {
             readProperties( config, config_props );
 
             if ( build(config_props) ) {
+                compile();
                 enabled = true;
             } else {
                 throw sg_exception("Logic error in electrical system file.");
@@ -419,101 +434,32 @@ void FGElectricalSystem::update (double dt) {
 
     // cout << "Updating electrical system, dt = " << dt << endl;
 
-    unsigned int i;
-
-    // zero out the voltage before we start, but don't clear the
-    // requested load values.
-    for ( i = 0; i < suppliers.size(); ++i ) {
-        suppliers[i]->set_volts( 0.0 );
-    }
-    for ( i = 0; i < buses.size(); ++i ) {
-        buses[i]->set_volts( 0.0 );
-    }
-    for ( i = 0; i < outputs.size(); ++i ) {
-        outputs[i]->set_volts( 0.0 );
-    }
-    for ( i = 0; i < connectors.size(); ++i ) {
-        connectors[i]->set_volts( 0.0 );
-    }
-
-    // for each "external" supplier, propagate the electrical current
-    for ( i = 0; i < suppliers.size(); ++i ) {
-        FGElectricalSupplier *node = (FGElectricalSupplier *)suppliers[i];
-        if ( node->get_model() == FGElectricalSupplier::FG_EXTERNAL ) {
-            float load;
-            // cout << "Starting propagation: " << suppliers[i]->get_name()
-            //      << endl;
-            load = propagate( suppliers[i], dt,
-                              node->get_output_volts(),
-                              node->get_output_amps(),
-                              " " );
-
-            if ( node->apply_load( load, dt ) < 0.0 ) {
-                SG_LOG(SG_SYSTEMS, SG_ALERT,
-                       "Error drawing more current than available!");
-            }
-        }
-    }
-
-    // for each "alternator" supplier, propagate the electrical
-    // current
-    for ( i = 0; i < suppliers.size(); ++i ) {
-        FGElectricalSupplier *node = (FGElectricalSupplier *)suppliers[i];
-        if ( node->get_model() == FGElectricalSupplier::FG_ALTERNATOR) {
-            float load;
-            // cout << "Starting propagation: " << suppliers[i]->get_name()
-            //      << endl;
-            load = propagate( suppliers[i], dt,
-                              node->get_output_volts(),
-                              node->get_output_amps(),
-                              " " );
-
-            if ( node->apply_load( load, dt ) < 0.0 ) {
-                SG_LOG(SG_SYSTEMS, SG_ALERT,
-                       "Error drawing more current than available!");
-            }
-        }
-    }
-
-    // for each "battery" supplier, propagate the electrical
-    // current
-    for ( i = 0; i < suppliers.size(); ++i ) {
-        FGElectricalSupplier *node = (FGElectricalSupplier *)suppliers[i];
-        if ( node->get_model() == FGElectricalSupplier::FG_BATTERY ) {
-            float load;
-            // cout << "Starting propagation: " << suppliers[i]->get_name()
-            //      << endl;
-            load = propagate( suppliers[i], dt,
-                              node->get_output_volts(),
-                              node->get_output_amps(),
-                              " " );
-            // cout << "battery load = " << load << endl;
-
-            if ( node->apply_load( load, dt ) < 0.0 ) {
-                SG_LOG(SG_SYSTEMS, SG_ALERT,
-                       "Error drawing more current than available!");
-            }
-        }
+    // when nothing the solution depends on has changed, the last one
+    // still holds
+    if ( steady() ) {
+        replay( dt );
+    } else {
+        solve( dt );
     }
 
     float alt_norm
-        = fgGetFloat("/systems/electrical/suppliers/alternator") / 60.0;
+        = _alternator_node->getFloatValue() / 60.0;
 
     // impliment an extremely simplistic voltage model (assumes
     // certain naming conventions in electrical system config)
     // FIXME: we probably want to be able to feed power from all
     // engines if they are running and the master-alt is switched on
     float volts = 0.0;
-    if ( fgGetBool("/controls/engines/engine[0]/master-bat") ) {
+    if ( _master_bat_node->getBoolValue() ) {
         volts = 24.0;
     }
-    if ( fgGetBool("/controls/engines/engine[0]/master-alt") ) {
-        if ( fgGetFloat("/engines/engine[0]/rpm") > 800 ) {
+    if ( _master_alt_node->getBoolValue() ) {
+        if ( _rpm_node->getFloatValue() > 800 ) {
             float alt_contrib = 28.0;
             if ( alt_contrib > volts ) {
                 volts = alt_contrib;
             }
-        } else if ( fgGetFloat("/engines/engine[0]/rpm") > 200 ) {
+        } else if ( _rpm_node->getFloatValue() > 200 ) {
             float alt_contrib = 20.0;
             if ( alt_contrib > volts ) {
                 volts = alt_contrib;
@@ -526,17 +472,17 @@ void FGElectricalSystem::update (double dt) {
     // naming conventions in the electrical system config) ... FIXME:
     // make this more generic
     float amps = 0.0;
-    if ( fgGetBool("/controls/engines/engine[0]/master-bat") ) {
-        if ( fgGetBool("/controls/engines/engine[0]/master-alt") &&
-             fgGetFloat("/engines/engine[0]/rpm") > 800 )
+    if ( _master_bat_node->getBoolValue() ) {
+        if ( _master_alt_node->getBoolValue() &&
+             _rpm_node->getFloatValue() > 800 )
         {
             amps += 40.0 * alt_norm;
         }
         amps -= 15.0;            // normal load
-        if ( fgGetBool("/controls/switches/flashing-beacon") ) {
+        if ( _beacon_node->getBoolValue() ) {
             amps -= 7.5;
         }
-        if ( fgGetBool("/controls/switches/nav-lights") ) {
+        if ( _nav_lights_node->getBoolValue() ) {
             amps -= 7.5;
         }
         if ( amps > 7.0 ) {
@@ -583,71 +529,249 @@ bool FGElectricalSystem::build (SGPropertyNode* config_props) {
 }
 
 
-// propagate the electrical current through the network, returns the
-// total current drawn by the children of this node.
-float FGElectricalSystem::propagate( FGElectricalComponent *node, double dt,
-                                     float input_volts, float input_amps,
-                                     string s ) {
-    s += " ";
+// flatten the network built from the configuration into index arrays, so
+// that a solution walks it without following pointers through lists or
+// looking properties up by name.
+void FGElectricalSystem::compile() {
+    unsigned int i;
+    int j;
+
+    _components.clear();
+    _components.insert( _components.end(), suppliers.begin(), suppliers.end() );
+    _components.insert( _components.end(), buses.begin(), buses.end() );
+    _components.insert( _components.end(), outputs.begin(), outputs.end() );
+    _components.insert( _components.end(), connectors.begin(),
+                        connectors.end() );
+
+    std::map<FGElectricalComponent *, int> index;
+    for ( i = 0; i < _components.size(); ++i ) {
+        index[_components[i]] = i;
+    }
+
+    _first_edge.clear();
+    _edges.clear();
+    _first_prop.clear();
+    _prop_nodes.clear();
+    for ( i = 0; i < _components.size(); ++i ) {
+        FGElectricalComponent *node = _components[i];
+        _first_edge.push_back( _edges.size() );
+        for ( j = 0; j < node->get_num_outputs(); ++j ) {
+            _edges.push_back( index[node->get_output(j)] );
+        }
+        _first_prop.push_back( _prop_nodes.size() );
+        for ( j = 0; j < node->get_num_props(); ++j ) {
+            _prop_nodes.push_back( fgGetNode(node->get_prop(j).c_str(), true) );
+        }
+    }
+    _first_edge.push_back( _edges.size() );
+    _first_prop.push_back( _prop_nodes.size() );
+
+    _closed.assign( _components.size(), false );
+    _supplier_state.clear();
+    _loads.clear();
+    _solved = false;
+
+    SG_LOG( SG_SYSTEMS, SG_INFO, "Electrical system: " << _components.size()
+            << " components, " << _edges.size() << " connections" );
+}
+
+
+// true when the last solution still holds: same switch positions, same
+// supplier output, and no battery charge changed by the last solution.
+bool FGElectricalSystem::steady() {
+    unsigned int i;
+
+    // the switches may be tied properties, which do not notify their
+    // listeners, so poll them
+    bool switches_changed = false;
+    for ( i = suppliers.size() + buses.size() + outputs.size();
+          i < _components.size(); ++i )
+    {
+        bool closed = ((FGElectricalConnector *)_components[i])->get_state();
+        if ( closed != _closed[i] ) {
+            _closed[i] = closed;
+            switches_changed = true;
+        }
+    }
 
+    bool serviceable = _serviceable_node->getBoolValue();
+    bool same = _solved && !switches_changed
+        && serviceable == _serviceable;
+    _serviceable = serviceable;
+
+    // output volts, output amps and charge of each supplier
+    _supplier_state.resize( 3 * suppliers.size() );
+    for ( i = 0; i < suppliers.size(); ++i ) {
+        FGElectricalSupplier *node = (FGElectricalSupplier *)suppliers[i];
+        float volts = node->get_output_volts();
+        float amps = node->get_output_amps();
+        float percent = 0.0;
+        if ( node->get_model() == FGElectricalSupplier::FG_BATTERY ) {
+            percent = node->get_percent_remaining();
+        }
+        float *state = &_supplier_state[3 * i];
+        if ( state[0] != volts || state[1] != amps || state[2] != percent ) {
+            state[0] = volts;
+            state[1] = amps;
+            state[2] = percent;
+            same = false;
+        }
+    }
+
+    return same;
+}
+
+
+// compute a solution: propagate the current of each supplier, external
+// ones first, then the alternators and the batteries.
+void FGElectricalSystem::solve( double dt ) {
+    unsigned int i;
+    int pass;
+
+    // zero out the voltage before we start, but don't clear the
+    // requested load values.
+    for ( i = 0; i < _components.size(); ++i ) {
+        _components[i]->set_volts( 0.0 );
+    }
+    _loads.clear();
+
+    static const int models[] = { FGElectricalSupplier::FG_EXTERNAL,
+                                  FGElectricalSupplier::FG_ALTERNATOR,
+                                  FGElectricalSupplier::FG_BATTERY };
+    for ( pass = 0; pass < 3; ++pass ) {
+        for ( i = 0; i < suppliers.size(); ++i ) {
+            FGElectricalSupplier *node = (FGElectricalSupplier *)suppliers[i];
+            if ( node->get_model() != models[pass] ) {
+                continue;
+            }
+            float load = propagate( i, dt, node->get_output_volts(),
+                                    node->get_output_amps() );
+            Load applied = { node, load, true };
+            _loads.push_back( applied );
+            if ( node->apply_load( load, dt ) < 0.0 ) {
+                SG_LOG(SG_SYSTEMS, SG_ALERT,
+                       "Error drawing more current than available!");
+            }
+        }
+    }
+
+    // a solution charging or draining a battery changes what the next
+    // one starts from
+    _solved = true;
+    for ( i = 0; i < suppliers.size(); ++i ) {
+        FGElectricalSupplier *node = (FGElectricalSupplier *)suppliers[i];
+        if ( node->get_model() == FGElectricalSupplier::FG_BATTERY &&
+             node->get_percent_remaining() != _supplier_state[3 * i + 2] ) {
+            _solved = false;
+        }
+    }
+}
+
+
+// apply the loads of the last solution again, and publish the values of
+// the powered components that something else may have overwritten.
+void FGElectricalSystem::replay( double dt ) {
+    unsigned int i;
+
+    for ( i = 0; i < _loads.size(); ++i ) {
+        const Load &load = _loads[i];
+        if ( load.supplier->apply_load( load.amps, dt ) < 0.0 && load.check ) {
+            SG_LOG(SG_SYSTEMS, SG_ALERT,
+                   "Error drawing more current than available!");
+        }
+    }
+
+    for ( i = 0; i < _components.size(); ++i ) {
+        if ( _components[i]->get_volts() > 0.0 ) {
+            publish( i, true );
+        }
+    }
+}
+
+
+// start visiting a node from a parent at input_volts. Returns true when
+// the node found a stronger power source, and its children are to be
+// visited, with a new frame on the stack. Otherwise load is the current
+// the node draws from its parent.
+bool FGElectricalSystem::enter( int n, double dt, float input_volts,
+                                float input_amps, float& load ) {
+    FGElectricalComponent *node = _components[n];
     float total_load = 0.0;
+    load = 0.0;
 
     // determine the current to carry forward
     float volts = 0.0;
-    if ( !fgGetBool("/systems/electrical/serviceable") ) {
+    if ( !_serviceable ) {
         volts = 0;
     } else if ( node->get_kind() == FGElectricalComponent::FG_SUPPLIER ) {
-        // cout << s << "is a supplier (" << node->get_name() << ")" << endl;
         FGElectricalSupplier *supplier = (FGElectricalSupplier *)node;
         if ( supplier->get_model() == FGElectricalSupplier::FG_BATTERY ) {
-            // cout << s << " (and is a battery)" << endl;
             float battery_volts = supplier->get_output_volts();
             if ( battery_volts < (input_volts - 0.1) ) {
                 // special handling of a battery charge condition
-                // cout << s << "  (and is being charged) in v = "
-                //      << input_volts << " current v = " << battery_volts
-                //      << endl;
-                supplier->apply_load( -supplier->get_charge_amps(), dt );
-                return supplier->get_charge_amps();
+                Load applied = { supplier, -supplier->get_charge_amps(),
+                                 false };
+                _loads.push_back( applied );
+                supplier->apply_load( applied.amps, dt );
+                load = supplier->get_charge_amps();
+                return false;
             }
         }
         volts = input_volts;
     } else if ( node->get_kind() == FGElectricalComponent::FG_BUS ) {
-        // cout << s << "is a bus (" << node->get_name() << ")" << endl;
         volts = input_volts;
     } else if ( node->get_kind() == FGElectricalComponent::FG_OUTPUT ) {
-        // cout << s << "is an output (" << node->get_name() << ")" << endl;
         volts = input_volts;
         if ( volts > 1.0 ) {
             // draw current if we have voltage
             total_load = node->get_load_amps();
         }
     } else if ( node->get_kind() == FGElectricalComponent::FG_CONNECTOR ) {
-        // cout << s << "is a connector (" << node->get_name() << ")" << endl;
-        if ( ((FGElectricalConnector *)node)->get_state() ) {
-            volts = input_volts;
-        } else {
-            volts = 0.0;
-        }
-        // cout << s << "  input_volts = " << volts << endl;
+        volts = _closed[n] ? input_volts : 0.0;
     } else {
         SG_LOG( SG_SYSTEMS, SG_ALERT, "unknown node type" );
     }
 
-    int i;
-
     // if this node has found a stronger power source, update the
     // value and propagate to all children
     if ( volts > node->get_volts() ) {
         node->set_volts( volts );
-        for ( i = 0; i < node->get_num_outputs(); ++i ) {
-            FGElectricalComponent *child = node->get_output(i);
+        Frame frame = { n, _first_edge[n], volts, input_amps, total_load };
+        _stack.push_back( frame );
+        return true;
+    }
+    return false;
+}
+
+
+// propagate the electrical current through the network, returns the
+// total current drawn by the children of this node. The network is walked
+// depth first, in the order of the connections, as the loads seen by a
+// component depend on the components powered before it.
+float FGElectricalSystem::propagate( int n, double dt,
+                                     float input_volts, float input_amps ) {
+    float load;
+    if ( !enter( n, dt, input_volts, input_amps, load ) ) {
+        return load;
+    }
+
+    for ( ;; ) {
+        Frame &frame = _stack.back();
+        if ( frame.edge < _first_edge[frame.node + 1] ) {
+            int child = _edges[frame.edge++];
             // send current equal to load
-            total_load += propagate( child, dt,
-                                     volts, child->get_load_amps(),
-                                     s );
+            float volts = frame.volts;
+            if ( !enter( child, dt, volts,
+                         _components[child]->get_load_amps(), load ) ) {
+                _stack.back().total_load += load;
+            }
+            continue;
         }
 
+        // all children visited
+        FGElectricalComponent *node = _components[frame.node];
+        float total_load = frame.total_load;
+
         // if not an output node, register the downstream current draw
         // (sum of all children) with this node.  If volts are zero,
         // current draw should be zero.
@@ -655,28 +779,27 @@ float FGElectricalSystem::propagate( FGElectricalComponent *node, double dt,
             node->set_load_amps( total_load );
         }
 
-        node->set_available_amps( input_amps - total_load );
+        node->set_available_amps( frame.input_amps - total_load );
 
-        // publish values to specified properties
-        for ( i = 0; i < node->get_num_props(); ++i ) {
-            fgSetFloat( node->get_prop(i).c_str(), node->get_volts() );
+        publish( frame.node, false );
+
+        _stack.pop_back();
+        if ( _stack.empty() ) {
+            return total_load;
         }
+        _stack.back().total_load += total_load;
+    }
+}
 
-        /*
-        cout << s << node->get_name() << " -> (volts) " << node->get_volts()
-             << endl;
-        cout << s << node->get_name() << " -> (load amps) " << total_load
-             << endl;
-        cout << s << node->get_name() << " -> (input amps) " << input_amps
-             << endl;
-        cout << s << node->get_name() << " -> (extra amps) "
-             << node->get_available_amps() << endl;
-        */
 
-        return total_load;
-    } else {
-        // cout << s << "no further propagation" << endl;
-        return 0.0;
+// publish the voltage of a node to its properties
+void FGElectricalSystem::publish( int n, bool if_changed ) {
+    float volts = _components[n]->get_volts();
+    for ( int i = _first_prop[n]; i < _first_prop[n + 1]; ++i ) {
+        SGPropertyNode *prop = _prop_nodes[i];
+        if ( !if_changed || prop->getFloatValue() != volts ) {
+            prop->setFloatValue( volts );
+        }
     }
 }
 
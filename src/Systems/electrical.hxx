@@ -162,6 +162,7 @@ public:
     float get_output_volts();
     float get_output_amps();
     float get_charge_amps() const { return charge_amps; }
+    float get_percent_remaining() const { return percent_remaining; }
 };
 
 
@@ -252,9 +253,6 @@ public:
     virtual void update (double dt);
 
     bool build (SGPropertyNode* config_props);
-    float propagate( FGElectricalComponent *node, double dt,
-                     float input_volts, float input_amps,
-                     string s = "" );
     FGElectricalComponent *find ( const string &name );
 
 protected:
@@ -263,6 +261,16 @@ protected:
 
 private:
 
+    void compile();
+    bool steady();
+    void solve( double dt );
+    void replay( double dt );
+    float propagate( int node, double dt,
+                     float input_volts, float input_amps );
+    bool enter( int node, double dt, float input_volts, float input_amps,
+                float& load );
+    void publish( int node, bool if_changed );
+
     string name;
     int num;
     string path;
@@ -276,6 +284,48 @@ private:
 
     SGPropertyNode_ptr _volts_out;
     SGPropertyNode_ptr _amps_out;
+
+    // The network as built by compile(): all the components, the outputs
+    // of component i in _edges[_first_edge[i], _first_edge[i+1]) and the
+    // properties it publishes in _prop_nodes[_first_prop[i], ...).
+    comp_list _components;
+    vector<int> _first_edge;
+    vector<int> _edges;
+    vector<int> _first_prop;
+    vector<SGPropertyNode_ptr> _prop_nodes;
+    vector<bool> _closed;       // connectors whose switches are all on
+
+    // The state of the suppliers when the last solution was computed, and
+    // the loads applied to them, in order. When the switches and the
+    // suppliers are as they were, and the last solution did not change a
+    // battery charge, the next one is the same and is replayed.
+    struct Load {
+        FGElectricalSupplier *supplier;
+        float amps;
+        bool check;             // warn when drawing more than available
+    };
+    vector<Load> _loads;
+    vector<float> _supplier_state;
+    bool _solved;
+    bool _serviceable;
+
+    // propagation stack, see propagate()
+    struct Frame {
+        int node;
+        int edge;
+        float volts;
+        float input_amps;
+        float total_load;
+    };
+    vector<Frame> _stack;
+
+    SGPropertyNode_ptr _serviceable_node;
+    SGPropertyNode_ptr _alternator_node;
+    SGPropertyNode_ptr _master_bat_node;
+    SGPropertyNode_ptr _master_alt_node;
+    SGPropertyNode_ptr _rpm_node;
+    SGPropertyNode_ptr _beacon_node;
+    SGPropertyNode_ptr _nav_lights_node;
 };
 
 
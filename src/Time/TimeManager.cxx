@@ -112,6 +112,7 @@ void TimeManager::init()
     _modelHz = fgGetNode("sim/model-hz", true);
     _timeDelta = fgGetNode("sim/time/delta-realtime-sec", true);
     _simTimeDelta = fgGetNode("sim/time/delta-sec", true);
+    _simTimeRemainder = fgGetNode("sim/time/remainder-sec", true);
 
     _simTimeFactor = fgGetNode("/sim/speed-up", true);
     // use pre-set value but ensure we get a sane default
@@ -135,6 +136,7 @@ void TimeManager::unbind()
     _modelHz.clear();
     _timeDelta.clear();
     _simTimeDelta.clear();
+    _simTimeRemainder.clear();
     _simTimeFactor.clear();
 }
 
@@ -244,6 +246,9 @@ void TimeManager::computeTimeDeltas(double& simDt, double& realDt)
 // These are useful, especially for Nasal scripts.
   _timeDelta->setDoubleValue(realDt);
   _simTimeDelta->setDoubleValue(simDt);
+  // the time left over for the next frame, in sim time
+  _simTimeRemainder->setDoubleValue(simDt > 0 ?
+      _dtRemainder * _simTimeFactor->getDoubleValue() : 0.0);
 }
 
 void TimeManager::update(double dt)
@@ -91,7 +91,7 @@ private:
   
   SGPropertyNode_ptr _sceneryLoaded;
   SGPropertyNode_ptr _modelHz;
-  SGPropertyNode_ptr _timeDelta, _simTimeDelta;
+  SGPropertyNode_ptr _timeDelta, _simTimeDelta, _simTimeRemainder;
 };
 
 #endif // of FG_TIME_TIMEMANAGER_HXX
@@ -0,0 +1,158 @@
+/******************************************************************************
+ * CompiledTimetable.cxx
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ *
+ **************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
+#ifdef _WIN32
+#  include <windows.h>
+#else
+#  include <sys/types.h>
+#  include <sys/stat.h>
+#  include <sys/mman.h>
+#  include <fcntl.h>
+#  include <unistd.h>
+#endif
+
+#include <boost/foreach.hpp>
+
+#include <simgear/debug/logstream.hxx>
+#include <simgear/misc/sg_dir.hxx>
+
+#include "CompiledTimetable.hxx"
+
+FGCompiledTimetable::FGCompiledTimetable() :
+  _data(0),
+  _size(0),
+#ifdef _WIN32
+  _file(INVALID_HANDLE_VALUE),
+  _mapping(0)
+#else
+  _fd(-1)
+#endif
+{
+}
+
+FGCompiledTimetable::~FGCompiledTimetable()
+{
+  close();
+}
+
+bool FGCompiledTimetable::open(const SGPath& path)
+{
+  close();
+
+#ifdef _WIN32
+  _file = CreateFileW(path.wstr().c_str(), GENERIC_READ, FILE_SHARE_READ, NULL,
+                      OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+  if (_file == INVALID_HANDLE_VALUE) {
+    return false;
+  }
+  LARGE_INTEGER size;
+  if (!GetFileSizeEx(_file, &size) || (size.QuadPart == 0)) {
+    close();
+    return false;
+  }
+  _size = static_cast<size_t>(size.QuadPart);
+  _mapping = CreateFileMappingW(_file, NULL, PAGE_READONLY, 0, 0, NULL);
+  if (_mapping) {
+    _data = static_cast<const char*>(MapViewOfFile(_mapping, FILE_MAP_READ, 0, 0, 0));
+  }
+#else
+  _fd = ::open(path.utf8Str().c_str(), O_RDONLY);
+  if (_fd < 0) {
+    return false;
+  }
+  struct stat st;
+  if ((fstat(_fd, &st) != 0) || (st.st_size == 0)) {
+    close();
+    return false;
+  }
+  _size = static_cast<size_t>(st.st_size);
+  void* data = mmap(0, _size, PROT_READ, MAP_PRIVATE, _fd, 0);
+  if (data != MAP_FAILED) {
+    _data = static_cast<const char*>(data);
+  }
+#endif
+
+  if (!_data) {
+    SG_LOG(SG_AI, SG_WARN, "Traffic: unable to map " << path);
+    close();
+    return false;
+  }
+
+  if (!_view.set(_data, _size)) {
+    SG_LOG(SG_AI, SG_WARN, "Traffic: " << path << " is not a compiled timetable "
+           "of this version, ignored");
+    close();
+    return false;
+  }
+
+  return true;
+}
+
+void FGCompiledTimetable::close()
+{
+  _view = TimetableView();
+
+#ifdef _WIN32
+  if (_data) {
+    UnmapViewOfFile(_data);
+  }
+  if (_mapping) {
+    CloseHandle(_mapping);
+  }
+  if (_file != INVALID_HANDLE_VALUE) {
+    CloseHandle(_file);
+  }
+  _mapping = 0;
+  _file = INVALID_HANDLE_VALUE;
+#else
+  if (_data) {
+    munmap(const_cast<char*>(_data), _size);
+  }
+  if (_fd >= 0) {
+    ::close(_fd);
+  }
+  _fd = -1;
+#endif
+
+  _data = 0;
+  _size = 0;
+}
+
+bool FGCompiledTimetable::isOutdated(const SGPath& path, const SGPath& dir)
+{
+  time_t compiled = path.modTime();
+
+  simgear::Dir trafficDir(dir);
+  simgear::PathList subDirs = trafficDir.children(simgear::Dir::TYPE_DIR | simgear::Dir::NO_DOT_OR_DOTDOT);
+  BOOST_FOREACH(SGPath p, subDirs) {
+    simgear::PathList files = simgear::Dir(p).children(simgear::Dir::TYPE_FILE, ".xml");
+    BOOST_FOREACH(SGPath xml, files) {
+      if (xml.modTime() > compiled) {
+        return true;
+      }
+    }
+  }
+
+  return false;
+}
@@ -0,0 +1,68 @@
+/* -*- Mode: C++ -*- *****************************************************
+ * CompiledTimetable.hxx
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ *
+ **************************************************************************/
+
+#ifndef _COMPILEDTIMETABLE_HXX_
+#define _COMPILEDTIMETABLE_HXX_
+
+#include <simgear/misc/sg_path.hxx>
+
+#include "TimetableFormat.hxx"
+
+/**
+ * A compiled timetable file (see TimetableFormat.hxx), mapped in memory
+ * for as long as the object lives.
+ */
+class FGCompiledTimetable
+{
+public:
+  FGCompiledTimetable();
+  ~FGCompiledTimetable();
+
+  /**
+   * Maps the file and checks its contents.
+   * @return false if the file cannot be mapped or is not a compiled
+   * timetable of this version and byte order
+   */
+  bool open(const SGPath& path);
+  void close();
+
+  const TimetableView& view() const { return _view; }
+  size_t size() const { return _size; }
+
+  /** @return true if any .xml file of the sub-directories of the traffic
+   * directory dir is newer than the compiled timetable path. */
+  static bool isOutdated(const SGPath& path, const SGPath& dir);
+
+private:
+  FGCompiledTimetable(const FGCompiledTimetable&);
+  FGCompiledTimetable& operator=(const FGCompiledTimetable&);
+
+  const char* _data;
+  size_t _size;
+#ifdef _WIN32
+  void* _file;
+  void* _mapping;
+#else
+  int _fd;
+#endif
+  TimetableView _view;
+};
+
+#endif
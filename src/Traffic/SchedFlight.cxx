@@ -48,6 +48,8 @@
 
 #include <string>
 #include <vector>
+#include <mutex>
+#include <unordered_set>
 
 #include <simgear/compiler.h>
 #include <simgear/props/props.hxx>
@@ -71,8 +73,22 @@ using std::string;
  * FGScheduledFlight stuff
  *****************************************************************************/
 
+const string* FGScheduledFlight::intern(const string& s)
+{
+  // The strings never go away and the nodes of the set never move, so the
+  // pointers stay valid. Flights are made both by the thread parsing the
+  // traffic files and by the main loop.
+  static std::mutex symbolsLock;
+  static std::unordered_set<string> symbols;
+
+  std::lock_guard<std::mutex> g(symbolsLock);
+  return &*symbols.insert(s).first;
+}
+
 FGScheduledFlight::FGScheduledFlight()
 {
+    static const string* empty = intern(string());
+    callsign = fltRules = depId = arrId = requiredAircraft = empty;
     departureTime  = 0;
     arrivalTime    = 0;
     cruiseAltitude = 0;
@@ -110,17 +126,17 @@ FGScheduledFlight::FGScheduledFlight(const string& cs,
 		   const string& rep,
                    const string& reqAC)
 {
-  callsign          = cs;
-  fltRules          = fr;
+  callsign          = intern(cs);
+  fltRules          = intern(fr);
   //departurePort.setId(depPrt);
   //arrivalPort.setId(arrPrt);
-  depId = depPrt;
-  arrId = arrPrt;
+  depId = intern(depPrt);
+  arrId = intern(arrPrt);
   //cerr << "Constructor: departure " << depId << ". arrival " << arrId << endl;
   //departureTime     = processTimeString(deptime);
   //arrivalTime       = processTimeString(arrtime);
   cruiseAltitude    = cruiseAlt;
-  requiredAircraft  = reqAC;
+  requiredAircraft  = intern(reqAC);
 
   // Process the repeat period string
   if (rep.find("WEEK",0) != string::npos)
@@ -152,47 +168,82 @@ FGScheduledFlight::FGScheduledFlight(const string& cs,
 }
 
 
+FGScheduledFlight::FGScheduledFlight(const string& cs,
+                                     const string& fr,
+                                     const string& depPrt,
+                                     const string& arrPrt,
+                                     int cruiseAlt,
+                                     int depWeekday, int depSecond,
+                                     int arrWeekday, int arrSecond,
+                                     time_t rep,
+                                     const string& reqAC)
+{
+  callsign          = intern(cs);
+  fltRules          = intern(fr);
+  depId             = intern(depPrt);
+  arrId             = intern(arrPrt);
+  cruiseAltitude    = cruiseAlt;
+  requiredAircraft  = intern(reqAC);
+  repeatPeriod      = rep;
+
+  departureTime = processTime(depWeekday, depSecond);
+  arrivalTime   = processTime(arrWeekday, arrSecond);
+  if (departureTime > arrivalTime)
+    {
+      departureTime -= repeatPeriod;
+    }
+  initialized = false;
+  available   = true;
+  departurePort = NULL;
+  arrivalPort = NULL;
+}
+
 FGScheduledFlight:: ~FGScheduledFlight()
 {
 }
 
 time_t FGScheduledFlight::processTimeString(const string& theTime)
 {
-  int weekday;
-  int timeOffsetInDays;
-  int targetHour;
-  int targetMinute;
-  int targetSecond;
-
-  tm targetTimeDate;
-  SGTime* currTimeDate = globals->get_time_params();
- 
+  int weekday = -1;
   string timeCopy = theTime;
 
-
   // okay first split theTime string into
   // weekday, hour, minute, second;
   // Check if a week day is specified 
   if (timeCopy.find("/",0) != string::npos)
     {
       weekday          = atoi(timeCopy.substr(0,1).c_str());
-      timeOffsetInDays = weekday - currTimeDate->getGmt()->tm_wday;
       timeCopy = timeCopy.substr(2,timeCopy.length());
     }
+  // TODO: verify status of each token.
+  int targetHour   = atoi(timeCopy.substr(0,2).c_str());
+  int targetMinute = atoi(timeCopy.substr(3,5).c_str());
+  int targetSecond = atoi(timeCopy.substr(6,8).c_str());
+
+  return processTime(weekday, (targetHour*60 + targetMinute)*60 + targetSecond);
+}
+
+time_t FGScheduledFlight::processTime(int weekday, int secondOfDay)
+{
+  int timeOffsetInDays;
+
+  tm targetTimeDate;
+  SGTime* currTimeDate = globals->get_time_params();
+
+  if (weekday >= 0)
+    {
+      timeOffsetInDays = weekday - currTimeDate->getGmt()->tm_wday;
+    }
   else 
     {
       timeOffsetInDays = 0;
     }
-  // TODO: verify status of each token.
-  targetHour   = atoi(timeCopy.substr(0,2).c_str());
-  targetMinute = atoi(timeCopy.substr(3,5).c_str());
-  targetSecond = atoi(timeCopy.substr(6,8).c_str());
   targetTimeDate.tm_year  = currTimeDate->getGmt()->tm_year;
   targetTimeDate.tm_mon   = currTimeDate->getGmt()->tm_mon;
   targetTimeDate.tm_mday  = currTimeDate->getGmt()->tm_mday;
-  targetTimeDate.tm_hour  = targetHour;
-  targetTimeDate.tm_min   = targetMinute;
-  targetTimeDate.tm_sec   = targetSecond;
+  targetTimeDate.tm_hour  = secondOfDay / 3600;
+  targetTimeDate.tm_min   = (secondOfDay / 60) % 60;
+  targetTimeDate.tm_sec   = secondOfDay % 60;
 
   time_t processedTime = sgTimeGetGMT(&targetTimeDate);
   processedTime += timeOffsetInDays*24*60*60;
@@ -271,16 +322,16 @@ FGAirport * FGScheduledFlight::getArrivalAirport  ()
 bool FGScheduledFlight::initializeAirports()
 {
   //cerr << "Initializing using : " << depId << " " << arrId << endl;
-  departurePort = FGAirport::findByIdent(depId);
+  departurePort = FGAirport::findByIdent(*depId);
   if(departurePort == NULL)
     {
-      SG_LOG( SG_AI, SG_DEBUG, "Traffic manager could not find departure airport : " << depId);
+      SG_LOG( SG_AI, SG_DEBUG, "Traffic manager could not find departure airport : " << *depId);
       return false;
     }
-  arrivalPort = FGAirport::findByIdent(arrId);
+  arrivalPort = FGAirport::findByIdent(*arrId);
   if(arrivalPort == NULL)
     {
-      SG_LOG( SG_AI, SG_DEBUG, "Traffic manager could not find arrival airport   : " << arrId);
+      SG_LOG( SG_AI, SG_DEBUG, "Traffic manager could not find arrival airport   : " << *arrId);
       return false;
     }
 
@@ -45,13 +45,14 @@ class FGAirport;
 class FGScheduledFlight
 {
 private:
-  std::string callsign;
-  std::string fltRules;
+  // interned, see intern()
+  const std::string* callsign;
+  const std::string* fltRules;
   FGAirport *departurePort;
   FGAirport *arrivalPort;
-  std::string depId;
-  std::string arrId;
-  std::string requiredAircraft;
+  const std::string* depId;
+  const std::string* arrId;
+  const std::string* requiredAircraft;
   time_t departureTime;
   time_t arrivalTime;
   time_t repeatPeriod;
@@ -76,6 +77,19 @@ public:
                     const std::string& rep,
                     const std::string& reqAC
   );
+  // The departure and arrival times given as a weekday (0-6, or -1 for
+  // any day) and a number of seconds since midnight, the repeat period in
+  // seconds. Used to load compiled timetables.
+  FGScheduledFlight(const std::string& cs,
+                    const std::string& fr,
+                    const std::string& depPrt,
+                    const std::string& arrPrt,
+                    int cruiseAlt,
+                    int depWeekday, int depSecond,
+                    int arrWeekday, int arrSecond,
+                    time_t rep,
+                    const std::string& reqAC
+  );
   ~FGScheduledFlight();
 
   void update();
@@ -86,8 +100,8 @@ public:
   time_t getDepartureTime() { return departureTime; };
   time_t getArrivalTime  () { return arrivalTime;   };
   
-  void setDepartureAirport(const std::string& port) { depId = port; };
-  void setArrivalAirport  (const std::string& port) { arrId = port; };
+  void setDepartureAirport(const std::string& port) { depId = intern(port); };
+  void setArrivalAirport  (const std::string& port) { arrId = intern(port); };
   FGAirport *getDepartureAirport();
   FGAirport *getArrivalAirport  ();
 
@@ -97,25 +111,45 @@ public:
   { 
     return (departureTime < other.departureTime); 
   };
-  const std::string& getFlightRules() { return fltRules; };
+  const std::string& getFlightRules() { return *fltRules; };
 
   time_t processTimeString(const std::string& time);
-  const std::string& getCallSign() {return callsign; };
-  const std::string& getRequirement() { return requiredAircraft; }
+  time_t processTime(int weekday, int secondOfDay);
+  const std::string& getCallSign() {return *callsign; };
+  const std::string& getRequirement() { return *requiredAircraft; }
+  const std::string* getRequirementSymbol() const { return requiredAircraft; }
 
   void lock()    { available = false; };
   void release() { available = true;  };
 
   bool isAvailable() { return available; };
 
-  void setCallSign(const std::string& val)    { callsign = val; };
-  void setFlightRules(const std::string& val) { fltRules = val; };
+  void setCallSign(const std::string& val)    { callsign = intern(val); };
+  void setFlightRules(const std::string& val) { fltRules = intern(val); };
+
+  // Returns the one copy of s shared by all flights. Idents, callsigns
+  // and aircraft requirements are few and repeat over many flights; two
+  // interned strings are equal when their pointers are.
+  static const std::string* intern(const std::string& s);
 };
 
 typedef std::vector<FGScheduledFlight*>           FGScheduledFlightVec;
 typedef std::vector<FGScheduledFlight*>::iterator FGScheduledFlightVecIterator;
 
-typedef std::map < std::string, FGScheduledFlightVec > FGScheduledFlightMap;
+// The flights requiring a given aircraft, in order of departure. The times
+// of the flights only move when one of them has arrived (see adjustTime()),
+// so the order holds from adjustedAt until validUntil, the first arrival.
+struct FGScheduledFlightList
+{
+  FGScheduledFlightList() : adjustedAt(0), validUntil(0) {}
+
+  FGScheduledFlightVec flights;
+  time_t adjustedAt;
+  time_t validUntil;
+};
+
+// Keyed by interned requirement.
+typedef std::map < const std::string*, FGScheduledFlightList > FGScheduledFlightMap;
 
 bool compareScheduledFlights(FGScheduledFlight *a, FGScheduledFlight *b);
 
@@ -261,6 +261,7 @@ bool FGAISchedule::update(time_t now, const SGVec3d& userCart)
     // and detach it from the current list of aircraft. 
     flight->update();
     flights.erase(flights.begin()); // pop_front(), effectively
+    distanceToUser = -1; // unknown until the next flight is positioned
     return true; // processing complete
   }
   
@@ -328,6 +329,34 @@ bool FGAISchedule::update(time_t now, const SGVec3d& userCart)
     return true; // processing complete
 }
 
+/**
+ *  Returns the time at which update() needs to be called again, following a
+ *  call that completed. Until then nothing changes for a distant aircraft:
+ *  its current flight is not over and, even closing in on the user at
+ *  TRAFFICMAXCLOSINGSPEED, it cannot come within TRAFFICTOAIDISTTOSTART.
+ */
+time_t FGAISchedule::getNextUpdateTime(time_t now)
+{
+  if (!scheduleComplete || flights.empty()) {
+    return now;
+  }
+
+  if (aiAircraft) {
+    // the AIManager handles it; look for its end now and then
+    return aiAircraft->getDie() ? now : now + 10;
+  }
+
+  FGScheduledFlight* flight = flights.front();
+  if ((flight->getArrivalTime() < now) || (distanceToUser < 0)) {
+    return now; // catching up with flights in the past
+  }
+
+  time_t next = flight->getArrivalTime() + 1;
+  double margin = distanceToUser - TRAFFICTOAIDISTTOSTART;
+  time_t closest = now + static_cast<time_t>(margin * 3600.0 / TRAFFICMAXCLOSINGSPEED);
+  return std::min(next, std::max(closest, now + 1));
+}
+
 bool FGAISchedule::validModelPath(const std::string& modelPath)
 {
     return (resolveModelPath(modelPath) != SGPath());
@@ -558,9 +587,10 @@ FGScheduledFlight* FGAISchedule::findAvailableFlight (const string &currentDesti
     time_t now = globals->get_time_params()->get_cur_time();
 
     FGTrafficManager *tmgr = (FGTrafficManager *) globals->get_subsystem("traffic-manager");
-    FGScheduledFlightVecIterator fltBegin, fltEnd;
-    fltBegin = tmgr->getFirstFlight(req);
-    fltEnd   = tmgr->getLastFlight(req);
+    // the list only holds flights requiring req, sorted by departure
+    FGScheduledFlightVec& candidates = tmgr->getFlights(FGScheduledFlight::intern(req), now);
+    FGScheduledFlightVecIterator fltBegin = candidates.begin(),
+                                 fltEnd   = candidates.end();
 
 
      //cerr << "Finding available flight " << endl;
@@ -570,12 +600,6 @@ FGScheduledFlight* FGAISchedule::findAvailableFlight (const string &currentDesti
           //cerr << "No Flights Scheduled for " << req << endl;
      }
      int counter = 0;
-     for (FGScheduledFlightVecIterator i = fltBegin; i != fltEnd; i++) {
-          (*i)->adjustTime(now);
-           //sort(fltBegin, fltEnd, compareScheduledFlights);
-           //cerr << counter++ << endl;
-     }
-     std::sort(fltBegin, fltEnd, compareScheduledFlights);
      for (FGScheduledFlightVecIterator i = fltBegin; i != fltEnd; i++) {
           //bool valid = true;
           counter++;
@@ -583,9 +607,6 @@ FGScheduledFlight* FGAISchedule::findAvailableFlight (const string &currentDesti
                //cerr << (*i)->getCallSign() << "is no longer available" << endl;
                continue;
           }
-          if (!((*i)->getRequirement() == req)) {
-               continue;
-          }
           if (!(((*i)->getArrivalAirport()) && ((*i)->getDepartureAirport()))) {
               continue;
           }
@@ -31,6 +31,12 @@
 
 #define TRAFFICTOAIDISTTOSTART 150.0
 #define TRAFFICTOAIDISTTODIE   200.0
+// Highest speed at which the user and a distant aircraft may close in, in
+// knots; used to tell how long a distant aircraft can be left alone.
+#define TRAFFICMAXCLOSINGSPEED 2000.0
+// A move of the user farther than this between two frames, in nm, is taken
+// for a jump to another place.
+#define TRAFFICMAXUSERJUMP     20.0
 
 // forward decls
 class FGAIAircraft;
@@ -103,6 +109,7 @@ class FGAISchedule
     
   bool update(time_t now, const SGVec3d& userCart);
   bool init();
+  time_t getNextUpdateTime(time_t now);
 
   double getSpeed         ();
   //void setClosestDistanceToUser();
@@ -120,6 +127,9 @@ class FGAISchedule
   const std::string& getAircraft       () { return acType; };
   std::string getCallSign       ();
   const std::string& getRegistration   () { return registration;};
+  const std::string& getHomePort       () { return homePort; };
+  double getDistanceToUser        () { return distanceToUser; };
+  bool isValid                    () { return valid; };
   std::string getFlightRules    ();
   bool getHeavy                   () { return heavy; };
   double getCourse                () { return courseToDest; };
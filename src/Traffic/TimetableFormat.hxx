@@ -0,0 +1,184 @@
+/* -*- Mode: C++ -*- *****************************************************
+ * TimetableFormat.hxx
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ *
+ **************************************************************************/
+
+/**************************************************************************
+ * Layout of the compiled traffic timetables written by fgtraffic and read
+ * by the traffic manager.
+ *
+ * A compiled timetable holds the aircraft and the flights of a set of
+ * traffic files. It is made to be mapped in memory and used in place:
+ * every record has a fixed size and every string is stored once, in a
+ * string table, and referred to by its index. A file is made of:
+ *
+ * - a TimetableHeader;
+ * - the aircraft, as TimetableAircraft records;
+ * - the flights, as TimetableFlight records;
+ * - the offsets of the strings in the string data, as 32 bit integers;
+ * - the string data: the strings, each followed by a nul character.
+ *
+ * The numbers are written in the byte order of the machine that compiled
+ * the file; a file from a machine of the other order is rejected.
+ *
+ * The aircraft without a required-aircraft key get one at load time; their
+ * record, and the records of the flights that go with them, hold a number
+ * instead of a string, marked by TIMETABLE_AUTO_KEY.
+ *
+ * The aircraft that came from a .conf file are marked TIMETABLE_FROM_CONF:
+ * like the traffic manager's own reading of those files, the loader keeps
+ * all of them instead of a sample of /sim/traffic-manager/proportion.
+ **************************************************************************/
+
+#ifndef _TIMETABLEFORMAT_HXX_
+#define _TIMETABLEFORMAT_HXX_
+
+#include <cstddef>
+#include <cstring>
+#include <stdint.h>
+
+#define TIMETABLE_MAGIC      "FGTT"
+#define TIMETABLE_VERSION    2
+#define TIMETABLE_BYTE_ORDER 0x01020304
+#define TIMETABLE_AUTO_KEY   0x80000000u
+#define TIMETABLE_NO_WEEKDAY (-1)
+
+// TimetableAircraft::flags
+#define TIMETABLE_HEAVY      0x1
+#define TIMETABLE_FROM_CONF  0x2
+
+struct TimetableHeader
+{
+  char     magic[4];
+  uint32_t version;
+  uint32_t byteOrder;
+  uint32_t aircraftCount;
+  uint32_t flightCount;
+  uint32_t stringCount;
+  uint32_t stringBytes;
+  uint32_t reserved;
+};
+
+struct TimetableAircraft
+{
+  uint32_t model;
+  uint32_t livery;
+  uint32_t homePort;
+  uint32_t registration;
+  uint32_t requiredAircraft;   // string, or number | TIMETABLE_AUTO_KEY
+  uint32_t acType;
+  uint32_t airline;
+  uint32_t performanceClass;
+  uint32_t flightType;
+  float    radius;
+  float    offset;
+  uint32_t flags;              // TIMETABLE_HEAVY, TIMETABLE_FROM_CONF
+};
+
+struct TimetableFlight
+{
+  uint32_t callsign;
+  uint32_t flightRules;
+  uint32_t departurePort;
+  uint32_t arrivalPort;
+  uint32_t requiredAircraft;   // string, or number | TIMETABLE_AUTO_KEY
+  int32_t  cruiseAltitude;
+  int32_t  departureSecond;    // seconds since midnight
+  int32_t  arrivalSecond;
+  int8_t   departureWeekday;   // 0-6 or TIMETABLE_NO_WEEKDAY
+  int8_t   arrivalWeekday;
+  int16_t  reserved;
+  int32_t  repeatPeriod;       // seconds
+};
+
+/**
+ * Read-only access to a compiled timetable held in memory.
+ */
+class TimetableView
+{
+public:
+  TimetableView() : _header(0), _aircraft(0), _flights(0),
+                    _stringOffsets(0), _strings(0) {}
+
+  /**
+   * Checks the block and sets the view on it.
+   * @return false if the block is not a complete compiled timetable
+   */
+  bool set(const char* data, size_t size)
+  {
+    _header = 0;
+    if (size < sizeof(TimetableHeader))
+      return false;
+
+    const TimetableHeader* header = reinterpret_cast<const TimetableHeader*>(data);
+    if (memcmp(header->magic, TIMETABLE_MAGIC, 4) ||
+        (header->version != TIMETABLE_VERSION) ||
+        (header->byteOrder != TIMETABLE_BYTE_ORDER))
+      return false;
+
+    size_t expected = sizeof(TimetableHeader)
+      + header->aircraftCount * sizeof(TimetableAircraft)
+      + header->flightCount * sizeof(TimetableFlight)
+      + header->stringCount * sizeof(uint32_t)
+      + header->stringBytes;
+    if ((size != expected) ||
+        ((header->stringBytes > 0) && data[size - 1] != '\0'))
+      return false;
+
+    const char* p = data + sizeof(TimetableHeader);
+    _aircraft = reinterpret_cast<const TimetableAircraft*>(p);
+    p += header->aircraftCount * sizeof(TimetableAircraft);
+    _flights = reinterpret_cast<const TimetableFlight*>(p);
+    p += header->flightCount * sizeof(TimetableFlight);
+    _stringOffsets = reinterpret_cast<const uint32_t*>(p);
+    p += header->stringCount * sizeof(uint32_t);
+    _strings = p;
+
+    for (uint32_t i = 0; i < header->stringCount; i++) {
+      if (_stringOffsets[i] >= header->stringBytes)
+        return false;
+    }
+
+    _header = header;
+    return true;
+  }
+
+  bool valid() const { return _header != 0; }
+
+  uint32_t aircraftCount() const { return _header->aircraftCount; }
+  uint32_t flightCount() const { return _header->flightCount; }
+  const TimetableAircraft& aircraft(uint32_t i) const { return _aircraft[i]; }
+  const TimetableFlight& flight(uint32_t i) const { return _flights[i]; }
+
+  /** @return the string of the given index, or "" for a bad index. */
+  const char* string(uint32_t i) const
+  {
+    if (i >= _header->stringCount)
+      return "";
+    return _strings + _stringOffsets[i];
+  }
+
+private:
+  const TimetableHeader* _header;
+  const TimetableAircraft* _aircraft;
+  const TimetableFlight* _flights;
+  const uint32_t* _stringOffsets;
+  const char* _strings;
+};
+
+#endif
@@ -42,6 +42,19 @@
 
 #include <stdlib.h>
 #include <time.h>
+#include <stdio.h>
+
+#if defined(_WIN32)
+#  include <windows.h>
+#  include <psapi.h>
+#  ifdef _MSC_VER
+#    pragma comment(lib, "psapi.lib")
+#  endif
+#elif defined(__APPLE__)
+#  include <mach/mach.h>
+#else
+#  include <unistd.h>
+#endif
 #include <cstring>
 #include <iostream>
 #include <fstream>
@@ -49,6 +62,8 @@
 
 #include <string>
 #include <vector>
+#include <map>
+#include <cmath>
 #include <algorithm>
 #include <boost/foreach.hpp>
 
@@ -77,6 +92,7 @@
 #include <Main/fg_props.hxx>
 
 #include "TrafficMgr.hxx"
+#include "CompiledTimetable.hxx"
 
 using std::sort;
 using std::strcmp;
@@ -84,6 +100,42 @@ using std::endl;
 using std::string;
 using std::vector;
 
+// number of flights in a chunk of the flight pool
+#define FLIGHT_POOL_CHUNK 1024
+
+/**
+ * Resident memory of the process in MiB, or -1 where it is unknown, to
+ * report what loading the traffic costs. It covers the whole process, so
+ * the other threads' allocations meanwhile are counted in too.
+ */
+static double residentMiB()
+{
+#if defined(_WIN32)
+    PROCESS_MEMORY_COUNTERS counters;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+        return counters.WorkingSetSize / 1048576.0;
+    }
+#elif defined(__APPLE__)
+    mach_task_basic_info_data_t info;
+    mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+    if (task_info(mach_task_self(), MACH_TASK_BASIC_INFO,
+                  (task_info_t) &info, &count) == KERN_SUCCESS) {
+        return info.resident_size / 1048576.0;
+    }
+#else
+    FILE* statm = fopen("/proc/self/statm", "r");
+    if (statm) {
+        long size, resident;
+        int n = fscanf(statm, "%ld %ld", &size, &resident);
+        fclose(statm);
+        if (n == 2) {
+            return resident * (double) sysconf(_SC_PAGESIZE) / 1048576.0;
+        }
+    }
+#endif
+    return -1;
+}
+
 /**
  * Thread encapsulating parsing the traffic schedules.
  */
@@ -266,15 +318,15 @@ public:
                        << arrivalTime << "," << repeat << "," << requiredAircraft);
             }
 
-            _trafficManager->flights[requiredAircraft].push_back(new FGScheduledFlight(callsign,
-                                                                      fltrules,
-                                                                      departurePort,
-                                                                      arrivalPort,
-                                                                      cruiseAlt,
-                                                                      departureTime,
-                                                                      arrivalTime,
-                                                                      repeat,
-                                                                      requiredAircraft));
+            _trafficManager->addFlight(FGScheduledFlight(callsign,
+                                                         fltrules,
+                                                         departurePort,
+                                                         arrivalPort,
+                                                         cruiseAlt,
+                                                         departureTime,
+                                                         arrivalTime,
+                                                         repeat,
+                                                         requiredAircraft));
             requiredAircraft = "";
         } else if (!strcmp(name, "aircraft")) {
             endAircraft();
@@ -308,8 +360,86 @@ public:
                "Error: " << message << " (" << line << ',' << column << ')');
     }
 
+    /**
+     * Load the aircraft and the flights of a timetable compiled by
+     * fgtraffic. The aircraft go through the same checks as the ones
+     * read from XML files.
+     */
+    bool loadCompiledTimetable(const SGPath& path)
+    {
+        SGTimeStamp st;
+        st.stamp();
+        double rss = residentMiB();
+
+        FGCompiledTimetable timetable;
+        if (!timetable.open(path)) {
+            return false;
+        }
+        const TimetableView& view = timetable.view();
+
+        // the aircraft without a key of their own are numbered from here
+        int firstCounter = acCounter;
+
+        for (uint32_t i = 0; i < view.flightCount(); i++) {
+            const TimetableFlight& f = view.flight(i);
+            string key = compiledKey(view, f.requiredAircraft, firstCounter);
+            _trafficManager->addFlight(FGScheduledFlight(view.string(f.callsign),
+                                                         view.string(f.flightRules),
+                                                         view.string(f.departurePort),
+                                                         view.string(f.arrivalPort),
+                                                         f.cruiseAltitude,
+                                                         f.departureWeekday, f.departureSecond,
+                                                         f.arrivalWeekday, f.arrivalSecond,
+                                                         f.repeatPeriod,
+                                                         key));
+            if (_cancelThread) {
+                return true;
+            }
+        }
+
+        for (uint32_t i = 0; i < view.aircraftCount(); i++) {
+            const TimetableAircraft& a = view.aircraft(i);
+            mdl = view.string(a.model);
+            livery = view.string(a.livery);
+            homePort = view.string(a.homePort);
+            registration = view.string(a.registration);
+            requiredAircraft = compiledKey(view, a.requiredAircraft, firstCounter);
+            acType = view.string(a.acType);
+            airline = view.string(a.airline);
+            m_class = view.string(a.performanceClass);
+            flighttype = view.string(a.flightType);
+            radius = a.radius;
+            offset = a.offset;
+            heavy = (a.flags & TIMETABLE_HEAVY) != 0;
+            endAircraft(!(a.flags & TIMETABLE_FROM_CONF));
+        }
+        acCounter = std::max(acCounter, firstCounter + (int) view.aircraftCount());
+
+        SG_LOG(SG_AI, SG_INFO, "loading compiled timetable " << path << " ("
+               << view.aircraftCount() << " aircraft, " << view.flightCount()
+               << " flights, " << timetable.size() / 1024 << " KiB) took:"
+               << st.elapsedMSec() << "msec, resident memory " << rss
+               << " -> " << residentMiB() << " MiB");
+        return true;
+    }
+
 private:
-    void endAircraft()
+    string compiledKey(const TimetableView& view, uint32_t key, int firstCounter)
+    {
+        if (key & TIMETABLE_AUTO_KEY) {
+            char buffer[16];
+            snprintf(buffer, 16, "%d", firstCounter + (int) (key & ~TIMETABLE_AUTO_KEY));
+            return buffer;
+        }
+        return view.string(key);
+    }
+
+    /**
+     * Adds the aircraft of the parser state to the traffic manager.
+     * @param sampled false to keep the aircraft whatever the traffic
+     * proportion, as readTimeTableFromFile() does for .conf files
+     */
+    void endAircraft(bool sampled = true)
     {
         string isHeavy = heavy ? "true" : "false";
 
@@ -326,12 +456,14 @@ private:
             return;
         }
 
-        int proportion =
-        (int) (fgGetDouble("/sim/traffic-manager/proportion") * 100);
-        int randval = rand() & 100;
-        if (randval > proportion) {
-            requiredAircraft = homePort = "";
-            return;
+        if (sampled) {
+            int proportion =
+            (int) (fgGetDouble("/sim/traffic-manager/proportion") * 100);
+            int randval = rand() & 100;
+            if (randval > proportion) {
+                requiredAircraft = homePort = "";
+                return;
+            }
         }
 
         if (fgGetBool("/sim/traffic-manager/dumpdata") == true) {
@@ -374,6 +506,19 @@ private:
     {
         SGTimeStamp st;
         st.stamp();
+        double rss = residentMiB();
+
+        // a timetable compiled by fgtraffic stands for the XML files, as
+        // long as none of them changed since
+        SGPath compiled = path / "timetable.fgtt";
+        if (compiled.exists()) {
+            if (FGCompiledTimetable::isOutdated(compiled, path)) {
+                SG_LOG(SG_AI, SG_WARN, "Traffic: " << compiled << " is older than "
+                       "the traffic files, ignored");
+            } else if (loadCompiledTimetable(compiled)) {
+                return;
+            }
+        }
 
         simgear::Dir trafficDir(path);
         simgear::PathList d = trafficDir.children(simgear::Dir::TYPE_DIR | simgear::Dir::NO_DOT_OR_DOTDOT);
@@ -390,7 +535,8 @@ private:
             }
         } // of sub-directories iteration
 
-        SG_LOG(SG_AI, SG_INFO, "parsing traffic schedules took:" << st.elapsedMSec() << "msec");
+        SG_LOG(SG_AI, SG_INFO, "parsing traffic schedules took:" << st.elapsedMSec()
+               << "msec, resident memory " << rss << " -> " << residentMiB() << " MiB");
     }
 
   FGTrafficManager* _trafficManager;
@@ -424,6 +570,8 @@ FGTrafficManager::FGTrafficManager() :
   doingInit(false),
   trafficSyncRequested(false),
   waitingMetarTime(0.0),
+  lastUpdateTime(0),
+  flightPoolUsed(0),
   enabled("/sim/traffic-manager/enabled"),
   aiEnabled("/sim/ai/enabled"),
   realWxEnabled("/environment/realwx/enabled"),
@@ -491,14 +639,52 @@ void FGTrafficManager::shutdown()
         cachefile.close();
     }
     scheduledAircraft.clear();
+    scheduleQueue.clear();
     flights.clear();
+    flightPool.clear();
+    flightPoolUsed = 0;
 
-    currAircraft = scheduledAircraft.begin();
     doingInit = false;
     inited = false;
     trafficSyncRequested = false;
 }
 
+// Copies flight into the pool and files it under its requirement. The
+// flights are never freed one by one, only all together at shutdown, so
+// they are made in chunks rather than each on the heap.
+FGScheduledFlight* FGTrafficManager::addFlight(const FGScheduledFlight& flight)
+{
+    if (flightPool.empty() || (flightPoolUsed == FLIGHT_POOL_CHUNK)) {
+        flightPool.push_back(std::unique_ptr<FGScheduledFlight[]>(new FGScheduledFlight[FLIGHT_POOL_CHUNK]));
+        flightPoolUsed = 0;
+    }
+    FGScheduledFlight* result = &flightPool.back()[flightPoolUsed++];
+    *result = flight;
+
+    FGScheduledFlightList& list = flights[result->getRequirementSymbol()];
+    list.flights.push_back(result);
+    list.validUntil = 0;
+    return result;
+}
+
+FGScheduledFlightVec& FGTrafficManager::getFlights(const std::string* ref, time_t now)
+{
+    FGScheduledFlightList& list = flights[ref];
+    if ((now < list.adjustedAt) || (now > list.validUntil)) {
+        time_t firstArrival = 0;
+        BOOST_FOREACH(FGScheduledFlight* flight, list.flights) {
+            flight->adjustTime(now);
+            if (!firstArrival || (flight->getArrivalTime() < firstArrival)) {
+                firstArrival = flight->getArrivalTime();
+            }
+        }
+        std::sort(list.flights.begin(), list.flights.end(), compareScheduledFlights);
+        list.adjustedAt = now;
+        list.validUntil = firstArrival;
+    }
+    return list.flights;
+}
+
 void FGTrafficManager::init()
 {
     if (!enabled) {
@@ -568,6 +754,11 @@ void FGTrafficManager::init()
             if (path.exists()) {
                 readTimeTableFromFile(path);
             }
+        } else if (path.extension() == "fgtt") {
+            ScheduleParseThread parser(this);
+            if (!parser.loadCompiledTimetable(path)) {
+                SG_LOG(SG_AI, SG_ALERT, "Unable to load traffic from " << path);
+            }
         } else {
              SG_LOG(SG_AI, SG_ALERT,
                                "Unknown data format " << path
@@ -595,8 +786,7 @@ void FGTrafficManager::finishInit()
 
     sort(scheduledAircraft.begin(), scheduledAircraft.end(),
          compareSchedules);
-    currAircraft = scheduledAircraft.begin();
-    currAircraftClosest = scheduledAircraft.begin();
+    buildScheduleQueue();
 
     doingInit = false;
     inited = true;
@@ -645,17 +835,87 @@ void FGTrafficManager::loadHeuristics()
       }
     }
 
-  for(currAircraft = scheduledAircraft.begin(); currAircraft != scheduledAircraft.end(); ++currAircraft) {
-        const string& registration = (*currAircraft)->getRegistration();
+  BOOST_FOREACH(FGAISchedule* acft, scheduledAircraft) {
+        const string& registration = acft->getRegistration();
         HeuristicMapIterator itr = heurMap.find(registration);
         if (itr != heurMap.end()) {
-            (*currAircraft)->setrunCount(itr->second.runCount);
-            (*currAircraft)->setHits(itr->second.hits);
-            (*currAircraft)->setLastUsed(itr->second.lastRun);
+            acft->setrunCount(itr->second.runCount);
+            acft->setHits(itr->second.hits);
+            acft->setLastUsed(itr->second.lastRun);
         }
     }
 }
 
+bool FGTrafficManager::laterScheduleEntry(const ScheduleQueueEntry& a,
+                                          const ScheduleQueueEntry& b)
+{
+    if (a.due != b.due)
+        return a.due > b.due;
+    if (a.distance != b.distance)
+        return a.distance > b.distance;
+    return a.order > b.order;
+}
+
+/**
+ * Queue all the schedules for an update, the ones based closest to the
+ * user first. Their actual position is only known once they have been
+ * updated, so the distance of their home port stands in for it.
+ */
+void FGTrafficManager::buildScheduleQueue()
+{
+    SGVec3d userCart = globals->get_aircraft_position_cart();
+    time_t now = globals->get_time_params()->get_cur_time();
+    std::map<string, double> homePortDistance;
+
+    scheduleQueue.clear();
+    scheduleQueue.reserve(scheduledAircraft.size());
+    for (unsigned int i = 0; i < scheduledAircraft.size(); ++i) {
+        FGAISchedule* schedule = scheduledAircraft[i];
+        const string& homePort = schedule->getHomePort();
+        std::map<string, double>::iterator itr = homePortDistance.find(homePort);
+        if (itr == homePortDistance.end()) {
+            double distance = HUGE_VAL;
+            FGAirportRef apt = FGAirport::findByIdent(homePort);
+            if (apt) {
+                distance = dist(userCart, apt->cart()) * SG_METER_TO_NM;
+            }
+            itr = homePortDistance.insert(std::make_pair(homePort, distance)).first;
+        }
+
+        ScheduleQueueEntry entry;
+        entry.due = now;
+        entry.distance = itr->second;
+        entry.order = i;
+        entry.schedule = schedule;
+        scheduleQueue.push_back(entry);
+    }
+    std::make_heap(scheduleQueue.begin(), scheduleQueue.end(), laterScheduleEntry);
+
+    SGPropertyNode* node = fgGetNode("/sim/traffic-manager", true);
+    budget = node->getNode("budget-ms", true);
+    if (!budget->hasValue()) {
+        budget->setDoubleValue(1.0);
+    }
+    statProcessed = node->getNode("stats/processed", true);
+    statQueued = node->getNode("stats/queued", true);
+    statOverdue = node->getNode("stats/overdue-sec", true);
+
+    lastUserCart = userCart;
+    lastUpdateTime = now;
+}
+
+/**
+ * The due times rely on the user flying and the time running forward;
+ * after a jump of either, update everything again.
+ */
+void FGTrafficManager::requeueSchedules(time_t now)
+{
+    BOOST_FOREACH(ScheduleQueueEntry& entry, scheduleQueue) {
+        entry.due = now;
+    }
+    std::make_heap(scheduleQueue.begin(), scheduleQueue.end(), laterScheduleEntry);
+}
+
 bool FGTrafficManager::metarReady(double dt)
 {
     // wait for valid METAR (when realWX is enabled only), since we need
@@ -716,22 +976,58 @@ void FGTrafficManager::update(double dt)
     }
 
 
-    if (scheduledAircraft.empty()) {
+    if (scheduleQueue.empty()) {
         return;
     }
 
     SGVec3d userCart = globals->get_aircraft_position_cart();
+    time_t now = globals->get_time_params()->get_cur_time();
 
-    if (currAircraft == scheduledAircraft.end()) {
-        currAircraft = scheduledAircraft.begin();
+    if ((now < lastUpdateTime) ||
+        (dist(userCart, lastUserCart) * SG_METER_TO_NM > TRAFFICMAXUSERJUMP)) {
+        requeueSchedules(now);
     }
+    lastUserCart = userCart;
+    lastUpdateTime = now;
+
+    // Update the schedules that are due, most urgent first, for as long as
+    // the time budget of the frame allows. At least one is updated in any
+    // case.
+    SGTimeStamp start;
+    start.stamp();
+    double budgetMSec = budget->getDoubleValue();
+    int processed = 0;
+
+    while (!scheduleQueue.empty() && (scheduleQueue.front().due <= now)) {
+        if ((processed > 0) && (start.elapsedMSec() >= budgetMSec)) {
+            break;
+        }
 
-    time_t now = globals->get_time_params()->get_cur_time();
+        std::pop_heap(scheduleQueue.begin(), scheduleQueue.end(), laterScheduleEntry);
+        ScheduleQueueEntry& entry = scheduleQueue.back();
+        FGAISchedule* schedule = entry.schedule;
+        processed++;
+
+        if (!schedule->update(now, userCart)) {
+            // schedule is not done - carry on with it next
+            entry.due = now;
+        } else if (!schedule->isValid()) {
+            // never flies again
+            scheduleQueue.pop_back();
+            continue;
+        } else {
+            entry.due = schedule->getNextUpdateTime(now);
+            entry.distance = schedule->getDistanceToUser();
+        }
+        std::push_heap(scheduleQueue.begin(), scheduleQueue.end(), laterScheduleEntry);
+    }
 
-    //cerr << "Processing << " << (*currAircraft)->getRegistration() << " with score " << (*currAircraft)->getScore() << endl;
-    if ((*currAircraft)->update(now, userCart)) {
-        // schedule is done - process another aircraft in next iteration
-        currAircraft++;
+    statProcessed->setIntValue(processed);
+    statQueued->setIntValue(scheduleQueue.size());
+    if (!scheduleQueue.empty() && (scheduleQueue.front().due < now)) {
+        statOverdue->setDoubleValue(now - scheduleQueue.front().due);
+    } else {
+        statOverdue->setDoubleValue(0.0);
     }
 }
 
@@ -755,6 +1051,10 @@ void FGTrafficManager::readTimeTableFromFile(SGPath infileName)
     vector <string> tokens, depTime,arrTime;
     vector <string>::iterator it;
 
+    SGTimeStamp st;
+    st.stamp();
+    double rss = residentMiB();
+
     sg_ifstream infile(infileName);
     while (1) {
          infile.getline(buffer, 256);
@@ -876,21 +1176,24 @@ void FGTrafficManager::readTimeTableFromFile(SGPath infileName)
                                                       << repeat        << " "
                                                       <<  requiredAircraft);
 
-                         flights[requiredAircraft].push_back(new FGScheduledFlight(callsign,
-                                                                 fltrules,
-                                                                 departurePort,
-                                                                 arrivalPort,
-                                                                 cruiseAlt,
-                                                                 departureTime,
-                                                                 arrivalTime,
-                                                                 repeat,
-                                                                 requiredAircraft));
+                         addFlight(FGScheduledFlight(callsign,
+                                                     fltrules,
+                                                     departurePort,
+                                                     arrivalPort,
+                                                     cruiseAlt,
+                                                     departureTime,
+                                                     arrivalTime,
+                                                     repeat,
+                                                     requiredAircraft));
                     }
                 }
              }
          }
 
     }
+    SG_LOG(SG_AI, SG_INFO, "reading traffic from " << infileName << " took:"
+           << st.elapsedMSec() << "msec, resident memory " << rss
+           << " -> " << residentMiB() << " MiB");
     //exit(1);
 }
 
@@ -86,9 +86,32 @@ private:
   std::string waitingMetarStation;
   
   ScheduleVector scheduledAircraft;
-  ScheduleVectorIterator currAircraft, currAircraftClosest;
+
+  // The schedules, in a heap ordered by the time they need an update, then
+  // by distance to the user; see update().
+  struct ScheduleQueueEntry
+  {
+    time_t due;
+    double distance;
+    unsigned int order;   // rank in scheduledAircraft, sorted by score
+    FGAISchedule* schedule;
+  };
+  static bool laterScheduleEntry(const ScheduleQueueEntry& a,
+                                 const ScheduleQueueEntry& b);
+  std::vector<ScheduleQueueEntry> scheduleQueue;
+  SGVec3d lastUserCart;
+  time_t lastUpdateTime;
+  SGPropertyNode_ptr budget, statProcessed, statQueued, statOverdue;
+
+  void buildScheduleQueue();
+  void requeueSchedules(time_t now);
     
   FGScheduledFlightMap flights;
+  // the flights live here, in chunks, see addFlight()
+  std::vector<std::unique_ptr<FGScheduledFlight[]> > flightPool;
+  size_t flightPoolUsed;
+
+  FGScheduledFlight* addFlight(const FGScheduledFlight& flight);
 
   void readTimeTableFromFile(SGPath infilename);
     void Tokenize(const std::string& str, std::vector<std::string>& tokens, const std::string& delimiters = " ");
@@ -116,8 +139,11 @@ public:
   void init();
   void update(double time);
 
-    FGScheduledFlightVecIterator getFirstFlight(const std::string &ref) { return flights[ref].begin(); }
-    FGScheduledFlightVecIterator getLastFlight(const std::string &ref) { return flights[ref].end(); }
+  /**
+   * @return the flights requiring the aircraft ref (an interned string,
+   * see FGScheduledFlight::intern()), moved to now and sorted by departure.
+   */
+  FGScheduledFlightVec& getFlights(const std::string* ref, time_t now);
 
 };
 
@@ -0,0 +1,150 @@
+// benchGenericProtocol.cxx -- send a generic protocol channel of a motion
+// platform's size over a loopback UDP socket, in ASCII and binary mode and
+// with frames batched, and time the sender and the receiver per frame.
+
+#include "config.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <simgear/io/sg_socket.hxx>
+#include <simgear/misc/sg_dir.hxx>
+#include <simgear/misc/sg_path.hxx>
+#include <simgear/props/props.hxx>
+#include <simgear/timing/timestamp.hxx>
+
+#include <Main/fg_props.hxx>
+#include <Main/globals.hxx>
+#include <Network/generic.hxx>
+
+static const int doubles = 8, floats = 8, ints = 4, bools = 4;
+
+static void writeChunks(std::ofstream& xml, const char* dir)
+{
+    int n = 0;
+    for (int i = 0; i < doubles; ++i, ++n)
+        xml << "   <chunk><node>/bench/" << dir << "/value[" << n
+            << "]</node><type>double</type><format>%.4f</format></chunk>\n";
+    for (int i = 0; i < floats; ++i, ++n)
+        xml << "   <chunk><node>/bench/" << dir << "/value[" << n
+            << "]</node><type>float</type><format>%.2f</format></chunk>\n";
+    for (int i = 0; i < ints; ++i, ++n)
+        xml << "   <chunk><node>/bench/" << dir << "/value[" << n
+            << "]</node><type>int</type><format>%d</format></chunk>\n";
+    for (int i = 0; i < bools; ++i, ++n)
+        xml << "   <chunk><node>/bench/" << dir << "/value[" << n
+            << "]</node><type>bool</type><format>%d</format></chunk>\n";
+}
+
+static std::string writeProtocol(const SGPath& root, bool binary, int batch)
+{
+    std::string name = std::string(binary ? "bench-binary-" : "bench-ascii-")
+                       + std::to_string(batch);
+    std::ofstream xml((root / "Protocol" / (name + ".xml")).utf8Str().c_str());
+    xml << "<?xml version=\"1.0\"?>\n<PropertyList>\n <generic>\n";
+    const char* sections[] = { "output", "input" };
+    const char* dirs[] = { "out", "in" };
+    for (int s = 0; s < 2; ++s) {
+        xml << "  <" << sections[s] << ">\n"
+            << "   <binary_mode>" << (binary ? "true" : "false") << "</binary_mode>\n"
+            << "   <var_separator>,</var_separator>\n"
+            << "   <line_separator>newline</line_separator>\n"
+            << "   <batch>" << batch << "</batch>\n";
+        writeChunks(xml, dirs[s]);
+        xml << "  </" << sections[s] << ">\n";
+    }
+    xml << " </generic>\n</PropertyList>\n";
+    return name;
+}
+
+static FGGeneric* openChannel(const std::string& name, const char* dir,
+                              const std::string& port)
+{
+    std::vector<std::string> tokens;
+    tokens.push_back("generic");
+    tokens.push_back("socket");
+    tokens.push_back(dir);
+    tokens.push_back("60");
+    tokens.push_back(dir[0] == 'i' ? "" : "localhost");
+    tokens.push_back(port);
+    tokens.push_back("udp");
+    tokens.push_back(name);
+
+    FGGeneric* channel = new FGGeneric(tokens);
+    if (!channel->getInitOk()) {
+        fprintf(stderr, "can't read protocol %s\n", name.c_str());
+        exit(EXIT_FAILURE);
+    }
+    channel->set_direction(dir);
+    channel->set_io_channel(new SGSocket(tokens[4], port, "udp"));
+    if (!channel->open()) {
+        fprintf(stderr, "can't open the %s socket on port %s\n", dir, port.c_str());
+        exit(EXIT_FAILURE);
+    }
+    return channel;
+}
+
+static void run(const SGPath& root, bool binary, int batch, int port)
+{
+    const int frames = 20000;
+    std::string name = writeProtocol(root, binary, batch);
+    std::string portString = std::to_string(port);
+
+    FGGeneric* receiver = openChannel(name, "in", portString);
+    FGGeneric* sender = openChannel(name, "out", portString);
+
+    SGPropertyNode* out = fgGetNode("/bench/out", true);
+    SGPropertyNode* in = fgGetNode("/bench/in", true);
+    const int chunks = doubles + floats + ints + bools;
+
+    double sendSecs = 0.0, receiveSecs = 0.0;
+    for (int f = 0; f < frames; ++f) {
+        for (int i = 0; i < chunks; ++i)
+            out->getChild("value", i, true)->setDoubleValue((f % 1000) * 0.25 + i);
+
+        SGTimeStamp start = SGTimeStamp::now();
+        sender->process();
+        SGTimeStamp sent = SGTimeStamp::now();
+        sendSecs += (sent - start).toSecs();
+
+        if ((f + 1) % batch == 0) {
+            receiver->process();
+            receiveSecs += (SGTimeStamp::now() - sent).toSecs();
+        }
+    }
+
+    bool ok = in->getChild("value", 0, true)->getDoubleValue()
+              == out->getChild("value", 0)->getDoubleValue();
+
+    sender->close();
+    receiver->close();
+    delete sender;
+    delete receiver;
+
+    printf("%-6s batch %2d: send %6.2f us/frame, receive %6.2f us/frame, "
+           "%d writes%s\n", binary ? "binary" : "ascii", batch,
+           1e6 * sendSecs / frames, 1e6 * receiveSecs / frames,
+           frames / batch, ok ? "" : ", LAST FRAME NOT RECEIVED");
+}
+
+int main(int argc, char* argv[])
+{
+    globals = new FGGlobals;
+
+    SGPath root = simgear::Dir::tempDir("fgbench").path();
+    simgear::Dir(root / "Protocol").create(0755);
+    globals->set_fg_root(root);
+
+    int port = argc > 1 ? atoi(argv[1]) : 5599;
+    run(root, false, 1, port++);
+    run(root, false, 8, port++);
+    run(root, true, 1, port++);
+    run(root, true, 8, port++);
+
+    simgear::Dir(root).remove(true);
+    delete globals;
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,117 @@
+// benchMirrorPropertyTree.cxx -- compare the JSON and binary encodings
+// used by MirrorPropertyTreeWebsocket, in bytes and CPU time per update.
+
+#include "config.h"
+
+#include <cstdio>
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+
+#include <simgear/props/props.hxx>
+#include <simgear/timing/timestamp.hxx>
+
+#include <Main/globals.hxx>
+#include <Network/http/MirrorPropertyTreeWebsocket.hxx>
+
+using namespace flightgear::http;
+
+class CountingWriter : public WebsocketWriter
+{
+public:
+    virtual int writeToWebsocket(int opcode, const char * data, size_t len)
+    {
+        ++frames;
+        bytes += len;
+        return static_cast<int>(len);
+    }
+
+    size_t frames = 0;
+    size_t bytes = 0;
+};
+
+// roughly the shape of a glass-cockpit canvas: many groups of path
+// elements with transforms and a few text elements
+static void buildCanvas(SGPropertyNode* root, int groups)
+{
+    for (int g = 0; g < groups; ++g) {
+        SGPropertyNode* group = root->getChild("group", g, true);
+        group->setBoolValue("visible", true);
+        for (int p = 0; p < 8; ++p) {
+            SGPropertyNode* path = group->getChild("path", p, true);
+            path->setStringValue("stroke", "#00ff00");
+            path->setDoubleValue("stroke-width", 2.0);
+            for (int c = 0; c < 6; ++c) {
+                path->getChild("coord", c, true)->setDoubleValue(c * 10.0);
+            }
+            SGPropertyNode* tf = path->getChild("tf", 0, true);
+            for (int m = 0; m < 6; ++m) {
+                tf->getChild("m", m, true)->setDoubleValue(m == 0 || m == 3 ? 1.0 : 0.0);
+            }
+        }
+        group->getChild("text", 0, true)->setStringValue("text", "FL350");
+    }
+}
+
+static void animate(SGPropertyNode* root, int groups, int frame)
+{
+    for (int g = 0; g < groups; ++g) {
+        SGPropertyNode* group = root->getChild("group", g);
+        for (int p = 0; p < 8; ++p) {
+            SGPropertyNode* tf = group->getChild("path", p)->getChild("tf", 0);
+            tf->getChild("m", 4)->setDoubleValue(frame * 0.37 + p);
+            tf->getChild("m", 5)->setDoubleValue(frame * -0.11 + g);
+        }
+
+        group->getChild("text", 0)->setStringValue("text", std::to_string(350 - frame % 100));
+    }
+}
+
+static void runBenchmark(const char* name, const std::string& encoding, bool compress)
+{
+    const int groups = 64;
+    const int frames = 500;
+
+    SGPropertyNode* root = globals->get_props()->getNode("/canvas/by-index/texture", true);
+    root->removeAllChildren();
+    buildCanvas(root, groups);
+
+    HTTPRequest::StringMap options;
+    options["encoding"] = encoding;
+    options["compress"] = compress ? "1" : "0";
+    options["interval"] = "0";
+
+    MirrorPropertyTreeWebsocket mirror("/canvas/by-index/texture", options);
+    CountingWriter initial;
+    mirror.poll(initial);
+
+    CountingWriter updates;
+    int64_t encodeUSec = 0;
+    for (int f = 0; f < frames; ++f) {
+        animate(root, groups, f);
+
+        SGTimeStamp st;
+        st.stamp();
+        mirror.poll(updates);
+        encodeUSec += (SGTimeStamp::now() - st).toUSecs();
+    }
+
+    mirror.close();
+
+    printf("%-16s initial: %8zu bytes   update: %7.1f bytes, %7.1f usec\n",
+           name, initial.bytes,
+           static_cast<double>(updates.bytes) / updates.frames,
+           static_cast<double>(encodeUSec) / updates.frames);
+}
+
+int main(int argc, char* argv[])
+{
+    globals = new FGGlobals;
+
+    runBenchmark("json", "json", false);
+    runBenchmark("binary", "binary", false);
+    runBenchmark("binary+zlib", "binary", true);
+
+    delete globals;
+    return EXIT_SUCCESS;
+}
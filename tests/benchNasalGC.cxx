@@ -0,0 +1,112 @@
+// benchNasalGC.cxx -- reproduce the frame stutter of Nasal garbage
+// collections with a large live heap, and compare the frame times with
+// the collections left to the interpreter and paced between frames.
+//
+// usage: benchNasalGC [allocation|paced] [frames] [live objects]
+// Run the two modes in separate processes: the interpreter keeps the
+// object pools it grew for the whole process.
+
+#include "config.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include <simgear/nasal/nasal.h>
+#include <simgear/timing/timestamp.hxx>
+
+#include <Scripting/NasalGC.hxx>
+
+// a heap of aircraft-like state, and a frame function leaving garbage
+// behind as display code does
+static const char* script =
+    "var live = [];\n"
+    "for (var i = 0; i < count; i += 1)\n"
+    "    append(live, {id: i, pos: [i, i * 2, i * 3], name: \"wp\" ~ i});\n"
+    "var frame = func(n) {\n"
+    "    var tmp = [];\n"
+    "    for (var i = 0; i < 2000; i += 1)\n"
+    "        append(tmp, {x: i, y: [i, n], label: \"l\" ~ i});\n"
+    "    live[n * 7 % size(live)] = {id: n, pos: [n, n, n], name: \"r\" ~ n};\n"
+    "}\n"
+    "return frame;\n";
+
+static naRef newString(naContext c, const char* s)
+{
+    naRef str = naNewString(c);
+    naStr_fromdata(str, s, strlen(s));
+    return str;
+}
+
+int main(int argc, char* argv[])
+{
+    bool paced = argc > 1 && !strcmp(argv[1], "paced");
+    int frames = argc > 2 ? atoi(argv[2]) : 600;
+    int count = argc > 3 ? atoi(argv[3]) : 200000;
+
+    naContext c = naNewContext();
+    naRef globals = naInit_std(c);
+    naSave(c, globals);
+    naHash_set(globals, newString(c, "count"), naNum(count));
+
+    int errLine = -1;
+    naRef code = naParseCode(c, newString(c, "benchNasalGC"), 1,
+                             (char*)script, strlen(script), &errLine);
+    if (naIsNil(code)) {
+        fprintf(stderr, "parse error: %s, line %d\n", naGetError(c), errLine);
+        return EXIT_FAILURE;
+    }
+    naRef frame = naCall(c, naBindFunction(c, code, globals), 0, 0,
+                         naNil(), naNil());
+    if (naGetError(c)) {
+        fprintf(stderr, "runtime error: %s\n", naGetError(c));
+        return EXIT_FAILURE;
+    }
+    naSave(c, frame);
+
+    NasalGCPacer pacer;
+    pacer.setMode(paced ? NasalGCPacer::PACED : NasalGCPacer::ALLOCATION);
+    // the frames run back to back here: collect every few of them,
+    // whatever the pause
+    pacer.setInterval(0.05);
+    pacer.setBudget(1000.0);
+    pacer.collect();
+
+    std::vector<double> times(frames);
+    for (int n = 0; n < frames; ++n) {
+        SGTimeStamp start = SGTimeStamp::now();
+        naRef arg = naNum(n);
+        naCall(c, frame, 1, &arg, naNil(), naNil());
+        pacer.update();
+        times[n] = 1000.0 * (SGTimeStamp::now() - start).toSecs();
+        if (naGetError(c)) {
+            fprintf(stderr, "runtime error: %s\n", naGetError(c));
+            return EXIT_FAILURE;
+        }
+    }
+    naFreeContext(c);
+
+    double total = 0.0;
+    for (int n = 0; n < frames; ++n)
+        total += times[n];
+    double mean = total / frames;
+    int stutters = 0;
+    for (int n = 0; n < frames; ++n) {
+        if (times[n] > 3 * mean)
+            ++stutters;
+    }
+    std::sort(times.begin(), times.end());
+
+    const NasalGCPacer::Stats& stats = pacer.stats();
+    printf("%s mode, %d frames, %d live objects\n",
+           paced ? "paced" : "allocation", frames, count);
+    printf("frame time: mean %.3f ms, 99%% %.3f ms, max %.3f ms\n",
+           mean, times[frames * 99 / 100], times[frames - 1]);
+    printf("frames over 3x the mean: %d\n", stutters);
+    printf("pacer collections (one before the frames): %u, "
+           "mean pause %.3f ms, max %.3f ms\n", stats.collections,
+           stats.totalPauseMs / stats.collections, stats.maxPauseMs);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,139 @@
+// benchNasalProps.cxx -- run a Nasal script calling getprop() and setprop()
+// with and without the property path cache, and compare the run times.
+//
+// usage: benchNasalProps [script.nas]
+// Without a script, one reading and writing a few instrument properties
+// in a loop is run.
+
+#include "config.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#include <simgear/nasal/nasal.h>
+#include <simgear/props/props.hxx>
+#include <simgear/timing/timestamp.hxx>
+
+#include <Scripting/NasalPropertyCache.hxx>
+
+static SGPropertyNode_ptr root;
+static NasalPropertyCache cache;
+
+static const char* defaultScript =
+    "var frame = func(i) {\n"
+    "    var alt = getprop(\"/instrumentation/altimeter/indicated-altitude-ft\");\n"
+    "    var ias = getprop(\"/instrumentation/airspeed-indicator/indicated-speed-kt\");\n"
+    "    setprop(\"/instrumentation/pfd/altitude-tape/offset\", alt - 100 * i);\n"
+    "    setprop(\"/instrumentation/pfd/speed-tape/offset\", ias * 2.5);\n"
+    "    for (var e = 0; e < 2; e += 1)\n"
+    "        setprop(\"/instrumentation/eicas/n1\", e, getprop(\"/engines/engine\", e, \"n1\"));\n"
+    "}\n"
+    "setprop(\"/instrumentation/altimeter/indicated-altitude-ft\", 10000);\n"
+    "setprop(\"/instrumentation/airspeed-indicator/indicated-speed-kt\", 250);\n"
+    "setprop(\"/engines/engine[0]/n1\", 92.5);\n"
+    "setprop(\"/engines/engine[1]/n1\", 92.7);\n"
+    "for (var i = 0; i < 100000; i += 1)\n"
+    "    frame(i);\n";
+
+static unsigned long calls = 0;
+
+static naRef f_getprop(naContext c, naRef me, int argc, naRef* args)
+{
+    ++calls;
+    if (argc < 1)
+        naRuntimeError(c, "getprop() expects at least 1 argument");
+    SGPropertyNode* p = cache.find(c, root, args, argc, false);
+    return p ? naNum(p->getDoubleValue()) : naNil();
+}
+
+static naRef f_setprop(naContext c, naRef me, int argc, naRef* args)
+{
+    ++calls;
+    if (argc < 2)
+        naRuntimeError(c, "setprop() expects at least 2 arguments");
+    SGPropertyNode* p = cache.find(c, root, args, argc - 1, true);
+    naRef val = args[argc - 1];
+    if (naIsString(val))
+        return naNum(p->setStringValue(naStr_data(val)));
+    return naNum(p->setDoubleValue(naNumValue(val).num));
+}
+
+static void hashset(naContext c, naRef hash, const char* key, naRef val)
+{
+    naRef s = naNewString(c);
+    naStr_fromdata(s, key, strlen(key));
+    naHash_set(hash, s, val);
+}
+
+// run the script in a new tree, returns the seconds it took
+static double run(const std::string& name, const std::string& source)
+{
+    root = new SGPropertyNode;
+    cache.clear();
+    cache.resetStats();
+    calls = 0;
+
+    naContext c = naNewContext();
+    naRef globals = naInit_std(c);
+    naSave(c, globals);
+    hashset(c, globals, "getprop", naNewFunc(c, naNewCCode(c, f_getprop)));
+    hashset(c, globals, "setprop", naNewFunc(c, naNewCCode(c, f_setprop)));
+
+    naRef file = naNewString(c);
+    naStr_fromdata(file, name.c_str(), name.size());
+    int errLine = -1;
+    naRef code = naParseCode(c, file, 1, (char*)source.c_str(), source.size(),
+                             &errLine);
+    if (naIsNil(code)) {
+        fprintf(stderr, "parse error: %s in %s, line %d\n", naGetError(c),
+                name.c_str(), errLine);
+        exit(EXIT_FAILURE);
+    }
+    code = naBindFunction(c, code, globals);
+
+    SGTimeStamp start = SGTimeStamp::now();
+    naCall(c, code, 0, 0, naNil(), naNil());
+    double secs = (SGTimeStamp::now() - start).toSecs();
+    if (naGetError(c)) {
+        fprintf(stderr, "runtime error: %s in %s, line %d\n", naGetError(c),
+                name.c_str(), naGetLine(c, 0));
+        exit(EXIT_FAILURE);
+    }
+    naFreeContext(c);
+    return secs;
+}
+
+int main(int argc, char* argv[])
+{
+    std::string name = "default";
+    std::string source = defaultScript;
+    if (argc > 1) {
+        std::ifstream file(argv[1]);
+        if (!file) {
+            fprintf(stderr, "cannot read %s\n", argv[1]);
+            return EXIT_FAILURE;
+        }
+        std::ostringstream text;
+        text << file.rdbuf();
+        name = argv[1];
+        source = text.str();
+    }
+
+    cache.setEnabled(false);
+    double uncached = run(name, source);
+
+    cache.setEnabled(true);
+    double cached = run(name, source);
+    unsigned long lookups = cache.hits() + cache.misses();
+
+    printf("%lu getprop/setprop calls\n", calls);
+    printf("without cache: %8.3f us per call\n", 1e6 * uncached / calls);
+    printf("with cache:    %8.3f us per call\n", 1e6 * cached / calls);
+    printf("hit ratio:     %8.3f\n",
+           lookups ? double(cache.hits()) / lookups : 0.0);
+    return EXIT_SUCCESS;
+}
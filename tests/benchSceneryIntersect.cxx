@@ -0,0 +1,146 @@
+// benchSceneryIntersect.cxx -- compare elevation queries made one by one
+// with the same queries made in batches, on a synthetic terrain.
+
+#include "config.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include <osg/Geode>
+#include <osg/Geometry>
+#include <osg/Group>
+#include <osg/MatrixTransform>
+
+#include <simgear/math/SGMath.hxx>
+#include <simgear/math/SGGeometry.hxx>
+#include <simgear/scene/model/BoundingVolumeBuildVisitor.hxx>
+#include <simgear/timing/timestamp.hxx>
+
+#include <Scenery/SceneryBatchIntersect.hxx>
+
+using flightgear::SceneryBatchIntersect;
+
+static const double baseLon = 7.0, baseLat = 46.0;
+static const double tileDeg = 0.125;
+static const int tileGrid = 8;        // tiles per side
+static const int tileVertices = 64;   // vertices per tile side
+
+static double terrainHeight(double lon, double lat)
+{
+    return 1500.0 + 800.0 * sin(lon * 40.0) * cos(lat * 55.0);
+}
+
+// one tile: a grid of triangles around its center, under a transform, as
+// the scenery tiles are
+static osg::Node* buildTile(double lon0, double lat0)
+{
+    SGVec3d center = SGVec3d::fromGeod(SGGeod::fromDeg(lon0 + tileDeg / 2, lat0 + tileDeg / 2));
+
+    osg::Vec3Array* vertices = new osg::Vec3Array;
+    for (int j = 0; j < tileVertices; ++j) {
+        for (int i = 0; i < tileVertices; ++i) {
+            double lon = lon0 + tileDeg * i / (tileVertices - 1);
+            double lat = lat0 + tileDeg * j / (tileVertices - 1);
+            SGVec3d p = SGVec3d::fromGeod(SGGeod::fromDegM(lon, lat, terrainHeight(lon, lat)));
+            vertices->push_back(toOsg(SGVec3f(p - center)));
+        }
+    }
+
+    osg::DrawElementsUInt* triangles = new osg::DrawElementsUInt(GL_TRIANGLES);
+    for (int j = 0; j + 1 < tileVertices; ++j) {
+        for (int i = 0; i + 1 < tileVertices; ++i) {
+            unsigned v = j * tileVertices + i;
+            triangles->push_back(v);
+            triangles->push_back(v + 1);
+            triangles->push_back(v + tileVertices);
+            triangles->push_back(v + 1);
+            triangles->push_back(v + tileVertices + 1);
+            triangles->push_back(v + tileVertices);
+        }
+    }
+
+    osg::Geometry* geometry = new osg::Geometry;
+    geometry->setVertexArray(vertices);
+    geometry->addPrimitiveSet(triangles);
+    osg::Geode* geode = new osg::Geode;
+    geode->addDrawable(geometry);
+
+    osg::MatrixTransform* transform = new osg::MatrixTransform;
+    transform->setMatrix(osg::Matrix::translate(toOsg(center)));
+    transform->addChild(geode);
+    return transform;
+}
+
+static SGLineSegmentd downward(const SGGeod& geod)
+{
+    SGGeod end = geod;
+    end.setElevationM(-10000);
+    return SGLineSegmentd(SGVec3d::fromGeod(geod), SGVec3d::fromGeod(end));
+}
+
+int main(int argc, char* argv[])
+{
+    size_t numQueries = (argc > 1) ? atoi(argv[1]) : 20000;
+    size_t chunkSize = (argc > 2) ? atoi(argv[2]) : 64;
+
+    osg::ref_ptr<osg::Group> terrain = new osg::Group;
+    for (int j = 0; j < tileGrid; ++j)
+        for (int i = 0; i < tileGrid; ++i)
+            terrain->addChild(buildTile(baseLon + i * tileDeg, baseLat + j * tileDeg));
+    simgear::BoundingVolumeBuildVisitor bvhBuilder(true);
+    terrain->accept(bvhBuilder);
+
+    std::vector<SGGeod> geods(numQueries);
+    srand(1);
+    for (size_t i = 0; i < numQueries; ++i) {
+        double lon = baseLon + tileDeg * tileGrid * rand() / RAND_MAX;
+        double lat = baseLat + tileDeg * tileGrid * rand() / RAND_MAX;
+        geods[i] = SGGeod::fromDegM(lon, lat, 10000);
+    }
+
+    // one query at a time, as FGScenery::get_elevation_m does
+    std::vector<double> single(numQueries, -1e9);
+    SGTimeStamp start = SGTimeStamp::now();
+    for (size_t i = 0; i < numQueries; ++i) {
+        SceneryBatchIntersect visitor(0);
+        visitor.addLineSegment(downward(geods[i]));
+        visitor.intersect(*terrain);
+        if (visitor.getHaveHit(0))
+            single[i] = SGGeod::fromCart(visitor.getLineSegment(0).getEnd()).getElevationM();
+    }
+    double singleSecs = (SGTimeStamp::now() - start).toSecs();
+
+    // sorted by area and in chunks, as FGStgTerrain::get_elevation_m_batch does
+    std::vector<double> batched(numQueries, -1e9);
+    start = SGTimeStamp::now();
+    std::vector<size_t> order;
+    SceneryBatchIntersect::sortByArea(&geods[0], numQueries, order);
+    SceneryBatchIntersect visitor(0);
+    for (size_t begin = 0; begin < numQueries; begin += chunkSize) {
+        size_t end = std::min(begin + chunkSize, numQueries);
+        visitor.clear();
+        for (size_t i = begin; i < end; ++i)
+            visitor.addLineSegment(downward(geods[order[i]]));
+        visitor.intersect(*terrain);
+        for (size_t i = begin; i < end; ++i) {
+            if (visitor.getHaveHit(i - begin))
+                batched[order[i]] = SGGeod::fromCart(visitor.getLineSegment(i - begin).getEnd()).getElevationM();
+        }
+    }
+    double batchSecs = (SGTimeStamp::now() - start).toSecs();
+
+    size_t mismatches = 0;
+    for (size_t i = 0; i < numQueries; ++i) {
+        if (fabs(single[i] - batched[i]) > 1e-3)
+            ++mismatches;
+    }
+
+    printf("%zu queries on %d tiles, chunks of %zu\n", numQueries, tileGrid * tileGrid, chunkSize);
+    printf("one by one: %8.2f us per query\n", 1e6 * singleSecs / numQueries);
+    printf("batched:    %8.2f us per query\n", 1e6 * batchSecs / numQueries);
+    printf("results differing: %zu\n", mismatches);
+    return mismatches ? 1 : 0;
+}
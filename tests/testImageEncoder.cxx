@@ -0,0 +1,219 @@
+// testImageEncoder.cxx -- run the screenshot encoding pipeline on
+// synthetic images, without a graphics context
+
+#include "config.h"
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+#include <osg/Image>
+#include <osgDB/ReaderWriter>
+#include <osgDB/Registry>
+
+#include <simgear/misc/test_macros.hxx>
+#include <simgear/threads/SGGuard.hxx>
+#include <simgear/threads/SGThread.hxx>
+#include <simgear/timing/timestamp.hxx>
+
+#include <Network/http/ImageEncoder.hxx>
+
+using namespace flightgear::http;
+
+// a writer putting out the first byte of the image, which can be held
+// up to fill the queues
+static SGMutex gateLock;
+static SGWaitCondition gateChanged;
+static bool gateClosed = false;
+static int writing = 0;
+
+class TestWriter : public osgDB::ReaderWriter {
+public:
+  TestWriter()
+  {
+    supportsExtension("fgtest", "first byte of the image");
+  }
+
+  virtual WriteResult writeImage(const osg::Image& image, std::ostream& out,
+                                 const Options*) const
+  {
+    {
+      SGGuard<SGMutex> g(gateLock);
+      ++writing;
+      gateChanged.broadcast();
+      while (gateClosed)
+        gateChanged.wait(gateLock);
+      --writing;
+    }
+    out << (int)image.data()[0];
+    return WriteResult::FILE_SAVED;
+  }
+};
+
+static osg::ref_ptr<osg::Image> makeImage(int s, int t, unsigned char first)
+{
+  osg::ref_ptr<osg::Image> image = new osg::Image;
+  image->allocateImage(s, t, 1, GL_RGB, GL_UNSIGNED_BYTE, 1);
+  for (int y = 0; y < t; ++y) {
+    unsigned char* p = image->data(0, y);
+    for (int x = 0; x < s; ++x) {
+      *p++ = (unsigned char)(x * 10);
+      *p++ = (unsigned char)(y * 10);
+      *p++ = 200;
+    }
+  }
+  image->data()[0] = first;
+  return image;
+}
+
+static void waitForEncoded(ImageEncoderQueue* queue, unsigned count)
+{
+  for (int i = 0; i < 500 && queue->getEncoded() < count; ++i)
+    SGTimeStamp::sleepForMSec(10);
+  SG_CHECK_EQUAL(queue->getEncoded(), count);
+}
+
+void testEncoding()
+{
+  ImageEncoding e;
+  e.jpegQuality = 0;
+  e.pngCompression = 12;
+  e.downscale = 0;
+  e.clamp();
+  SG_CHECK_EQUAL(e.jpegQuality, 1);
+  SG_CHECK_EQUAL(e.pngCompression, 9);
+  SG_CHECK_EQUAL(e.downscale, 1);
+  SG_CHECK_EQUAL(e.options(), "JPEG_QUALITY 1 PNG_COMPRESSION 9");
+}
+
+void testDownscale()
+{
+  osg::ref_ptr<osg::Image> image = makeImage(5, 4, 0);
+  osg::ref_ptr<osg::Image> scaled = new osg::Image;
+  SG_VERIFY(downscaleImage(*image, 2, *scaled));
+  SG_CHECK_EQUAL(scaled->s(), 2);
+  SG_CHECK_EQUAL(scaled->t(), 2);
+  // x of 2 and 3, y of 0 and 1
+  const unsigned char* p = scaled->data(1, 0);
+  SG_CHECK_EQUAL((int)p[0], 25);
+  SG_CHECK_EQUAL((int)p[1], 5);
+  SG_CHECK_EQUAL((int)p[2], 200);
+
+  // the storage is kept for the next image of the same size
+  const unsigned char* data = scaled->data();
+  SG_VERIFY(downscaleImage(*image, 2, *scaled));
+  SG_VERIFY(data == scaled->data());
+
+  SG_VERIFY(downscaleImage(*image, 8, *scaled));
+  SG_CHECK_EQUAL(scaled->s(), 1);
+  SG_CHECK_EQUAL(scaled->t(), 1);
+  SG_CHECK_EQUAL((int)scaled->data()[1], 15);
+}
+
+void testDropOldest()
+{
+  ImageEncoderPool_ptr pool = new ImageEncoderPool(1);
+  ImageEncoding e;
+  e.format = "fgtest";
+  ImageEncoderQueue_ptr queue = new ImageEncoderQueue(e, 2);
+
+  // hold the only thread up with the first image, and queue five more
+  {
+    SGGuard<SGMutex> g(gateLock);
+    gateClosed = true;
+  }
+  pool->submit(queue, makeImage(8, 8, 1).get());
+  {
+    SGGuard<SGMutex> g(gateLock);
+    while (writing == 0)
+      gateChanged.wait(gateLock);
+  }
+  for (unsigned char i = 2; i <= 6; ++i)
+    pool->submit(queue, makeImage(8, 8, i).get());
+  SG_CHECK_EQUAL(queue->getDropped(), 3u);
+
+  {
+    SGGuard<SGMutex> g(gateLock);
+    gateClosed = false;
+    gateChanged.broadcast();
+  }
+  // 1, 5 and 6, only the last one is left to take
+  waitForEncoded(queue, 3);
+  SG_CHECK_EQUAL(queue->getDropped(), 5u);
+
+  std::string buffer;
+  SG_VERIFY(queue->take(buffer));
+  SG_CHECK_EQUAL(buffer, "6");
+  SG_VERIFY(!queue->take(buffer));
+
+  pool->submit(queue, makeImage(8, 8, 7).get());
+  waitForEncoded(queue, 4);
+  SG_VERIFY(queue->take(buffer));
+  SG_CHECK_EQUAL(buffer, "7");
+
+  queue->close();
+  pool->submit(queue, makeImage(8, 8, 8).get());
+  SG_VERIFY(!queue->take(buffer));
+}
+
+void testClients()
+{
+  ImageEncoderPool_ptr pool = new ImageEncoderPool(3);
+  ImageEncoding e;
+  e.format = "fgtest";
+  e.downscale = 2;
+
+  ImageEncoderQueue_ptr queues[8];
+  for (int i = 0; i < 8; ++i)
+    queues[i] = new ImageEncoderQueue(e);
+  for (int i = 0; i < 8; ++i)
+    pool->submit(queues[i], makeImage(64, 64, (unsigned char)(i * 20)).get());
+
+  for (int i = 0; i < 8; ++i) {
+    waitForEncoded(queues[i], 1);
+    std::string buffer;
+    SG_VERIFY(queues[i]->take(buffer));
+    // the average of the first block
+    SG_CHECK_EQUAL(buffer, std::to_string((i * 20 + 20 + 2) / 4));
+  }
+}
+
+// the real writers, when osgDB finds their plugins
+void testFormats()
+{
+  osg::ref_ptr<osg::Image> image = makeImage(320, 200, 0);
+  const char* formats[] = { "png", "jpg" };
+  const char* magic[] = { "\x89PNG", "\xff\xd8" };
+  for (int i = 0; i < 2; ++i) {
+    if (!osgDB::Registry::instance()->getReaderWriterForExtension(formats[i])) {
+      printf("no %s writer, skipped\n", formats[i]);
+      continue;
+    }
+
+    ImageEncoderPool_ptr pool = new ImageEncoderPool(1);
+    ImageEncoding e;
+    e.format = formats[i];
+    e.pngCompression = 1;
+    e.jpegQuality = 50;
+    e.downscale = 2;
+    ImageEncoderQueue_ptr queue = new ImageEncoderQueue(e);
+    pool->submit(queue, image.get());
+    waitForEncoded(queue, 1);
+
+    std::string buffer;
+    SG_VERIFY(queue->take(buffer));
+    SG_CHECK_EQUAL(buffer.compare(0, strlen(magic[i]), magic[i]), 0);
+  }
+}
+
+int main(int argc, char* argv[])
+{
+  osgDB::Registry::instance()->addReaderWriter(new TestWriter);
+
+  testEncoding();
+  testDownscale();
+  testDropOldest();
+  testClients();
+  testFormats();
+  return 0;
+}
@@ -0,0 +1,92 @@
+// testMSISTable.cxx -- check the tabulated MSIS atmosphere against the full
+// NRLMSISE-00 model over the domain of the table
+
+#include "config.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+#include <sstream>
+
+#include <simgear/misc/test_macros.hxx>
+
+#include "FDM/JSBSim/FGFDMExec.h"
+#include "FDM/JSBSim/models/atmosphere/FGMSIS.h"
+
+using namespace JSBSim;
+
+// the bounds stated in FGMSIS.h
+static const double densityBound = 0.10;
+static const double temperatureBound = 0.05;
+
+// MSIS does not implement the altitude based accessors of FGAtmosphere,
+// which are not needed here
+class TestMSIS : public MSIS
+{
+public:
+    TestMSIS(FGFDMExec* exec) : MSIS(exec) {}
+
+    virtual double GetTemperature(double) const { return 0.0; }
+    virtual void SetTemperature(double, double, eTemperature) {}
+    virtual double GetPressure(double) const { return 0.0; }
+};
+
+// compare the table with the model at the centre of every cell, where the
+// interpolation is furthest from the table entries
+void checkTable(TestMSIS& msis, int day, double sec)
+{
+    msis.BuildTable(day, sec);
+    SG_VERIFY(msis.GetTableReady());
+    SG_VERIFY(msis.GetTableDensityError() <= densityBound);
+    SG_VERIFY(msis.GetTableTemperatureError() <= temperatureBound);
+
+    double densityError = 0.0, temperatureError = 0.0;
+    for (double alt = 1.0; alt < 500.0; alt += 2.0) {
+        for (double lat = -85.0; lat < 90.0; lat += 10.0) {
+            for (double lst = 1.0; lst < 24.0; lst += 2.0) {
+                double lon = lst * 15.0 - sec / 240.0;
+                if (lon > 180.0) lon -= 360.0;
+                if (lon < -180.0) lon += 360.0;
+
+                double modelDensity, modelTemperature, density, temperature;
+                msis.SetTabulated(false);
+                msis.Compute(day, sec, alt * 3281.0, lat, lon,
+                             modelDensity, modelTemperature);
+                msis.SetTabulated(true);
+                msis.Compute(day, sec, alt * 3281.0, lat, lon,
+                             density, temperature);
+
+                densityError = std::max(densityError,
+                                        fabs(density / modelDensity - 1.0));
+                temperatureError = std::max(temperatureError,
+                                            fabs(temperature / modelTemperature - 1.0));
+            }
+        }
+    }
+
+    printf("day %d, %.0f s: density error %.4f, temperature error %.4f "
+           "(published %.4f, %.4f)\n", day, sec, densityError, temperatureError,
+           msis.GetTableDensityError(), msis.GetTableTemperatureError());
+    SG_VERIFY(densityError <= densityBound);
+    SG_VERIFY(temperatureError <= temperatureBound);
+}
+
+int main(int argc, char* argv[])
+{
+    FGFDMExec exec;
+    exec.SetDebugLevel(0);
+
+    // the standard atmosphere of the executive already has the atmosphere
+    // properties, so tying them again only complains
+    std::ostringstream tieErrors;
+    std::streambuf* cerrBuf = std::cerr.rdbuf(tieErrors.rdbuf());
+    TestMSIS msis(&exec);
+    std::cerr.rdbuf(cerrBuf);
+    msis.InitModel();
+
+    // at midnight UT, half of the local times come from negative longitudes
+    checkTable(msis, 1, 0.0);
+    checkTable(msis, 220, 40000.0);
+    return 0;
+}
@@ -104,6 +104,14 @@ bool FGScenery::get_elevation_m(const SGGeod& geod, double& alt,
     return false;
 }
 
+void FGScenery::get_elevation_m_batch(const SGGeod* geods, size_t n,
+                     FGElevationResult* results,
+                     const osg::Node* butNotFrom)
+{
+    for (size_t i = 0; i < n; ++i)
+        results[i].valid = false;
+}
+
 bool FGScenery::get_cart_ground_intersection(const SGVec3d& start, const SGVec3d& dir,
                      SGVec3d& nearestHit,
                      const osg::Node* butNotFrom)
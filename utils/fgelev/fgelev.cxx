@@ -23,10 +23,20 @@
 #include <iostream>
 #include <cstdlib>
 #include <iomanip>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <atomic>
+#include <limits>
+#include <mutex>
+#include <thread>
+#include <vector>
 
 #include <osg/ArgumentParser>
 #include <osg/Image>
 
+#include <simgear/bucket/newbucket.hxx>
+#include <simgear/io/raw_socket.hxx>
 #include <simgear/props/props.hxx>
 #include <simgear/props/props_io.hxx>
 #include <simgear/misc/sg_path.hxx>
@@ -42,25 +52,34 @@
 #include <simgear/scene/util/SGReaderWriterOptions.hxx>
 #include <simgear/scene/util/OptionsReadFileCallback.hxx>
 #include <simgear/scene/tgdb/userdata.hxx>
+#include <simgear/timing/timestamp.hxx>
 
 namespace sg = simgear;
 
 class Visitor : public sg::BVHLineSegmentVisitor {
 public:
-    Visitor(const SGLineSegmentd& lineSegment, sg::BVHPager& pager) :
+    Visitor(const SGLineSegmentd& lineSegment, sg::BVHPager& pager,
+            std::mutex& pagerMutex) :
         BVHLineSegmentVisitor(lineSegment, 0),
-        _pager(pager)
+        _pager(pager),
+        _pagerMutex(pagerMutex)
     { }
     virtual ~Visitor()
     { }
     virtual void apply(sg::BVHPageNode& node)
     {
         // we have a non threaded pager so load just right here.
-        _pager.use(node);
+        // A thread only walks the children of a page node after going
+        // through use() itself, so holding the lock while loading is enough.
+        {
+            std::lock_guard<std::mutex> lock(_pagerMutex);
+            _pager.use(node);
+        }
         BVHLineSegmentVisitor::apply(node);
     }
 private:
     sg::BVHPager& _pager;
+    std::mutex& _pagerMutex;
 };
 
 // Short circuit reading image files.
@@ -74,11 +93,11 @@ public:
 };
 
 static bool
-intersect(sg::BVHNode& node, sg::BVHPager& pager,
+intersect(sg::BVHNode& node, sg::BVHPager& pager, std::mutex& pagerMutex,
           const SGVec3d& start, SGVec3d& end, double offset, const simgear::BVHMaterial** material)
 {
     SGVec3d perp = offset*perpendicular(start - end);
-    Visitor visitor(SGLineSegmentd(start + perp, end + perp), pager);
+    Visitor visitor(SGLineSegmentd(start + perp, end + perp), pager, pagerMutex);
     node.accept(visitor);
     if (visitor.empty())
         return false;
@@ -87,6 +106,278 @@ intersect(sg::BVHNode& node, sg::BVHPager& pager,
     return true;
 }
 
+struct Query {
+    std::string id;
+    double lon, lat;
+
+    bool found;
+    double elevation;
+    bool solid;
+    double holeScale;
+};
+
+// Answers queries on several threads sharing one pager.
+class Elevation {
+public:
+    Elevation(sg::BVHNode& node, unsigned expire, unsigned threads) :
+        _node(node),
+        _expire(expire),
+        _threads(std::max(threads, 1u)),
+        _queries(NULL)
+    { }
+
+    // The queries are sorted by tile, so that the threads work on few tiles
+    // at a time, and answered in rounds of _roundSize. Each round is one
+    // pager use stamp, so what was not used in the last expire rounds is
+    // dropped.
+    void evaluate(std::vector<Query>& queries)
+    {
+        std::vector<std::pair<long, size_t> > tiles(queries.size());
+        for (size_t i = 0; i < queries.size(); ++i) {
+            SGBucket bucket(SGGeod::fromDeg(queries[i].lon, queries[i].lat));
+            tiles[i] = std::make_pair(bucket.gen_index(), i);
+        }
+        std::stable_sort(tiles.begin(), tiles.end());
+        _order.resize(tiles.size());
+        for (size_t i = 0; i < tiles.size(); ++i)
+            _order[i] = tiles[i].second;
+        _queries = &queries;
+
+        for (size_t begin = 0; begin < _order.size(); begin += _roundSize) {
+            // Increment the paging relevant number
+            _pager.setUseStamp(1 + _pager.getUseStamp());
+            // and expire everything not accessed for the past rounds
+            _pager.update(_expire);
+
+            _roundEnd = std::min(begin + _roundSize, _order.size());
+            _nextBlock = begin;
+            size_t blocks = (_roundEnd - begin + _blockSize - 1) / _blockSize;
+            size_t threads = std::min<size_t>(_threads, blocks);
+
+            std::vector<std::thread> workers;
+            for (size_t i = 1; i < threads; ++i)
+                workers.push_back(std::thread(runWorker, this));
+            work();
+            for (size_t i = 0; i < workers.size(); ++i)
+                workers[i].join();
+        }
+        _queries = NULL;
+    }
+
+private:
+    static void runWorker(Elevation* elevation)
+    { elevation->work(); }
+
+    void work()
+    {
+        for (;;) {
+            size_t begin = _nextBlock.fetch_add(_blockSize);
+            if (_roundEnd <= begin)
+                return;
+            size_t end = std::min(begin + _blockSize, _roundEnd);
+            for (size_t i = begin; i < end; ++i)
+                answer((*_queries)[_order[i]]);
+        }
+    }
+
+    void answer(Query& query)
+    {
+        SGVec3d start = SGVec3d::fromGeod(SGGeod::fromDegM(query.lon, query.lat, 10000));
+        SGVec3d end = SGVec3d::fromGeod(SGGeod::fromDegM(query.lon, query.lat, -1000));
+
+        const simgear::BVHMaterial* material = NULL;
+        // Try to find an intersection
+        bool found = intersect(_node, _pager, _pagerMutex, start, end, 0, &material);
+        double scale = 1e-5;
+        while (!found && scale <= 1) {
+            found = intersect(_node, _pager, _pagerMutex, start, end, scale, &material);
+            scale *= 2;
+        }
+
+        query.found = found;
+        query.elevation = found ? SGGeod::fromCart(end).getElevationM() : -1000;
+        query.solid = material && material->get_solid();
+        query.holeScale = scale;
+    }
+
+    static const size_t _roundSize = 65536;
+    static const size_t _blockSize = 64;
+
+    sg::BVHNode& _node;
+    // We assume that the above is a paged database.
+    sg::BVHPager _pager;
+    std::mutex _pagerMutex;
+    unsigned _expire;
+    unsigned _threads;
+
+    std::vector<Query>* _queries;
+    std::vector<size_t> _order;
+    size_t _roundEnd;
+    std::atomic<size_t> _nextBlock;
+};
+
+static void
+report(const std::vector<Query>& queries, bool printSolidness, std::ostream& out)
+{
+    for (size_t i = 0; i < queries.size(); ++i) {
+        const Query& query = queries[i];
+        if (1e-5 < query.holeScale)
+            std::cerr << "Found hole of minimum diameter "
+                      << query.holeScale << "m at lon = " << query.lon
+                      << "deg lat = " << query.lat << "deg" << std::endl;
+
+        out << query.id << ": ";
+        if (!query.found) {
+            out << "-1000" << std::endl;
+        } else {
+            out << std::fixed << std::setprecision(3) << query.elevation;
+            if( printSolidness )
+                out <<  " " << (query.solid ? "solid" : "-");
+            out << std::endl;
+        }
+    }
+}
+
+static void
+reportRate(size_t count, const SGTimeStamp& start)
+{
+    double seconds = (SGTimeStamp::now() - start).toSecs();
+    std::ostringstream rate;
+    rate << count << " queries in " << std::fixed << std::setprecision(3)
+         << seconds << "s";
+    if (0 < seconds)
+        rate << ", " << std::setprecision(0) << count / seconds << " queries/s";
+    std::cerr << "fgelev: " << rate.str() << std::endl;
+}
+
+// Parse "id lon lat" or "id,lon,lat".
+static bool
+parseQuery(std::string line, Query& query)
+{
+    std::replace(line.begin(), line.end(), ',', ' ');
+    std::istringstream stream(line);
+    stream >> query.id >> query.lon >> query.lat;
+    return !stream.fail();
+}
+
+// Read a batch file: text with one query per line, or with binary, records
+// of two native doubles lon, lat with their record number as id.
+static bool
+readBatch(const std::string& path, bool binary, std::vector<Query>& queries)
+{
+    std::ifstream file(path.c_str(), binary ? std::ios::in | std::ios::binary : std::ios::in);
+    if (!file.is_open())
+        return false;
+
+    if (binary) {
+        double record[2];
+        while (file.read(reinterpret_cast<char*>(record), sizeof(record))) {
+            Query query;
+            std::ostringstream id;
+            id << queries.size();
+            query.id = id.str();
+            query.lon = record[0];
+            query.lat = record[1];
+            queries.push_back(query);
+        }
+        return file.eof() && file.gcount() == 0;
+    }
+
+    std::string line;
+    while (std::getline(file, line)) {
+        if (line.empty() || line[0] == '#')
+            continue;
+        Query query;
+        if (!parseQuery(line, query)) {
+            SG_LOG(SG_GENERAL, SG_ALERT, "Cannot parse query \"" << line << "\"");
+            return false;
+        }
+        queries.push_back(query);
+    }
+    return true;
+}
+
+// Serve requests on a port of the loopback interface, one connection at a
+// time, keeping the paged tiles between requests. A request is a set of
+// query lines ended by an empty line or by closing the connection. The
+// answers come in the same order, followed by an empty line.
+static int
+serve(Elevation& elevation, int port, bool printSolidness)
+{
+    simgear::Socket::initSockets();
+    simgear::Socket listener;
+    if (!listener.open(true) || listener.bind("127.0.0.1", port) < 0
+        || listener.listen(5) < 0) {
+        SG_LOG(SG_GENERAL, SG_ALERT, "Cannot listen on port " << port);
+        return EXIT_FAILURE;
+    }
+    listener.setBlocking(true);
+    SG_LOG(SG_GENERAL, SG_INFO, "fgelev: listening on 127.0.0.1:" << port);
+
+    for (;;) {
+        simgear::IPAddress address;
+        int handle = listener.accept(&address);
+        if (handle < 0)
+            continue;
+        simgear::Socket connection;
+        connection.setHandle(handle);
+        connection.setBlocking(true);
+
+        std::string pending;
+        std::vector<Query> queries;
+        bool open = true;
+        while (open) {
+            char buffer[8192];
+            int received = connection.recv(buffer, sizeof(buffer));
+            if (received <= 0) {
+                open = false;
+                // terminate the last line and the request
+                pending += "\n\n";
+            } else {
+                pending.append(buffer, received);
+            }
+
+            std::string::size_type eol;
+            while ((eol = pending.find('\n')) != std::string::npos) {
+                std::string line = pending.substr(0, eol);
+                pending.erase(0, eol + 1);
+                if (!line.empty() && line[line.size() - 1] == '\r')
+                    line.erase(line.size() - 1);
+
+                if (!line.empty()) {
+                    Query query;
+                    if (parseQuery(line, query))
+                        queries.push_back(query);
+                    else
+                        SG_LOG(SG_GENERAL, SG_WARN, "Cannot parse query \"" << line << "\"");
+                    continue;
+                }
+                if (queries.empty())
+                    continue;
+
+                SGTimeStamp start = SGTimeStamp::now();
+                elevation.evaluate(queries);
+                reportRate(queries.size(), start);
+
+                std::ostringstream answer;
+                report(queries, printSolidness, answer);
+                answer << std::endl;
+                std::string data = answer.str();
+                for (size_t sent = 0; open && sent < data.size();) {
+                    int count = connection.send(data.data() + sent, data.size() - sent);
+                    if (count <= 0)
+                        open = false;
+                    else
+                        sent += count;
+                }
+                queries.clear();
+            }
+        }
+        connection.close();
+    }
+    return EXIT_SUCCESS;
+}
+
 int
 main(int argc, char** argv)
 {
@@ -101,6 +392,17 @@ main(int argc, char** argv)
 
     bool printSolidness = arguments.read("--print-solidness");
 
+    unsigned threads;
+    if (arguments.read("--threads", threads)) {
+    } else threads = std::max(std::thread::hardware_concurrency(), 1u);
+
+    std::string batchFile;
+    bool batch = arguments.read("--batch", batchFile);
+    bool binary = arguments.read("--binary");
+
+    int port;
+    bool server = arguments.read("--server", port);
+
     std::string fg_root;
     if (arguments.read("--fg-root", fg_root)) {
     } else if (const char *fg_root_env = std::getenv("FG_ROOT")) {
@@ -191,50 +493,36 @@ main(int argc, char** argv)
         return EXIT_FAILURE;
     }
 
-    // We assume that the above is a paged database.
-    sg::BVHPager pager;
+    Elevation elevation(*node, expire, threads);
+
+    if (server)
+        return serve(elevation, port, printSolidness);
 
+    if (batch) {
+        std::vector<Query> queries;
+        if (!readBatch(batchFile, binary, queries)) {
+            SG_LOG(SG_GENERAL, SG_ALERT, "Cannot read batch file " << batchFile);
+            return EXIT_FAILURE;
+        }
+        SGTimeStamp start = SGTimeStamp::now();
+        elevation.evaluate(queries);
+        reportRate(queries.size(), start);
+        report(queries, printSolidness, std::cout);
+        return EXIT_SUCCESS;
+    }
+
+    // Answer the lines from the standard input one by one
+    std::vector<Query> queries(1);
     while (std::cin.good()) {
-        // Increment the paging relevant number
-        pager.setUseStamp(1 + pager.getUseStamp());
-        // and expire everything not accessed for the past 30 requests
-        pager.update(expire);
-
-        std::string id;
-        std::cin >> id;
-        double lon, lat;
-        std::cin >> lon >> lat;
+        Query& query = queries[0];
+        std::cin >> query.id;
+        std::cin >> query.lon >> query.lat;
         if (std::cin.fail())
             return EXIT_FAILURE;
         std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
 
-        SGVec3d start = SGVec3d::fromGeod(SGGeod::fromDegM(lon, lat, 10000));
-        SGVec3d end = SGVec3d::fromGeod(SGGeod::fromDegM(lon, lat, -1000));
-
-        const simgear::BVHMaterial* material = NULL;
-        // Try to find an intersection
-        bool found = intersect(*node, pager, start, end, 0, &material);
-        double scale = 1e-5;
-        while (!found && scale <= 1) {
-            found = intersect(*node, pager, start, end, scale, &material);
-            scale *= 2;
-        }
-        if (1e-5 < scale)
-            std::cerr << "Found hole of minimum diameter "
-                      << scale << "m at lon = " << lon
-                      << "deg lat = " << lat << "deg" << std::endl;
-
-        std::cout << id << ": ";
-        string solid = material && material->get_solid() ? "solid" : "-";
-        if (!found) {
-            std::cout << "-1000" << std::endl;
-        } else {
-            SGGeod geod = SGGeod::fromCart(end);
-            std::cout << std::fixed << std::setprecision(3) << geod.getElevationM();
-            if( printSolidness )
-                std::cout <<  " " << (material && material->get_solid() ? "solid" : "-");
-            std::cout << std::endl;
-        }
+        elevation.evaluate(queries);
+        report(queries, printSolidness, std::cout);
     }
 
     return EXIT_SUCCESS;
@@ -27,6 +27,9 @@
 #include <QNetworkAccessManager>
 #include <QNetworkReply>
 #include <QDataStream>
+#include <QUrlQuery>
+
+#include <cstring>
 
 #include "localprop.h"
 #include "fgqcanvasfontcache.h"
@@ -38,6 +41,8 @@ CanvasConnection::CanvasConnection(QObject *parent) : QObject(parent)
     connect(&m_webSocket, &QWebSocket::disconnected, this, &CanvasConnection::onWebSocketClosed);
     connect(&m_webSocket, &QWebSocket::textMessageReceived,
             this, &CanvasConnection::onTextMessageReceived);
+    connect(&m_webSocket, &QWebSocket::binaryMessageReceived,
+            this, &CanvasConnection::onBinaryMessageReceived);
 
     m_destRect = QRectF(50, 50, 400, 400);
 }
@@ -144,6 +149,13 @@ void CanvasConnection::connectWebSocket(QByteArray hostName, int port)
     wsUrl.setPort(port);
     wsUrl.setPath("/PropertyTreeMirror" + m_rootPropertyPath);
 
+    // ask for the compact binary encoding; servers which don't support it
+    // ignore the query and send JSON text frames instead
+    QUrlQuery query;
+    query.addQueryItem("encoding", "binary");
+    query.addQueryItem("compress", "1");
+    wsUrl.setQuery(query);
+
     m_webSocketUrl = wsUrl;
     emit webSocketUrlChanged();
 
@@ -204,43 +216,19 @@ void CanvasConnection::onTextMessageReceived(QString message)
             QJsonObject newProp = v.toObject();
 
             QByteArray nodePath = newProp.value("path").toString().toUtf8();
-            if (nodePath.indexOf(m_rootPropertyPath) != 0) {
-                qWarning() << "not a property path we are mirroring:" << nodePath;
-                continue;
-            }
-
-            QByteArray localPath = nodePath.mid(m_rootPropertyPath.size() + 1);
-            LocalProp* newNode = propertyFromPath(localPath);
-            newNode->setPosition(newProp.value("position").toInt());
-            // store in the global dict
             unsigned int propId = newProp.value("id").toInt();
-            if (idPropertyDict.contains(propId)) {
-                qWarning() << "duplicate add of:" << nodePath << "old is" << idPropertyDict.value(propId)->path();
-            } else {
-                idPropertyDict.insert(propId, newNode);
-            }
+            LocalProp* newNode = createProperty(nodePath, propId, newProp.value("position").toInt());
 
             // set initial value
-            newNode->processChange(newProp.value("value"));
+            if (newNode) {
+                newNode->processChange(newProp.value("value"));
+            }
         }
 
         // process removes
         QJsonArray removed = json.object().value("removed").toArray();
         Q_FOREACH (QJsonValue v, removed) {
-            unsigned int propId = v.toInt();
-            if (!idPropertyDict.contains(propId)) {
-                continue;
-            }
-
-            auto prop = idPropertyDict.value(propId);
-            idPropertyDict.remove(propId);
-
-            // depending on the order removes are sent, the LocalProp
-            // may already have been deleted when its parent was removed,
-            // so check if the QPointer is null
-            if (!prop.isNull()) {
-                prop->parent()->removeChild(prop);
-            }
+            removeProperty(v.toInt());
         } // of removes processing
 
         // process changes
@@ -253,13 +241,7 @@ void CanvasConnection::onTextMessageReceived(QString message)
                 continue;
             }
 
-            unsigned int propId = change.at(0).toInt();
-            if (!idPropertyDict.contains(propId)) {
-                qWarning() << "ignoring unknown prop ID " << propId;
-                continue;
-            }
-
-            LocalProp* lp = idPropertyDict.value(propId);
+            LocalProp* lp = propertyForId(change.at(0).toInt());
             if (lp != nullptr) {
                 lp->processChange(change.at(1));
             }
@@ -269,6 +251,251 @@ void CanvasConnection::onTextMessageReceived(QString message)
     emit updated();
 }
 
+namespace
+{
+// keep in sync with MirrorPropertyTreeWebsocket.hxx in the FlightGear sources
+const quint8 BinaryVersion = 1;
+const quint8 FlagCompressed = 1 << 0;
+
+enum BlockTag
+{
+    BlockCreated = 1,
+    BlockRemoved = 2,
+    BlockChanged = 3
+};
+
+enum ValueTag
+{
+    ValueNone = 0,
+    ValueFalse = 1,
+    ValueTrue = 2,
+    ValueInt = 3,
+    ValueFloat = 4,
+    ValueDouble = 5,
+    ValueString = 6
+};
+
+class BinaryFrameReader
+{
+public:
+    BinaryFrameReader(const QByteArray& data) :
+        m_data(reinterpret_cast<const quint8*>(data.constData())),
+        m_end(m_data + data.size())
+    {}
+
+    bool atEnd() const
+    {
+        return m_failed || (m_data >= m_end);
+    }
+
+    bool failed() const
+    {
+        return m_failed;
+    }
+
+    quint8 readByte()
+    {
+        if (m_data >= m_end) {
+            m_failed = true;
+            return 0;
+        }
+
+        return *m_data++;
+    }
+
+    quint64 readVarint()
+    {
+        quint64 result = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            const quint8 b = readByte();
+            result |= static_cast<quint64>(b & 0x7f) << shift;
+            if ((b & 0x80) == 0) {
+                return result;
+            }
+        }
+
+        m_failed = true;
+        return 0;
+    }
+
+    qint64 readSignedVarint()
+    {
+        const quint64 v = readVarint();
+        return static_cast<qint64>(v >> 1) ^ -static_cast<qint64>(v & 1);
+    }
+
+    QByteArray readString()
+    {
+        const quint64 len = readVarint();
+        if (m_failed || (len > static_cast<quint64>(m_end - m_data))) {
+            m_failed = true;
+            return {};
+        }
+
+        QByteArray result(reinterpret_cast<const char*>(m_data), static_cast<int>(len));
+        m_data += len;
+        return result;
+    }
+
+    quint64 readLittleEndian(int bytes)
+    {
+        if (bytes > (m_end - m_data)) {
+            m_failed = true;
+            return 0;
+        }
+
+        quint64 result = 0;
+        for (int i = 0; i < bytes; ++i) {
+            result |= static_cast<quint64>(m_data[i]) << (i * 8);
+        }
+        m_data += bytes;
+        return result;
+    }
+
+    QVariant readValue()
+    {
+        switch (readByte()) {
+        case ValueNone:     return {};
+        case ValueFalse:    return false;
+        case ValueTrue:     return true;
+        case ValueInt:      return readSignedVarint();
+        case ValueFloat: {
+            const quint32 bits = static_cast<quint32>(readLittleEndian(4));
+            float f;
+            memcpy(&f, &bits, sizeof(f));
+            return static_cast<double>(f);
+        }
+        case ValueDouble: {
+            const quint64 bits = readLittleEndian(8);
+            double d;
+            memcpy(&d, &bits, sizeof(d));
+            return d;
+        }
+        case ValueString:   return QString::fromUtf8(readString());
+        default:
+            m_failed = true;
+            return {};
+        }
+    }
+
+private:
+    const quint8* m_data;
+    const quint8* m_end;
+    bool m_failed = false;
+};
+
+} // of anonymous namespace
+
+void CanvasConnection::onBinaryMessageReceived(QByteArray message)
+{
+    if ((message.size() < 2) || (static_cast<quint8>(message.at(0)) != BinaryVersion)) {
+        qWarning() << "unsupported binary mirror frame";
+        return;
+    }
+
+    QByteArray payload = message.mid(2);
+    if (static_cast<quint8>(message.at(1)) & FlagCompressed) {
+        // server sends a big-endian uncompressed size followed by zlib data,
+        // which is exactly what qUncompress expects
+        payload = qUncompress(payload);
+        if (payload.isEmpty()) {
+            qWarning() << "failed to decompress binary mirror frame";
+            return;
+        }
+    }
+
+    BinaryFrameReader reader(payload);
+    while (!reader.atEnd()) {
+        const quint8 tag = reader.readByte();
+        const quint64 count = reader.readVarint();
+        unsigned int propId = 0;
+
+        for (quint64 i = 0; (i < count) && !reader.failed(); ++i) {
+            propId += static_cast<unsigned int>(reader.readVarint());
+
+            if (tag == BlockCreated) {
+                const QByteArray nodePath = reader.readString();
+                const unsigned int position = static_cast<unsigned int>(reader.readVarint());
+                const QVariant value = reader.readValue();
+                if (reader.failed()) {
+                    break;
+                }
+
+                LocalProp* newNode = createProperty(nodePath, propId, position);
+                if (newNode && value.isValid()) {
+                    newNode->processChange(value);
+                }
+            } else if (tag == BlockRemoved) {
+                removeProperty(propId);
+            } else if (tag == BlockChanged) {
+                const QVariant value = reader.readValue();
+                LocalProp* lp = propertyForId(propId);
+                if (lp && !reader.failed()) {
+                    lp->processChange(value);
+                }
+            } else {
+                qWarning() << "unknown block in binary mirror frame:" << tag;
+                return;
+            }
+        }
+
+        if (reader.failed()) {
+            qWarning() << "malformed binary mirror frame";
+            break;
+        }
+    }
+
+    emit updated();
+}
+
+LocalProp* CanvasConnection::createProperty(QByteArray nodePath, unsigned int propId, unsigned int position)
+{
+    if (nodePath.indexOf(m_rootPropertyPath) != 0) {
+        qWarning() << "not a property path we are mirroring:" << nodePath;
+        return nullptr;
+    }
+
+    QByteArray localPath = nodePath.mid(m_rootPropertyPath.size() + 1);
+    LocalProp* newNode = propertyFromPath(localPath);
+    newNode->setPosition(position);
+    // store in the global dict
+    if (idPropertyDict.contains(propId)) {
+        qWarning() << "duplicate add of:" << nodePath << "old is" << idPropertyDict.value(propId)->path();
+    } else {
+        idPropertyDict.insert(propId, newNode);
+    }
+
+    return newNode;
+}
+
+void CanvasConnection::removeProperty(unsigned int propId)
+{
+    if (!idPropertyDict.contains(propId)) {
+        return;
+    }
+
+    auto prop = idPropertyDict.value(propId);
+    idPropertyDict.remove(propId);
+
+    // depending on the order removes are sent, the LocalProp
+    // may already have been deleted when its parent was removed,
+    // so check if the QPointer is null
+    if (!prop.isNull()) {
+        prop->parent()->removeChild(prop);
+    }
+}
+
+LocalProp* CanvasConnection::propertyForId(unsigned int propId) const
+{
+    auto it = idPropertyDict.find(propId);
+    if (it == idPropertyDict.end()) {
+        qWarning() << "ignoring unknown prop ID " << propId;
+        return nullptr;
+    }
+
+    return it.value();
+}
+
 void CanvasConnection::onWebSocketClosed()
 {
     qDebug() << "saw web-socket closed";
@@ -120,12 +120,17 @@ signals:
 private Q_SLOTS:
     void onWebSocketConnected();
     void onTextMessageReceived(QString message);
+    void onBinaryMessageReceived(QByteArray message);
     void onWebSocketClosed();
 
 private:
     void setStatus(Status newStatus);
     LocalProp *propertyFromPath(QByteArray path) const;
 
+    LocalProp* createProperty(QByteArray nodePath, unsigned int propId, unsigned int position);
+    void removeProperty(unsigned int propId);
+    LocalProp* propertyForId(unsigned int propId) const;
+
     QUrl m_webSocketUrl;
     QByteArray m_rootPropertyPath;
     QRectF m_destRect;
@@ -96,7 +96,11 @@ LocalProp::~LocalProp()
 
 void LocalProp::processChange(QJsonValue json)
 {
-    QVariant newValue = json.toVariant();
+    processChange(json.toVariant());
+}
+
+void LocalProp::processChange(QVariant newValue)
+{
     if (newValue != _value) {
         _value = newValue;
         emit valueChanged(_value);
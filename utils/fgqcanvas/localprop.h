@@ -86,6 +86,8 @@ public:
 
     void processChange(QJsonValue newValue);
 
+    void processChange(QVariant newValue);
+
     const NameIndexTuple& id() const;
 
     QByteArray path() const;
@@ -1,8 +1,453 @@
+// fgtraffic.cxx -- compiles traffic timetables for the traffic manager
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation; either version 2 of the
+// License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
 #include "fgtraffic.hxx"
 
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
 #include <iostream>
+#include <fstream>
+#include <sstream>
+
+#include <simgear/misc/sg_dir.hxx>
+#include <simgear/io/iostreams/sgstream.hxx>
+#include <simgear/structure/exception.hxx>
+
+static void tokenize(const std::string& str, std::vector<std::string>& tokens,
+                     const std::string& delimiters)
+{
+    tokens.clear();
+    std::string::size_type lastPos = str.find_first_not_of(delimiters, 0);
+    std::string::size_type pos = str.find_first_of(delimiters, lastPos);
+
+    while (std::string::npos != pos || std::string::npos != lastPos) {
+        tokens.push_back(str.substr(lastPos, pos - lastPos));
+        lastPos = str.find_first_not_of(delimiters, pos);
+        pos = str.find_first_of(delimiters, lastPos);
+    }
+}
+
+// Same reading as FGScheduledFlight::processTimeString(): "[d/]hh:mm:ss".
+static void parseTime(const std::string& time, int8_t& weekday, int32_t& second)
+{
+    std::string timeCopy = time;
+    weekday = TIMETABLE_NO_WEEKDAY;
+    if (timeCopy.find("/", 0) != std::string::npos) {
+        weekday = atoi(timeCopy.substr(0, 1).c_str());
+        timeCopy = timeCopy.substr(2, timeCopy.length());
+    }
+    int hour = atoi(timeCopy.substr(0, 2).c_str());
+    int minute = timeCopy.size() > 3 ? atoi(timeCopy.substr(3, 5).c_str()) : 0;
+    int sec = timeCopy.size() > 6 ? atoi(timeCopy.substr(6, 8).c_str()) : 0;
+    second = (hour * 60 + minute) * 60 + sec;
+}
+
+// Same reading as the FGScheduledFlight constructor.
+static int32_t parseRepeat(const std::string& rep, const std::string& callsign)
+{
+    if (rep.find("WEEK", 0) != std::string::npos) {
+        return 7 * 24 * 60 * 60;
+    } else if (rep.find("Hr", 0) != std::string::npos) {
+        return 60 * 60 * atoi(rep.substr(0, 2).c_str());
+    }
+
+    std::cerr << "Unknown repeat period in flight plan of flight '"
+              << callsign << "': " << rep << std::endl;
+    return 365 * 24 * 60 * 60;
+}
+
+TimetableCompiler::TimetableCompiler() :
+    _autoKeys(0)
+{
+    intern(""); // index 0 stands for missing values
+}
+
+uint32_t TimetableCompiler::intern(const std::string& s)
+{
+    std::map<std::string, uint32_t>::iterator it = _stringIndex.find(s);
+    if (it != _stringIndex.end()) {
+        return it->second;
+    }
+
+    uint32_t index = _strings.size();
+    _strings.push_back(s);
+    _stringIndex.insert(std::make_pair(s, index));
+    return index;
+}
+
+uint32_t TimetableCompiler::key(const std::string& requiredAircraft)
+{
+    if (requiredAircraft.empty()) {
+        return _autoKeys | TIMETABLE_AUTO_KEY;
+    }
+    return intern(requiredAircraft);
+}
+
+void TimetableCompiler::addAircraft(const TimetableAircraft& aircraft)
+{
+    _aircraft.push_back(aircraft);
+    if (aircraft.requiredAircraft == (_autoKeys | TIMETABLE_AUTO_KEY)) {
+        _autoKeys++;
+    }
+}
+
+void TimetableCompiler::addFlight(TimetableFlight flight,
+                                  const std::string& departureTime,
+                                  const std::string& arrivalTime,
+                                  const std::string& repeat)
+{
+    parseTime(departureTime, flight.departureWeekday, flight.departureSecond);
+    parseTime(arrivalTime, flight.arrivalWeekday, flight.arrivalSecond);
+    flight.repeatPeriod = parseRepeat(repeat, _strings[flight.callsign]);
+    flight.reserved = 0;
+    _flights.push_back(flight);
+}
+
+bool TimetableCompiler::addTrafficDir(const SGPath& dir)
+{
+    if (!dir.isDir()) {
+        std::cerr << dir << " is not a directory" << std::endl;
+        return false;
+    }
+
+    simgear::Dir trafficDir(dir);
+    simgear::PathList subDirs = trafficDir.children(simgear::Dir::TYPE_DIR | simgear::Dir::NO_DOT_OR_DOTDOT);
+    for (simgear::PathList::const_iterator d = subDirs.begin(); d != subDirs.end(); ++d) {
+        simgear::PathList files = simgear::Dir(*d).children(simgear::Dir::TYPE_FILE, ".xml");
+        for (simgear::PathList::const_iterator f = files.begin(); f != files.end(); ++f) {
+            if (!addFile(*f)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+bool TimetableCompiler::addFile(const SGPath& path)
+{
+    if (path.extension() == "conf") {
+        return addConfFile(path);
+    }
+
+    try {
+        TrafficXMLVisitor visitor(*this);
+        readXML(path, visitor);
+    } catch (const sg_exception& e) {
+        std::cerr << "Error reading " << path << ": " << e.getFormattedMessage() << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// Same reading as FGTrafficManager::readTimeTableFromFile().
+bool TimetableCompiler::addConfFile(const SGPath& path)
+{
+    sg_ifstream infile(path);
+    if (!infile.is_open()) {
+        std::cerr << "Unable to open " << path << std::endl;
+        return false;
+    }
+
+    std::string line;
+    std::vector<std::string> tokens, time;
+    int lineNumber = 0;
+    while (std::getline(infile, line)) {
+        lineNumber++;
+        tokenize(line, tokens, " \t\r");
+        if (tokens.empty()) {
+            continue;
+        }
+
+        if (tokens[0] == "AC") {
+            if (tokens.size() != 13) {
+                std::cerr << path << ":" << lineNumber << ": bad AC line" << std::endl;
+                return false;
+            }
+
+            TimetableAircraft a;
+            a.model = intern(tokens[12]);
+            a.livery = intern(tokens[6]);
+            a.homePort = intern(tokens[1]);
+            a.registration = intern(tokens[2]);
+            a.requiredAircraft = intern(tokens[3] + tokens[5]);
+            a.acType = intern(tokens[4]);
+            a.airline = intern(tokens[5]);
+            a.performanceClass = intern(tokens[10]);
+            a.flightType = intern(tokens[9]);
+            a.radius = atof(tokens[8].c_str());
+            a.offset = atof(tokens[7].c_str());
+            a.flags = TIMETABLE_FROM_CONF;
+            if (tokens[11] != "false") {
+                a.flags |= TIMETABLE_HEAVY;
+            }
+            addAircraft(a);
+        } else if (tokens[0] == "FLIGHT") {
+            if (tokens.size() != 10 || tokens[3].size() != 7) {
+                std::cerr << path << ":" << lineNumber << ": bad FLIGHT line" << std::endl;
+                return false;
+            }
+
+            TimetableFlight f;
+            f.callsign = intern(tokens[1]);
+            f.flightRules = intern(tokens[2]);
+            f.departurePort = intern(tokens[5]);
+            f.arrivalPort = intern(tokens[7]);
+            f.cruiseAltitude = atoi(tokens[8].c_str());
+            f.requiredAircraft = intern(tokens[9]);
+
+            const std::string& weekdays = tokens[3];
+            const std::string& depTime = tokens[4];
+            const std::string& arrTime = tokens[6];
+            tokenize(depTime, time, ":");
+            double dep = atof(time[0].c_str()) + (time.size() > 1 ? atof(time[1].c_str()) / 60.0 : 0);
+            tokenize(arrTime, time, ":");
+            double arr = atof(time[0].c_str()) + (time.size() > 1 ? atof(time[1].c_str()) / 60.0 : 0);
+
+            // one weekly flight per day of operation
+            for (int i = 0; i < 7; i++) {
+                if (weekdays[i] == '.') {
+                    continue;
+                }
+                int arrDay = i + 1;
+                if (arr < dep) {
+                    arrDay = (i == 6) ? 0 : i + 2;
+                }
+                std::ostringstream departure, arrival;
+                departure << (i + 1) << "/" << depTime << ":00";
+                arrival << arrDay << "/" << arrTime << ":00";
+                addFlight(f, departure.str(), arrival.str(), "WEEK");
+            }
+        }
+    }
+    return true;
+}
+
+bool TimetableCompiler::write(const SGPath& path) const
+{
+    TimetableHeader header;
+    memcpy(header.magic, TIMETABLE_MAGIC, 4);
+    header.version = TIMETABLE_VERSION;
+    header.byteOrder = TIMETABLE_BYTE_ORDER;
+    header.aircraftCount = _aircraft.size();
+    header.flightCount = _flights.size();
+    header.stringCount = _strings.size();
+    header.reserved = 0;
+
+    std::vector<uint32_t> offsets;
+    std::string data;
+    for (size_t i = 0; i < _strings.size(); i++) {
+        offsets.push_back(data.size());
+        data += _strings[i];
+        data += '\0';
+    }
+    header.stringBytes = data.size();
+
+    sg_ofstream out(path, std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!out.is_open()) {
+        std::cerr << "Unable to write " << path << std::endl;
+        return false;
+    }
+
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    if (!_aircraft.empty()) {
+        out.write(reinterpret_cast<const char*>(&_aircraft[0]),
+                  _aircraft.size() * sizeof(TimetableAircraft));
+    }
+    if (!_flights.empty()) {
+        out.write(reinterpret_cast<const char*>(&_flights[0]),
+                  _flights.size() * sizeof(TimetableFlight));
+    }
+    out.write(reinterpret_cast<const char*>(&offsets[0]),
+              offsets.size() * sizeof(uint32_t));
+    out.write(data.data(), data.size());
+
+    return out.good();
+}
+
+TrafficXMLVisitor::TrafficXMLVisitor(TimetableCompiler& compiler) :
+    _compiler(compiler),
+    cruiseAlt(0),
+    radius(0),
+    offset(0),
+    heavy(false)
+{
+}
+
+void TrafficXMLVisitor::startXML()
+{
+    requiredAircraft = "";
+    homePort = "";
+}
+
+void TrafficXMLVisitor::startElement(const char* name, const XMLAttributes& atts)
+{
+    if (atts.getValue("include")) {
+        std::cerr << "Warning: include of " << atts.getValue("include")
+                  << " ignored" << std::endl;
+    }
+    _values.push_back("");
+}
+
+void TrafficXMLVisitor::endElement(const char* name)
+{
+    const std::string& value = _values.back();
+
+    if (!strcmp(name, "model"))
+        mdl = value;
+    else if (!strcmp(name, "livery"))
+        livery = value;
+    else if (!strcmp(name, "home-port"))
+        homePort = value;
+    else if (!strcmp(name, "registration"))
+        registration = value;
+    else if (!strcmp(name, "airline"))
+        airline = value;
+    else if (!strcmp(name, "actype"))
+        acType = value;
+    else if (!strcmp(name, "required-aircraft"))
+        requiredAircraft = value;
+    else if (!strcmp(name, "flighttype"))
+        flighttype = value;
+    else if (!strcmp(name, "radius"))
+        radius = atoi(value.c_str());
+    else if (!strcmp(name, "offset"))
+        offset = atoi(value.c_str());
+    else if (!strcmp(name, "performance-class"))
+        m_class = value;
+    else if (!strcmp(name, "heavy"))
+        heavy = (value == "true");
+    else if (!strcmp(name, "callsign"))
+        callsign = value;
+    else if (!strcmp(name, "fltrules"))
+        fltrules = value;
+    else if (!strcmp(name, "port"))
+        port = value;
+    else if (!strcmp(name, "time"))
+        timeString = value;
+    else if (!strcmp(name, "departure")) {
+        departurePort = port;
+        departureTime = timeString;
+    } else if (!strcmp(name, "cruise-alt"))
+        cruiseAlt = atoi(value.c_str());
+    else if (!strcmp(name, "arrival")) {
+        arrivalPort = port;
+        arrivalTime = timeString;
+    } else if (!strcmp(name, "repeat"))
+        repeat = value;
+    else if (!strcmp(name, "flight")) {
+        TimetableFlight f;
+        f.callsign = _compiler.intern(callsign);
+        f.flightRules = _compiler.intern(fltrules);
+        f.departurePort = _compiler.intern(departurePort);
+        f.arrivalPort = _compiler.intern(arrivalPort);
+        f.cruiseAltitude = cruiseAlt;
+        f.requiredAircraft = _compiler.key(requiredAircraft);
+        _compiler.addFlight(f, departureTime, arrivalTime, repeat);
+        requiredAircraft = "";
+    } else if (!strcmp(name, "aircraft")) {
+        TimetableAircraft a;
+        a.model = _compiler.intern(mdl);
+        a.livery = _compiler.intern(livery);
+        a.homePort = _compiler.intern(homePort.empty() ? departurePort : homePort);
+        a.registration = _compiler.intern(registration);
+        a.requiredAircraft = _compiler.key(requiredAircraft);
+        a.acType = _compiler.intern(acType);
+        a.airline = _compiler.intern(airline);
+        a.performanceClass = _compiler.intern(m_class);
+        a.flightType = _compiler.intern(flighttype);
+        a.radius = radius;
+        a.offset = offset;
+        a.flags = heavy ? TIMETABLE_HEAVY : 0;
+        _compiler.addAircraft(a);
+        requiredAircraft = "";
+        homePort = "";
+    }
+
+    _values.pop_back();
+}
+
+void TrafficXMLVisitor::data(const char* s, int len)
+{
+    _values.back() += std::string(s, len);
+}
+
+void TrafficXMLVisitor::warning(const char* message, int line, int column)
+{
+    std::cerr << "Warning: " << message << " (" << line << ',' << column << ')' << std::endl;
+}
+
+void TrafficXMLVisitor::error(const char* message, int line, int column)
+{
+    std::cerr << "Error: " << message << " (" << line << ',' << column << ')' << std::endl;
+}
+
+static void usage(const char* name)
+{
+    std::cout << "Usage: " << name << " compile [--output FILE] PATH..." << std::endl
+              << std::endl
+              << "Compiles traffic timetables into one file that the traffic manager" << std::endl
+              << "maps in memory instead of parsing the timetables at startup." << std::endl
+              << "A PATH is a traffic directory, laid out as $FG_ROOT/AI/Traffic," << std::endl
+              << "or a single .xml or .conf traffic file. The output defaults to" << std::endl
+              << "timetable.fgtt in the traffic directory when only one is given;" << std::endl
+              << "the traffic manager picks it up there, or as" << std::endl
+              << "/sim/traffic-manager/datafile." << std::endl;
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc < 3 || strcmp(argv[1], "compile")) {
+        usage(argv[0]);
+        return argc < 2 ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
+    SGPath output;
+    std::vector<SGPath> inputs;
+    for (int i = 2; i < argc; i++) {
+        if (!strcmp(argv[i], "--output") && i + 1 < argc) {
+            output = SGPath::fromLocal8Bit(argv[++i]);
+        } else {
+            inputs.push_back(SGPath::fromLocal8Bit(argv[i]));
+        }
+    }
+
+    if (output.isNull()) {
+        if (inputs.size() != 1 || !inputs[0].isDir()) {
+            std::cerr << "--output is required unless a single traffic directory is given" << std::endl;
+            return EXIT_FAILURE;
+        }
+        output = inputs[0] / "timetable.fgtt";
+    }
+
+    TimetableCompiler compiler;
+    for (size_t i = 0; i < inputs.size(); i++) {
+        bool ok = inputs[i].isDir() ? compiler.addTrafficDir(inputs[i])
+                                    : compiler.addFile(inputs[i]);
+        if (!ok) {
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (!compiler.write(output)) {
+        return EXIT_FAILURE;
+    }
 
-int main(int argc, char *argv[]) {
-    std::cout << "Hello World" << std::endl;
-    return 0;
+    std::cout << output << ": " << compiler.aircraftCount() << " aircraft, "
+              << compiler.flightCount() << " flights, "
+              << compiler.stringCount() << " strings" << std::endl;
+    return EXIT_SUCCESS;
 }
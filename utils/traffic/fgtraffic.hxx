@@ -0,0 +1,97 @@
+// fgtraffic.hxx -- compiles traffic timetables for the traffic manager
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation; either version 2 of the
+// License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+#ifndef FGTRAFFIC_HXX
+#define FGTRAFFIC_HXX
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include <simgear/misc/sg_path.hxx>
+#include <simgear/xml/easyxml.hxx>
+
+#include <Traffic/TimetableFormat.hxx>
+
+/**
+ * Collects aircraft and flights and writes them as a compiled timetable
+ * (see Traffic/TimetableFormat.hxx), each string once.
+ */
+class TimetableCompiler
+{
+public:
+    TimetableCompiler();
+
+    /** Reads the .xml files of the sub-directories of a traffic directory,
+     * the layout of $FG_ROOT/AI/Traffic. */
+    bool addTrafficDir(const SGPath& dir);
+    /** Reads a traffic file, in XML or in the .conf format. */
+    bool addFile(const SGPath& path);
+
+    bool write(const SGPath& path) const;
+
+    size_t aircraftCount() const { return _aircraft.size(); }
+    size_t flightCount() const { return _flights.size(); }
+    size_t stringCount() const { return _strings.size(); }
+
+    uint32_t intern(const std::string& s);
+    // Key of a required-aircraft, numbered when empty.
+    uint32_t key(const std::string& requiredAircraft);
+    uint32_t nextAutoKey() const { return _autoKeys; }
+
+    void addAircraft(const TimetableAircraft& aircraft);
+    void addFlight(TimetableFlight flight, const std::string& departureTime,
+                   const std::string& arrivalTime, const std::string& repeat);
+
+private:
+    bool addConfFile(const SGPath& path);
+
+    std::vector<TimetableAircraft> _aircraft;
+    std::vector<TimetableFlight> _flights;
+    std::map<std::string, uint32_t> _stringIndex;
+    std::vector<std::string> _strings;
+    uint32_t _autoKeys;
+};
+
+/**
+ * Reads the XML traffic files, as the traffic manager does.
+ */
+class TrafficXMLVisitor : public XMLVisitor
+{
+public:
+    TrafficXMLVisitor(TimetableCompiler& compiler);
+
+    virtual void startXML();
+    virtual void startElement(const char* name, const XMLAttributes& atts);
+    virtual void endElement(const char* name);
+    virtual void data(const char* s, int len);
+    virtual void warning(const char* message, int line, int column);
+    virtual void error(const char* message, int line, int column);
+
+private:
+    TimetableCompiler& _compiler;
+    std::vector<std::string> _values;
+
+    std::string mdl, livery, registration, callsign, fltrules,
+        port, timeString, departurePort, departureTime, arrivalPort,
+        arrivalTime, repeat, acType, airline, m_class, flighttype,
+        requiredAircraft, homePort;
+    int cruiseAlt;
+    double radius, offset;
+    bool heavy;
+};
+
+#endif